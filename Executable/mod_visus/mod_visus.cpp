@@ -389,7 +389,13 @@ extern "C" __declspec(dllexport)  HRESULT __stdcall RegisterModule(DWORD ,IHttpM
 #else
 
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <unistd.h>
+#include <errno.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <httpd.h>
 #include <http_config.h>
@@ -401,7 +407,9 @@ extern "C" module AP_MODULE_DECLARE_DATA visus_module;
 
 #include <http_log.h>
 #include <http_protocol.h>
+#include <http_connection.h>
 #include <apr_strings.h>
+#include <apr_portable.h>
 
 using namespace Visus;
 
@@ -743,6 +751,104 @@ static int MyFillRequestHeader(void *arg, const char *key, const char *value)
   return 1;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//for example the explicit points of a point query are POSTed
+static bool MyReadRequestBody(request_rec *apache_request, NetRequest& visus_request)
+{
+  if (ap_setup_client_block(apache_request, REQUEST_CHUNKED_DECHUNK) != OK)
+    return false;
+
+  if (!ap_should_client_block(apache_request))
+    return true;
+
+  String body;
+  char buffer[64 * 1024];
+  long n;
+  while ((n = ap_get_client_block(apache_request, buffer, sizeof(buffer))) > 0)
+    body.append(buffer, (size_t)n);
+
+  if (n < 0)
+    return false;
+
+  if (!body.empty())
+    visus_request.setTextBody(body);
+
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//sets the request aborted when the client goes away
+//apache sets connection->aborted only when a write fails, so the socket is also peeked for a close from the client
+class MyConnectionWatcher
+{
+public:
+
+  //constructor
+  MyConnectionWatcher(request_rec* apache_request_, Aborted aborted_) : apache_request(apache_request_), aborted(aborted_)
+  {
+#if !((AP_SERVER_MAJORVERSION_NUMBER>=2) && (AP_SERVER_MINORVERSION_NUMBER<4))
+    apr_os_sock_t os_socket;
+    auto socket = ap_get_conn_socket(apache_request->connection);
+    if (socket && apr_os_sock_get(&os_socket, socket) == APR_SUCCESS)
+      this->fd = (int)os_socket;
+#endif
+    this->thread = std::thread([this]() {
+      run();
+    });
+  }
+
+  //destructor
+  ~MyConnectionWatcher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->lock);
+      this->bExit = true;
+    }
+    wakeup.notify_all();
+    thread.join();
+  }
+
+private:
+
+  request_rec*            apache_request;
+  Aborted                 aborted;
+  int                     fd = -1;
+  std::mutex              lock;
+  std::condition_variable wakeup;
+  bool                    bExit = false;
+  std::thread             thread;
+
+  //run
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(this->lock);
+    while (!bExit)
+    {
+      wakeup.wait_for(lock, std::chrono::milliseconds(100));
+      if (bExit)
+        break;
+
+      if (apache_request->connection->aborted || isPeerClosed())
+      {
+        aborted.setTrue();
+        break;
+      }
+    }
+  }
+
+  //isPeerClosed (pending bytes, for example a pipelined request, do not count)
+  bool isPeerClosed() const
+  {
+    if (fd < 0)
+      return false;
+
+    char ch;
+    auto n = ::recv(fd, &ch, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+  }
+
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////
 //need this string to stick in memory up to the end ... forced to use static const char!
 //see http://www.gossamer-threads.com/lists/apache/users/375605?do=post_view_threaded       
@@ -773,7 +879,16 @@ static int MyHookRequest(request_rec *apache_request)
   );
 
   apr_table_do(MyFillRequestHeader, &(visus_request.headers), apache_request->headers_in, NULL);    
-  NetResponse visus_response=(*module)->handleRequest(visus_request);  
+
+  visus_request.method = apache_request->method;
+  if (!MyReadRequestBody(apache_request, visus_request))
+    return HTTP_BAD_REQUEST;
+
+  NetResponse visus_response;
+  {
+    MyConnectionWatcher watcher(apache_request, visus_request.aborted);
+    visus_response=(*module)->handleRequest(visus_request);  
+  }
   
   const char* content_type=APPLICATION_OCTET_STREAM;
   
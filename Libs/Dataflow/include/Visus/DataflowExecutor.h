@@ -0,0 +1,118 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#ifndef VISUS_DATAFLOW_EXECUTOR_H__
+#define VISUS_DATAFLOW_EXECUTOR_H__
+
+#include <Visus/DataflowModule.h>
+#include <Visus/CriticalSection.h>
+#include <Visus/Thread.h>
+
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+namespace Visus {
+
+/////////////////////////////////////////////////////////////////////////////
+//process-wide work-stealing executor shared by all dataflow nodes (see Node::addNodeJob)
+//each worker owns one queue per priority class, idle workers steal from the others
+//higher priority work is always picked before lower priority work, no matter which worker queued it
+class VISUS_DATAFLOW_API DataflowExecutor
+{
+public:
+
+  VISUS_DECLARE_SINGLETON_CLASS(DataflowExecutor)
+
+  enum Priority
+  {
+    HighPriority = 0,
+    NormalPriority,
+    LowPriority,
+    NumPriorities
+  };
+
+  //constructor (VISUS_DATAFLOW_NUM_THREADS overrides the number of workers)
+  DataflowExecutor();
+
+  //destructor
+  virtual ~DataflowExecutor();
+
+  //getNumWorkers
+  int getNumWorkers() const {
+    return (int)workers.size();
+  }
+
+  //push (from a worker the task goes to its own queue, otherwise round robin)
+  void push(std::function<void()> fn, int priority = NormalPriority);
+
+private:
+
+  //___________________________________________
+  class Worker
+  {
+  public:
+    CriticalSection                      lock;
+    std::deque< std::function<void()> >  queue[NumPriorities];
+    SharedPtr<std::thread>               thread;
+  };
+
+  std::vector< SharedPtr<Worker> > workers;
+  std::atomic<int>                 next_worker;
+
+  std::mutex                       wait_lock;
+  std::condition_variable          wait_task;  //a task has been queued
+  std::condition_variable          wait_push;  //for workers that missed their task while scanning the queues
+  Int64                            num_tasks = 0; //queued tasks no worker has claimed yet
+  Int64                            num_pushed = 0;
+  bool                             bExit = false;
+
+  //popTask
+  bool popTask(int worker, std::function<void()>& fn);
+
+  //workerEntryProc
+  void workerEntryProc(int worker);
+
+};
+
+} //namespace Visus
+
+#endif //VISUS_DATAFLOW_EXECUTOR_H__
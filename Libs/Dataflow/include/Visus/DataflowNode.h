@@ -49,6 +49,8 @@ For support : support@visus.net
 #include <Visus/Async.h>
 #include <Visus/Array.h>
 
+#include <condition_variable>
+
 namespace Visus {
 
 //predeclaration
@@ -66,6 +68,9 @@ public:
   //aborted
   Aborted aborted;
 
+  //priority (see DataflowExecutor::Priority, -1 means Node::getNodeJobPriority, evaluated by addNodeJob)
+  int priority=-1;
+
   //done
   Promise<int> done;
 
@@ -192,7 +197,10 @@ public:
     addNodeJob(SharedPtr<NodeJob>(job));
   }
 
-  //abortProcessing
+  //getNodeJobPriority (hidden nodes run in background, called by addNodeJob)
+  virtual int getNodeJobPriority() const;
+
+  //abortProcessing (queued jobs are dropped immediately)
   virtual void abortProcessing();
 
   //joinProcessing 
@@ -377,10 +385,11 @@ protected:
   Node*                        parent;
   std::vector<Node*>           childs;
 
-  CriticalSection                running_lock;
-  std::set< SharedPtr<NodeJob> > running;
-
-  SharedPtr<ThreadPool>          thread_pool;
+  CriticalSection                  running_lock;
+  std::set< SharedPtr<NodeJob> >   running;
+  std::deque< SharedPtr<NodeJob> > waiting;
+  bool                             scheduled=false;
+  std::condition_variable          idle;
 
   //processInput 
   virtual bool processInput() {
@@ -393,6 +402,17 @@ protected:
   //removeChild
   void removeChild(Node* child);
 
+private:
+
+  //scheduleNextJob (jobs of the same node run one at a time, in order)
+  void scheduleNextJob();
+
+  //runNextJob
+  void runNextJob();
+
+  //waitJobs
+  void waitJobs();
+
 };
 
 
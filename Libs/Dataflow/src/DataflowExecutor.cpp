@@ -0,0 +1,179 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#include <Visus/DataflowExecutor.h>
+#include <Visus/Thread.h>
+#include <Visus/Utils.h>
+#include <Visus/StringUtils.h>
+
+namespace Visus {
+
+VISUS_IMPLEMENT_SINGLETON_CLASS(DataflowExecutor)
+
+//the executor and the worker index of the current thread (-1 if not a worker)
+static thread_local DataflowExecutor* CurrentExecutor = nullptr;
+static thread_local int               CurrentWorker = -1;
+
+////////////////////////////////////////////////////////////
+DataflowExecutor::DataflowExecutor() : next_worker(0)
+{
+  //node jobs can wait for I/O, so don't go too low on small machines
+  int num_workers = std::max(4, (int)std::thread::hardware_concurrency());
+  auto env = Utils::getEnv("VISUS_DATAFLOW_NUM_THREADS");
+  if (!env.empty())
+    num_workers = std::max(1, cint(env));
+
+  for (int I = 0; I < num_workers; I++)
+    workers.push_back(std::make_shared<Worker>());
+
+  for (int I = 0; I < num_workers; I++)
+  {
+    workers[I]->thread = Thread::start("Dataflow Worker " + cstring(I), [this, I]() {
+      workerEntryProc(I);
+    });
+  }
+}
+
+////////////////////////////////////////////////////////////
+DataflowExecutor::~DataflowExecutor()
+{
+  {
+    std::unique_lock<std::mutex> lock(wait_lock);
+    bExit = true;
+  }
+  wait_task.notify_all();
+  wait_push.notify_all();
+
+  for (auto worker : workers)
+    Thread::join(worker->thread);
+}
+
+////////////////////////////////////////////////////////////
+void DataflowExecutor::push(std::function<void()> fn, int priority)
+{
+  VisusAssert(fn);
+  priority = Utils::clamp(priority, (int)HighPriority, (int)LowPriority);
+
+  int W = (CurrentExecutor == this && CurrentWorker >= 0) ? CurrentWorker : (next_worker++ % (int)workers.size());
+  {
+    auto worker = workers[W];
+    ScopedLock lock(worker->lock);
+    worker->queue[priority].push_back(fn);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(wait_lock);
+    num_tasks++;
+    num_pushed++;
+  }
+  wait_task.notify_one();
+  wait_push.notify_all();
+}
+
+////////////////////////////////////////////////////////////
+bool DataflowExecutor::popTask(int W, std::function<void()>& fn)
+{
+  int N = (int)workers.size();
+  for (int P = 0; P < NumPriorities; P++)
+  {
+    //own queue first (oldest first)
+    {
+      auto worker = workers[W];
+      ScopedLock lock(worker->lock);
+      auto& queue = worker->queue[P];
+      if (!queue.empty())
+      {
+        fn = queue.front();
+        queue.pop_front();
+        return true;
+      }
+    }
+
+    //steal from the others (newest first, the owner is working on the other end)
+    for (int I = 1; I < N; I++)
+    {
+      auto victim = workers[(W + I) % N];
+      ScopedLock lock(victim->lock);
+      auto& queue = victim->queue[P];
+      if (!queue.empty())
+      {
+        fn = queue.back();
+        queue.pop_back();
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////
+void DataflowExecutor::workerEntryProc(int W)
+{
+  CurrentExecutor = this;
+  CurrentWorker = W;
+
+  while (true)
+  {
+    //claim one of the queued tasks (on exit, the queued tasks are run first)
+    Int64 pushed;
+    {
+      std::unique_lock<std::mutex> lock(wait_lock);
+      wait_task.wait(lock, [&]() {return num_tasks > 0 || bExit; });
+      if (!num_tasks)
+        return;
+      num_tasks--;
+      pushed = num_pushed;
+    }
+
+    //my task is in some queue, but I can miss it while scanning: other workers can take the ones I'm looking at,
+    //while the one left for me is pushed into a queue I have already scanned. Wait for that push, don't spin
+    std::function<void()> fn;
+    while (!popTask(W, fn))
+    {
+      std::unique_lock<std::mutex> lock(wait_lock);
+      wait_push.wait(lock, [&]() {return num_pushed != pushed; });
+      pushed = num_pushed;
+    }
+
+    fn();
+  }
+}
+
+} //namespace Visus
@@ -39,6 +39,7 @@ For support : support@visus.net
 #include <Visus/DataflowModule.h>
 #include <Visus/DataflowPort.h>
 #include <Visus/Dataflow.h>
+#include <Visus/DataflowExecutor.h>
 
 namespace Visus {
 
@@ -53,6 +54,7 @@ void DataflowModule::attach()
   if ((++attached)>1) return;
   KernelModule::attach();
   NodeFactory::getSingleton()->allocSingleton();
+  DataflowExecutor::allocSingleton();
   VISUS_REGISTER_NODE_CLASS(Node);
 }
 
@@ -61,6 +63,7 @@ void DataflowModule::attach()
 void DataflowModule::detach()
 {
   if ((--attached)>0) return;
+  DataflowExecutor::releaseSingleton();
   NodeFactory::getSingleton()->releaseSingleton();
   KernelModule::detach();
 }
@@ -38,6 +38,7 @@ For support : support@visus.net
 
 #include <Visus/Dataflow.h>
 #include <Visus/DataflowNode.h>
+#include <Visus/DataflowExecutor.h>
 #include <Visus/Dataflow.h>
 
 namespace Visus {
@@ -51,6 +52,10 @@ Node::Node() :  dataflow(nullptr),visible(true),parent(nullptr),uuid("")
 Node::~Node()
 {
   VisusAssert(!dataflow);
+
+  //queued jobs have a pointer to the node
+  waitJobs();
+
   for (auto it=inputs .begin();it!=inputs .end();it++) delete it->second;
   for (auto it=outputs.begin();it!=outputs.end();it++) delete it->second;
 }
@@ -233,26 +238,53 @@ void Node::exitFromDataflow()
   joinProcessing();
 }
 
+////////////////////////////////////////////////////////////
+int Node::getNodeJobPriority() const
+{
+  for (auto node = this; node; node = node->parent)
+  {
+    if (!node->visible)
+      return DataflowExecutor::LowPriority;
+  }
+  return DataflowExecutor::NormalPriority;
+}
+
 ////////////////////////////////////////////////////////////
 void Node::abortProcessing()
 {
   VisusAssert(VisusHasMessageLock());
 
+  std::deque< SharedPtr<NodeJob> > cancelled;
   {
     ScopedLock lock(running_lock);
     for (auto it : running)
       it->abort();
+
+    //jobs not started yet are removed right away (no need to wait for a worker to skip them)
+    cancelled.swap(waiting);
+    for (auto it : cancelled)
+      running.erase(it);
   }
-}
 
+  for (auto it : cancelled)
+    it->done.set_value(0);
+}
 
 ////////////////////////////////////////////////////////////
 void Node::joinProcessing()
 {
   VisusAssert(VisusHasMessageLock());
+  waitJobs();
+}
 
-  if (thread_pool)
-    thread_pool->waitAll();
+////////////////////////////////////////////////////////////
+void Node::waitJobs()
+{
+  //signaled by runNextJob when the executor releases the node
+  std::unique_lock<CriticalSection> lock(running_lock);
+  idle.wait(lock, [this]() {
+    return running.empty() && !scheduled;
+  });
 }
 
 ////////////////////////////////////////////////////////////
@@ -261,28 +293,85 @@ void Node::addNodeJob(SharedPtr<NodeJob> job)
   VisusAssert(VisusHasMessageLock());
   VisusAssert(job && getDataflow()!=nullptr);
 
-  //create a thread for the jobs
-  if (!thread_pool)
-    thread_pool=std::make_shared<ThreadPool>(name + " " + "Worker",1);
+  //here and not in the workers, getNodeJobPriority walks the node tree
+  if (job->priority < 0)
+    job->priority = getNodeJobPriority();
 
   {
     ScopedLock lock(running_lock);
     running.insert(job);
+    waiting.push_back(job);
+    if (scheduled)
+      return;
+    scheduled = true;
+  }
+
+  scheduleNextJob();
+}
 
-    job->done.when_ready([this,job](int nworker) {
-      
-      ScopedLock lock(running_lock);
-      running.erase(job);
-    });
+////////////////////////////////////////////////////////////
+void Node::scheduleNextJob()
+{
+  int priority;
+  {
+    ScopedLock lock(running_lock);
+    VisusAssert(scheduled);
+    priority = waiting.empty() ? DataflowExecutor::NormalPriority : waiting.front()->priority;
   }
 
-  ThreadPool::push(thread_pool,[job]()
+  auto executor = DataflowExecutor::getSingleton();
+  if (!executor)
   {
-    if (!job->aborted())
-      job->runJob();
+    runNextJob();
+    return;
+  }
 
-    job->done.set_value(1);
-  });
+  executor->push([this]() {
+    runNextJob();
+  }, priority);
+}
+
+////////////////////////////////////////////////////////////
+void Node::runNextJob()
+{
+  SharedPtr<NodeJob> job;
+  {
+    ScopedLock lock(running_lock);
+
+    //cancelled in the meantime
+    if (waiting.empty())
+    {
+      scheduled = false;
+      idle.notify_all();
+      return;
+    }
+
+    job = waiting.front();
+    waiting.pop_front();
+  }
+
+  if (!job->aborted())
+    job->runJob();
+
+  {
+    ScopedLock lock(running_lock);
+    running.erase(job);
+  }
+
+  job->done.set_value(1);
+
+  //NOTE: after scheduled=false the node can be destroyed (see waitJobs), notify with the lock
+  {
+    ScopedLock lock(running_lock);
+    if (waiting.empty())
+    {
+      scheduled = false;
+      idle.notify_all();
+      return;
+    }
+  }
+
+  scheduleNextJob();
 }
 
 
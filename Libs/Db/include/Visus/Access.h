@@ -50,8 +50,27 @@ class VISUS_DB_API AccessStatistics
 {
 public:
 
-  Int64 rok = 0, rfail = 0;
-  Int64 wok = 0, wfail = 0;
+  //NOTE: atomic since the same access can complete blocks from multiple worker threads (exposed to python as read-only attributes, see VisusDbPy.i)
+#if !SWIG
+  std::atomic<Int64> rok, rfail;
+  std::atomic<Int64> wok, wfail;
+#endif
+
+  //constructor
+  AccessStatistics() : rok(0), rfail(0), wok(0), wfail(0) {
+  }
+
+  //copy constructor
+  AccessStatistics(const AccessStatistics& other) : rok(other.rok.load()), rfail(other.rfail.load()), wok(other.wok.load()), wfail(other.wfail.load()) {
+  }
+
+  //operator=
+  AccessStatistics& operator=(const AccessStatistics& other)
+  {
+    rok = other.rok.load(); rfail = other.rfail.load();
+    wok = other.wok.load(); wfail = other.wfail.load();
+    return *this;
+  }
 
   //reset
   void reset()
@@ -180,6 +199,10 @@ public:
   //writeBlock
   virtual void writeBlock(SharedPtr<BlockQuery> query) = 0;
 
+  //flushBatch (accesses grouping block queries must start the pending ones, otherwise nothing to do)
+  virtual void flushBatch() {
+  }
+
   //beginRead
   void beginRead() {
     beginIO('r');
@@ -216,15 +239,15 @@ public:
 
   //resetStatistics
   void resetStatistics() {
-    statistics = Statistics();
+    statistics.reset();
   }
 
   //printStatistics
   virtual void printStatistics()
   {
     PrintInfo("type", typeid(*this).name(), "chmod", can_read ? "r" : "", can_write ? "w" : "", "bitsperblock", bitsperblock);
-    PrintInfo("rok", statistics.rok, "rfail", statistics.rfail);
-    PrintInfo("wok", statistics.wok, "wfail", statistics.wfail);
+    PrintInfo("rok", statistics.rok.load(), "rfail", statistics.rfail.load());
+    PrintInfo("wok", statistics.wok.load(), "wfail", statistics.wfail.load());
   }
 
   //write
@@ -251,6 +274,12 @@ public:
     query->setFailed(errormsg);
   }
 
+  //readNotStored (the block does not exist, for example in a sparse dataset, it's not an I/O error)
+  void readNotStored(SharedPtr<BlockQuery> query, String errormsg) {
+    query->not_stored = true;
+    readFailed(query, errormsg);
+  }
+
   //writeOk
   void writeOk(SharedPtr<BlockQuery> query) {
     ++statistics.wok;
@@ -83,6 +83,7 @@ public:
   BigInt       blockid = 0;
   int          H = 0;
   LogicSamples logic_samples;
+  bool         not_stored = false; //failed only because the block does not exist (see Access::readNotStored)
 
   //constructor
   BlockQuery() {
@@ -407,6 +407,7 @@ public:
   //executeBlockQueryAndWait
   bool executeBlockQueryAndWait(SharedPtr<Access> access, SharedPtr<BlockQuery> query) {
     executeBlockQuery(access, query);
+    if (access) access->flushBatch();
     query->done.get(); 
     return query->ok();
   }
@@ -450,6 +451,12 @@ public:
   //executeBoxQuery
   virtual bool executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query);
 
+  //readMany (box queries run concurrently on native threads, one access per thread; failed boxes give invalid arrays)
+  std::vector<Array> readMany(std::vector<BoxNi> logic_boxes, Field field, double time, int end_resolution = -1, int nthreads = 0, Aborted aborted = Aborted());
+
+  //prefetchBoxQuery (read the blocks the query would need from cur_resolution to end_resolution without merging them, so that the caching layers of access get them; returns bytes read)
+  virtual Int64 prefetchBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query, Int64 max_bytes = 0);
+
   //mergeBoxQueryWithBlockQuery
   virtual bool mergeBoxQueryWithBlockQuery(SharedPtr<BoxQuery> query, SharedPtr<BlockQuery> block_query);
 
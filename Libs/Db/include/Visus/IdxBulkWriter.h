@@ -0,0 +1,99 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#ifndef __VISUS_DB_IDX_BULK_WRITER_H
+#define __VISUS_DB_IDX_BULK_WRITER_H
+
+#include <Visus/Db.h>
+#include <Visus/Field.h>
+#include <Visus/Array.h>
+
+namespace Visus {
+
+//predeclaration
+class Dataset;
+
+//////////////////////////////////////////////////////////////////////////////
+/*
+Bulk ingest of full resolution samples into a *fresh* IDX v6 dataset (i.e. no *.bin file exists yet for the timestep).
+
+Each slab is split into blocks by a pool of workers (hz reordering and compression run in parallel);
+a block is encoded as soon as all its samples have been written, and a *.bin file is written with one
+sequential append (headers+blocks) as soon as all its blocks are encoded.
+Since blocks are never read back there is no file lock and no read-merge-write.
+
+Slabs must not overlap.
+*/
+class VISUS_DB_API IdxBulkWriter
+{
+public:
+
+  VISUS_PIMPL_CLASS(IdxBulkWriter)
+
+  //constructor (empty fields means all the fields of the dataset; nthreads<=0 means hardware concurrency)
+  IdxBulkWriter(SharedPtr<Dataset> dataset, std::vector<Field> fields = std::vector<Field>(), double time = 0, int nthreads = 0);
+
+  //destructor
+  virtual ~IdxBulkWriter();
+
+  //setCompression (default is field.default_compression)
+  void setCompression(String value);
+
+  //writeSlab (full resolution samples in row major order, one array for each field)
+  void writeSlab(BoxNi logic_box, std::vector<Array> data);
+
+  //writeSlab
+  void writeSlab(BoxNi logic_box, Array data) {
+    writeSlab(logic_box, std::vector<Array>({ data }));
+  }
+
+  //close (encodes blocks not fully covered by slabs and writes all the pending files)
+  void close();
+
+  //getNumWrittenBlocks
+  Int64 getNumWrittenBlocks() const;
+
+  //getNumWrittenFiles
+  Int64 getNumWrittenFiles() const;
+
+};
+
+} //namespace Visus
+
+#endif //__VISUS_DB_IDX_BULK_WRITER_H
@@ -0,0 +1,150 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#ifndef __VISUS_IDX_CLOUD_STORAGE_ACCESS_H
+#define __VISUS_IDX_CLOUD_STORAGE_ACCESS_H
+
+#include <Visus/Db.h>
+#include <Visus/Access.h>
+#include <Visus/IdxFile.h>
+#include <Visus/CloudStorage.h>
+#include <Visus/NetService.h>
+#include <Visus/CriticalSection.h>
+#include <Visus/Time.h>
+
+#include <list>
+
+namespace Visus {
+
+class Dataset;
+
+///////////////////////////////////////////////////////////////////////////////////////
+//read regular IDX v6 *.bin files (file header+block headers+blocks) directly from a bucket using range requests (s3 only)
+//NOTE: it must be owned by a SharedPtr, async callbacks only keep a weak reference to it
+class VISUS_DB_API IdxCloudStorageAccess :
+  public Access,
+  public std::enable_shared_from_this<IdxCloudStorageAccess>
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxCloudStorageAccess)
+
+  //constructor
+  IdxCloudStorageAccess(Dataset* dataset,StringTree config=StringTree());
+
+  //destructor
+  virtual ~IdxCloudStorageAccess();
+
+  //getFilename
+  virtual String getFilename(Field field, double time, BigInt blockid) const override;
+
+  //readBlock 
+  virtual void readBlock(SharedPtr<BlockQuery> query) override;
+
+  //writeBlock
+  virtual void writeBlock(SharedPtr<BlockQuery> query) override {
+    writeFailed(query, "not supported");
+  }
+
+  //endIO
+  virtual void endIO() override {
+    flushBatch(); //blocks of the same file are grouped
+    Access::endIO();
+  }
+
+  //flushBatch
+  virtual void flushBatch() override;
+
+  //printStatistics
+  virtual void printStatistics() override;
+
+private:
+
+  typedef std::vector< SharedPtr<BlockQuery> > Batch;
+
+  //(query,errormsg), an empty errormsg means ok
+  typedef std::vector< std::pair<SharedPtr<BlockQuery>, String> > ReadResults;
+
+  Dataset*                 dataset;
+  IdxFile                  idxfile;
+  StringTree               config;
+  Url                      url;
+  String                   time_template;
+  String                   filename_template;
+
+  SharedPtr<NetService>    netservice;
+  SharedPtr<CloudStorage>  cloud_storage;
+
+  //headers of *.bin files, fetched only once (a failed fetch is retried after missing_headers_ttl msec)
+  struct CachedHeaders
+  {
+    Future< SharedPtr<HeapMemory> > future;
+    Time                            t1;
+    std::list<String>::iterator     lru;
+  };
+
+  CriticalSection                  headers_lock;
+  std::map<String, CachedHeaders>  headers;
+  std::list<String>                headers_lru; //most recently used first
+  int                              max_cached_headers = 4096;
+  Int64                            missing_headers_ttl = 30000;
+
+  //pending block reads, all in the same file
+  Batch                    batch;
+  String                   batch_filename;
+  int                      max_blocks_per_request = 64;
+  Int64                    max_request_size = 16 * 1024 * 1024;
+  Int64                    max_gap = 0;
+
+  std::atomic<Int64>       num_requests;
+
+  //getHeaders
+  Future< SharedPtr<HeapMemory> > getHeaders(String filename);
+
+  //countReadResults
+  void countReadResults(const ReadResults& results);
+
+  //notifyReadResults
+  static void notifyReadResults(const ReadResults& results);
+
+
+};
+
+} //namespace Visus
+
+#endif //__VISUS_IDX_CLOUD_STORAGE_ACCESS_H
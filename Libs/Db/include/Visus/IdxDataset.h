@@ -43,6 +43,7 @@ For support : support@visus.net
 #include <Visus/Dataset.h>
 #include <Visus/IdxFile.h>
 #include <Visus/IdxHzOrder.h>
+#include <Visus/ThreadPool.h>
 
 namespace Visus {
 
@@ -83,6 +84,14 @@ public:
   //readDatasetFromArchive
   virtual void readDatasetFromArchive(Archive& ar) override;
 
+private:
+
+#if !SWIG
+  //workers for big point queries, shared by all the queries
+  CriticalSection        point_query_lock;
+  SharedPtr<ThreadPool>  point_query_pool;
+#endif
+
 };
 
 //swig will use internal casting (see Db.i)
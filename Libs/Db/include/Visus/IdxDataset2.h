@@ -49,6 +49,7 @@ For support : support@visus.net
 namespace idx2 {
   struct idx2_file;
   struct params;
+  struct shared_chunk_cache;
 };
 
 
@@ -178,6 +179,11 @@ public:
     return {};
   }
 
+  //prefetchBoxQuery (not supported, chunks are read by executeBoxQuery)
+  virtual Int64 prefetchBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query, Int64 max_bytes = 0) override {
+    return 0;
+  }
+
   //mergeBoxQueryWithBlockQuery
   virtual bool mergeBoxQueryWithBlockQuery(SharedPtr<BoxQuery> query, SharedPtr<BlockQuery> block_query) override {
     ThrowException("not supported");
@@ -234,6 +240,9 @@ private:
   String           in_dir;
   String           metafile;
 
+  //decompressed chunks shared by all the queries (see VISUS_IDX2_CHUNK_CACHE_SIZE)
+  SharedPtr<idx2::shared_chunk_cache> chunk_cache;
+
   void GetDecodeParams(idx2::params& P,SharedPtr<BoxQuery> query, int H);
 
 };
@@ -49,6 +49,7 @@ namespace Visus {
 
 //predeclaration
 class IdxDataset;
+class IdxDiskAccessOpenFiles;
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -77,6 +78,9 @@ public:
   //disableAsync
   virtual void disableAsync() override;
  
+  //shareOpenFilesWith (read-only accesses to the same dataset can share open files and their headers)
+  void shareOpenFilesWith(SharedPtr<IdxDiskAccess> other);
+
   //getFilename
   virtual String getFilename(Field field, double time, BigInt blockid) const override;
 
@@ -98,11 +102,29 @@ public:
   //releaseWriteLock
   virtual void releaseWriteLock(SharedPtr<BlockQuery> query) override;
 
+#if !SWIG
+public:
+
+  //getFilenameV56 (to locate *.bin files in other storages too)
+  static String getFilenameV56(const IdxFile& idxfile, String time_template, String filename_template, Field field, double time, BigInt blockid);
+
+  //getHeadersSizeV6 (file header followed by the block headers of all fields)
+  static Int64 getHeadersSizeV6(const IdxFile& idxfile);
+
+  //getBlockHeaderV6 (headers must be already in host byte order)
+  static void getBlockHeaderV6(const IdxFile& idxfile, const HeapMemory& headers, Field field, BigInt blockid, Int64& offset, Int32& size, String& compression, String& layout);
+
+  //setBlockHeaderV6 (headers are in host byte order, swap them before writing; false if compression cannot be stored)
+  static bool setBlockHeaderV6(const IdxFile& idxfile, HeapMemory& headers, Field field, BigInt blockid, Int64 offset, Int32 size, String compression, String layout);
+#endif
+
 private:
 
   UniquePtr<Access>     sync, async;
   SharedPtr<ThreadPool> async_tpool;
   IdxFile               idxfile;
+
+  SharedPtr<IdxDiskAccessOpenFiles> open_files;
   bool                  bSkipReading = false;
   bool                  bSkipWriting = false;
 
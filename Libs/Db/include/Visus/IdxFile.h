@@ -117,6 +117,15 @@ public:
       field.default_compression = value;
   }
 
+  //getZstdDictionary (v6 block headers only say "zstd", the dictionary of a field is stored here)
+  String getZstdDictionary(const Field& field) const;
+
+  //setZstdDictionary
+  void setZstdDictionary(String fieldname, String filename);
+
+  //parseZstdDictionary (example "zstd-19-dict=/path/to/dict" -> "/path/to/dict")
+  static String parseZstdDictionary(String compression);
+
   //getMaxFieldSize
   int getMaxFieldSize() const {
     int ret = 0;
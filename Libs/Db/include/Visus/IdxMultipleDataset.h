@@ -42,9 +42,16 @@ For support : support@visus.net
 #include <Visus/Db.h>
 #include <Visus/IdxDataset.h>
 #include <Visus/Color.h>
+#include <Visus/ArrayUtils.h>
+#include <Visus/ThreadPool.h>
+
+#include <list>
 
 namespace Visus {
 
+//predeclaration
+class IdxMultipleExpression;
+
 //////////////////////////////////////////////////////////////////////
 class VISUS_DB_API IdxMultipleDataset  : public IdxDataset
 {
@@ -96,6 +103,10 @@ public:
   {
     VisusAssert(!down_datasets.count(name));
     down_datasets[name] = value;
+#if !SWIG
+    ScopedLock lock(down_lock);
+    down_index.reset();
+#endif
   }
 
 public:
@@ -119,8 +130,19 @@ public:
   //getInputName
   static String getInputName(String dataset_name, String fieldname);
 
-  //executeDownQuery
-  Array executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> ACCESS, String dataset_name, String fieldname);
+  //findDownDatasets (names of the down datasets whose LOGIC footprint intersects LOGIC_BOX)
+  std::vector<String> findDownDatasets(BoxNd LOGIC_BOX);
+
+  //executeDownQuery (bCrop: the returned buffer covers only the QUERY samples inside the down dataset, starting at the PIXEL_OFFSET run time attribute)
+  Array executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> ACCESS, String dataset_name, String fieldname, bool bCrop = false);
+
+#if !SWIG
+  //executeDownQueries (executes in parallel several (dataset_name,fieldname) down queries, see executeDownQuery)
+  std::vector<Array> executeDownQueries(BoxQuery* QUERY, SharedPtr<Access> ACCESS, std::vector< std::pair<String, String> > args, bool bCrop = false);
+#endif
+
+  //blendDownQueries (executes in parallel the down queries of the default fields, and blend them)
+  Array blendDownQueries(BoxQuery* QUERY, SharedPtr<Access> ACCESS, BlendBuffers::Type type);
 
   //computeOuput (to override)
   virtual Array computeOuput(BoxQuery* QUERY, SharedPtr<Access> ACCESS, Aborted aborted, String CODE) const {
@@ -135,6 +157,23 @@ public:
 
 private:
 
+#if !SWIG
+  class DownIndex;
+
+  CriticalSection        down_lock;
+  SharedPtr<DownIndex>   down_index;
+  SharedPtr<ThreadPool>  down_pool;
+
+  //parsed expressions (LRU order, see computeOutputEx)
+  typedef std::pair< SharedPtr<IdxMultipleExpression>, std::list<String>::iterator > CachedExpression;
+  mutable CriticalSection                     expressions_lock;
+  mutable std::map<String, CachedExpression>  expressions;
+  mutable std::list<String>                   expressions_lru;
+#endif
+
+  //computeOutputEx (uses the native expression engine if possible, otherwise computeOuput)
+  Array computeOutputEx(BoxQuery* QUERY, SharedPtr<Access> ACCESS, Aborted aborted, String CODE) const;
+
   //removeAliases
   String removeAliases(String url);
 
@@ -0,0 +1,108 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#ifndef __VISUS_DB_IDX_MULTIPLE_EXPRESSION_H
+#define __VISUS_DB_IDX_MULTIPLE_EXPRESSION_H
+
+#include <Visus/Db.h>
+#include <Visus/Array.h>
+
+#include <stdexcept>
+
+namespace Visus {
+
+//predeclaration
+class IdxMultipleDataset;
+class BoxQuery;
+class Access;
+
+//////////////////////////////////////////////////////////////////////////////
+/*
+Native evaluation of the most common midx field formulas, without the python engine.
+
+Supported:
+  - statements NAME=expr (separated by newlines or ';')
+  - input.A.field, input['A']['field'], input.A.B.field (midx of midx)
+  - numbers, query_time, lists [a,b,...], + - * / with arrays and numbers, component picking a[C]
+  - ArrayUtils.add|sub|mul|div|min|max|average|standardDeviation|median|interleave|sqrt
+  - voronoi(), noBlend(), averageBlend() with or without a list of arrays
+
+All the down queries of the formula are executed in parallel before evaluating it.
+Anything else (loops, imports, doPublish, timesteps...) needs the python engine (i.e. parse returns null).
+Errors found only while evaluating (for example an operator on a list) throw NotSupported, the caller should use the python engine.
+*/
+class VISUS_DB_API IdxMultipleExpression
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxMultipleExpression)
+
+  class Node;
+
+  //NotSupported (the code needs the python engine, it's not an error so it's not logged)
+  class NotSupported : public std::runtime_error
+  {
+  public:
+
+    //constructor
+    NotSupported(String what) : std::runtime_error(what) {
+    }
+  };
+
+  //constructor
+  IdxMultipleExpression();
+
+  //destructor
+  ~IdxMultipleExpression();
+
+  //parse (returns null if the code is not supported)
+  static SharedPtr<IdxMultipleExpression> parse(String code);
+
+  //evaluate (QUERY==nullptr means I'm just interested in the dtype of the output, can throw NotSupported)
+  Array evaluate(IdxMultipleDataset* DATASET, BoxQuery* QUERY, SharedPtr<Access> ACCESS, Aborted aborted) const;
+
+private:
+
+  std::vector< std::pair<String, SharedPtr<Node> > > statements;
+  std::vector< SharedPtr<Node> > inputs;
+
+};
+
+} //namespace Visus
+
+#endif //__VISUS_DB_IDX_MULTIPLE_EXPRESSION_H
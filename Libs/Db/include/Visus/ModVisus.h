@@ -58,6 +58,12 @@ public:
   //default_public
   bool default_public = true;
 
+  //cache_size (decoded blocks kept in RAM, shared by all published datasets, 0 means disabled)
+  Int64 cache_size = 0;
+
+  //version_ttl (seconds a dataset version is trusted before the data files are checked again)
+  int version_ttl = 60;
+
   //constructor
   ModVisus();
 
@@ -78,8 +84,12 @@ public:
 private:
 
   class PublicDatasets;
+  class InFlight;
+  class ResponseCache;
 
   SharedPtr<PublicDatasets>  m_datasets;
+  SharedPtr<InFlight>        in_flight;
+  SharedPtr<ResponseCache>   response_cache;
 
   String                     config_filename;
 
@@ -99,6 +109,9 @@ private:
   //getDatasets
   SharedPtr<PublicDatasets> getDatasets();
 
+  //getResponseCache
+  SharedPtr<ResponseCache> getResponseCache();
+
   //all requests
   NetResponse handleReadDataset      (const NetRequest& request);
   NetResponse handleGetListOfDatasets(const NetRequest& request);
@@ -106,6 +119,18 @@ private:
   NetResponse handleBoxQuery         (const NetRequest& request);
   NetResponse handlePointQuery       (const NetRequest& request);
 
+  //getETag (empty if the response cannot be cached)
+  String getETag(const NetRequest& request, String action);
+
+  //getBodyDigest
+  static String getBodyDigest(const NetRequest& request);
+
+  //isCacheable
+  static bool isCacheable(const NetResponse& response);
+
+  //handleCachedQuery
+  NetResponse handleCachedQuery(const NetRequest& request, String action, std::function<NetResponse()> fn);
+
   //trackConfigChangesInBackground
   void trackConfigChangesInBackground();
 
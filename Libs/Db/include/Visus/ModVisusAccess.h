@@ -42,6 +42,11 @@ For support : support@visus.net
 #include <Visus/Db.h>
 #include <Visus/Access.h>
 #include <Visus/NetService.h>
+#include <Visus/CriticalSection.h>
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 namespace Visus {
 
@@ -76,27 +81,66 @@ public:
     Access::endIO();
   }
 
+  //flushBatch
+  virtual void flushBatch() override;
+
   //printStatistics
-  virtual void printStatistics() override {
-    PrintInfo(name, "hostname", url.getHostname(), "port", url.getPort(), "compression", compression, "url", url.toString());
-    Access::printStatistics();
-  }
+  virtual void printStatistics() override;
+
+  //getNumQueriesPerRequest (adapted to the bandwidth-delay product of the link)
+  int getNumQueriesPerRequest();
 
 private:
 
   typedef std::vector< SharedPtr<BlockQuery> > Batch;
 
+  class Pending
+  {
+  public:
+    Batch batch;
+    Time  t1;
+  };
+
   StringTree             config;
   Url                    url;
   SharedPtr<NetService>  netservice;
 
-  Batch batch;
+  //one pending batch for each field/time/aborted
+  std::vector<Pending> pendings;
+
+  //the flush thread sends the batches waiting for too long, even if no other query comes
+  std::mutex              pendings_lock;
+  std::condition_variable pendings_changed;
+  SharedPtr<std::thread>  flush_thread;
+  bool                    bExit = false;
 
-  //num_queries_per_request
+  //min/max number of blocks in a request
   int num_queries_per_request=1;
+  int max_queries_per_request=1;
 
-  //flushBatch
-  void flushBatch();
+  //a batch is sent anyway when its first query has been waiting this long
+  int batch_window_msec = 10;
+
+  //link estimation (updated by the network thread)
+  CriticalSection stats_lock;
+  double latency = 0;    //seconds to first byte
+  double bandwidth = 0;  //bytes per second
+  double block_size = 0; //encoded bytes per block
+
+  //sendBatch
+  void sendBatch(Batch batch);
+
+  //popExpiredBatches (must have the pendings lock)
+  std::vector<Batch> popExpiredBatches(int num_queries_per_request);
+
+  //runInBackground
+  void runInBackground();
+
+  //onBlockResponse
+  void onBlockResponse(SharedPtr<BlockQuery> query, NetResponse response);
+
+  //updateStatistics
+  void updateStatistics(int nqueries, Int64 nbytes, Int64 first_byte_msec, Int64 total_msec);
 
 };
 
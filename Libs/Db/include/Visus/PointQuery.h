@@ -60,15 +60,24 @@ public:
 
   PointNi               npoints;
   SharedPtr<HeapMemory> points = std::make_shared<HeapMemory>();
+  bool                  explicit_points = false; //true if set by setPoints(Array), in this case logic_position is not needed
 
   int                   start_resolution = 0; //always zero
   int                   cur_resolution = -1;
   int                   end_resolution = -1;
   std::vector<int>      end_resolutions;
 
-  //blockid -> (point-cloud-offset, block-offset)*
-  typedef std::vector< std::pair<BigInt, BigInt> > Offsets;
-  std::map< BigInt, SharedPtr< Offsets > > offsets;
+  //points grouped by block, in hz order (see createBlockQueriesForPointQuery)
+#if !SWIG
+  struct
+  {
+    std::vector<BigInt>  blocks;        //sorted block ids
+    std::vector<Int64>   begin;         //points of blocks[I] are in range [begin[I],begin[I+1])
+    std::vector<Int64>   point_offset;  //offset in the query buffer
+    std::vector<Int64>   block_offset;  //offset in the (row major) block buffer
+  }
+  offsets;
+#endif
 
   //constructor
   PointQuery() {
@@ -84,9 +93,26 @@ public:
     return field.dtype.getByteSize(getNumberOfPoints());
   }
 
-  //setPoints
+  //setPoints (regular grid of points inside logic_position, pdim<=3)
   bool setPoints(PointNi nsamples);
 
+  //setPoints (arbitrary logic points, int64 array with dims (pdim,npoints...))
+  bool setPoints(Array points);
+
+#if !SWIG
+  //getBlockPoints
+  bool getBlockPoints(BigInt blockid, Int64& begin, Int64& end) const
+  {
+    auto it = std::lower_bound(offsets.blocks.begin(), offsets.blocks.end(), blockid);
+    if (it == offsets.blocks.end() || *it != blockid)
+      return false;
+    auto I = it - offsets.blocks.begin();
+    begin = offsets.begin[I];
+    end   = offsets.begin[I + 1];
+    return true;
+  }
+#endif
+
 
   //getCurrentResolution
   int getCurrentResolution() const {
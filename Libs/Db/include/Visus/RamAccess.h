@@ -65,7 +65,12 @@ public:
   //shareMemoryWith
   void shareMemoryWith(SharedPtr<RamAccess> value);
 
-  //readBlock
+  //setKeyPrefix (keeps apart the blocks of different datasets sharing the same memory)
+  void setKeyPrefix(String value) {
+    this->key_prefix = value;
+  }
+
+  //readBlock (cache hits share the cached buffer, do not modify it)
   virtual void readBlock(SharedPtr<BlockQuery> query) override;
 
   //writeBlock
@@ -78,6 +83,8 @@ private:
 
   class Shared;
   SharedPtr<Shared> shared;
+  int               num_shards = 16;
+  String            key_prefix;
 
 };
 
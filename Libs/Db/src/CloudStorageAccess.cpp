@@ -121,7 +121,15 @@ void CloudStorageAccess::readBlock(SharedPtr<BlockQuery> query)
   cloud_storage->getBlob(netservice, blob_name, /*head*/false, /*range*/{0,0}, query->aborted).when_ready([this, query](SharedPtr<CloudStorageItem> blob) {
 
     if (!blob || !blob->valid())
-      return readFailed(query, query->aborted()? "query aborted" : "blob not valid");
+    {
+      if (query->aborted())
+        return readFailed(query, "query aborted");
+
+      if (blob && blob->status == HttpStatus::STATUS_NOT_FOUND)
+        return readNotStored(query, "blob not stored");
+
+      return readFailed(query, "blob not valid");
+    }
 
     auto compression = getCompression();
 
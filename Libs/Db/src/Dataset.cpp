@@ -41,6 +41,8 @@ For support : support@visus.net
 #include <Visus/MultiplexAccess.h>
 #include <Visus/CloudStorageAccess.h>
 #include <Visus/RamAccess.h>
+#include <Visus/PackedCacheAccess.h>
+#include <Visus/IdxCloudStorageAccess.h>
 #include <Visus/NetService.h>
 #include <Visus/StringTree.h>
 #include <Visus/Polygon.h>
@@ -57,6 +59,10 @@ For support : support@visus.net
 #include <Visus/IdxDiskAccess.h>
 #include <Visus/IdxFilter.h>
 #include <Visus/IdxDataset2.h>
+#include <Visus/ThreadPool.h>
+#include <Visus/CriticalSection.h>
+
+#include <atomic>
 
 namespace Visus {
 
@@ -74,19 +80,24 @@ public:
     //only row major supported
     VisusReleaseAssert(block_query->buffer.layout.empty());
 
+    Int64 begin, end;
+    if (!query->getBlockPoints(block_query->blockid, begin, end))
+      return false;
+
+    auto Q = query->buffer.c_ptr<Sample*>();
+    auto B = block_query->buffer.c_ptr<Sample*>();
+    auto point_offset = query->offsets.point_offset.data();
+    auto block_offset = query->offsets.block_offset.data();
+
     if (block_query->mode == 'r')
     {
-      auto query_samples = GetSamples<Sample>(query->buffer);
-      auto block_samples = GetSamples<Sample>(block_query->buffer);
-      for (auto it : *query->offsets[block_query->blockid])
-        query_samples[it.first] = block_samples[it.second];
+      for (Int64 I = begin; I < end; I++)
+        Q[point_offset[I]] = B[block_offset[I]];
     }
     else
     {
-      auto block_samples = GetSamples<Sample>(block_query->buffer);
-      auto query_samples = GetSamples<Sample>(query->buffer);
-      for (auto it : *query->offsets[block_query->blockid])
-        block_samples[it.second] = query_samples[it.first];
+      for (Int64 I = begin; I < end; I++)
+        B[block_offset[I]] = Q[point_offset[I]];
     }
 
     return true;
@@ -187,7 +198,7 @@ StringTree FindDatasetConfig(StringTree ar, String url)
 /// ////////////////////////////////////////////////////////////////
 void EnableCachingIfNeeded(String& url, Archive& ar)
 {
-  //special case for cached dataset (use cached=1|idx for IdxDiskCaching, cached=2|disk for DiskCaching)
+  //special case for cached dataset (use cached=1|idx for IdxDiskCaching, cached=2|disk for DiskCaching, cached=3|packed for PackedCacheAccess)
   //Example:
   //   http://atlantis.sci.utah.edu/mod_visus?dataset=2kbit1&cached=1
   //   https://mghp.osn.xsede.org/vpascuccibucket1/visus-server-foam/visus.idx?compression=zip&layout=hzorder&cached=1
@@ -217,13 +228,15 @@ void EnableCachingIfNeeded(String& url, Archive& ar)
   //cached is extracted from the url
   String cached = StringUtils::toLower(parsed.getParam("cached", "idx")); //TODO: not sure if it's better to use "idx" or "disk" here
 
-  //1 || idx means to use IdxDiskAccess; 2| disk means to use Disk Access
+  //1 || idx means to use IdxDiskAccess; 2| disk means to use Disk Access; 3 | packed means to use PackedCacheAccess
   String cache_access_type;
 
   if (cached == "1" || StringUtils::contains(cached, "idx"))
     cache_access_type = "IdxDiskAccess";
   else if (cached == "2" || StringUtils::contains(cached, "arco"))
     cache_access_type = "DiskAccess";
+  else if (cached == "3" || StringUtils::contains(cached, "packed"))
+    cache_access_type = "PackedCacheAccess";
   else
     cache_access_type = "IdxDiskAccess"; //default is this
 
@@ -482,8 +495,14 @@ SharedPtr<Access> Dataset::createAccess(StringTree config,bool for_block_query)
         VisusAssert(url.isRemote());
 
         //if the IDX is on the cloud (i.e. S3) I think it's an ARCO database
+        //unless it's a regular IDX (i.e. *.bin files with headers) stored as it is in the bucket
         if (bool is_cloud = !CloudStorage::guessType(url).empty())
-          return std::make_shared<CloudStorageAccess>(this, config);
+        {
+          if (cbool(config.readString("packed", url.getParam("packed", "0"))))
+            return std::make_shared<IdxCloudStorageAccess>(this, config);
+          else
+            return std::make_shared<CloudStorageAccess>(this, config);
+        }
 
         //otherwise it's a regular modvisus dataset
         if (for_block_query)
@@ -498,6 +517,10 @@ SharedPtr<Access> Dataset::createAccess(StringTree config,bool for_block_query)
     if (type == "disk" || type == "idxdiskaccess")
       return std::make_shared<IdxDiskAccess>(idx, config);
 
+    //IdxCloudStorageAccess
+    if (type == "idxcloudstorageaccess" || type == "cloudidx")
+      return std::make_shared<IdxCloudStorageAccess>(this, config);
+
     //IdxMultipleAccess
     if (type == "idxmultipleaccess" || type == "midx" || type == "multipleaccess")
     {
@@ -528,6 +551,10 @@ SharedPtr<Access> Dataset::createAccess(StringTree config,bool for_block_query)
   if (type=="diskaccess")
     return std::make_shared<DiskAccess>(this, config);
 
+  //PackedCacheAccess
+  if (type == "packedcache" || type == "packedcacheaccess")
+    return std::make_shared<PackedCacheAccess>(this, config);
+
   // MULTIPLEX 
   if (type=="multiplex" || type=="multiplexaccess")
     return std::make_shared<MultiplexAccess>(this, config);
@@ -609,11 +636,26 @@ void Dataset::compressDataset(std::vector<String> compression, Array data)
   while (compression.size() < nlevels)
     compression.insert(compression.begin(), compression.front());
 
-  //save the new idx file oonly if compression is equal for all levels
-  if (std::set<String>(compression.begin(), compression.end()).size() == 1)
+  //zstd dictionaries must be in the idx file, since block headers only say "zstd"
+  std::set<String> dictionaries;
+  for (auto it : compression)
+    dictionaries.insert(IdxFile::parseZstdDictionary(it));
+  dictionaries.erase("");
+  if (dictionaries.size() > 1)
+    ThrowException("only one zstd dictionary is supported");
+
+  //save the new idx file oonly if compression is equal for all levels (or there is a dictionary)
+  bool bSameCompression = std::set<String>(compression.begin(), compression.end()).size() == 1;
+  if (bSameCompression || !dictionaries.empty())
   {
     for (auto& field : idxfile.fields)
-      field.default_compression = compression[0];
+    {
+      if (bSameCompression)
+        field.default_compression = compression[0];
+
+      if (!dictionaries.empty())
+        idxfile.setZstdDictionary(field.name, *dictionaries.begin());
+    }
 
     String filename = Url(getUrl()).getPath();
     idxfile.save(filename);
@@ -1167,9 +1209,9 @@ bool Dataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> quer
 
       auto write_block = createBlockQuery(read_block->blockid, query->field, query->time, 'w', query->aborted);
 
-      //read ok
+      //read ok (copy on write, a cache can share the same buffer)
       if (read_block->ok())
-        write_block->buffer = read_block->buffer;
+        write_block->buffer = read_block->buffer.heap.use_count() > 1 ? read_block->buffer.clone() : read_block->buffer;
       //I don't care if it fails... maybe does not exist
       else
         write_block->allocateBufferIfNeeded();
@@ -1194,6 +1236,8 @@ bool Dataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> quer
 
   if (bEndIO) 
     access->endIO();
+  else
+    access->flushBatch(); //the caller is keeping the access open
 
   wait_async.waitAllDone();
 
@@ -1210,6 +1254,104 @@ bool Dataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> quer
 
 }
 
+//////////////////////////////////////////////////////////////
+std::vector<Array> Dataset::readMany(std::vector<BoxNi> logic_boxes, Field field, double time, int end_resolution, int nthreads, Aborted aborted)
+{
+  int N = (int)logic_boxes.size();
+  std::vector<Array> ret(N);
+
+  if (nthreads <= 0)
+    nthreads = std::max(1, (int)std::thread::hardware_concurrency());
+  nthreads = std::max(1, std::min(nthreads, N));
+
+  //accesses are not thread safe, one for each worker
+  std::vector< SharedPtr<Access> > accesses(nthreads);
+  for (int T = 0; T < nthreads; T++)
+    accesses[T] = createAccess();
+
+  std::atomic<int> next(0);
+  auto thread_pool = nthreads > 1 ? std::make_shared<ThreadPool>("ReadMany Worker", nthreads) : SharedPtr<ThreadPool>();
+  for (int T = 0; T < nthreads; T++)
+  {
+    ThreadPool::push(thread_pool, [&, T]()
+    {
+      for (int I = next++; I < N && !aborted(); I = next++)
+      {
+        //a failed box is an invalid array, an exception must not take down the worker
+        try
+        {
+          auto query = createBoxQuery(logic_boxes[I], field, time, 'r', aborted);
+          if (end_resolution >= 0)
+            query->end_resolutions = { end_resolution };
+
+          beginBoxQuery(query);
+          if (query->isRunning() && executeBoxQuery(accesses[T], query))
+            ret[I] = query->buffer;
+        }
+        catch (std::exception& ex)
+        {
+          PrintWarning("readMany box", logic_boxes[I].toString(), "failed", ex.what());
+          ret[I] = Array();
+          accesses[T] = createAccess(); //could have been left in the middle of an I/O
+        }
+      }
+    });
+  }
+
+  if (thread_pool)
+    thread_pool->waitAll();
+
+  return ret;
+}
+
+//////////////////////////////////////////////////////////////
+Int64 Dataset::prefetchBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query, Int64 max_bytes)
+{
+  if (!access || !query || !query->isRunning() || query->aborted())
+    return 0;
+
+  if (query->filter.dataset_filter)
+    return 0;
+
+  auto blocks = createBlockQueriesForBoxQuery(query);
+  auto block_size = query->field.dtype.getByteSize((Int64)1 << getDefaultBitsPerBlock());
+
+  WaitAsync< Future<Void> > wait_async(/*max_running*/512);
+
+  bool bEndIO = false;
+  if (!access->isReading())
+  {
+    bEndIO = true;
+    access->beginRead();
+  }
+
+  //blocks are sorted by resolution, so the coarse ones come first when the budget is low
+  //NOTE: only the blocks actually read count (a failed or not stored block is not in the cache)
+  std::atomic<Int64> ret(0);
+  Int64 issued = 0;
+  for (auto blockid : blocks)
+  {
+    if (query->aborted() || (max_bytes > 0 && issued + block_size > max_bytes))
+      break;
+
+    auto block_query = createBlockQuery(blockid, query->field, query->time, 'r', query->aborted);
+    executeBlockQuery(access, block_query);
+    wait_async.pushRunning(block_query->done, [block_query, block_size, &ret](Void) {
+      if (block_query->ok())
+        ret += block_size;
+    });
+    issued += block_size;
+  }
+
+  if (bEndIO)
+    access->endIO();
+  else
+    access->flushBatch();
+
+  wait_async.waitAllDone();
+  return ret.load();
+}
+
 //////////////////////////////////////////////////////////////
 void Dataset::nextBoxQuery(SharedPtr<BoxQuery> query)
 {
@@ -1681,13 +1823,11 @@ void Dataset::beginPointQuery(SharedPtr<PointQuery> query)
   //if you want to set a buffer for 'w' queries, please do it after begin
   VisusAssert(!query->buffer.valid());
 
-  if (getPointDim() != 3)
-    return query->setFailed("pointquery supported only in 3d so far");
-
   if (!query->field.valid())
     return query->setFailed("field not valid");
 
-  if (!query->logic_position.valid())
+  //explicit points (see PointQuery::setPoints(Array)) do not need a position
+  if (!query->logic_position.valid() && !query->explicit_points)
     return query->setFailed("position not valid");
 
   // override time from field
@@ -2015,9 +2155,26 @@ NetRequest Dataset::createPointQueryRequest(SharedPtr<PointQuery> query)
   request.url.setParam("fromh", cstring(0)); //backward compatible
   request.url.setParam("toh", cstring(query->end_resolution));
   request.url.setParam("maxh", cstring(getMaxResolution())); //backward compatible
-  request.url.setParam("matrix", query->logic_position.getTransformation().toString());
-  request.url.setParam("box", query->logic_position.getBoxNd().toBox3().toString(/*bInterleave*/false));
-  request.url.setParam("nsamples", query->getNumberOfPoints().toString());
+
+  //explicit points are sent in the body
+  if (query->explicit_points)
+  {
+    auto npoints = query->getNumberOfPoints();
+    PointNi dims;
+    dims.push_back(getPointDim());
+    for (int D = 0; D < npoints.getPointDim(); D++)
+      dims.push_back(npoints[D]);
+
+    request.method = "POST";
+    if (!request.setArrayBody("zip", Array(dims, DTypes::INT64, query->points)))
+      return NetRequest();
+  }
+  else
+  {
+    request.url.setParam("matrix", query->logic_position.getTransformation().toString());
+    request.url.setParam("box", query->logic_position.getBoxNd().toBox3().toString(/*bInterleave*/false));
+    request.url.setParam("nsamples", query->getNumberOfPoints().toString());
+  }
 
   request.aborted = query->aborted;
 
@@ -2107,124 +2264,194 @@ bool Dataset::computeFilter(SharedPtr<IdxFilter> filter, double time, Field fiel
 {
   VisusAssert(!blocksFullRes());
 
-  //this works only for filter_size==2, otherwise the building of the sliding_window is very difficult
+  //this works only for filter_size==2 (i.e. each filter group is made of two samples)
   VisusAssert(filter->size == 2);
 
+  /* NOTE: SlidingWindow is not used anymore, kept for backward compatibility
+
+  The dataset is split in sub-trees rooted at level Hs (cells):
+    - the filter groups of levels >Hs are all inside one cell, so a cell can be filtered in memory, fine to coarse, without looking at other cells
+    - the blocks of levels >Hc (Hc=Hs+bitsperblock) are all inside one cell, so each one is read and written only once
+    - the samples of levels <=Hc are shared among cells and are kept in a coarse in-memory buffer, filtered at the end for levels <=Hs
+
+  The cells are processed in parallel (at most VISUS_FILTER_MAX_MEMORY bytes of cells in memory), the IO is serialized
+  */
+
+  auto t1 = Time::now();
+
   DatasetBitmask bitmask = this->idxfile.bitmask;
   BoxNi          box = this->getLogicBox();
+  int            maxh = this->getMaxResolution();
+  int            bitsperblock = this->getDefaultBitsPerBlock();
+
+  //same number of samples for a cell and for the coarse buffer
+  int Hs = maxh - bitsperblock > 1 ? (maxh - bitsperblock + 1) / 2 : maxh;
+  if (auto env = getenv("VISUS_FILTER_SUBTREE_RESOLUTION"))
+    Hs = Utils::clamp(cint(String(env)), 0, maxh);
+
+  //no block owned by a single cell, everything in the coarse buffer
+  int Hc = std::min(maxh, Hs + bitsperblock);
+  if (Hc == maxh)
+    Hs = maxh;
+
+  auto coarse = createBoxQuery(box, field, time, 'r');
+  coarse->setResolutionRange(0, Hc);
+  beginBoxQuery(coarse);
+  if (!executeBoxQuery(access, coarse))
+    return false;
 
-  int pdim = bitmask.getPointDim();
-
-  //the window size must be multiple of 2, otherwise I loose the filter alignment
-  for (int D = 0; D < pdim; D++)
+  if (Hs < maxh)
   {
-    Int64 size = SlidingWindow[D];
-    VisusAssert(size == 1 || (size / 2) * 2 == size);
-  }
+    PointNi cell_size = bitmask.getPow2Dims();
+    for (int H = 1; H <= Hs; H++)
+      cell_size[bitmask[H]] >>= 1;
+
+    PointNi From = box.p1;
+    for (int D = 0; D < bitmask.getPointDim(); D++)
+      From[D] = Utils::alignLeft(From[D], (Int64)0, cell_size[D]);
+
+    std::vector<BoxNi> cells;
+    for (auto P = ForEachPoint(From, box.p2, cell_size); !P.end(); P.next())
+    {
+      auto cell = BoxNi(P.pos, P.pos + cell_size).getIntersection(box);
+      if (cell.isFullDim())
+        cells.push_back(cell);
+    }
 
-  //convert the dataset  FINE TO COARSE, this can be really time consuming!!!!
-  for (int H = this->getMaxResolution(); H >= 1; H--)
-  {
     if (bVerbose)
-      PrintInfo("Applying filter to dataset resolution", H);
+      PrintInfo("Applying filter to dataset resolution", maxh, "..", Hs + 1, "ncells", cells.size());
 
-    int bit = bitmask[H];
+    int nthreads = std::max(1, (int)std::thread::hardware_concurrency());
+    if (auto env = getenv("VISUS_FILTER_NUM_THREADS"))
+      nthreads = std::max(1, cint(String(env)));
 
-    Int64 FILTERSTEP = filter->getFilterStep(H)[bit];
+    //each worker keeps a full resolution cell and its blocks in memory, so the number of workers is bounded by the memory budget
+    Int64 max_memory = (Int64)2 * 1024 * 1024 * 1024;
+    if (auto env = getenv("VISUS_FILTER_MAX_MEMORY"))
+      max_memory = StringUtils::getByteSizeFromString(String(env));
 
-    //need to align the from so that the first sample is filter-aligned
-    PointNi From = box.p1;
+    Int64 cell_memory = std::max((Int64)1, 2 * field.dtype.getByteSize(cell_size));
+    nthreads = (int)Utils::clamp(max_memory / cell_memory, (Int64)1, (Int64)nthreads);
 
-    if (!Utils::isAligned(From[bit], (Int64)0, FILTERSTEP))
-      From[bit] = Utils::alignLeft(From[bit], (Int64)0, FILTERSTEP) + FILTERSTEP;
+    if (bVerbose)
+      PrintInfo("Filter nthreads", nthreads, "cell memory", StringUtils::getStringFromByteSize(cell_memory));
 
-    PointNi To = box.p2;
-    for (auto P = ForEachPoint(From, To, SlidingWindow); !P.end(); P.next())
-    {
-      //this is the sliding window
-      BoxNi sliding_window(P.pos, P.pos + SlidingWindow);
+    auto thread_pool = nthreads > 1 ? std::make_shared<ThreadPool>("Filter Worker", nthreads) : SharedPtr<ThreadPool>();
 
-      //important! crop to the stored world box to be sure that the alignment with the filter is correct!
-      sliding_window = sliding_window.getIntersection(box);
+    //blocks before this one have samples in the coarse buffer
+    BigInt first_blockid = ((BigInt)1) << (Hc - bitsperblock);
 
-      //no valid box since do not intersect with box 
-      if (!sliding_window.isFullDim())
-        continue;
+    CriticalSection io_lock;
+    std::atomic<bool> bFailed(false);
 
-      //I'm sure that since the From is filter-aligned, then P must be already aligned
-      VisusAssert(Utils::isAligned(sliding_window.p1[bit], (Int64)0, FILTERSTEP));
+    access->beginWrite();
+    for (auto cell_box : cells)
+    {
+      ThreadPool::push(thread_pool, [&, cell_box]()
+      {
+        if (bFailed)
+          return;
 
-      //important, i'm not using adjustBox because I'm sure it is already correct!
-      auto read = createBoxQuery(sliding_window, field, time, 'r');
-      read->setResolutionRange(0, H);
+        auto read = createBoxQuery(cell_box, field, time, 'r');
+        read->setResolutionRange(0, maxh);
+        beginBoxQuery(read);
 
-      beginBoxQuery(read);
+        auto write = createBoxQuery(cell_box, field, time, 'w');
+        write->setResolutionRange(0, maxh);
+        beginBoxQuery(write);
 
-      if (!executeBoxQuery(access, read))
-        return false;
+        if (!read->isRunning() || !write->isRunning() || !read->allocateBufferIfNeeded())
+          return (void)(bFailed = true);
 
-      //if you want to debug step by step...
-#if 0
-      {
-        PrintInfo("Before");
-        int nx = (int)read->buffer->dims.x;
-        int ny = (int)read->buffer->dims.y;
-        Uint8* SRC = read->buffer->c_ptr();
-        std::ostringstream out;
-        for (int Y = 0; Y < ny; Y++)
+        std::vector< SharedPtr<BlockQuery> > blocks;
+        for (auto blockid : createBlockQueriesForBoxQuery(read))
         {
-          for (int X = 0; X < nx; X++)
+          if (blockid < first_blockid)
+            continue;
+
+          auto block = createBlockQuery(blockid, field, time, 'r', read->aborted);
           {
-            out << std::setw(3) << (int)SRC[((ny - Y - 1) * nx + X) * 2] << " ";
+            ScopedLock lock(io_lock);
+            executeBlockQueryAndWait(access, block);
           }
-          out << std::endl;
+
+          //I don't care if the read fails... maybe does not exist
+          if (block->ok())
+            mergeBoxQueryWithBlockQuery(read, block);
+
+          blocks.push_back(block);
         }
-        out << std::endl;
-        PrintInfo("\n" << out.str();
-      }
-#endif
 
-      filter->internalComputeFilter(read.get(),/*bInverse*/false);
+        insertSamples(read->logic_samples, read->buffer, coarse->logic_samples, coarse->buffer, read->aborted);
 
-      //if you want to debug step by step...
-#if 0 
-      {
-        PrintInfo("After");
-        int nx = (int)read->buffer->dims.x;
-        int ny = (int)read->buffer->dims.y;
-        Uint8* SRC = read->buffer->c_ptr();
-        std::ostringstream out;
-        for (int Y = 0; Y < ny; Y++)
+        for (int H = maxh; H > Hs; H--)
         {
-          for (int X = 0; X < nx; X++)
-          {
-            out << std::setw(3) << (int)SRC[((ny - Y - 1) * nx + X) * 2] << " ";
-          }
-          out << std::endl;
+          read->setCurrentResolution(H);
+          filter->internalComputeFilter(read.get(),/*bInverse*/false);
         }
-        out << std::endl;
-        PrintInfo("\n", out.str());
-      }
-#endif
 
-      auto write = createBoxQuery(sliding_window, field, time, 'w');
-      write->setResolutionRange(0, H);
+        //coarse samples of different cells do not overlap
+        insertSamples(coarse->logic_samples, coarse->buffer, read->logic_samples, read->buffer, read->aborted);
+
+        write->buffer = read->buffer;
+        for (auto read_block : blocks)
+        {
+          auto write_block = createBlockQuery(read_block->blockid, field, time, 'w', read->aborted);
 
-      beginBoxQuery(write);
+          //copy on write, a cache can share the same buffer
+          if (read_block->ok())
+            write_block->buffer = read_block->buffer.heap.use_count() > 1 ? read_block->buffer.clone() : read_block->buffer;
+          else
+            write_block->allocateBufferIfNeeded();
 
-      if (!write->isRunning())
-        return false;
+          //here a change in the layout (hzorder) can happen
+          mergeBoxQueryWithBlockQuery(write, write_block);
 
-      write->buffer = read->buffer;
+          ScopedLock lock(io_lock);
+          access->acquireWriteLock(write_block);
+          executeBlockQueryAndWait(access, write_block);
+          access->releaseWriteLock(write_block);
 
-      if (!executeBoxQuery(access, write))
-        return false;
+          if (write_block->failed())
+            bFailed = true;
+        }
+      });
     }
 
-    //I'm going to write the next resolution, double the dimension along the current axis
-    //in this way I have the same number of samples!
-    SlidingWindow[bit] <<= 1;
+    if (thread_pool)
+      thread_pool->waitAll();
+
+    access->endIO();
+
+    if (bFailed)
+      return false;
+  }
+
+  //coarse levels
+  if (bVerbose)
+    PrintInfo("Applying filter to dataset resolution", Hs, "..", 1);
+
+  for (int H = Hs; H >= 1; H--)
+  {
+    coarse->setCurrentResolution(H);
+    filter->internalComputeFilter(coarse.get(),/*bInverse*/false);
   }
+
+  auto write = createBoxQuery(box, field, time, 'w');
+  write->setResolutionRange(0, Hc);
+  beginBoxQuery(write);
+
+  if (!write->isRunning())
+    return false;
+
+  write->buffer = coarse->buffer;
+
+  if (!executeBoxQuery(access, write))
+    return false;
+
+  if (bVerbose)
+    PrintInfo("Filter computed in", t1.elapsedMsec(), "msec");
+
   return true;
 }
 
@@ -193,7 +193,7 @@ void DiskAccess::readBlock(SharedPtr<BlockQuery> query)
   auto FAILED = [&](String reason) {
     if (bVerbose)
       PrintInfo("DiskAccess::read blockid", query->blockid, "filename", filename, "failed ", reason);
-    return readFailed(query, "filename empty");
+    return readFailed(query, reason);
   };
 
   auto OK = [&]() {
@@ -208,6 +208,13 @@ void DiskAccess::readBlock(SharedPtr<BlockQuery> query)
   if (query->aborted())
     return FAILED("query aborted");
 
+  //a missing block file means the block is not stored
+  if (!FileUtils::existsFile(filename))
+  {
+    query->not_stored = true;
+    return FAILED(cstring("file not stored", filename));
+  }
+
   auto encoded=std::make_shared<HeapMemory>();
   if (!encoded->resize(FileUtils::getFileSize(filename),__FILE__,__LINE__))
     return FAILED("cannot create encoded buffer");
@@ -0,0 +1,531 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#include <Visus/IdxBulkWriter.h>
+#include <Visus/IdxDiskAccess.h>
+#include <Visus/Dataset.h>
+#include <Visus/ThreadPool.h>
+#include <Visus/ByteOrder.h>
+#include <Visus/File.h>
+#include <Visus/Path.h>
+
+#include <atomic>
+
+namespace Visus {
+
+////////////////////////////////////////////////////////////////////
+class IdxBulkWriter::Pimpl
+{
+public:
+
+  //a block being filled by the slabs
+  class PendingBlock
+  {
+  public:
+    CriticalSection       lock;
+    SharedPtr<BlockQuery> query;
+    Int64                 nwritten = 0;
+    Int64                 ntotal = 0;
+  };
+
+  //an encoded block waiting for its file to be complete
+  class EncodedBlock
+  {
+  public:
+    Field                 field;
+    BigInt                blockid = 0;
+    String                compression;
+    String                layout;
+    SharedPtr<HeapMemory> encoded;
+  };
+
+  //a file waiting for all its blocks
+  class PendingFile
+  {
+  public:
+    std::vector<EncodedBlock> blocks;
+    Int64                     ntotal = 0;
+  };
+
+  SharedPtr<Dataset>      dataset;
+  IdxFile                 idxfile;
+  std::vector<Field>      fields;
+  double                  time = 0;
+  String                  compression;
+  String                  time_template;
+  String                  filename_template;
+  BoxNi                   logic_box;
+  bool                    closed = false;
+
+  SharedPtr<ThreadPool>   workers; //merge and encode
+  SharedPtr<ThreadPool>   writer;  //only one thread, so that writes are sequential
+
+  CriticalSection                                          lock;
+  std::map< std::pair<int, BigInt>, SharedPtr<PendingBlock> > blocks;
+  std::map< String, PendingFile >                          files;
+  String                                                   error_msg;
+
+  std::atomic<Int64>      num_written_blocks;
+  std::atomic<Int64>      num_written_files;
+
+  //constructor
+  Pimpl(SharedPtr<Dataset> dataset_, std::vector<Field> fields_, double time_, int nthreads)
+    : dataset(dataset_), fields(fields_), time(time_), num_written_blocks(0), num_written_files(0)
+  {
+    if (!dataset)
+      ThrowException("dataset is null");
+
+    this->idxfile = dataset->idxfile;
+
+    if (idxfile.version != 6)
+      ThrowException("IdxBulkWriter supports only IDX version 6");
+
+    if (dataset->blocksFullRes())
+      ThrowException("IdxBulkWriter does not support arco datasets");
+
+    if (fields.empty())
+      fields = dataset->getFields();
+
+    for (auto& field : fields)
+    {
+      field = dataset->getField(field.name);
+      if (!field.valid())
+        ThrowException("wrong field");
+    }
+
+    if (!dataset->getTimesteps().containsTimestep(time))
+      ThrowException("wrong time", time);
+
+    this->logic_box = dataset->getLogicBox();
+
+    //a "./" at the beginning means a reference to the *.idx directory
+    String local_idx_filename = Url(dataset->getUrl()).getPath();
+    auto resolveAlias = [&](String value) {
+
+      String dir = Path(local_idx_filename).getParent().toString();
+      if (dir.empty())
+        return value;
+
+      if (StringUtils::startsWith(value, "./"))
+        value = StringUtils::replaceFirst(value, ".", dir);
+
+      value = StringUtils::replaceAll(value, "$(CurrentFileDirectory)", dir);
+      return value;
+    };
+
+    this->time_template     = resolveAlias(idxfile.time_template);
+    this->filename_template = resolveAlias(idxfile.filename_template);
+
+    if (nthreads <= 0)
+      nthreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    if (auto env = cint(Utils::getEnv("VISUS_BULK_WRITER_NUM_THREADS")))
+      nthreads = std::max(1, env);
+
+    this->workers = std::make_shared<ThreadPool>("IdxBulkWriter Worker", nthreads);
+    this->writer  = std::make_shared<ThreadPool>("IdxBulkWriter Writer", 1);
+  }
+
+  //destructor
+  ~Pimpl() {
+    workers.reset();
+    writer.reset();
+  }
+
+  //getFilename
+  String getFilename(const Field& field, BigInt blockid) const {
+    return IdxDiskAccess::getFilenameV56(idxfile, time_template, filename_template, field, time, blockid);
+  }
+
+  //countSamples
+  static Int64 countSamples(const LogicSamples& samples, BoxNi box)
+  {
+    box = samples.alignBox(box);
+    if (!box.valid())
+      return 0;
+
+    Int64 ret = 1;
+    for (int D = 0; D < box.getPointDim(); D++)
+      ret *= std::max((Int64)0, (box.p2[D] - box.p1[D]) / samples.delta[D]);
+    return ret;
+  }
+
+  //countBlocksInFile
+  Int64 countBlocksInFile(String filename, BigInt blockid)
+  {
+    auto first = idxfile.getFirstBlockInFile(blockid);
+    auto step  = std::max(1, idxfile.block_interleaving);
+    auto total = dataset->getTotalNumberOfBlocks();
+
+    Int64 ret = 0;
+    for (int I = 0; I < idxfile.blocksperfile; I++)
+    {
+      BigInt id = first + I * step;
+      if (id >= total)
+        break;
+
+      int H;
+      if (!countSamples(dataset->getBlockQuerySamples(id, H), logic_box))
+        continue;
+
+      for (const auto& field : fields)
+      {
+        if (getFilename(field, id) == filename)
+          ret++;
+      }
+    }
+    return ret;
+  }
+
+  //setCompression
+  void setCompression(String value)
+  {
+    this->compression = value;
+
+    //zstd block headers do not have the dictionary, readers get it from the idx file
+    auto dictionary = IdxFile::parseZstdDictionary(value);
+    if (dictionary.empty())
+      return;
+
+    for (const auto& field : fields)
+      idxfile.setZstdDictionary(field.name, dictionary);
+
+    dataset->idxfile = idxfile;
+    idxfile.save(Url(dataset->getUrl()).getPath());
+  }
+
+  //setError
+  void setError(String value)
+  {
+    ScopedLock lock(this->lock);
+    if (error_msg.empty())
+      error_msg = value;
+  }
+
+  //encodeBlock (called by a worker)
+  void encodeBlock(SharedPtr<BlockQuery> query)
+  {
+    EncodedBlock block;
+    block.field       = query->field;
+    block.blockid     = query->blockid;
+    block.compression = compression.empty() ? query->field.default_compression : compression;
+    block.layout      = query->buffer.layout;
+    block.encoded     = ArrayUtils::encodeArray(block.compression, query->buffer);
+
+    if (!block.encoded)
+      return setError(cstring("cannot encode block", block.blockid, "compression", block.compression));
+
+    num_written_blocks++;
+
+    String filename = getFilename(block.field, block.blockid);
+
+    //countBlocksInFile is slow, do not hold the lock (a file cannot be flushed before all its blocks arrived)
+    bool bNew;
+    {
+      ScopedLock lock(this->lock);
+      bNew = files.find(filename) == files.end();
+    }
+    Int64 ntotal = bNew ? countBlocksInFile(filename, block.blockid) : 0;
+
+    ScopedLock lock(this->lock);
+
+    auto it = files.find(filename);
+    if (it == files.end())
+    {
+      VisusReleaseAssert(bNew);
+      it = files.insert(std::make_pair(filename, PendingFile())).first;
+      it->second.ntotal = ntotal;
+    }
+
+    auto& file = it->second;
+    file.blocks.push_back(block);
+
+    if ((Int64)file.blocks.size() >= file.ntotal)
+      flushFile(filename);
+  }
+
+  //flushFile (lock must be taken)
+  void flushFile(String filename)
+  {
+    auto it = files.find(filename);
+    if (it == files.end())
+      return;
+
+    auto blocks = std::make_shared< std::vector<EncodedBlock> >(std::move(it->second.blocks));
+    files.erase(it);
+
+    ThreadPool::push(writer, [this, filename, blocks]() {
+      writeFile(filename, *blocks);
+    });
+  }
+
+  //writeFile (called by the writer thread)
+  void writeFile(String filename, std::vector<EncodedBlock>& blocks)
+  {
+    std::sort(blocks.begin(), blocks.end(), [&](const EncodedBlock& a, const EncodedBlock& b) {
+      auto A = std::make_pair(cint(a.field.index), idxfile.getBlockPositionInFile(a.blockid));
+      auto B = std::make_pair(cint(b.field.index), idxfile.getBlockPositionInFile(b.blockid));
+      return A < B;
+    });
+
+    HeapMemory headers;
+    if (!headers.resize(IdxDiskAccess::getHeadersSizeV6(idxfile), __FILE__, __LINE__))
+      return setError("cannot allocate headers");
+    headers.fill(0);
+
+    Int64 offset = headers.c_size();
+    for (const auto& block : blocks)
+    {
+      auto size = block.encoded->c_size();
+      if (!IdxDiskAccess::setBlockHeaderV6(idxfile, headers, block.field, block.blockid, offset, (Int32)size, block.compression, block.layout))
+        return setError(cstring("compression", block.compression, "cannot be stored in the block header"));
+      offset += size;
+    }
+
+    //host to network order
+    if (!ByteOrder::isNetworkByteOrder())
+    {
+      auto ptr = (Uint32*)(headers.c_ptr());
+      for (int I = 0, Tot = (int)headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
+        ptr[I] = ByteOrder::swapByteOrder(ptr[I]);
+    }
+
+    File file;
+    if (!file.createAndOpen(filename, "rw"))
+      return setError(cstring("cannot create file", filename, "(already exists?)"));
+
+    if (!file.write(0, headers.c_size(), headers.c_ptr()))
+      return setError(cstring("cannot write headers", filename));
+
+    offset = headers.c_size();
+    for (const auto& block : blocks)
+    {
+      if (!file.write(offset, block.encoded->c_size(), block.encoded->c_ptr()))
+        return setError(cstring("cannot write block", block.blockid, filename));
+      offset += block.encoded->c_size();
+    }
+
+    file.close();
+    num_written_files++;
+  }
+
+  //throwIfError
+  void throwIfError()
+  {
+    ScopedLock lock(this->lock);
+    if (!error_msg.empty())
+      ThrowException(error_msg);
+  }
+
+  //writeSlab
+  void writeSlab(BoxNi slab_box, std::vector<Array> data)
+  {
+    if (closed)
+      ThrowException("IdxBulkWriter already closed");
+
+    if (data.size() != fields.size())
+      ThrowException("wrong number of arrays, expected", fields.size(), "got", data.size());
+
+    for (int F = 0; F < (int)fields.size(); F++)
+    {
+      auto field = fields[F];
+
+      auto query = dataset->createBoxQuery(slab_box, field, time, 'w');
+      query->setResolutionRange(0, dataset->getMaxResolution());
+      dataset->beginBoxQuery(query);
+
+      if (!query->isRunning())
+        ThrowException("cannot begin query", query->errormsg);
+
+      if (query->logic_samples.logic_box != slab_box || query->getNumberOfSamples() != data[F].dims)
+        ThrowException("slab", slab_box, "must be inside the dataset box and match the array dimensions");
+
+      if (data[F].dtype != field.dtype)
+        ThrowException("wrong dtype for field", field.name);
+
+      query->buffer = data[F];
+
+      for (auto blockid : dataset->createBlockQueriesForBoxQuery(query))
+      {
+        int H;
+        auto block_samples = dataset->getBlockQuerySamples(blockid, H);
+        auto nsamples = countSamples(block_samples, slab_box);
+        if (!nsamples)
+          continue;
+
+        //create the block in this thread, workers will only merge/encode
+        SharedPtr<PendingBlock> block;
+        {
+          ScopedLock lock(this->lock);
+          auto& it = blocks[std::make_pair(cint(field.index), blockid)];
+          if (!it)
+          {
+            it = std::make_shared<PendingBlock>();
+            it->query = dataset->createBlockQuery(blockid, field, time, 'w');
+            it->ntotal = countSamples(block_samples, logic_box);
+          }
+          block = it;
+        }
+
+        ThreadPool::push(workers, [this, query, block, nsamples]() 
+        {
+          bool bComplete = false;
+          {
+            ScopedLock lock(block->lock);
+
+            if (!block->query->allocateBufferIfNeeded())
+              return setError("out of memory");
+
+            if (!dataset->mergeBoxQueryWithBlockQuery(query, block->query))
+              return setError(cstring("cannot merge block", block->query->blockid));
+
+            block->nwritten += nsamples;
+            bComplete = block->nwritten >= block->ntotal;
+          }
+
+          if (bComplete)
+          {
+            {
+              ScopedLock lock(this->lock);
+              blocks.erase(std::make_pair(cint(block->query->field.index), block->query->blockid));
+            }
+            encodeBlock(block->query);
+            block->query.reset();
+          }
+        });
+      }
+    }
+
+    //wait so that the caller can reuse the slab memory
+    workers->waitAll();
+    throwIfError();
+  }
+
+  //close
+  void close()
+  {
+    if (closed)
+      return;
+
+    closed = true;
+
+    //blocks not fully covered by slabs
+    std::vector< SharedPtr<PendingBlock> > partial;
+    {
+      ScopedLock lock(this->lock);
+      for (auto it : blocks)
+        partial.push_back(it.second);
+      blocks.clear();
+    }
+
+    for (auto block : partial)
+    {
+      ThreadPool::push(workers, [this, block]() {
+        encodeBlock(block->query);
+      });
+    }
+    workers->waitAll();
+
+    //files not fully covered by slabs
+    {
+      ScopedLock lock(this->lock);
+      std::vector<String> filenames;
+      for (auto it : files)
+        filenames.push_back(it.first);
+      for (auto filename : filenames)
+        flushFile(filename);
+    }
+    writer->waitAll();
+
+    if (!partial.empty())
+      PrintWarning("IdxBulkWriter", partial.size(), "blocks were not fully covered by slabs");
+
+    throwIfError();
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////
+IdxBulkWriter::IdxBulkWriter(SharedPtr<Dataset> dataset, std::vector<Field> fields, double time, int nthreads)
+{
+  this->pimpl = new Pimpl(dataset, fields, time, nthreads);
+}
+
+////////////////////////////////////////////////////////////////////
+IdxBulkWriter::~IdxBulkWriter()
+{
+  if (!pimpl->closed)
+  {
+    try {
+      pimpl->close();
+    }
+    catch (std::exception& ex) {
+      PrintWarning("IdxBulkWriter close failed", ex.what());
+    }
+  }
+  delete pimpl;
+}
+
+////////////////////////////////////////////////////////////////////
+void IdxBulkWriter::setCompression(String value) {
+  pimpl->setCompression(value);
+}
+
+////////////////////////////////////////////////////////////////////
+void IdxBulkWriter::writeSlab(BoxNi logic_box, std::vector<Array> data) {
+  pimpl->writeSlab(logic_box, data);
+}
+
+////////////////////////////////////////////////////////////////////
+void IdxBulkWriter::close() {
+  pimpl->close();
+}
+
+////////////////////////////////////////////////////////////////////
+Int64 IdxBulkWriter::getNumWrittenBlocks() const {
+  return pimpl->num_written_blocks;
+}
+
+////////////////////////////////////////////////////////////////////
+Int64 IdxBulkWriter::getNumWrittenFiles() const {
+  return pimpl->num_written_files;
+}
+
+} //namespace Visus
+
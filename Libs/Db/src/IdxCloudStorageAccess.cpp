@@ -0,0 +1,439 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#include <Visus/IdxCloudStorageAccess.h>
+#include <Visus/IdxDiskAccess.h>
+#include <Visus/Dataset.h>
+#include <Visus/ByteOrder.h>
+#include <Visus/Path.h>
+
+namespace Visus {
+
+///////////////////////////////////////////////////////////////////////////////////////
+class IdxCloudStorageBlockRead
+{
+public:
+  SharedPtr<BlockQuery> query;
+  Int64                 offset = 0;
+  Int32                 size = 0;
+  String                compression;
+  String                layout;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+IdxCloudStorageAccess::IdxCloudStorageAccess(Dataset* dataset,StringTree config_)
+  : config(config_), num_requests(0)
+{ 
+  this->dataset = dataset;
+  this->idxfile = dataset->idxfile;
+
+  if (idxfile.version < 6)
+    ThrowException("IdxCloudStorageAccess supports only IDX version 6");
+
+  this->name = config.readString("name", "IdxCloudStorageAccess");
+  this->can_read  = StringUtils::find(config.readString("chmod", DefaultChMod), "r") >= 0;
+  this->can_write = false;
+  this->bitsperblock = idxfile.bitsperblock;
+
+  this->url = config.readString("url", dataset->getUrl()); VisusAssert(url.valid());
+  this->config.write("url", url.toString());
+
+  //range requests are implemented only by the s3 backend (azure and gcs would abort on them)
+  auto storage_type = CloudStorage::guessType(url);
+  if (storage_type != "s3")
+    ThrowException("IdxCloudStorageAccess supports only s3 storage, url", url, "type", storage_type.empty() ? String("unknown") : storage_type);
+
+  //a "./" at the beginning means a reference to the directory of the *.idx inside the bucket
+  auto resolveAlias = [&](String value) {
+    String dir = Path(url.getPath()).getParent().toString();
+    if (dir.empty())
+      return value;
+
+    if (StringUtils::startsWith(value, "./"))
+      value = StringUtils::replaceFirst(value, ".", dir);
+
+    value = StringUtils::replaceAll(value, "$(CurrentFileDirectory)", dir);
+    return value;
+  };
+
+  this->time_template     = resolveAlias(idxfile.time_template);
+  this->filename_template = resolveAlias(idxfile.filename_template);
+
+  this->max_blocks_per_request = std::max(1, config.readInt("max_blocks_per_request", 64));
+  this->max_request_size       = StringUtils::getByteSizeFromString(config.readString("max_request_size", "16mb"));
+  this->max_gap                = config.readInt64("max_gap", 0); //allow to read (and discard) some bytes to reduce the number of requests
+  this->max_cached_headers     = std::max(1, config.readInt("max_cached_headers", 4096));
+  this->missing_headers_ttl    = config.readInt64("missing_headers_ttl", 30000); //msec
+
+  bool disable_async = config.readBool("disable_async", cbool(this->url.getParam("disable_async",cstring(dataset->isServerMode()))));
+
+  int nconnections = disable_async ? 0 : config.readInt("nconnections", cint(this->url.getParam("nconnections", cstring(64))));
+
+  if (nconnections)
+    this->netservice = std::make_shared<NetService>(nconnections);
+
+  this->cloud_storage=CloudStorage::createInstance(url);
+  if (!this->cloud_storage)
+    ThrowException("cannot create cloud storage for", url);
+
+  PrintInfo("Created IdxCloudStorageAccess", "url", url, "filename_template", filename_template, "max_blocks_per_request", max_blocks_per_request, "nconnections", nconnections);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+IdxCloudStorageAccess::~IdxCloudStorageAccess()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+String IdxCloudStorageAccess::getFilename(Field field, double time, BigInt blockid) const
+{    
+  auto ret = IdxDiskAccess::getFilenameV56(idxfile, time_template, filename_template, field, time, blockid);
+
+  //s3://bucket/... -> /bucket/...
+  if (StringUtils::startsWith(ret,"s3://"))
+    ret = ret.substr(4);
+
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+Future< SharedPtr<HeapMemory> > IdxCloudStorageAccess::getHeaders(String filename)
+{
+  auto ret = Promise< SharedPtr<HeapMemory> >().get_future();
+  {
+    ScopedLock lock(headers_lock);
+
+    auto it = headers.find(filename);
+    if (it != headers.end())
+    {
+      auto& cached = it->second;
+
+      //a missing file or a failed request: try again after some time
+      bool bMissing = cached.future.is_ready() && (!cached.future.get() || !cached.future.get()->c_size());
+      bool bExpired = bMissing && cached.t1.elapsedMsec() >= missing_headers_ttl;
+      if (!bExpired)
+      {
+        headers_lru.splice(headers_lru.begin(), headers_lru, cached.lru);
+        return cached.future;
+      }
+
+      headers_lru.erase(cached.lru);
+      headers.erase(it);
+    }
+
+    //evict the least recently used
+    while (!headers_lru.empty() && (int)headers.size() >= max_cached_headers)
+    {
+      headers.erase(headers_lru.back());
+      headers_lru.pop_back();
+    }
+
+    headers_lru.push_front(filename);
+    auto& cached = headers[filename];
+    cached.future = ret;
+    cached.t1     = Time::now();
+    cached.lru    = headers_lru.begin();
+  }
+
+  ++num_requests;
+  Int64 headers_size = IdxDiskAccess::getHeadersSizeV6(idxfile);
+  cloud_storage->getBlob(netservice, filename, /*head*/false, /*range*/{ 0,headers_size }).when_ready([ret, headers_size](SharedPtr<CloudStorageItem> blob) {
+
+    //NOTE: a missing file is cached too (i.e. all its blocks are missing) until missing_headers_ttl expires
+    //empty headers means the file is not stored, null headers means the request failed
+    SharedPtr<HeapMemory> value;
+    if (blob && !blob->valid() && blob->status == HttpStatus::STATUS_NOT_FOUND)
+    {
+      value = std::make_shared<HeapMemory>();
+    }
+    else if (blob && blob->body && blob->body->c_size() >= headers_size)
+    {
+      value = std::make_shared<HeapMemory>();
+      if (value->resize(headers_size, __FILE__, __LINE__))
+      {
+        memcpy(value->c_ptr(), blob->body->c_ptr(), headers_size);
+
+        // network to host order
+        if (!ByteOrder::isNetworkByteOrder())
+        {
+          Uint32* ptr = (Uint32*)(value->c_ptr());
+          for (int I = 0, Tot = (int)value->c_size() / (int)sizeof(Uint32); I < Tot; I++)
+            ptr[I] = ByteOrder::swapByteOrder(ptr[I]);
+        }
+      }
+      else
+      {
+        value.reset();
+      }
+    }
+
+    ret.get_promise()->set_value(value);
+  });
+
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void IdxCloudStorageAccess::readBlock(SharedPtr<BlockQuery> query)
+{
+  auto filename = getFilename(query->field, query->time, query->blockid);
+
+  if (!batch.empty())
+  {
+    bool bCompatible =
+      filename       == batch_filename &&
+      query->aborted == batch[0]->aborted;
+
+    if (!bCompatible)
+      flushBatch();
+  }
+
+  batch_filename = filename;
+  batch.push_back(query);
+
+  if (batch.size() >= max_blocks_per_request)
+    flushBatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void IdxCloudStorageAccess::flushBatch()
+{
+  if (batch.empty())
+    return;
+
+  Batch batch;
+  std::swap(batch, this->batch);
+  String filename = this->batch_filename;
+
+  //callbacks can run after the access has been destroyed
+  std::weak_ptr<IdxCloudStorageAccess> weak_this = shared_from_this();
+
+  getHeaders(filename).when_ready([weak_this, batch, filename](SharedPtr<HeapMemory> headers) {
+
+    ReadResults failed;
+    auto self = weak_this.lock();
+
+    if (!self || !headers)
+    {
+      for (auto query : batch)
+        failed.push_back(std::make_pair(query, String(self ? "cannot read headers" : "access destroyed")));
+      if (self)
+        self->countReadResults(failed);
+      self.reset();
+      return notifyReadResults(failed);
+    }
+
+    //the file does not exist, so none of its blocks is stored
+    if (!headers->c_size())
+    {
+      for (auto query : batch)
+      {
+        query->not_stored = true;
+        failed.push_back(std::make_pair(query, String("file not stored")));
+      }
+      self->countReadResults(failed);
+      self.reset();
+      return notifyReadResults(failed);
+    }
+
+    typedef IdxCloudStorageBlockRead BlockRead;
+    std::vector<BlockRead> reads;
+    for (auto query : batch)
+    {
+      if (query->aborted())
+      {
+        failed.push_back(std::make_pair(query, String("aborted")));
+        continue;
+      }
+
+      BlockRead read;
+      read.query = query;
+      IdxDiskAccess::getBlockHeaderV6(self->idxfile, *headers, query->field, query->blockid, read.offset, read.size, read.compression, read.layout);
+
+      //see IdxDiskAccess (zfp bitplanes are not stored in the block header)
+      if (read.compression == "zfp" && StringUtils::startsWith(query->field.default_compression, "zfp"))
+        read.compression = query->field.default_compression;
+
+      //same for the zstd dictionary
+      if (StringUtils::contains(read.compression, "zstd"))
+      {
+        auto dictionary = self->idxfile.getZstdDictionary(query->field);
+        if (!dictionary.empty())
+          read.compression += "-dict=" + dictionary;
+      }
+
+      if (!read.offset || !read.size)
+      {
+        query->not_stored = true;
+        failed.push_back(std::make_pair(query, String("block not stored in file")));
+        continue;
+      }
+
+      reads.push_back(read);
+    }
+
+    std::sort(reads.begin(), reads.end(), [](const BlockRead& a, const BlockRead& b) {
+      return a.offset < b.offset;
+    });
+
+    //coalesce adjacent blocks in the same range request
+    for (int I = 0; I < (int)reads.size(); )
+    {
+      Int64 range_begin = reads[I].offset;
+      Int64 range_end   = reads[I].offset + reads[I].size;
+      int J = I + 1;
+      for (; J < (int)reads.size(); J++)
+      {
+        Int64 block_end = std::max(range_end, reads[J].offset + reads[J].size);
+        if (reads[J].offset > range_end + self->max_gap || block_end - range_begin > self->max_request_size)
+          break;
+        range_end = block_end;
+      }
+
+      std::vector<BlockRead> group(reads.begin() + I, reads.begin() + J);
+      I = J;
+
+      ++self->num_requests;
+      self->cloud_storage->getBlob(self->netservice, filename, /*head*/false, { range_begin, range_end }, group[0].query->aborted).when_ready([weak_this, group, range_begin, range_end](SharedPtr<CloudStorageItem> blob) {
+
+        //the server could ignore the range and return the whole file
+        Int64 body_size = blob && blob->body ? blob->body->c_size() : 0;
+        Int64 body_offset = body_size == range_end - range_begin ? range_begin : 0;
+
+        ReadResults results;
+        auto self = weak_this.lock();
+
+        for (auto read : group)
+        {
+          auto query = read.query;
+
+          if (!self)
+          {
+            results.push_back(std::make_pair(query, String("access destroyed")));
+            continue;
+          }
+
+          if (query->aborted())
+          {
+            results.push_back(std::make_pair(query, String("aborted")));
+            continue;
+          }
+
+          if (read.offset - body_offset < 0 || read.offset + read.size - body_offset > body_size)
+          {
+            results.push_back(std::make_pair(query, String("range request failed")));
+            continue;
+          }
+
+          //the decoder owns its output, only raw blocks need their own copy
+          auto ptr = blob->body->c_ptr() + (read.offset - body_offset);
+          SharedPtr<HeapMemory> encoded;
+          if (read.compression.empty() || read.compression == "raw")
+          {
+            encoded = std::make_shared<HeapMemory>();
+            if (!encoded->resize(read.size, __FILE__, __LINE__))
+            {
+              results.push_back(std::make_pair(query, String("cannot allocate memory")));
+              continue;
+            }
+            memcpy(encoded->c_ptr(), ptr, read.size);
+          }
+          else
+          {
+            encoded = HeapMemory::createUnmanaged(ptr, read.size);
+          }
+
+          auto decoded = ArrayUtils::decodeArray(read.compression, query->getNumberOfSamples(), query->field.dtype, encoded);
+          if (!decoded.valid())
+          {
+            results.push_back(std::make_pair(query, String("cannot decode the data")));
+            continue;
+          }
+
+          decoded.layout = read.layout;
+          query->buffer = decoded;
+          results.push_back(std::make_pair(query, String()));
+        }
+
+        if (self)
+          self->countReadResults(results);
+        self.reset();
+        notifyReadResults(results);
+      });
+    }
+
+    self->countReadResults(failed);
+    self.reset();
+    notifyReadResults(failed);
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void IdxCloudStorageAccess::countReadResults(const ReadResults& results)
+{
+  for (auto it : results)
+  {
+    if (it.second.empty())
+      ++statistics.rok;
+    else
+      ++statistics.rfail;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void IdxCloudStorageAccess::notifyReadResults(const ReadResults& results)
+{
+  //NOTE: the caller must not hold a reference to the access here: a waiting thread can release its own one and
+  //the last release must not happen inside a NetService callback (~NetService joins the NetService thread)
+  for (auto it : results)
+  {
+    if (it.second.empty())
+      it.first->setOk();
+    else
+      it.first->setFailed(it.second);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void IdxCloudStorageAccess::printStatistics()
+{
+  PrintInfo(name, "hostname", url.getHostname(), "port", url.getPort(), "url", url, "num_requests", num_requests.load());
+  Access::printStatistics();
+}
+
+} //namespace Visus
@@ -38,6 +38,7 @@ For support : support@visus.net
 
 #include <Visus/IdxDataset.h>
 #include <Visus/IdxHzOrder.h>
+#include <Visus/ThreadPool.h>
 
 namespace Visus {
 
@@ -54,6 +55,157 @@ public:
 
     VisusAssert(block_query->buffer.layout == "hzorder");
 
+    //all blocks but the first one contain samples of only one level, so I can use offset tables instead of the kd-traversal
+    bool bDone = false;
+    if (block_query->blockid > 0 && !executeWithTables<Sample>(vf, query, block_query, bDone))
+      return false;
+
+    return bDone ? true : executeWithKdTraversal<Sample>(vf, query, block_query);
+  }
+
+private:
+
+  /*
+    Inside a block at level H (H>bitsperblock) the hz offset of a sample is the interleaving of the sample local coordinates 
+    using bitmask[H-bitsperblock..H-1] (first split==most significant bit). Since the bits are disjoint, the hz offset is 
+    the sum of one table per dimension, and the query offset is separable too. So the copy is a loop of gathers along dimension 0.
+  */
+  template <class Sample>
+  bool executeWithTables(IdxDataset* vf, BoxQuery* query, BlockQuery* block_query, bool& bDone)
+  {
+    DatasetBitmask bitmask = vf->idxfile.bitmask;
+    int            pdim = bitmask.getPointDim();
+    int            bitsperblock = vf->getDefaultBitsPerBlock();
+    int            H = block_query->H;
+    auto           block_samples = block_query->logic_samples;
+    auto           block_box = block_samples.logic_box;
+    Aborted        aborted = query->aborted;
+
+    //level not requested by the query
+    if (H <= bitsperblock || H <= query->getCurrentResolution() || H > query->getEndResolution())
+      return (bDone = true);
+
+    LogicSamples Lsamples = vf->level_samples[H];
+    if (!block_box.valid() || block_samples.delta != Lsamples.delta)
+      return true; //let the kd-traversal handle it
+
+    //per-dimension hz offset tables
+    std::vector<int> nbits(pdim, 0);
+    for (int K = 0; K < bitsperblock; K++)
+      nbits[bitmask[H - bitsperblock + K]]++;
+
+    for (int D = 0; D < pdim; D++)
+    {
+      if (block_samples.nsamples[D] != (((Int64)1) << nbits[D]))
+        return true; //let the kd-traversal handle it
+    }
+
+    std::vector< std::vector<Int64> > hzoffsets(pdim);
+    for (int D = 0; D < pdim; D++)
+      hzoffsets[D].assign((size_t)1 << nbits[D], 0);
+
+    std::vector<int> nseen(pdim, 0);
+    for (int K = 0; K < bitsperblock; K++)
+    {
+      int   D = bitmask[H - bitsperblock + K];
+      Int64 weight = ((Int64)1) << (bitsperblock - 1 - K);
+      int   coord_bit = nbits[D] - 1 - (nseen[D]++);
+      auto& table = hzoffsets[D];
+      for (Int64 C = 0, Tot = (Int64)table.size(); C < Tot; C++)
+      {
+        if ((C >> coord_bit) & 1)
+          table[C] += weight;
+      }
+    }
+
+    bDone = true;
+
+    BoxNi   logic_box = query->logic_samples.logic_box;
+    PointNi stride = query->getNumberOfSamples().stride();
+    PointNi qshift = query->logic_samples.shift;
+    BoxNi   box = Lsamples.alignBox(logic_box.getIntersection(block_box));
+    if (!box.isFullDim())
+      return true;
+
+    //range of block samples inside the box and their offsets in the query buffer
+    std::vector<Int64> cfrom(pdim), count(pdim);
+    std::vector< std::vector<Int64> > qoffsets(pdim);
+    for (int D = 0; D < pdim; D++)
+    {
+      auto delta = block_samples.delta[D];
+      cfrom[D] = (box.p1[D] - block_box.p1[D] + delta - 1) / delta;
+      count[D] = std::min(block_samples.nsamples[D], (box.p2[D] - block_box.p1[D] + delta - 1) / delta) - cfrom[D];
+      if (count[D] <= 0)
+        return true;
+
+      qoffsets[D].resize(count[D]);
+      for (Int64 I = 0; I < count[D]; I++)
+      {
+        auto P = block_box.p1[D] + (cfrom[D] + I) * delta;
+        qoffsets[D][I] = stride[D] * ((P - logic_box.p1[D]) >> qshift[D]);
+      }
+    }
+
+    auto Qbuffer = GetSamples<Sample>(query->buffer);
+    auto Hbuffer = GetSamples<Sample>(block_query->buffer);
+
+    bool bWrite = query->mode == 'w';
+    const Int64* Q0 = &qoffsets[0][0];
+    const Int64* R0 = &hzoffsets[0][cfrom[0]];
+    Int64 N0 = count[0];
+    bool  bUnitStride = true;
+    for (Int64 I = 1; I < N0 && bUnitStride; I++)
+      bUnitStride = Q0[I] == Q0[0] + I;
+
+    std::vector<Int64> idx(pdim, 0);
+    while (true)
+    {
+      if (aborted())
+        return false;
+
+      Int64 qbase = 0, hzbase = 0;
+      for (int D = 1; D < pdim; D++)
+      {
+        qbase  += qoffsets[D][idx[D]];
+        hzbase += hzoffsets[D][cfrom[D] + idx[D]];
+      }
+
+      if (bWrite)
+      {
+        for (Int64 I = 0; I < N0; I++)
+          Hbuffer[hzbase + R0[I]] = Qbuffer[qbase + Q0[I]];
+      }
+      else if (bUnitStride)
+      {
+        qbase += Q0[0];
+        for (Int64 I = 0; I < N0; I++)
+          Qbuffer[qbase + I] = Hbuffer[hzbase + R0[I]];
+      }
+      else
+      {
+        for (Int64 I = 0; I < N0; I++)
+          Qbuffer[qbase + Q0[I]] = Hbuffer[hzbase + R0[I]];
+      }
+
+      //next row
+      int D = 1;
+      for (; D < pdim; D++)
+      {
+        if (++idx[D] < count[D]) break;
+        idx[D] = 0;
+      }
+
+      if (D == pdim)
+        break;
+    }
+
+    return true;
+  }
+
+  //executeWithKdTraversal
+  template <class Sample>
+  bool executeWithKdTraversal(IdxDataset* vf, BoxQuery* query, BlockQuery* block_query)
+  {
     bool bInvertOrder = query->mode == 'w';
 
     auto bitsperblock = vf->getDefaultBitsPerBlock();
@@ -281,66 +433,140 @@ std::vector<BigInt> IdxDataset::createBlockQueriesForPointQuery(SharedPtr<PointQ
   if (blocksFullRes())
     return Dataset::createBlockQueriesForPointQuery(query);
 
-  std::vector<BigInt> ret;
-
-  query->offsets.clear();
+  auto& offsets = query->offsets;
+  offsets.blocks.clear();
+  offsets.begin.clear();
+  offsets.point_offset.clear();
+  offsets.block_offset.clear();
 
-  auto pdim = getPointDim(); VisusReleaseAssert(pdim==3);
+  auto pdim = getPointDim();
   auto bounds = this->getLogicBox();
-  auto last_bitmask = ((BigInt)1) << (getMaxResolution());
   auto hzorder = HzOrder(idxfile.bitmask);
   auto depth_mask = hzorder.getLevelP2Included(query->end_resolution);
   auto bitsperblock = getDefaultBitsPerBlock();
-  auto samplesperblock = 1 << bitsperblock;
+  auto SRC = (const Int64*)query->points->c_ptr();
+  Int64 npoints = query->getNumberOfPoints().innerProduct();
 
-  BigInt blockid, block_offset;
-  int    H;
-  PointNi p(pdim),stride;
-  auto SRC = (Int64*)query->points->c_ptr();
-  BigInt hzaddress;
-  LogicSamples block_samples;
+  int nthreads = std::max(1, (int)std::thread::hardware_concurrency());
+  if (auto env = cint(Utils::getEnv("VISUS_POINTQUERY_NUM_THREADS")))
+    nthreads = std::max(1, env);
 
-  for (int N = 0, Tot = (int)query->getNumberOfPoints().innerProduct(); N < Tot; N++, SRC += pdim)
+  //few points are not worth the threads
+  SharedPtr<ThreadPool> thread_pool;
+  if (npoints < (1 << 16) || nthreads == 1)
   {
-    if (query->aborted()) {
-      query->setFailed("query aborted");
-      return {};
-    }
-
-    p[0] = SRC[0] & depth_mask[0];
-    p[1] = SRC[1] & depth_mask[1];
-    p[2] = SRC[2] & depth_mask[2];
+    nthreads = 1;
+  }
+  else
+  {
+    ScopedLock lock(point_query_lock);
+    if (!point_query_pool)
+      point_query_pool = std::make_shared<ThreadPool>("PointQuery Worker", nthreads);
+    thread_pool = point_query_pool;
+  }
 
-    if (!(
-      p[0] >= bounds.p1[0] && p[0] < bounds.p2[0] &&
-      p[1] >= bounds.p1[1] && p[1] < bounds.p2[1] &&
-      p[2] >= bounds.p1[2] && p[2] < bounds.p2[2]))
+  //wait only for the tasks of this query (the pool is shared)
+  auto runParallel = [&](int ntasks, std::function<void(int)> fn) {
+    Semaphore ndone;
+    for (int T = 0; T < ntasks; T++)
+      ThreadPool::push(thread_pool, [fn, T, &ndone]() {fn(T); ndone.up(); });
+    for (int T = 0; T < ntasks; T++)
+      ndone.down();
+  };
+
+  //(hzaddress, point index) of all the points inside the dataset, each chunk sorted by hzaddress
+  typedef std::pair<BigInt, Int64> Item;
+  std::vector< std::vector<Item> > chunks(nthreads);
+  runParallel(nthreads, [&](int C)
+  {
+    Int64 A = (npoints * C) / nthreads, B = (npoints * (C + 1)) / nthreads;
+    auto& chunk = chunks[C];
+    chunk.reserve(B - A);
+    PointNi p(pdim);
+    for (Int64 N = A; N < B; N++)
     {
-      continue;
-    }
+      if ((N & 0xffff) == 0 && query->aborted())
+        return;
 
-    hzaddress = hzorder.getAddress(p);
+      auto src = SRC + N * pdim;
+      bool bInside = true;
+      for (int D = 0; bInside && D < pdim; D++)
+      {
+        p[D] = src[D] & depth_mask[D];
+        bInside = p[D] >= bounds.p1[D] && p[D] < bounds.p2[D];
+      }
 
-    blockid = hzaddress >> bitsperblock;
-    if (!query->offsets.count(blockid))
-    {
-      query->offsets[blockid]=std::make_shared<PointQuery::Offsets>();
-      ret.push_back(blockid);
+      if (bInside)
+        chunk.push_back(std::make_pair(hzorder.getAddress(p), N));
     }
+    std::sort(chunk.begin(), chunk.end());
+  });
+
+  //merge sorted chunks two by two
+  while (chunks.size() > 1 && !query->aborted())
+  {
+    std::vector< std::vector<Item> > merged((chunks.size() + 1) / 2);
+    runParallel((int)merged.size(), [&](int C)
+    {
+      if (2 * C + 1 == chunks.size())
+      {
+        merged[C] = std::move(chunks[2 * C]);
+        return;
+      }
+      auto& a = chunks[2 * C + 0];
+      auto& b = chunks[2 * C + 1];
+      merged[C].resize(a.size() + b.size());
+      std::merge(a.begin(), a.end(), b.begin(), b.end(), merged[C].begin());
+      std::vector<Item>().swap(a);
+      std::vector<Item>().swap(b);
+    });
+    chunks = std::move(merged);
+  }
 
-    block_samples = getBlockQuerySamples(blockid, H);
-    stride = block_samples.nsamples.stride();
+  if (query->aborted()) {
+    query->setFailed("query aborted");
+    return {};
+  }
 
-    //todo: is there a better way to get this?
-    block_offset =
-      stride[0] * ((p[0] - block_samples.logic_box.p1[0]) / block_samples.delta[0]) +
-      stride[1] * ((p[1] - block_samples.logic_box.p1[1]) / block_samples.delta[1]) +
-      stride[2] * ((p[2] - block_samples.logic_box.p1[2]) / block_samples.delta[2]);
+  const auto& sorted = chunks[0];
 
-    query->offsets[blockid]->push_back(std::make_pair(N, block_offset));
+  //points of the same block are contiguous
+  for (Int64 I = 0, Tot = (Int64)sorted.size(); I < Tot; I++)
+  {
+    BigInt blockid = sorted[I].first >> bitsperblock;
+    if (offsets.blocks.empty() || offsets.blocks.back() != blockid)
+    {
+      offsets.blocks.push_back(blockid);
+      offsets.begin.push_back(I);
+    }
   }
+  offsets.begin.push_back((Int64)sorted.size());
 
-  return ret;
+  //offsets inside the (row major) blocks, one getBlockQuerySamples for each block
+  offsets.point_offset.resize(sorted.size());
+  offsets.block_offset.resize(sorted.size());
+  Int64 nblocks = (Int64)offsets.blocks.size();
+  runParallel(nthreads, [&](int C)
+  {
+    for (Int64 K = (nblocks * C) / nthreads, KEnd = (nblocks * (C + 1)) / nthreads; K < KEnd; K++)
+    {
+      int H;
+      auto block_samples = getBlockQuerySamples(offsets.blocks[K], H);
+      auto stride = block_samples.nsamples.stride();
+      for (Int64 I = offsets.begin[K]; I < offsets.begin[K + 1]; I++)
+      {
+        auto N = sorted[I].second;
+        auto src = SRC + N * pdim;
+        Int64 block_offset = 0;
+        for (int D = 0; D < pdim; D++)
+          block_offset += stride[D] * (((src[D] & depth_mask[D]) - block_samples.logic_box.p1[D]) >> block_samples.shift[D]);
+        offsets.point_offset[I] = N;
+        offsets.block_offset[I] = block_offset;
+      }
+    }
+  });
+
+  return offsets.blocks;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -39,6 +39,7 @@ For support : support@visus.net
 
 #include <Visus/Db.h>
 #include <Visus/IdxDataset2.h>
+#include <Visus/CriticalSection.h>
 
 #if VISUS_IDX2
 
@@ -156,7 +157,10 @@ bool IdxDataset2::setBoxQueryEndResolution(SharedPtr<BoxQuery> query, int H)
 //////////////////////////////////////////////////////////////////////
 void IdxDataset2::enableExternalRead(idx2::idx2_file& Idx2, SharedPtr<Access> access, Aborted aborted)
 {
-  Idx2.external_read = [this, access, aborted](const idx2::idx2_file& Idx2, idx2::buffer& Buf, idx2::u64 ChunkAddress) -> std::future<bool>
+  //decode tasks can ask for chunks in parallel, but the access is not thread safe (NOTE: the wait for the future is not serialized)
+  auto access_lock = std::make_shared<CriticalSection>();
+
+  Idx2.external_read = [this, access, aborted, access_lock](const idx2::idx2_file& Idx2, idx2::buffer& Buf, idx2::u64 ChunkAddress) -> std::future<bool>
   {
     VisusReleaseAssert(static_cast<idx2::u64>(static_cast<Visus::BigInt>(ChunkAddress)) == ChunkAddress);
 
@@ -193,14 +197,33 @@ void IdxDataset2::enableExternalRead(idx2::idx2_file& Idx2, SharedPtr<Access> ac
 
     }));
 
-    executeBlockQuery(access, query);
+    {
+      ScopedLock lock(*access_lock);
+      executeBlockQuery(access, query);
+    }
     return f;
   };
+
+  //fetched and decompressed chunks survive the query (i.e. progressive refinements and small pans don't read them again)
+  if (chunk_cache)
+  {
+    Idx2.external_cache = chunk_cache;
+    Idx2.external_cache_prefix = concatenate(getField().name, "/", getTime());
+  }
 }
 
 //////////////////////////////////////////////////////////////////////
 void IdxDataset2::enableExternalWrite(idx2::idx2_file& Idx2, SharedPtr<Access> access, Aborted aborted)
 {
+  //chunks are going to change (same lock of GetSharedChunk, the readers keep their pending futures)
+  if (chunk_cache)
+  {
+    std::unique_lock<std::mutex> lock(chunk_cache->Mutex);
+    chunk_cache->Entries.clear();
+    chunk_cache->Lru.clear();
+    chunk_cache->Bytes = 0;
+  }
+
   Idx2.external_write = [this, access, aborted](const idx2::idx2_file& Idx2, idx2::buffer& Buf, idx2::u64 ChunkAddress) -> bool {
 #if 0
     std::ostringstream filename;
@@ -341,13 +364,26 @@ bool IdxDataset2::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery>
   idx2::buffer my_buffer((const idx2::byte*)this->metafile.c_str(), this->metafile.size());
   idx2::InitFromBuffer(&Idx2, P, my_buffer);
 
+  //decode tasks stop as soon as the query is aborted (legacy file format too)
+  auto aborted = query->aborted;
+  Idx2.external_aborted = [aborted]() {
+    return aborted() ? true : false;
+  };
+
   //in OpenVisus by default I use IDX1 format
   if (!this->useLegacyFileFormat())
     enableExternalRead(Idx2, access, query->aborted);
 
   auto query_buffer = idx2::buffer((const idx2::byte*)query->buffer.c_ptr(), query->buffer.c_size());
-  //idx2::Decode(Idx2, P, &query_buffer);  //TODO: no aborted?
-  idx2::ParallelDecode(Idx2, P, &query_buffer);  //TODO: no aborted?
+  //idx2::Decode(Idx2, P, &query_buffer);
+  idx2::ParallelDecode(Idx2, P, &query_buffer);
+
+  if (query->aborted())
+  {
+    query->setFailed("query aborted");
+    return false;
+  }
+
   query->setCurrentResolution(query->end_resolution);
 
   return true;
@@ -375,6 +411,13 @@ void IdxDataset2::readDatasetFromArchive(Archive& ar)
 
   this->metafile = Utils::loadTextDocument(url);
   VisusReleaseAssert(!metafile.empty());
+
+  //0 disables the cache
+  if (auto max_bytes = StringUtils::getByteSizeFromString(Utils::getEnv("VISUS_IDX2_CHUNK_CACHE_SIZE", "512mb")))
+  {
+    this->chunk_cache = std::make_shared<idx2::shared_chunk_cache>();
+    this->chunk_cache->MaxBytes = max_bytes;
+  }
   idx2::buffer my_buffer((const idx2::byte*)metafile.c_str(), metafile.size());
   VisusReleaseAssert(idx2::ReadMetaFileFromBuffer(&Idx2, my_buffer));
 
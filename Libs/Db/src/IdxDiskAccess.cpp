@@ -183,6 +183,150 @@ static String GetFilenameV56(const IdxFile& idxfile, String TimeTemplate, String
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////
+//LRU of read-only files with their (already byte-swapped) headers, shared by all the IdxDiskAccess workers
+class IdxDiskAccessOpenFiles
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxDiskAccessOpenFiles)
+
+  //___________________________________________
+  class OpenFile
+  {
+  public:
+
+    VISUS_NON_COPYABLE_CLASS(OpenFile)
+
+    //File::read is seek+read, so the handle cannot be used by two workers at the same time
+    CriticalSection lock;
+    File            file;
+
+    //headers in host byte order (read only after the open)
+    HeapMemory      headers;
+
+    //file size and modification time at the open, to notice the file being rewritten by someone else
+    Int64           size = 0;
+    Int64           mtime = 0;
+
+    //constructor
+    OpenFile() {
+    }
+
+    //isUpToDate
+    bool isUpToDate(String filename) const {
+      return FileUtils::getFileSize(filename) == size && FileUtils::getTimeLastModified(filename) == mtime;
+    }
+  };
+
+  int verbose = 0;
+
+  //constructor
+  IdxDiskAccessOpenFiles(Int64 headers_size_, int max_open_files_) 
+    : headers_size(headers_size_), max_open_files(std::max(1, max_open_files_)) {
+  }
+
+  //open
+  SharedPtr<OpenFile> open(String filename)
+  {
+    SharedPtr<OpenFile> cached;
+    {
+      ScopedLock lock(this->lock);
+      auto it = index.find(filename);
+      if (it != index.end())
+      {
+        lru.splice(lru.begin(), lru, it->second);
+        cached = it->second->second;
+      }
+    }
+
+    //another writer (or process) may have rewritten the file since I parsed its headers
+    if (cached)
+    {
+      if (cached->isUpToDate(filename))
+        return cached;
+
+      ScopedLock lock(this->lock);
+      auto it = index.find(filename);
+      if (it != index.end() && it->second->second == cached)
+      {
+        lru.erase(it->second);
+        index.erase(it);
+      }
+    }
+
+    //open and parse headers outside the lock (can be slow on parallel file systems)
+    auto ret = std::make_shared<OpenFile>();
+
+    //stat before reading the headers, a rewrite happening while reading will be noticed by the next open
+    ret->size  = FileUtils::getFileSize(filename);
+    ret->mtime = FileUtils::getTimeLastModified(filename);
+
+    if (!ret->file.open(filename, "r"))
+      return SharedPtr<OpenFile>();
+
+    if (verbose & 1)
+      PrintInfo("Opening file", filename, "reading mode r");
+
+    if (!ret->headers.resize(headers_size, __FILE__, __LINE__) || !ret->file.read(0, ret->headers.c_size(), ret->headers.c_ptr()))
+      return SharedPtr<OpenFile>();
+
+    // network to host order
+    if (!ByteOrder::isNetworkByteOrder())
+    {
+      Uint32* ptr = (Uint32*)(ret->headers.c_ptr());
+      for (int I = 0, Tot = (int)ret->headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
+        ptr[I] = ByteOrder::swapByteOrder(ptr[I]);
+    }
+
+    ScopedLock lock(this->lock);
+
+    //another worker opened the same file in the meantime
+    auto it = index.find(filename);
+    if (it != index.end())
+    {
+      if (it->second->second->size == ret->size && it->second->second->mtime == ret->mtime)
+      {
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->second;
+      }
+      lru.erase(it->second);
+      index.erase(it);
+    }
+
+    lru.push_front(std::make_pair(filename, ret));
+    index[filename] = lru.begin();
+
+    //workers still using an evicted file keep it alive until they are done
+    while ((int)lru.size() > max_open_files)
+    {
+      index.erase(lru.back().first);
+      lru.pop_back();
+    }
+
+    return ret;
+  }
+
+  //clear (needed anytime the files are going to change on disk, entries are revalidated by size and modification time anyway)
+  void clear()
+  {
+    ScopedLock lock(this->lock);
+    index.clear();
+    lru.clear();
+  }
+
+private:
+
+  typedef std::list< std::pair<String, SharedPtr<OpenFile> > > Lru;
+
+  Int64                            headers_size = 0;
+  int                              max_open_files = 0;
+  CriticalSection                  lock;
+  Lru                              lru;
+  std::map<String, Lru::iterator>  index;
+
+};
+
 //////////////////////////////////////////////////////////////////////////////////
 class IdxDiskAccessV5 : public Access
 {
@@ -237,10 +381,16 @@ public:
       return owner->readFailed(query,reason);
     };
 
+    //not_stored (the block does not exist, it's not an I/O error)
+    auto not_stored = [&](String reason) {
+      query->not_stored = true;
+      return failed(reason);
+    };
+
     //try to open the existing file
     String filename = getFilename(query->field, query->time, blockid);
     if (!openFile(filename, "r"))
-      return failed(cstring("cannot open file", filename));
+      return FileUtils::existsFile(filename) ? failed(cstring("cannot open file", filename)) : not_stored(cstring("file not stored", filename));
 
     const auto& block_header = block_headers[cint(query->field.index)*idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockid)];
     
@@ -252,7 +402,7 @@ public:
       PrintInfo("Block header contains the following: block_offset",block_offset,"block_size",block_size,"compression",compression);
 
     if (!block_offset || !block_size)
-      return failed(cstring("the idx data seeems not stored in the file","block_offset", block_offset,"block_size", block_size));
+      return not_stored(cstring("the idx data seeems not stored in the file","block_offset", block_offset,"block_size", block_size));
 
     auto encoded = std::make_shared<HeapMemory>();
     if (!encoded->resize(block_size, __FILE__, __LINE__))
@@ -411,13 +561,13 @@ public:
   bool bSkipDecode=false;
 
   //constructor
-    IdxDiskAccessV6(IdxDiskAccess* owner_, const IdxFile& idxfile_, String time_template_, String filename_template_, String compression, int verbose)
-    : owner(owner_), idxfile(idxfile_), time_template(time_template_), filename_template(filename_template_)
+  IdxDiskAccessV6(IdxDiskAccess* owner_, const IdxFile& idxfile_, String time_template_, String filename_template_, String compression, int verbose, SharedPtr<IdxDiskAccessOpenFiles> open_files_)
+    : owner(owner_), idxfile(idxfile_), time_template(time_template_), filename_template(filename_template_), open_files(open_files_)
   {
     this->compression = compression;
     this->verbose = verbose;
     this->bitsperblock = idxfile.bitsperblock;
-    this->headers.resize(sizeof(FileHeader) + (idxfile.blocksperfile * (int)idxfile.fields.size()) * sizeof(BlockHeader), __FILE__, __LINE__);
+    this->headers.resize(getHeadersSize(idxfile), __FILE__, __LINE__);
     this->file_header   = (FileHeader* )(this->headers.c_ptr());
     this->block_headers = (BlockHeader*)(this->headers.c_ptr() + sizeof(FileHeader));
 
@@ -433,6 +583,48 @@ public:
     file.reset();
   }
 
+  //setOpenFiles
+  void setOpenFiles(SharedPtr<IdxDiskAccessOpenFiles> value) {
+    this->open_files = value;
+  }
+
+  //getHeadersSize
+  static Int64 getHeadersSize(const IdxFile& idxfile) {
+    return sizeof(FileHeader) + (idxfile.blocksperfile * (Int64)idxfile.fields.size()) * sizeof(BlockHeader);
+  }
+
+  //getBlockHeader
+  static void getBlockHeader(const IdxFile& idxfile, const HeapMemory& headers, Field field, BigInt blockid, Int64& offset, Int32& size, String& compression, String& layout)
+  {
+    auto block_headers = (const BlockHeader*)(headers.c_ptr() + sizeof(FileHeader));
+    const auto& block_header = block_headers[cint(field.index) * idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockid)];
+    offset      = block_header.getOffset();
+    size        = block_header.getSize();
+    compression = block_header.getCompression();
+    layout      = block_header.getLayout();
+  }
+
+  //canStoreZstdDictionary (the block header only says "zstd", a reader gets the dictionary from the idx file)
+  static bool canStoreZstdDictionary(const IdxFile& idxfile, Field field, String compression)
+  {
+    auto dictionary = IdxFile::parseZstdDictionary(compression);
+    return dictionary.empty() || dictionary == idxfile.getZstdDictionary(field);
+  }
+
+  //setBlockHeader (return false if the compression cannot be stored in the block header)
+  static bool setBlockHeader(const IdxFile& idxfile, HeapMemory& headers, Field field, BigInt blockid, Int64 offset, Int32 size, String compression, String layout)
+  {
+    auto block_headers = (BlockHeader*)(headers.c_ptr() + sizeof(FileHeader));
+    BlockHeader block_header;
+    block_header.setLayout(layout);
+    block_header.setSize(size);
+    if (!block_header.setCompression(compression) || !canStoreZstdDictionary(idxfile, field, compression))
+      return false;
+    block_header.setOffset(offset);
+    block_headers[cint(field.index) * idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockid)] = block_header;
+    return true;
+  }
+
   //getFilename
   virtual String getFilename(Field field, double time, BigInt blockid) const override
   {
@@ -459,6 +651,11 @@ public:
       return owner->readFailed(query,reason);
     };
 
+    auto NOT_STORED = [&](String reason) {
+      query->not_stored = true;
+      return FAILED(reason);
+    };
+
     auto OK = [&]() {
       if (bVerbose)
         PrintInfo("IdxDiskAccess::read blockid", blockid, filename, "OK");
@@ -468,15 +665,24 @@ public:
     if (aborted())
       return FAILED("aborted");
 
-    //try to open the existing file
-    
-    if (!openFile(filename, isWriting() ? "rw" : "r"))
-      return FAILED(cstring("cannot open file", filename));
+    //try to open the existing file (when reading, the open file and its headers are shared by all workers)
+    SharedPtr<IdxDiskAccessOpenFiles::OpenFile> open_file;
+    if (!isWriting() && open_files)
+    {
+      open_file = open_files->open(filename);
+      if (!open_file)
+        return FileUtils::existsFile(filename) ? FAILED(cstring("cannot open file", filename)) : NOT_STORED(cstring("file not stored", filename));
+    }
+    else
+    {
+      if (!openFile(filename, isWriting() ? "rw" : "r"))
+        return FileUtils::existsFile(filename) ? FAILED(cstring("cannot open file", filename)) : NOT_STORED(cstring("file not stored", filename));
+    }
 
     if (aborted())
       return FAILED("aborted");
 
-    const BlockHeader& block_header = getBlockHeader(query->field, blockid);
+    const BlockHeader& block_header = open_file ? getBlockHeader(open_file->headers, query->field, blockid) : getBlockHeader(query->field, blockid);
     Int64 block_offset = block_header.getOffset();
     Int32 block_size   = block_header.getSize();
     String compression = block_header.getCompression();
@@ -490,11 +696,19 @@ public:
       compression = query->field.default_compression;
 #endif
 
+    //same for zstd, the dictionary (if any) is in the idx file
+    if (StringUtils::contains(compression, "zstd"))
+    {
+      auto dictionary = idxfile.getZstdDictionary(query->field);
+      if (!dictionary.empty())
+        compression += "-dict=" + dictionary;
+    }
+
     if (bVerbose)
       PrintInfo("Block header contains the following: block_offset",block_offset,"block_size",block_size,"compression",compression,"layout",layout);
 
     if (!block_offset || !block_size)
-      return FAILED(cstring("the idx data seeems not stored in the file","block_offset", block_offset,"block_size", block_size));
+      return NOT_STORED(cstring("the idx data seeems not stored in the file","block_offset", block_offset,"block_size", block_size));
 
     auto encoded = std::make_shared<HeapMemory>();
     if (!encoded->resize(block_size, __FILE__, __LINE__))
@@ -506,8 +720,17 @@ public:
     if (aborted())
       return FAILED("aborted");
 
-    if (!file->read(block_offset, encoded->c_size(), encoded->c_ptr()))
-      return FAILED("cannot read encoded buffer");
+    if (open_file)
+    {
+      ScopedLock lock(open_file->lock);
+      if (!open_file->file.read(block_offset, encoded->c_size(), encoded->c_ptr()))
+        return FAILED("cannot read encoded buffer");
+    }
+    else
+    {
+      if (!file->read(block_offset, encoded->c_size(), encoded->c_ptr()))
+        return FAILED("cannot read encoded buffer");
+    }
 
     if (bVerbose)
       PrintInfo("Decoding buffer");
@@ -535,7 +758,7 @@ public:
     query->buffer = decoded;
 
     if (bVerbose)
-      PrintInfo("Read block",blockid,"from file",file->getFilename(),"ok");
+      PrintInfo("Read block",blockid,"from file",filename,"ok");
 
     return OK();
   }
@@ -581,6 +804,9 @@ public:
     //encode the data
     String compression = getCompression(query->field.default_compression);
 
+    if (!canStoreZstdDictionary(idxfile, query->field, compression))
+      return FAILED(cstring("zstd dictionary of", compression, "is not in the idx file, see IdxFile::setZstdDictionary"));
+
     auto decoded = query->buffer;
     auto encoded = ArrayUtils::encodeArray(compression, decoded);
     if (!encoded)
@@ -592,7 +818,11 @@ public:
     BlockHeader block_header;
     block_header.setLayout(query->buffer.layout);
     block_header.setSize((Int32)encoded->c_size());
-    block_header.setCompression(compression);
+    if (!block_header.setCompression(compression))
+    {
+      VisusAssert(false);
+      return FAILED(cstring("compression", compression, "cannot be stored in the block header"));
+    }
 
     if (!openFile(filename, "rw"))
       return FAILED(cstring("cannot open file", filename));
@@ -685,6 +915,12 @@ private:
     PngCompression = 0x06,
     Lz4Compression = 0x07,
     ZfpCompression = 0x08,    
+    ZstdCompression = 0x09,
+    ShuffleZstdCompression = 0x0a,
+    ShuffleLz4Compression = 0x0b,
+    ShuffleZipCompression = 0x0c,
+    BitShuffleZstdCompression = 0x0d,
+    BitShuffleLz4Compression = 0x0e,
     CompressionMask = 0x0f
   };
 
@@ -779,20 +1015,34 @@ private:
         case JpgCompression:return "jpg"; break;
         case PngCompression:return "png"; break;
         case ZfpCompression:return "zfp"; break;
+        case ZstdCompression:return "zstd"; break;
+        case ShuffleZstdCompression:return "shuffle+zstd"; break;
+        case ShuffleLz4Compression:return "shuffle+lz4"; break;
+        case ShuffleZipCompression:return "shuffle+zip"; break;
+        case BitShuffleZstdCompression:return "bitshuffle+zstd"; break;
+        case BitShuffleLz4Compression:return "bitshuffle+lz4"; break;
         default: VisusAssert(false); return "";
       }
     }
 
-    //setCompression
-    void setCompression(String value) 
+    //setCompression (return false if value has no flag code)
+    bool setCompression(String value) 
     {
       if      (value.empty())  flags |= NoCompression;
+      else if (StringUtils::startsWith(value, "shuffle+zstd")) flags |= ShuffleZstdCompression;
+      else if (StringUtils::startsWith(value, "shuffle+lz4")) flags |= ShuffleLz4Compression;
+      else if (StringUtils::startsWith(value, "shuffle+zip")) flags |= ShuffleZipCompression;
+      else if (StringUtils::startsWith(value, "bitshuffle+zstd")) flags |= BitShuffleZstdCompression;
+      else if (StringUtils::startsWith(value, "bitshuffle+lz4")) flags |= BitShuffleLz4Compression;
+      else if (StringUtils::contains(value, "shuffle+")) return false;
+      else if (StringUtils::startsWith(value, "zstd")) flags |= ZstdCompression;
       else if (StringUtils::startsWith(value, "lz4")) flags |= Lz4Compression;
       else if (StringUtils::startsWith(value, "zip")) flags |= ZipCompression;
       else if (StringUtils::startsWith(value, "jpg")) flags |= JpgCompression;
       else if (StringUtils::startsWith(value, "png")) flags |= PngCompression;
       else if (StringUtils::startsWith(value, "zfp")) flags |= ZfpCompression;
-      else VisusAssert(false);
+      else return false;
+      return true;
     }
 
   };
@@ -806,6 +1056,9 @@ private:
   BlockHeader*    block_headers = nullptr;
   SharedPtr<File> file;
 
+  //shared between workers, used only for reading
+  SharedPtr<IdxDiskAccessOpenFiles> open_files;
+
   //re-entrant file lock
   std::map<String, int> file_locks;
 
@@ -814,6 +1067,12 @@ private:
     return block_headers[cint(field.index)*idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockid)];
   }
 
+  //getBlockHeader
+  const BlockHeader& getBlockHeader(const HeapMemory& headers, Field& field, Int64 blockid) const {
+    auto block_headers = (const BlockHeader*)(headers.c_ptr() + sizeof(FileHeader));
+    return block_headers[cint(field.index)*idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockid)];
+  }
+
   //openFile
   bool openFile(String filename, String file_mode)
   {
@@ -925,6 +1184,7 @@ private:
       if (!this->file->write(0, this->headers.c_size(), this->headers.c_ptr()))
       {
         VisusAssert(false);
+        ++owner->statistics.wfail; //so that the caller knows the last writes are lost
         //if (bVerbose)
         PrintInfo("cannot write headers");
       }
@@ -1031,12 +1291,19 @@ IdxDiskAccess::IdxDiskAccess(IdxDataset* dataset, StringTree config)
     return value;
   };
   
+  //open files (and their headers) are shared between the sync access and all the async workers
+  if (idxfile.version >= 6)
+  {
+    this->open_files = std::make_shared<IdxDiskAccessOpenFiles>(IdxDiskAccessV6::getHeadersSize(idxfile), config.readInt("max_open_files", 64));
+    this->open_files->verbose = verbose;
+  }
+
   //NOTE: time_template will go inside filename_template so there is no reason to resolve alias
   auto myCreateAccess = [&]()->Access*{
     if (idxfile.version < 6)
       return new IdxDiskAccessV5(this, idxfile, resoveAlias(idxfile.time_template), resoveAlias(idxfile.filename_template), compression, verbose);
     else
-      return new IdxDiskAccessV6(this, idxfile, resoveAlias(idxfile.time_template), resoveAlias(idxfile.filename_template), compression, verbose);
+      return new IdxDiskAccessV6(this, idxfile, resoveAlias(idxfile.time_template), resoveAlias(idxfile.filename_template), compression, verbose, open_files);
   };
 
   this-> sync.reset(myCreateAccess());
@@ -1067,18 +1334,53 @@ IdxDiskAccess::IdxDiskAccess(IdxDataset* dataset, StringTree config)
   else
     disable_async = config.readBool("disable_async", dataset->isServerMode());
 
-  // important!number of threads must be <=1 
-  if (int nthreads = disable_async ? 0 : 1)
+  //V6 workers share the open files (V5 keeps one file per access, so it must use only one worker)
+  int nthreads = 0;
+  if (!disable_async)
   {
-    async_tpool = std::make_shared<ThreadPool>("IdxDiskAccess Thread", nthreads);
+    nthreads = config.readInt("nthreads", Utils::clamp((int)std::thread::hardware_concurrency(), 1, 8));
+
+    if (auto env = getenv("VISUS_IDX_NUM_THREADS"))
+      nthreads = cint(String(env));
+
+    nthreads = idxfile.version < 6 ? 1 : std::max(1, nthreads);
   }
+
+  if (nthreads)
+    async_tpool = std::make_shared<ThreadPool>("IdxDiskAccess Thread", nthreads);
 #endif
 
-  PrintInfo("Created IdxDiskAccess", "local_idx_filename", local_idx_filename, "compression", compression, "bDisableWriteLocks", bDisableWriteLocks);
+  PrintInfo("Created IdxDiskAccess", "local_idx_filename", local_idx_filename, "compression", compression, "bDisableWriteLocks", bDisableWriteLocks, "nthreads", nthreads);
 }
 
 
 
+////////////////////////////////////////////////////////////////////
+String IdxDiskAccess::getFilenameV56(const IdxFile& idxfile, String time_template, String filename_template, Field field, double time, BigInt blockid)
+{
+  return GetFilenameV56(idxfile, time_template, filename_template, field, time, blockid);
+}
+
+////////////////////////////////////////////////////////////////////
+Int64 IdxDiskAccess::getHeadersSizeV6(const IdxFile& idxfile)
+{
+  return IdxDiskAccessV6::getHeadersSize(idxfile);
+}
+
+////////////////////////////////////////////////////////////////////
+void IdxDiskAccess::getBlockHeaderV6(const IdxFile& idxfile, const HeapMemory& headers, Field field, BigInt blockid, Int64& offset, Int32& size, String& compression, String& layout)
+{
+  VisusAssert(headers.c_size() >= getHeadersSizeV6(idxfile));
+  IdxDiskAccessV6::getBlockHeader(idxfile, headers, field, blockid, offset, size, compression, layout);
+}
+
+////////////////////////////////////////////////////////////////////
+bool IdxDiskAccess::setBlockHeaderV6(const IdxFile& idxfile, HeapMemory& headers, Field field, BigInt blockid, Int64 offset, Int32 size, String compression, String layout)
+{
+  VisusAssert(headers.c_size() >= getHeadersSizeV6(idxfile));
+  return IdxDiskAccessV6::setBlockHeader(idxfile, headers, field, blockid, offset, size, compression, layout);
+}
+
 ////////////////////////////////////////////////////////////////////
 IdxDiskAccess::~IdxDiskAccess()
 {
@@ -1102,6 +1404,19 @@ void IdxDiskAccess::disableAsync()
 }
 
 
+////////////////////////////////////////////////////////////////////
+void IdxDiskAccess::shareOpenFilesWith(SharedPtr<IdxDiskAccess> other)
+{
+  //only V6 caches open files, and they must refer to the same files
+  if (!this->open_files || !other->open_files || other->idxfile.filename_template != this->idxfile.filename_template)
+    return;
+
+  VisusReleaseAssert(!isReading() && !isWriting());
+  this->open_files = other->open_files;
+  ((IdxDiskAccessV6*)sync.get())->setOpenFiles(open_files);
+  ((IdxDiskAccessV6*)async.get())->setOpenFiles(open_files);
+}
+
 ////////////////////////////////////////////////////////////////////
 String IdxDiskAccess::getFilename(Field field,double time,BigInt blockid) const 
 {
@@ -1116,35 +1431,35 @@ void IdxDiskAccess::beginIO(int mode)
 
   Access::beginIO(mode);
 
+  //files are going to change, cannot trust cached headers anymore
+  if (isWriting() && open_files)
+    open_files->clear();
+
+  //NOTE: the pool is empty here, and with more than one worker beginIO must happen before any read
   if (!isWriting() && async_tpool)
-  {
-    ThreadPool::push(async_tpool, [this, mode]() {
-      async->beginIO(mode);
-    });
-  }
+    async->beginIO(mode);
   else
-  {
     sync->beginIO(mode);
-  }
 }
 
 ////////////////////////////////////////////////////////////////////
 void IdxDiskAccess::endIO() 
 {
+  //wait for all pending reads before closing anything
+  if (async_tpool)
+    async_tpool->waitAll();
+
   if (!isWriting() && async_tpool)
   {
-    ThreadPool::push(async_tpool, [this]() {
-      async->endIO();
-    });
-    async_tpool->waitAll();
+    async->endIO();
   }
   else
   {
     sync->endIO();
-  }
 
-  if (async_tpool)
-    async_tpool->waitAll();
+    if (isWriting() && open_files)
+      open_files->clear();
+  }
 
   Access::endIO();
 }
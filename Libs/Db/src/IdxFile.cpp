@@ -317,6 +317,42 @@ IdxFile::IdxFile(int version_) : version(version_)
   timesteps.addTimestep(0); //default is to have one timestep with 0 value
 }
 
+//////////////////////////////////////////////////////////////////////////////
+String IdxFile::getZstdDictionary(const Field& field) const
+{
+  auto ret = metadata.getValue("zstd_dictionary " + field.name);
+  if (!ret.empty())
+    return ret;
+
+  //backward compatible, the dictionary is only in the default_compression
+  for (const auto& it : fields)
+  {
+    if (it.name == field.name)
+      return parseZstdDictionary(it.default_compression);
+  }
+
+  return parseZstdDictionary(field.default_compression);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxFile::setZstdDictionary(String fieldname, String filename)
+{
+  if (filename.empty())
+    metadata.eraseValue("zstd_dictionary " + fieldname);
+  else
+    metadata.setValue("zstd_dictionary " + fieldname, filename);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+String IdxFile::parseZstdDictionary(String compression)
+{
+  //see ZstdEncoder (dict= is always the last option)
+  auto pos = compression.find("-dict=");
+  if (!StringUtils::contains(compression, "zstd") || pos == String::npos)
+    return "";
+  return compression.substr(pos + String("-dict=").size());
+}
+
 //////////////////////////////////////////////////////////////////////////////
 void IdxFile::load(String url,String& TypeName)
 {
@@ -38,9 +38,12 @@ For support : support@visus.net
 
 #include <Visus/IdxMultipleDataset.h>
 #include <Visus/IdxMultipleAccess.h>
+#include <Visus/IdxMultipleExpression.h>
 #include <Visus/Path.h>
 #include <Visus/Polygon.h>
 
+#include <cmath>
+
 namespace Visus {
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -97,6 +100,94 @@ static bool IsGoodVariableName(String name)
 };
 
 
+////////////////////////////////////////////////////////////////////////////////////
+class IdxMultipleDataset::DownIndex
+{
+public:
+
+  std::vector<String>             names;
+  std::vector<BoxNd>              boxes;
+  BoxNd                           bounds;
+  PointNi                         ncells;
+  std::vector< std::vector<int> > cells;
+
+  //constructor (uniform grid with about one LOGIC footprint for each cell)
+  DownIndex(const IdxMultipleDataset* DATASET)
+  {
+    for (auto it : DATASET->down_datasets)
+    {
+      auto dataset = it.second;
+      auto box = Position(dataset->logic_to_LOGIC, dataset->getLogicBox()).toAxisAlignedBox();
+      names.push_back(it.first);
+      boxes.push_back(box);
+      bounds = bounds.valid() ? bounds.getUnion(box) : box;
+    }
+
+    if (boxes.empty())
+      return;
+
+    int pdim = bounds.getPointDim();
+    auto n = std::max((Int64)1, (Int64)std::pow((double)boxes.size(), 1.0 / pdim));
+    ncells = PointNi::one(pdim) * n;
+    cells.resize(ncells.innerProduct());
+
+    for (int I = 0; I < (int)boxes.size(); I++)
+    {
+      PointNi from, to;
+      getCellRange(boxes[I], from, to);
+      for (auto P = ForEachPoint(from, to, PointNi::one(pdim)); !P.end(); P.next())
+        cells[ncells.stride().dot(P.pos)].push_back(I);
+    }
+  }
+
+  //find
+  std::vector<String> find(BoxNd box) const
+  {
+    if (boxes.empty() || !box.valid())
+      return {};
+
+    std::vector<int> candidates;
+    PointNi from, to;
+    getCellRange(box, from, to);
+    for (auto P = ForEachPoint(from, to, PointNi::one(ncells.getPointDim())); !P.end(); P.next())
+    {
+      const auto& cell = cells[ncells.stride().dot(P.pos)];
+      candidates.insert(candidates.end(), cell.begin(), cell.end());
+    }
+
+    //same order of down_datasets
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<String> ret;
+    for (auto I : candidates)
+    {
+      if (box.intersect(boxes[I]))
+        ret.push_back(names[I]);
+    }
+    return ret;
+  }
+
+private:
+
+  //getCellRange
+  void getCellRange(BoxNd box, PointNi& from, PointNi& to) const
+  {
+    int pdim = ncells.getPointDim();
+    from = PointNi(pdim);
+    to = PointNi(pdim);
+    for (int D = 0; D < pdim; D++)
+    {
+      auto size = bounds.p2[D] - bounds.p1[D];
+      auto A = size > 0 ? (Int64)std::floor(ncells[D] * (box.p1[D] - bounds.p1[D]) / size) : 0;
+      auto B = size > 0 ? (Int64)std::floor(ncells[D] * (box.p2[D] - bounds.p1[D]) / size) : 0;
+      from[D] = Utils::clamp(A, (Int64)0, ncells[D] - 1);
+      to  [D] = Utils::clamp(B, (Int64)0, ncells[D] - 1) + 1;
+    }
+  }
+
+};
+
 ///////////////////////////////////////////////////////////////////////////////////
 IdxMultipleDataset::IdxMultipleDataset() {
 
@@ -122,10 +213,66 @@ Field IdxMultipleDataset::getFieldEx(String FIELDNAME) const
   else
     CODE = FIELDNAME; //the fieldname itself is the expression
 
-  auto OUTPUT = computeOuput(/*QUERY*/nullptr, /*ACCESS*/SharedPtr<Access>(), Aborted(), CODE);
+  auto OUTPUT = computeOutputEx(/*QUERY*/nullptr, /*ACCESS*/SharedPtr<Access>(), Aborted(), CODE);
   return Field(CODE, OUTPUT.dtype);
 }
 
+////////////////////////////////////////////////////////////////////////////////////
+Array IdxMultipleDataset::computeOutputEx(BoxQuery* QUERY, SharedPtr<Access> ACCESS, Aborted aborted, String CODE) const
+{
+  //read only once, this is called for each query
+  static const bool bNative = []() {
+    auto env = Utils::getEnv("VISUS_MIDX_NATIVE_EXPRESSIONS");
+    return env.empty() ? true : cbool(env);
+  }();
+
+  //parse only once (keep the most recently used ones, CODE can be anything the clients send)
+  const size_t max_expressions = 256;
+  SharedPtr<IdxMultipleExpression> expression;
+  if (bNative)
+  {
+    ScopedLock lock(expressions_lock);
+    auto it = expressions.find(CODE);
+    if (it != expressions.end())
+    {
+      expressions_lru.splice(expressions_lru.begin(), expressions_lru, it->second.second);
+    }
+    else
+    {
+      expressions_lru.push_front(CODE);
+      it = expressions.insert(std::make_pair(CODE, CachedExpression(IdxMultipleExpression::parse(CODE), expressions_lru.begin()))).first;
+      while (expressions.size() > max_expressions)
+      {
+        expressions.erase(expressions_lru.back());
+        expressions_lru.pop_back();
+      }
+    }
+    expression = it->second.first;
+  }
+
+  if (!expression)
+    return computeOuput(QUERY, ACCESS, aborted, CODE);
+
+  try
+  {
+    return expression->evaluate(const_cast<IdxMultipleDataset*>(this), QUERY, ACCESS, aborted);
+  }
+  catch (IdxMultipleExpression::NotSupported& ex)
+  {
+    PrintInfo("Native expression failed", ex.what(), "using the python engine");
+
+    //do not try the native engine again with the same code
+    {
+      ScopedLock lock(expressions_lock);
+      auto it = expressions.find(CODE);
+      if (it != expressions.end() && it->second.first == expression)
+        it->second.first.reset();
+    }
+
+    return computeOuput(QUERY, ACCESS, aborted, CODE);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////
 String IdxMultipleDataset::getInputName(String dataset_name, String fieldname)
 {
@@ -160,11 +307,24 @@ String IdxMultipleDataset::getInputName(String dataset_name, String fieldname)
 
 
 /////////////////////////////////////////////////////////////////////////////////////
-Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> ACCESS, String dataset_name, String fieldname)
+std::vector<String> IdxMultipleDataset::findDownDatasets(BoxNd LOGIC_BOX)
+{
+  SharedPtr<DownIndex> index;
+  {
+    ScopedLock lock(down_lock);
+    if (!down_index || down_index->names.size() != down_datasets.size())
+      down_index = std::make_shared<DownIndex>(this);
+    index = down_index;
+  }
+  return index->find(LOGIC_BOX);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> ACCESS, String dataset_name, String fieldname, bool bCrop)
 {
   IdxMultipleDataset* DATASET = this;
 
-  auto dataset = DATASET->down_datasets[dataset_name]; 
+  auto dataset = DATASET->getChild(dataset_name); 
   VisusReleaseAssert(dataset);
 
   auto field = dataset->getField(fieldname); 
@@ -194,6 +354,9 @@ Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> AC
   //sometimes I miss the last level
   delta_h++; 
 
+  //down queries can run in parallel (see blendDownQueries)
+  std::unique_lock<CriticalSection> down_queries_lock(down_lock);
+
   //query already created?
   auto key = dataset_name + "/" + fieldname;
   SharedPtr<BoxQuery> query;
@@ -243,7 +406,7 @@ Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> AC
   //if not multiple access i think it will be a pure remote query
   //NOTE I'm creating a donw-access for each key (i.e. dataset_name.field_name)
   //     this could be just dataset_name but what happens if I executeDownQuery in parallel on 2 fields of the same datasets?
-  //     at least this way I could run in parallel... even if I'm not doing it
+  //     this way two down queries never share the same access
   SharedPtr<Access> access;
   if (auto multiple_access = std::dynamic_pointer_cast<IdxMultipleAccess>(ACCESS))
   {
@@ -258,6 +421,8 @@ Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> AC
     }
   }
 
+  down_queries_lock.unlock();
+
   //already failed
   if (!query || query->failed())
     return Array();
@@ -286,20 +451,36 @@ Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> AC
     //PrintInfo("MIDX up nsamples",QUERY->nsamples,"dw",dataset_name,".",field.name,"nsamples",query->buffer.dims.toString());
   }
 
-  //create a brand new BUFFER for doing the warpPerspective
-  auto ret = Array(QUERY->getNumberOfSamples(), query->buffer.dtype);
-  ret.fillWithValue(query->field.default_value);
-
-  ret.alpha = std::make_shared<Array>(ret.dims, DTypes::UINT8);
-  ret.alpha->fillWithValue(0);
-
-  auto PIXEL_TO_LOGIC = Position::computeTransformation(Position(QUERY->logic_box), ret.dims);
+  auto DIMS = QUERY->getNumberOfSamples();
+  auto PIXEL_TO_LOGIC = Position::computeTransformation(Position(QUERY->logic_box), DIMS);
   auto pixel_to_logic = Position::computeTransformation(Position(query->logic_box), query->buffer.dims);
 
   auto LOGIC_TO_PIXEL = PIXEL_TO_LOGIC.invert();
   auto pixel_to_PIXEL = LOGIC_TO_PIXEL * dataset->logic_to_LOGIC * pixel_to_logic;
   auto LOGIC_CENTROID = dataset->logic_to_LOGIC * dataset->getLogicBox().center();
 
+  //warp only in the PIXEL region covered by the down dataset (+1 pixel for rounding)
+  auto PIXEL_BOX = BoxNi(PointNi(DIMS.getPointDim()), DIMS);
+  if (bCrop)
+  {
+    auto box = Position(pixel_to_PIXEL, BoxNi(PointNi(DIMS.getPointDim()), query->buffer.dims)).toAxisAlignedBox();
+    for (int D = 0; D < DIMS.getPointDim(); D++)
+    {
+      PIXEL_BOX.p1[D] = Utils::clamp((Int64)std::floor(box.p1[D]) - 1, (Int64)0, DIMS[D]);
+      PIXEL_BOX.p2[D] = Utils::clamp((Int64)std::ceil (box.p2[D]) + 1, (Int64)0, DIMS[D]);
+    }
+
+    if (!PIXEL_BOX.isFullDim())
+      return Array();
+  }
+
+  //create a brand new BUFFER for doing the warpPerspective
+  auto ret = Array(PIXEL_BOX.size(), query->buffer.dtype);
+  ret.fillWithValue(query->field.default_value);
+
+  ret.alpha = std::make_shared<Array>(ret.dims, DTypes::UINT8);
+  ret.alpha->fillWithValue(0);
+
   //limit the samples to good logic domain
   //explanation: for each pixel in dims, tranform it to the logic dataset box, if inside set the pixel to 1 otherwise set the pixel to 0
   if (!query->buffer.alpha)
@@ -309,7 +490,8 @@ Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> AC
   }
   VisusReleaseAssert(query->buffer.alpha->dims == query->buffer.dims);
 
-  ArrayUtils::warpPerspective(ret, pixel_to_PIXEL, query->buffer, QUERY->aborted);
+  //NOTE: all the transformations are relative to the full QUERY samples
+  ArrayUtils::warpPerspective(ret, pixel_to_PIXEL, query->buffer, PIXEL_BOX.p1, QUERY->aborted);
 
   if (DATASET->debug_mode & IdxMultipleDataset::DebugSaveImages)
   {
@@ -327,10 +509,82 @@ Array IdxMultipleDataset::executeDownQuery(BoxQuery* QUERY, SharedPtr<Access> AC
   ret.run_time_attributes.setValue("LOGIC_TO_PIXEL", LOGIC_TO_PIXEL.toString());
   ret.run_time_attributes.setValue("PIXEL_TO_LOGIC", PIXEL_TO_LOGIC.toString());
   ret.run_time_attributes.setValue("LOGIC_CENTROID", LOGIC_CENTROID.toString());
+  ret.run_time_attributes.setValue("PIXEL_OFFSET", PIXEL_BOX.p1.toString());
+
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+std::vector<Array> IdxMultipleDataset::executeDownQueries(BoxQuery* QUERY, SharedPtr<Access> ACCESS, std::vector< std::pair<String, String> > args, bool bCrop)
+{
+  int nthreads = std::max(1, (int)std::thread::hardware_concurrency());
+  if (auto env = getenv("VISUS_MIDX_NUM_THREADS"))
+    nthreads = std::max(1, cint(String(env)));
+
+  //one pool shared by all the queries
+  SharedPtr<ThreadPool> thread_pool;
+  if (nthreads > 1 && args.size() > 1)
+  {
+    ScopedLock lock(down_lock);
+    if (!down_pool)
+      down_pool = std::make_shared<ThreadPool>("Midx Worker", nthreads);
+    thread_pool = down_pool;
+  }
+
+  //NOTE: two args must not refer to the same down query (i.e. same dataset_name/fieldname)
+  std::vector<Array> ret(args.size());
+  String error;
+  Semaphore ndone;
+  for (int I = 0; I < (int)args.size(); I++)
+  {
+    ThreadPool::push(thread_pool, [&, I]()
+    {
+      try
+      {
+        ret[I] = executeDownQuery(QUERY, ACCESS, args[I].first, args[I].second, bCrop);
+      }
+      catch (std::exception& ex)
+      {
+        ScopedLock lock(down_lock);
+        error = ex.what();
+      }
+      ndone.up();
+    });
+  }
+
+  for (int I = 0; I < (int)args.size(); I++)
+    ndone.down();
+
+  if (!error.empty())
+    ThrowException(error);
 
   return ret;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+Array IdxMultipleDataset::blendDownQueries(BoxQuery* QUERY, SharedPtr<Access> ACCESS, BlendBuffers::Type type)
+{
+  //only the down datasets intersecting the QUERY
+  std::vector< std::pair<String, String> > args;
+  for (auto dataset_name : findDownDatasets(QUERY->logic_box.castTo<BoxNd>()))
+    args.push_back(std::make_pair(dataset_name, getChild(dataset_name)->getField().name));
+
+  //each down query has its own (cropped) buffer, the blending is done in the same order of down_datasets
+  auto buffers = executeDownQueries(QUERY, ACCESS, args, /*bCrop*/true);
+
+  auto DIMS = QUERY->getNumberOfSamples();
+  BlendBuffers blend(type, QUERY->aborted);
+  for (auto buffer : buffers)
+  {
+    if (!buffer.valid() || QUERY->aborted())
+      continue;
+
+    blend.addBlendArg(buffer, PointNi::fromString(buffer.run_time_attributes.getValue("PIXEL_OFFSET")), DIMS);
+  }
+
+  return blend.result;
+}
+
 ////////////////////////////////////////////////////////////////////////
 bool IdxMultipleDataset::executeBoxQuery(SharedPtr<Access> ACCESS,SharedPtr<BoxQuery> QUERY)
 {
@@ -360,7 +614,7 @@ bool IdxMultipleDataset::executeBoxQuery(SharedPtr<Access> ACCESS,SharedPtr<BoxQ
   Array  OUTPUT;
   try
   {
-    OUTPUT = computeOuput(QUERY.get(), ACCESS, QUERY->aborted, QUERY->field.name);
+    OUTPUT = computeOutputEx(QUERY.get(), ACCESS, QUERY->aborted, QUERY->field.name);
   }
   catch (const std::exception& ex)
   {
@@ -0,0 +1,907 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#include <Visus/IdxMultipleExpression.h>
+#include <Visus/IdxMultipleDataset.h>
+#include <Visus/ArrayUtils.h>
+
+#include <cstring>
+
+namespace Visus {
+
+////////////////////////////////////////////////////////////////////////////////////
+class IdxMultipleExpression::Node
+{
+public:
+
+  enum Type
+  {
+    NumberNode,
+    StringNode,
+    ListNode,
+    VariableNode,
+    QueryTimeNode,
+    InputNode,
+    UnaryNode,
+    BinaryNode,
+    IndexNode,
+    CallNode
+  };
+
+  Type                           type;
+  String                         name;  //variable, operator or function name
+  double                         number = 0;
+  String                         string;
+  std::vector<String>            path;  //input['dataset_name']['fieldname']
+  int                            input_id = -1;
+  std::vector< SharedPtr<Node> > args;
+
+  //constructor
+  Node(Type type_, String name_ = "") : type(type_), name(name_) {
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+typedef IdxMultipleExpression::NotSupported ExpressionNotSupported;
+
+////////////////////////////////////////////////////////////////////////////////////
+class ExpressionToken
+{
+public:
+
+  enum Type
+  {
+    EndToken,
+    NewlineToken,
+    NameToken,
+    NumberToken,
+    StringToken,
+    OpToken
+  };
+
+  Type   type = EndToken;
+  String value;
+  double number = 0;
+
+  //constructor
+  ExpressionToken(Type type_ = EndToken, String value_ = "", double number_ = 0) : type(type_), value(value_), number(number_) {
+  }
+
+  //isOperand
+  bool isOperand() const {
+    return type == NameToken || type == NumberToken || type == StringToken || (type == OpToken && (value == ")" || value == "]"));
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+static std::vector<ExpressionToken> TokenizeExpression(const String& code)
+{
+  std::vector<ExpressionToken> ret;
+  int depth = 0;
+  size_t I = 0, N = code.size();
+  while (I < N)
+  {
+    char c = code[I];
+
+    //comment
+    if (c == '#')
+    {
+      while (I < N && code[I] != '\n') I++;
+      continue;
+    }
+
+    //line continuation
+    if (c == '\\')
+    {
+      I++;
+      if (I < N && code[I] == '\r') I++;
+      if (I >= N || code[I] != '\n') throw ExpressionNotSupported("unexpected character");
+      I++;
+      continue;
+    }
+
+    //new statement (newlines inside brackets are ignored)
+    if (c == '\n' || c == ';')
+    {
+      if (!depth && !ret.empty() && ret.back().type != ExpressionToken::NewlineToken)
+        ret.push_back(ExpressionToken(ExpressionToken::NewlineToken));
+      I++;
+      continue;
+    }
+
+    if (std::isspace((unsigned char)c))
+    {
+      I++;
+      continue;
+    }
+
+    //name
+    if (std::isalpha((unsigned char)c) || c == '_')
+    {
+      auto I0 = I;
+      while (I < N && (std::isalnum((unsigned char)code[I]) || code[I] == '_')) I++;
+      ret.push_back(ExpressionToken(ExpressionToken::NameToken, code.substr(I0, I - I0)));
+      continue;
+    }
+
+    //number
+    bool bLeadingDot = c == '.' && I + 1 < N && std::isdigit((unsigned char)code[I + 1]) && !(ret.size() && ret.back().isOperand());
+    if (std::isdigit((unsigned char)c) || bLeadingDot)
+    {
+      const char* p1 = code.c_str() + I;
+      char* p2 = nullptr;
+      double value = std::strtod(p1, &p2);
+      ret.push_back(ExpressionToken(ExpressionToken::NumberToken, code.substr(I, p2 - p1), value));
+      I += p2 - p1;
+      continue;
+    }
+
+    //string
+    if (c == '\'' || c == '"')
+    {
+      String quote = (I + 2 < N && code[I + 1] == c && code[I + 2] == c) ? String(3, c) : String(1, c);
+      I += quote.size();
+      String value;
+      for (;;)
+      {
+        if (I >= N || (quote.size() == 1 && code[I] == '\n'))
+          throw ExpressionNotSupported("unterminated string");
+
+        if (code.compare(I, quote.size(), quote) == 0)
+        {
+          I += quote.size();
+          break;
+        }
+
+        if (code[I] == '\\' && I + 1 < N)
+        {
+          char e = code[I + 1];
+          I += 2;
+          switch (e)
+          {
+          case 'n':  value += '\n'; break;
+          case 't':  value += '\t'; break;
+          case '\n': break;
+          case '\\': case '\'': case '"': value += e; break;
+          default:   value += '\\'; value += e; break;
+          }
+          continue;
+        }
+
+        value += code[I++];
+      }
+      ret.push_back(ExpressionToken(ExpressionToken::StringToken, value));
+      continue;
+    }
+
+    //operators (no augmented assignments, no power, no floor division, no comparisons)
+    if (std::strchr("+-*/()[],.=", c))
+    {
+      char next = I + 1 < N ? code[I + 1] : 0;
+      if ((c == '*' && next == '*') || (c == '/' && next == '/') || next == '=')
+        throw ExpressionNotSupported("unsupported operator");
+
+      if (c == '(' || c == '[') depth++;
+      if (c == ')' || c == ']') depth--;
+      ret.push_back(ExpressionToken(ExpressionToken::OpToken, String(1, c)));
+      I++;
+      continue;
+    }
+
+    throw ExpressionNotSupported("unexpected character");
+  }
+
+  ret.push_back(ExpressionToken(ExpressionToken::EndToken));
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+class ExpressionParser
+{
+public:
+
+  typedef IdxMultipleExpression::Node Node;
+
+  std::vector< std::pair<String, SharedPtr<Node> > > statements;
+  std::vector< SharedPtr<Node> > inputs;
+
+  //constructor
+  ExpressionParser(const String& code) : tokens(TokenizeExpression(code)) {
+  }
+
+  //parseStatements
+  void parseStatements()
+  {
+    for (;;)
+    {
+      while (peek().type == ExpressionToken::NewlineToken)
+        pos++;
+
+      if (peek().type == ExpressionToken::EndToken)
+        return;
+
+      //only assignments
+      if (peek().type != ExpressionToken::NameToken || !isOp("=", 1))
+        throw ExpressionNotSupported("unsupported statement");
+
+      auto name = peek().value;
+      pos += 2;
+
+      auto expr = parseExpr();
+      if (peek().type != ExpressionToken::NewlineToken && peek().type != ExpressionToken::EndToken)
+        throw ExpressionNotSupported("unsupported statement");
+
+      variables.insert(name);
+      statements.push_back(std::make_pair(name, expr));
+    }
+  }
+
+private:
+
+  std::vector<ExpressionToken> tokens;
+  size_t                       pos = 0;
+  std::set<String>             variables;
+
+  //peek
+  const ExpressionToken& peek(size_t offset = 0) const {
+    return tokens[std::min(pos + offset, tokens.size() - 1)];
+  }
+
+  //isOp
+  bool isOp(String op, size_t offset = 0) const {
+    auto& token = peek(offset);
+    return token.type == ExpressionToken::OpToken && token.value == op;
+  }
+
+  //accept
+  bool accept(String op) {
+    if (!isOp(op)) return false;
+    pos++;
+    return true;
+  }
+
+  //expect
+  void expect(String op) {
+    if (!accept(op))
+      throw ExpressionNotSupported("expected " + op);
+  }
+
+  //expectName
+  String expectName() {
+    if (peek().type != ExpressionToken::NameToken)
+      throw ExpressionNotSupported("expected name");
+    return tokens[pos++].value;
+  }
+
+  //newBinary
+  static SharedPtr<Node> newBinary(String op, SharedPtr<Node> a, SharedPtr<Node> b) {
+    auto ret = std::make_shared<Node>(Node::BinaryNode, op);
+    ret->args = { a,b };
+    return ret;
+  }
+
+  //parseExpr
+  SharedPtr<Node> parseExpr()
+  {
+    auto ret = parseTerm();
+    while (isOp("+") || isOp("-"))
+    {
+      auto op = tokens[pos++].value;
+      ret = newBinary(op, ret, parseTerm());
+    }
+    return ret;
+  }
+
+  //parseTerm
+  SharedPtr<Node> parseTerm()
+  {
+    auto ret = parseUnary();
+    while (isOp("*") || isOp("/"))
+    {
+      auto op = tokens[pos++].value;
+      ret = newBinary(op, ret, parseUnary());
+    }
+    return ret;
+  }
+
+  //parseUnary
+  SharedPtr<Node> parseUnary()
+  {
+    if (accept("+"))
+      return parseUnary();
+
+    if (accept("-"))
+    {
+      auto ret = std::make_shared<Node>(Node::UnaryNode, "-");
+      ret->args = { parseUnary() };
+      return ret;
+    }
+
+    auto ret = parsePrimary();
+
+    //component picking (or list item)
+    while (accept("["))
+    {
+      auto index = std::make_shared<Node>(Node::IndexNode);
+      index->args = { ret, parseExpr() };
+      expect("]");
+      ret = index;
+    }
+
+    return ret;
+  }
+
+  //parseList
+  SharedPtr<Node> parseList(SharedPtr<Node> ret, String close)
+  {
+    while (!isOp(close))
+    {
+      ret->args.push_back(parseExpr());
+      if (!accept(","))
+        break;
+    }
+    expect(close);
+    return ret;
+  }
+
+  //parseCall
+  SharedPtr<Node> parseCall(String name)
+  {
+    expect("(");
+
+    //no keyword arguments
+    for (size_t I = pos; tokens[I].type != ExpressionToken::EndToken; I++)
+    {
+      if (tokens[I].type == ExpressionToken::NameToken && tokens[I + 1].type == ExpressionToken::OpToken && tokens[I + 1].value == "=")
+        throw ExpressionNotSupported("unsupported keyword argument");
+      if (tokens[I].type == ExpressionToken::NewlineToken)
+        break;
+    }
+
+    return parseList(std::make_shared<Node>(Node::CallNode, name), ")");
+  }
+
+  //parseInput
+  SharedPtr<Node> parseInput()
+  {
+    auto ret = std::make_shared<Node>(Node::InputNode);
+    for (;;)
+    {
+      if (accept("."))
+      {
+        ret->path.push_back(expectName());
+      }
+      else if (isOp("[") && peek(1).type == ExpressionToken::StringToken && isOp("]", 2))
+      {
+        ret->path.push_back(peek(1).value);
+        pos += 3;
+      }
+      else
+      {
+        break;
+      }
+    }
+
+    //input.timesteps, input.A.timesteps (and dataset objects) need the python engine
+    if (ret->path.size() < 2 || ret->path.size() > 3 || ret->path[0] == "timesteps" || ret->path[1] == "timesteps")
+      throw ExpressionNotSupported("unsupported input");
+
+    ret->input_id = (int)inputs.size();
+    inputs.push_back(ret);
+    return ret;
+  }
+
+  //parsePrimary
+  SharedPtr<Node> parsePrimary()
+  {
+    auto token = peek();
+
+    if (token.type == ExpressionToken::NumberToken)
+    {
+      pos++;
+      auto ret = std::make_shared<Node>(Node::NumberNode);
+      ret->number = token.number;
+      return ret;
+    }
+
+    if (token.type == ExpressionToken::StringToken)
+    {
+      pos++;
+      auto ret = std::make_shared<Node>(Node::StringNode);
+      ret->string = token.value;
+      return ret;
+    }
+
+    //(expr) or tuple
+    if (accept("("))
+    {
+      auto ret = parseExpr();
+      if (!accept(","))
+      {
+        expect(")");
+        return ret;
+      }
+      auto tuple = std::make_shared<Node>(Node::ListNode);
+      tuple->args.push_back(ret);
+      return parseList(tuple, ")");
+    }
+
+    if (accept("["))
+      return parseList(std::make_shared<Node>(Node::ListNode), "]");
+
+    if (token.type == ExpressionToken::NameToken)
+    {
+      pos++;
+      auto name = token.value;
+
+      if (variables.count(name))
+        return std::make_shared<Node>(Node::VariableNode, name);
+
+      if (name == "query_time")
+        return std::make_shared<Node>(Node::QueryTimeNode);
+
+      if (name == "input")
+        return parseInput();
+
+      if (name == "voronoi" || name == "noBlend" || name == "averageBlend")
+        return parseCall(name);
+
+      if (name == "ArrayUtils")
+      {
+        expect(".");
+        name = expectName();
+        const std::set<String> functions = { "add", "sub", "mul", "div", "min", "max", "average", "standardDeviation", "median", "interleave", "sqrt" };
+        if (!functions.count(name))
+          throw ExpressionNotSupported("unsupported function");
+        return parseCall("ArrayUtils." + name);
+      }
+    }
+
+    throw ExpressionNotSupported("unsupported expression");
+  }
+
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////
+class ExpressionValue
+{
+public:
+
+  enum Type
+  {
+    NoneValue,
+    NumberValue,
+    StringValue,
+    ArrayValue,
+    ListValue
+  };
+
+  Type                         type = NoneValue;
+  double                       number = 0;
+  String                       string;
+  Array                        array;
+  std::vector<ExpressionValue> list;
+
+  //constructor
+  ExpressionValue() {
+  }
+
+  //constructor
+  ExpressionValue(double value) : type(NumberValue), number(value) {
+  }
+
+  //constructor
+  ExpressionValue(String value) : type(StringValue), string(value) {
+  }
+
+  //constructor
+  ExpressionValue(Array value) : type(ArrayValue), array(value) {
+  }
+
+  //constructor
+  ExpressionValue(std::vector<ExpressionValue> value) : type(ListValue), list(value) {
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+class ExpressionEvaluator
+{
+public:
+
+  typedef IdxMultipleExpression::Node Node;
+
+  IdxMultipleDataset*                     DATASET;
+  BoxQuery*                               QUERY;
+  SharedPtr<Access>                       ACCESS;
+  Aborted                                 aborted;
+  std::vector<Array>                      inputs; //by input_id
+  std::map<String, ExpressionValue>       variables;
+
+  //constructor
+  ExpressionEvaluator(IdxMultipleDataset* DATASET_, BoxQuery* QUERY_, SharedPtr<Access> ACCESS_, Aborted aborted_)
+    : DATASET(DATASET_), QUERY(QUERY_), ACCESS(ACCESS_), aborted(aborted_) {
+  }
+
+  //eval
+  ExpressionValue eval(Node* node)
+  {
+    switch (node->type)
+    {
+    case Node::NumberNode:
+      return ExpressionValue(node->number);
+
+    case Node::StringNode:
+      return ExpressionValue(node->string);
+
+    case Node::QueryTimeNode:
+      return ExpressionValue(QUERY ? QUERY->time : DATASET->getTimesteps().getDefault());
+
+    case Node::InputNode:
+      return ExpressionValue(inputs[node->input_id]);
+
+    case Node::VariableNode:
+      return variables[node->name];
+
+    case Node::ListNode:
+    {
+      std::vector<ExpressionValue> ret;
+      for (auto arg : node->args)
+        ret.push_back(eval(arg.get()));
+      return ExpressionValue(ret);
+    }
+
+    case Node::UnaryNode:
+    {
+      auto a = eval(node->args[0].get());
+      if (a.type == ExpressionValue::NumberValue) return ExpressionValue(-a.number);
+      if (a.type == ExpressionValue::ArrayValue)  return ExpressionValue(ArrayUtils::mul(a.array, -1.0, aborted));
+      ThrowException("wrong argument for unary -");
+    }
+
+    case Node::BinaryNode:
+      return binary(node->name, eval(node->args[0].get()), eval(node->args[1].get()));
+
+    case Node::IndexNode:
+    {
+      auto a = eval(node->args[0].get());
+      auto index = eval(node->args[1].get());
+      if (index.type != ExpressionValue::NumberValue)
+        ThrowException("index must be a number");
+
+      int I = (int)index.number;
+      if (a.type == ExpressionValue::ListValue)
+      {
+        if (I < 0) I += (int)a.list.size();
+        if (I < 0 || I >= (int)a.list.size()) ThrowException("list index out of range");
+        return a.list[I];
+      }
+
+      if (a.type == ExpressionValue::ArrayValue)
+      {
+        if (I < 0 || I >= a.array.dtype.ncomponents()) ThrowException("component index out of range");
+        return ExpressionValue(a.array.getComponent(I, aborted));
+      }
+
+      ThrowException("wrong argument for []");
+    }
+
+    case Node::CallNode:
+    {
+      std::vector<ExpressionValue> args;
+      for (auto arg : node->args)
+        args.push_back(eval(arg.get()));
+      return call(node->name, args);
+    }
+
+    }
+
+    ThrowException("internal error");
+    return ExpressionValue();
+  }
+
+private:
+
+  //toArrays (a single list argument is the list of arrays)
+  static std::vector<Array> toArrays(std::vector<ExpressionValue> args)
+  {
+    if (args.size() == 1 && args[0].type == ExpressionValue::ListValue)
+      args = args[0].list;
+
+    std::vector<Array> ret;
+    for (auto arg : args)
+    {
+      if (arg.type != ExpressionValue::ArrayValue)
+        ThrowException("expected array argument");
+      ret.push_back(arg.array);
+    }
+    return ret;
+  }
+
+  //binary
+  ExpressionValue binary(String op, ExpressionValue a, ExpressionValue b)
+  {
+    bool an = a.type == ExpressionValue::NumberValue, aa = a.type == ExpressionValue::ArrayValue;
+    bool bn = b.type == ExpressionValue::NumberValue, ba = b.type == ExpressionValue::ArrayValue;
+
+    if (an && bn)
+    {
+      if (op == "+") return ExpressionValue(a.number + b.number);
+      if (op == "-") return ExpressionValue(a.number - b.number);
+      if (op == "*") return ExpressionValue(a.number * b.number);
+      if (op == "/") return ExpressionValue(a.number / b.number);
+    }
+
+    if (aa && ba)
+    {
+      if (op == "+") return ExpressionValue(ArrayUtils::add(a.array, b.array, aborted));
+      if (op == "-") return ExpressionValue(ArrayUtils::sub(a.array, b.array, aborted));
+      if (op == "*") return ExpressionValue(ArrayUtils::mul(a.array, b.array, aborted));
+      if (op == "/") return ExpressionValue(ArrayUtils::div(a.array, b.array, aborted));
+    }
+
+    if (aa && bn)
+    {
+      if (op == "+") return ExpressionValue(ArrayUtils::add(a.array, b.number, aborted));
+      if (op == "-") return ExpressionValue(ArrayUtils::sub(a.array, b.number, aborted));
+      if (op == "*") return ExpressionValue(ArrayUtils::mul(a.array, b.number, aborted));
+      if (op == "/") return ExpressionValue(ArrayUtils::div(a.array, b.number, aborted));
+    }
+
+    if (an && ba)
+    {
+      if (op == "+") return ExpressionValue(ArrayUtils::add(b.array, a.number, aborted));
+      if (op == "-") return ExpressionValue(ArrayUtils::sub(a.number, b.array, aborted));
+      if (op == "*") return ExpressionValue(ArrayUtils::mul(b.array, a.number, aborted));
+      if (op == "/") return ExpressionValue(ArrayUtils::div(a.number, b.array, aborted));
+    }
+
+    ThrowException("wrong arguments for", op);
+    return ExpressionValue();
+  }
+
+  //blend
+  ExpressionValue blend(BlendBuffers::Type type, std::vector<ExpressionValue> args)
+  {
+    //all the down datasets intersecting the query, executed in parallel
+    if (args.empty() && QUERY)
+      return ExpressionValue(DATASET->blendDownQueries(QUERY, ACCESS, type));
+
+    BlendBuffers blend(type, aborted);
+    if (args.empty())
+    {
+      for (auto it : DATASET->down_datasets)
+        blend.addBlendArg(Array(PointNi(DATASET->getPointDim()), it.second->getField().dtype));
+    }
+    else
+    {
+      for (auto buffer : toArrays(args))
+      {
+        if (!buffer.valid() || (QUERY && QUERY->aborted()))
+          continue;
+        blend.addBlendArg(buffer);
+      }
+    }
+    return ExpressionValue(blend.result);
+  }
+
+  //call
+  ExpressionValue call(String name, std::vector<ExpressionValue> args)
+  {
+    if (name == "voronoi")      return blend(BlendBuffers::VororoiBlend, args);
+    if (name == "noBlend")      return blend(BlendBuffers::NoBlend, args);
+    if (name == "averageBlend") return blend(BlendBuffers::AverageBlend, args);
+
+    if (StringUtils::startsWith(name, "ArrayUtils."))
+      name = name.substr(String("ArrayUtils.").size());
+
+    if (name == "interleave")
+      return ExpressionValue(ArrayUtils::interleave(toArrays(args), aborted));
+
+    if (name == "sqrt")
+    {
+      auto arrays = toArrays(args);
+      if (arrays.size() != 1) ThrowException("sqrt needs one argument");
+      return ExpressionValue(ArrayUtils::sqrt(arrays[0], aborted));
+    }
+
+    //array-number overloads
+    if (args.size() == 2 && (name == "add" || name == "sub" || name == "mul" || name == "div") &&
+      (args[0].type == ExpressionValue::NumberValue || args[1].type == ExpressionValue::NumberValue))
+    {
+      return binary(name == "add" ? "+" : (name == "sub" ? "-" : (name == "mul" ? "*" : "/")), args[0], args[1]);
+    }
+
+    static const std::map<String, ArrayUtils::Operation> operations = {
+      {"add",               ArrayUtils::AddOperation},
+      {"sub",               ArrayUtils::SubOperation},
+      {"mul",               ArrayUtils::MulOperation},
+      {"div",               ArrayUtils::DivOperation},
+      {"min",               ArrayUtils::MinOperation},
+      {"max",               ArrayUtils::MaxOperation},
+      {"average",           ArrayUtils::AverageOperation},
+      {"standardDeviation", ArrayUtils::StandardDeviationOperation},
+      {"median",            ArrayUtils::MedianOperation}
+    };
+
+    auto it = operations.find(name);
+    if (it == operations.end())
+      ThrowException("unsupported function", name);
+
+    return ExpressionValue(ArrayUtils::executeOperation(it->second, toArrays(args), aborted));
+  }
+
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////
+IdxMultipleExpression::IdxMultipleExpression() {
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+IdxMultipleExpression::~IdxMultipleExpression() {
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+SharedPtr<IdxMultipleExpression> IdxMultipleExpression::parse(String code)
+{
+  try
+  {
+    ExpressionParser parser(code);
+    parser.parseStatements();
+
+    bool bHasOutput = false;
+    for (auto it : parser.statements)
+      bHasOutput = bHasOutput || it.first == "output";
+
+    if (!bHasOutput)
+      return SharedPtr<IdxMultipleExpression>();
+
+    auto ret = std::make_shared<IdxMultipleExpression>();
+    ret->statements = parser.statements;
+    ret->inputs = parser.inputs;
+    return ret;
+  }
+  catch (ExpressionNotSupported&)
+  {
+    //not supported, need the python engine
+    return SharedPtr<IdxMultipleExpression>();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+Array IdxMultipleExpression::evaluate(IdxMultipleDataset* DATASET, BoxQuery* QUERY, SharedPtr<Access> ACCESS, Aborted aborted) const
+{
+  ExpressionEvaluator evaluator(DATASET, QUERY, ACCESS, aborted);
+
+  //resolve the inputs (the same input can appear several times, but it's queried only once)
+  std::vector< std::pair<String, String> > down_args;
+  std::vector<int> down_id;
+  std::vector<DType> down_dtype;
+  for (auto input : inputs)
+  {
+    auto dataset_name = input->path[0];
+    auto dataset = DATASET->getChild(dataset_name);
+    if (!dataset)
+      ThrowException("input['", dataset_name, "'] not found");
+
+    //midx of midx (see midxofmidx.midx)
+    //EXAMPLE: output = input.first.A.temperature  -> input.first['output=input.A.temperature;']
+    String fieldname = input->path[1];
+    if (input->path.size() == 3)
+    {
+      auto midx = std::dynamic_pointer_cast<IdxMultipleDataset>(dataset);
+      if (!midx || !midx->getChild(fieldname))
+        ThrowException("input['", dataset_name, "']['", fieldname, "'] is not a dataset");
+      fieldname = concatenate("output=input.", fieldname, ".", input->path[2], ";");
+    }
+
+    auto field = dataset->getField(fieldname);
+    if (!field.valid())
+      ThrowException("input['", dataset_name, "']['", fieldname, "'] not found");
+
+    auto arg = std::make_pair(dataset_name, fieldname);
+    auto it = std::find(down_args.begin(), down_args.end(), arg);
+    down_id.push_back((int)(it - down_args.begin()));
+    if (it == down_args.end())
+    {
+      down_args.push_back(arg);
+      down_dtype.push_back(field.dtype);
+    }
+  }
+
+  //only getting the dtype
+  std::vector<Array> down_buffers;
+  if (bool bPreview = !QUERY)
+  {
+    for (auto dtype : down_dtype)
+      down_buffers.push_back(Array(PointNi(DATASET->getPointDim()), dtype));
+  }
+  else
+  {
+    down_buffers = DATASET->executeDownQueries(QUERY, ACCESS, down_args);
+  }
+
+  for (auto id : down_id)
+    evaluator.inputs.push_back(down_buffers[id]);
+
+  //runtime type errors (wrong arguments, dtypes ArrayUtils cannot handle...), the python engine may still be able to run the code
+  Array ret;
+  try
+  {
+    for (auto it : statements)
+      evaluator.variables[it.first] = evaluator.eval(it.second.get());
+
+    auto output = evaluator.variables["output"];
+    if (output.type != ExpressionValue::ArrayValue)
+      ThrowException("cannot convert output to array");
+
+    ret = output.array;
+  }
+  catch (ExpressionNotSupported&)
+  {
+    throw;
+  }
+  catch (std::exception& ex)
+  {
+    if (aborted())
+      throw;
+    throw ExpressionNotSupported(ex.what());
+  }
+
+  if (!ret.valid())
+  {
+    if (aborted())
+      return ret;
+    else
+      ThrowException("output not valid");
+  }
+
+  if (DATASET->debug_mode & IdxMultipleDataset::DebugSaveImages)
+  {
+    static int cont = 0;
+    ArrayUtils::saveImage(concatenate("tmp/debug_midx/", cont++, ".up.result.png"), ret);
+  }
+
+  return ret;
+}
+
+} //namespace Visus
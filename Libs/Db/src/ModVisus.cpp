@@ -45,6 +45,12 @@ For support : support@visus.net
 #include <Visus/IdxDataset.h>
 #include <Visus/IdxMultipleDataset.h>
 #include <Visus/IdxFilter.h>
+#include <Visus/IdxDiskAccess.h>
+#include <Visus/RamAccess.h>
+#include <Visus/MultiplexAccess.h>
+
+#include <atomic>
+#include <condition_variable>
 
 namespace Visus {
 
@@ -56,6 +62,509 @@ static NetResponse CreateNetResponseError(int status, String errormsg, String fi
 
 #define NetResponseError(status,errormsg) CreateNetResponseError(status,errormsg,__FILE__,__LINE__)
 
+////////////////////////////////////////////////////////////////////////////////
+//requests being executed: identical concurrent requests share one execution, and the bytes in flight are bounded
+class ModVisus::InFlight
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(InFlight)
+
+  //_______________________________________________
+  class Admission
+  {
+  public:
+
+    VISUS_NON_COPYABLE_CLASS(Admission)
+
+    InFlight* owner;
+    Int64     nbytes;
+
+    //constructor
+    Admission(InFlight* owner_, Int64 nbytes_) : owner(owner_), nbytes(nbytes_) {
+    }
+
+    //destructor
+    ~Admission() {
+      owner->release(nbytes);
+    }
+  };
+
+  //max_bytes (0 means unbounded)
+  Int64 max_bytes = 0;
+
+  //constructor
+  InFlight() {
+  }
+
+  //execute (the followers of an identical request wait for the leader and get the same response)
+  NetResponse execute(String key, const NetRequest& request, std::function<NetResponse()> fn)
+  {
+    while (true)
+    {
+      SharedPtr<Flight> flight;
+      bool bLeader = false;
+      {
+        ScopedLock lock(this->lock);
+        auto& it = flights[key];
+        if (!it)
+        {
+          it = std::make_shared<Flight>();
+          bLeader = true;
+        }
+        flight = it;
+      }
+
+      if (bLeader)
+      {
+        Landing landing(this, key, flight);
+        flight->response = fn();
+        landing.aborted = request.aborted();
+        return flight->response;
+      }
+
+      {
+        std::unique_lock<CriticalSection> lock(this->lock);
+        while (!flight->done && !request.aborted())
+          something_happened.wait_for(lock, std::chrono::milliseconds(100));
+      }
+
+      if (!flight->done || request.aborted())
+        return NetResponse(HttpStatus::STATUS_CANCELLED);
+
+      //the client of the leader went away and its execution has been aborted, try again
+      if (flight->aborted)
+        continue;
+
+      return flight->response;
+    }
+  }
+
+  //admit (wait until nbytes fit in the budget, a request bigger than the budget runs alone; returns null if aborted in the meantime)
+  UniquePtr<Admission> admit(Int64 nbytes, Aborted aborted)
+  {
+    std::unique_lock<CriticalSection> lock(this->lock);
+    while (max_bytes > 0 && used_bytes > 0 && used_bytes + nbytes > max_bytes)
+    {
+      if (aborted())
+        return UniquePtr<Admission>();
+      something_happened.wait_for(lock, std::chrono::milliseconds(100));
+    }
+
+    used_bytes += nbytes;
+    return UniquePtr<Admission>(new Admission(this, nbytes));
+  }
+
+private:
+
+  //_______________________________________________
+  class Flight
+  {
+  public:
+    bool        done = false;
+    bool        aborted = false;
+    NetResponse response;
+  };
+
+  //_______________________________________________
+  //ends the flight of a leader even if it throws, its followers then try again
+  class Landing
+  {
+  public:
+
+    VISUS_NON_COPYABLE_CLASS(Landing)
+
+    InFlight*         owner;
+    String            key;
+    SharedPtr<Flight> flight;
+    bool              aborted = true;
+
+    //constructor
+    Landing(InFlight* owner_, String key_, SharedPtr<Flight> flight_) : owner(owner_), key(key_), flight(flight_) {
+    }
+
+    //destructor
+    ~Landing()
+    {
+      {
+        ScopedLock lock(owner->lock);
+        flight->aborted = aborted;
+        flight->done = true;
+        owner->flights.erase(key);
+      }
+      owner->something_happened.notify_all();
+    }
+  };
+
+  CriticalSection                       lock;
+  std::condition_variable               something_happened;
+  std::map<String, SharedPtr<Flight> >  flights;
+  Int64                                 used_bytes = 0;
+
+  //release
+  void release(Int64 nbytes)
+  {
+    {
+      ScopedLock lock(this->lock);
+      used_bytes -= nbytes;
+    }
+    something_happened.notify_all();
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//successful query responses by ETag, least recently used go to disk (if a directory is given) or are dropped
+class ModVisus::ResponseCache
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(ResponseCache)
+
+  //constructor
+  ResponseCache(Int64 max_memory_, String dir_, Int64 max_disk_) : max_memory(max_memory_), dir(dir_), max_disk(max_disk_), tmp_counter(0)
+  {
+    if (dir.empty())
+      return;
+
+    //names are ETags, so what is already on disk is still valid
+    FileUtils::createDirectory(dir);
+    for (auto filename : FileUtils::findFilesInDirectory(dir))
+    {
+      //leftovers of an interrupted spill
+      if (!StringUtils::endsWith(filename, ".bin"))
+      {
+        if (StringUtils::contains(filename, ".bin.tmp"))
+          FileUtils::removeFile(filename);
+        continue;
+      }
+
+      auto size = FileUtils::getFileSize(filename);
+      if (!isValidFile(filename, size))
+      {
+        FileUtils::removeFile(filename);
+        continue;
+      }
+
+      auto etag = Path(filename).getFileNameWithoutExtension();
+      disk_lru.push_front(std::make_pair(etag, size));
+      disk_index[etag] = disk_lru.begin();
+      disk_used += disk_lru.front().second;
+    }
+
+    std::vector<String> evicted;
+    evictFromDisk(evicted);
+    for (auto etag : evicted)
+      FileUtils::removeFile(getFilename(etag));
+  }
+
+  //get
+  bool get(String etag, NetResponse& response)
+  {
+    {
+      ScopedLock lock(this->lock);
+      auto it = index.find(etag);
+      if (it != index.end())
+      {
+        lru.splice(lru.begin(), lru, it->second);
+        response = it->second->second;
+        return true;
+      }
+
+      if (!disk_index.count(etag))
+        return false;
+    }
+
+    //read outside the lock, the file could have been evicted in the meantime
+    File file;
+    auto filename = getFilename(etag);
+    auto size = FileUtils::getFileSize(filename);
+    auto content = std::make_shared<HeapMemory>();
+    if (size <= 0 || !content->resize(size, __FILE__, __LINE__) || !file.open(filename, "r") || !file.read(0, size, content->c_ptr()))
+      return false;
+    file.close();
+
+    String str((const char*)content->c_ptr(), (size_t)size);
+    auto end_headers = str.find("\r\n\r\n");
+    if (end_headers == String::npos || !response.setHeadersFromString(str.substr(0, end_headers + 4)))
+      return false;
+
+    end_headers += 4;
+    if (response.getContentLength() != size - (Int64)end_headers)
+      return false;
+
+    response.body = std::make_shared<HeapMemory>();
+    if (!response.body->resize(size - end_headers, __FILE__, __LINE__))
+      return false;
+    memcpy(response.body->c_ptr(), content->c_ptr() + end_headers, (size_t)(size - end_headers));
+
+    put(etag, response);
+    return true;
+  }
+
+  //put
+  void put(String etag, const NetResponse& response)
+  {
+    std::vector< std::pair<String, NetResponse> > spill;
+    {
+      ScopedLock lock(this->lock);
+      if (index.count(etag) || getSize(response) > max_memory)
+        return;
+
+      lru.push_front(std::make_pair(etag, response));
+      index[etag] = lru.begin();
+      memory_used += getSize(response);
+
+      while (memory_used > max_memory)
+      {
+        auto evicted = lru.back();
+        index.erase(evicted.first);
+        lru.pop_back();
+        memory_used -= getSize(evicted.second);
+
+        if (!dir.empty() && !disk_index.count(evicted.first))
+          spill.push_back(evicted);
+      }
+    }
+
+    for (auto it : spill)
+      writeToDisk(it.first, it.second);
+  }
+
+  //clear
+  void clear()
+  {
+    std::vector<String> evicted;
+    {
+      ScopedLock lock(this->lock);
+      lru.clear();
+      index.clear();
+      memory_used = 0;
+
+      for (auto it : disk_lru)
+        evicted.push_back(it.first);
+      disk_lru.clear();
+      disk_index.clear();
+      disk_used = 0;
+    }
+
+    for (auto etag : evicted)
+      FileUtils::removeFile(getFilename(etag));
+  }
+
+private:
+
+  typedef std::list< std::pair<String, NetResponse> > Lru;
+  typedef std::list< std::pair<String, Int64> >       DiskLru;
+
+  CriticalSection                   lock;
+
+  Int64                             max_memory = 0;
+  Int64                             memory_used = 0;
+  Lru                               lru;
+  std::map<String, Lru::iterator>   index;
+
+  String                            dir;
+  Int64                             max_disk = 0;
+  Int64                             disk_used = 0;
+  DiskLru                           disk_lru;
+  std::map<String, DiskLru::iterator> disk_index;
+  std::atomic<Int64>                tmp_counter;
+
+  //getSize
+  static Int64 getSize(const NetResponse& response) {
+    return (response.body ? response.body->c_size() : 0) + 1024;
+  }
+
+  //getFilename
+  String getFilename(String etag) const {
+    return dir + "/" + etag + ".bin";
+  }
+
+  //isValidFile (the body must be exactly Content-Length bytes)
+  static bool isValidFile(String filename, Int64 size)
+  {
+    if (size <= 0)
+      return false;
+
+    File file;
+    String str((size_t)std::min(size, (Int64)64 * 1024), 0);
+    if (!file.open(filename, "r") || !file.read(0, (Int64)str.size(), (unsigned char*)&str[0]))
+      return false;
+    file.close();
+
+    auto end_headers = str.find("\r\n\r\n");
+    NetResponse response;
+    if (end_headers == String::npos || !response.setHeadersFromString(str.substr(0, end_headers + 4)) || !response.hasContentLength())
+      return false;
+
+    return (Int64)(end_headers + 4) + response.getContentLength() == size;
+  }
+
+  //evictFromDisk (must be called with the lock)
+  void evictFromDisk(std::vector<String>& evicted)
+  {
+    while (disk_used > max_disk && !disk_lru.empty())
+    {
+      evicted.push_back(disk_lru.back().first);
+      disk_used -= disk_lru.back().second;
+      disk_index.erase(disk_lru.back().first);
+      disk_lru.pop_back();
+    }
+  }
+
+  //writeToDisk
+  void writeToDisk(String etag, NetResponse response)
+  {
+    auto body_size = response.body ? response.body->c_size() : 0;
+    response.setContentLength(body_size); //used to validate the file when loading it
+    auto headers = response.getHeadersAsString();
+    auto size = (Int64)headers.size() + body_size;
+    if (size > max_disk)
+      return;
+
+    //write to a temporary file and rename it, so that a crash never leaves a truncated *.bin (another thread could be spilling the same response)
+    auto filename = getFilename(etag);
+    auto tmp_filename = concatenate(filename, ".tmp", Utils::getPid(), "_", ++tmp_counter);
+    {
+      File file;
+      if (!file.createAndOpen(tmp_filename, "rw"))
+        return;
+
+      if (!file.write(0, headers.size(), (const unsigned char*)headers.c_str()) || (body_size && !file.write(headers.size(), body_size, response.body->c_ptr())))
+      {
+        file.close();
+        FileUtils::removeFile(tmp_filename);
+        return;
+      }
+      file.close();
+    }
+
+    //rename cannot overwrite on some OS
+    if (!FileUtils::moveFile(tmp_filename, filename))
+    {
+      FileUtils::removeFile(filename);
+      if (!FileUtils::moveFile(tmp_filename, filename))
+      {
+        FileUtils::removeFile(tmp_filename);
+        return;
+      }
+    }
+
+    std::vector<String> evicted;
+    {
+      ScopedLock lock(this->lock);
+      if (disk_index.count(etag))
+        return;
+
+      disk_lru.push_front(std::make_pair(etag, size));
+      disk_index[etag] = disk_lru.begin();
+      disk_used += size;
+      evictFromDisk(evicted);
+    }
+
+    for (auto it : evicted)
+      FileUtils::removeFile(getFilename(it));
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//long-lived accesses of a published dataset
+//accesses are not thread safe, so each request borrows one; all of them share the same open files
+//the decoded-block cache is shared by all published datasets, so the server has a single RAM budget
+class ModVisusSharedAccess : public std::enable_shared_from_this<ModVisusSharedAccess>
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(ModVisusSharedAccess)
+
+  SharedPtr<Dataset> dataset;
+
+  //max number of idle accesses kept for later requests
+  int max_idle = 16;
+
+  //constructor
+  ModVisusSharedAccess(SharedPtr<Dataset> dataset_, SharedPtr<RamAccess> ram_) : dataset(dataset_), ram(ram_)
+  {
+    static std::atomic<Int64> counter(0);
+    this->key_prefix = concatenate(++counter, "/");
+  }
+
+  //acquire (the access goes back to the pool when the caller releases it)
+  SharedPtr<Access> acquire(bool for_block_query)
+  {
+    SharedPtr<Access> ret;
+    {
+      ScopedLock lock(this->lock);
+      auto& idle = this->idle[for_block_query ? 1 : 0];
+      if (!idle.empty())
+      {
+        ret = idle.back();
+        idle.pop_back();
+      }
+    }
+
+    if (!ret)
+      ret = create(for_block_query);
+
+    if (!ret)
+      return SharedPtr<Access>();
+
+    auto self = shared_from_this();
+    return SharedPtr<Access>(ret.get(), [self, ret, for_block_query](Access*) {
+      self->release(ret, for_block_query);
+    });
+  }
+
+private:
+
+  CriticalSection                lock;
+  SharedPtr<RamAccess>           ram;
+  String                         key_prefix; //unique for each instance, a reloaded dataset never sees stale blocks
+  SharedPtr<IdxDiskAccess>       disk;
+  std::vector< SharedPtr<Access> > idle[2];
+
+  //create
+  SharedPtr<Access> create(bool for_block_query)
+  {
+    auto access = for_block_query ? dataset->createAccessForBlockQuery() : dataset->createAccess();
+    if (!access)
+      return SharedPtr<Access>(); //box/point queries executed on a remote server
+
+    if (auto disk = std::dynamic_pointer_cast<IdxDiskAccess>(access))
+    {
+      ScopedLock lock(this->lock);
+      if (this->disk)
+        disk->shareOpenFilesWith(this->disk);
+      else
+        this->disk = disk;
+    }
+
+    if (!ram)
+      return access;
+
+    auto ram = std::make_shared<RamAccess>(dataset->getDefaultBitsPerBlock());
+    ram->shareMemoryWith(this->ram);
+    ram->setKeyPrefix(key_prefix);
+
+    auto multiplex = std::make_shared<MultiplexAccess>(dataset.get());
+    multiplex->addChild(ram, StringTree("access"));
+    multiplex->addChild(access, StringTree("access"));
+    return multiplex;
+  }
+
+  //release
+  void release(SharedPtr<Access> access, bool for_block_query)
+  {
+    ScopedLock lock(this->lock);
+    auto& idle = this->idle[for_block_query ? 1 : 0];
+    if ((int)idle.size() < max_idle)
+      idle.push_back(access);
+  }
+
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 class ModVisus::PublicDatasets
 {
@@ -99,6 +608,10 @@ public:
       if (it->second.second.elapsedMsec() > 5*60*1000 &&
           it->first != name) {
         PrintInfo("releasing temp dataset", it->first);
+        {
+          ScopedLock lock(shared_access_lock);
+          shared_access.erase(it->second.first.get());
+        }
         it = temp_dataset_map.erase(it);
       }
       else {
@@ -155,6 +668,62 @@ public:
     return SharedPtr<Dataset>();
   }
 
+  //createAccess (borrowed from the long-lived accesses of the dataset)
+  SharedPtr<Access> createAccess(SharedPtr<Dataset> dataset, bool for_block_query)
+  {
+    SharedPtr<ModVisusSharedAccess> ret;
+    {
+      ScopedLock lock(shared_access_lock);
+      auto& it = shared_access[dataset.get()];
+      if (!ram && owner->cache_size > 0)
+      {
+        ram = std::make_shared<RamAccess>(dataset->getDefaultBitsPerBlock());
+        ram->setAvailableMemory(owner->cache_size);
+      }
+      if (!it)
+        it = std::make_shared<ModVisusSharedAccess>(dataset, ram);
+      ret = it;
+    }
+    return ret->acquire(for_block_query);
+  }
+
+  //getDatasetVersion (empty for datasets not in the configuration, recomputed after version_ttl seconds since data files can be rewritten)
+  String getDatasetVersion(String name)
+  {
+    auto it = dataset_map.find(name);
+    if (it == dataset_map.end())
+      return "";
+
+    {
+      ScopedLock lock(versions_lock);
+      auto version = versions.find(name);
+      if (version == versions.end())
+        return "";
+
+      if (version->second.second.elapsedMsec() < owner->version_ttl * 1000)
+        return version->second.first;
+    }
+
+    //outside the lock, it stats all the data files
+    auto value = computeDatasetVersion(it->second);
+    bool bChanged;
+    {
+      ScopedLock lock(versions_lock);
+      auto& version = versions[name];
+      bChanged = version.first != value;
+      version = std::make_pair(value, Time::now());
+    }
+
+    //blocks cached in RAM are stale too, a new shared access gets a new key prefix
+    if (bChanged)
+    {
+      ScopedLock lock(shared_access_lock);
+      shared_access.erase(it->second.get());
+    }
+
+    return value;
+  }
+
   //createPublicUrl
   String createPublicUrl(String path, String dataset) const {
     return "$(protocol)://$(hostname):$(port)" + path  + "?action=readdataset&dataset=" + dataset;
@@ -174,15 +743,22 @@ private:
   StringTree                              datasets;
   std::map<String, SharedPtr<Dataset > >  dataset_map;
   std::map<String, String>                location_match;
+  CriticalSection                         versions_lock;
+  std::map<String, std::pair<String, Time> > versions;
   std::map<String, std::pair<SharedPtr<Dataset>, Time>> temp_dataset_map;
   String                                  datasets_xml_body;
   String                                  datasets_json_body;
 
+  CriticalSection                                         shared_access_lock;
+  std::map<Dataset*, SharedPtr<ModVisusSharedAccess> >    shared_access;
+  SharedPtr<RamAccess>                                    ram; //decoded blocks of all datasets
+
   //addPublicDataset
   int addPublicDataset(StringTree& dst, String name, SharedPtr<Dataset> dataset, String location_match)
   {
     this->dataset_map[name] = dataset;
     this->location_match[name] = location_match;
+    this->versions[name] = std::make_pair(computeDatasetVersion(dataset), Time::now());
     dataset->setServerMode(true);
 
     auto child= dst.addChild("dataset");
@@ -205,6 +781,31 @@ private:
     return ret;
   }
 
+  //computeDatasetVersion (responses depend only on the dataset description and, for local datasets, the idx and data files)
+  static String computeDatasetVersion(SharedPtr<Dataset> dataset)
+  {
+    Url url(dataset->getUrl());
+    String ret = dataset->getDatasetBody().toString();
+    if (url.isFile())
+      ret += " " + cstring(FileUtils::getTimeLastModified(url.getPath()));
+
+    if (auto midx = std::dynamic_pointer_cast<IdxMultipleDataset>(dataset))
+    {
+      for (auto it : midx->down_datasets)
+        ret += " " + computeDatasetVersion(it.second);
+    }
+    else if (url.isFile())
+    {
+      for (auto filename : dataset->getFilenames())
+      {
+        if (FileUtils::existsFile(filename))
+          ret += " " + filename + " " + cstring(FileUtils::getFileSize(filename)) + " " + cstring(FileUtils::getTimeLastModified(filename));
+      }
+    }
+
+    return StringUtils::hexdigest(StringUtils::md5(ret));
+  }
+
   //addPublicDatasets
   int addPublicDatasets(StringTree& dst, const StringTree& cursor)
   {
@@ -270,7 +871,7 @@ private:
 };
 
 ////////////////////////////////////////////////////////////////////////////////
-ModVisus::ModVisus()
+ModVisus::ModVisus() : in_flight(std::make_shared<InFlight>()), response_cache(std::make_shared<ResponseCache>(0, "", 0))
 {
 }
 
@@ -299,6 +900,14 @@ SharedPtr<ModVisus::PublicDatasets> ModVisus::getDatasets()
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+SharedPtr<ModVisus::ResponseCache> ModVisus::getResponseCache()
+{
+  //configureDatasets can replace it while serving requests
+  ScopedReadLock lock(dynamic.lock);
+  return response_cache;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void ModVisus::trackConfigChangesInBackground()
 {
@@ -333,6 +942,9 @@ void ModVisus::trackConfigChangesInBackground()
         this->m_datasets = datasets;
         TIMESTAMP = timestamp;
       }
+
+      //datasets could have changed
+      getResponseCache()->clear();
     }
   }
 }
@@ -342,6 +954,18 @@ bool ModVisus::configureDatasets(const ConfigFile& config)
 {
   this->dynamic.enabled = false;
   this->config_filename = config.getFilename();
+  this->cache_size = StringUtils::getByteSizeFromString(config.readString("Configuration/ModVisus/cache_size", Utils::getEnv("VISUS_MODVISUS_CACHE_SIZE", "256mb")));
+  this->version_ttl = cint(config.readString("Configuration/ModVisus/version_ttl", Utils::getEnv("VISUS_MODVISUS_VERSION_TTL", "60")));
+  this->in_flight->max_bytes = StringUtils::getByteSizeFromString(config.readString("Configuration/ModVisus/max_inflight", Utils::getEnv("VISUS_MODVISUS_MAX_INFLIGHT", "1gb")));
+
+  auto response_cache = std::make_shared<ResponseCache>(
+    StringUtils::getByteSizeFromString(config.readString("Configuration/ModVisus/response_cache_size", Utils::getEnv("VISUS_MODVISUS_RESPONSE_CACHE_SIZE", "128mb"))),
+    config.readString("Configuration/ModVisus/response_cache_dir", Utils::getEnv("VISUS_MODVISUS_RESPONSE_CACHE_DIR")),
+    StringUtils::getByteSizeFromString(config.readString("Configuration/ModVisus/response_cache_disk_size", Utils::getEnv("VISUS_MODVISUS_RESPONSE_CACHE_DISK_SIZE", "1gb"))));
+  {
+    ScopedWriteLock lock(dynamic.lock);
+    this->response_cache = response_cache;
+  }
 
   auto datasets = std::make_shared<PublicDatasets>(this, config);
   this->m_datasets = datasets;
@@ -502,22 +1126,33 @@ NetResponse ModVisus::handleBlockQuery(const NetRequest& request)
 
   bool bHasFilter = !field.filter.empty();
 
-  auto access = dataset->createAccessForBlockQuery();
+  auto admission = in_flight->admit(blocks.size() * field.dtype.getByteSize(((Int64)1) << bitsperblock), request.aborted);
+  if (!admission)
+    return NetResponse(HttpStatus::STATUS_CANCELLED);
+
+  auto access = datasets->createAccess(dataset, /*for_block_query*/true);
 
   WaitAsync< Future<Void> > wait_async(/*max_running*/0);
   access->beginRead();
-  Aborted aborted;
+  Aborted aborted = request.aborted;
 
-  std::vector<NetResponse> responses;
-  for (auto blockid : blocks)
+  //blocks can complete in any order (i.e. cache hits first), the client wants them in the requested order
+  std::vector<NetResponse> responses(blocks.size());
+  for (int I = 0; I < (int)blocks.size(); I++)
   {
-    auto block_query = dataset->createBlockQuery(blockid, field, time, 'r', aborted);
+    auto block_query = dataset->createBlockQuery(blocks[I], field, time, 'r', aborted);
     dataset->executeBlockQuery(access, block_query);
-    wait_async.pushRunning(block_query->done,[block_query, &responses, dataset, compression, rowmajor](Void) {
+    wait_async.pushRunning(block_query->done,[block_query, &responses, I, dataset, compression, rowmajor](Void) {
 
+      //404 only if the block does not exist, so that the client can tell a sparse dataset from a failure
       if (block_query->failed())
       {
-        responses.push_back(NetResponseError(HttpStatus::STATUS_NOT_FOUND, "block_query->executeAndWait failed"));
+        if (block_query->not_stored)
+          responses[I] = NetResponseError(HttpStatus::STATUS_NOT_FOUND, "block not stored");
+        else if (block_query->aborted())
+          responses[I] = NetResponse(HttpStatus::STATUS_CANCELLED);
+        else
+          responses[I] = NetResponseError(HttpStatus::STATUS_INTERNAL_SERVER_ERROR, "block query failed: " + block_query->errormsg);
         return;
       }
 
@@ -529,11 +1164,11 @@ NetResponse ModVisus::handleBlockQuery(const NetRequest& request)
       NetResponse response(HttpStatus::STATUS_OK);
       if (!response.setArrayBody(compression, block_query->buffer))
       {
-        responses.push_back(NetResponseError(HttpStatus::STATUS_INTERNAL_SERVER_ERROR, "Encoding converting to row major failed"));
+        responses[I] = NetResponseError(HttpStatus::STATUS_INTERNAL_SERVER_ERROR, "Encoding converting to row major failed");
         return;
       }
 
-      responses.push_back(response);
+      responses[I] = response;
     });
   }
   access->endRead();
@@ -572,15 +1207,13 @@ NetResponse ModVisus::handleBoxQuery(const NetRequest& request)
   if (!field.valid())
     return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "Cannot find fieldname(" + fieldname + ")");
 
-  //TODO: how can I get the aborted from network?
-
   Array buffer;
 
   bool   bDisableFilters = cbool(request.url.getParam("disable_filters"));
   bool   bKdBoxQuery = request.url.getParam("kdquery") == "box";
 
   auto logic_box = BoxNi::parseFromOldFormatString(pdim, request.url.getParam("box"));;
-  auto query = dataset->createBoxQuery(logic_box, field, time, 'r', Aborted());
+  auto query = dataset->createBoxQuery(logic_box, field, time, 'r', request.aborted);
   query->setResolutionRange(fromh, endh);
 
   //I apply the filter on server side only for the first coarse query (more data need to be processed on client side)
@@ -599,7 +1232,11 @@ NetResponse ModVisus::handleBoxQuery(const NetRequest& request)
   if (!query->isRunning())
     return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->beginBoxQuery() failed " + query->errormsg);
 
-  auto access = dataset->createAccess();
+  auto admission = in_flight->admit(query->getByteSize(), request.aborted);
+  if (!admission)
+    return NetResponse(HttpStatus::STATUS_CANCELLED);
+
+  auto access = datasets->createAccess(dataset, /*for_block_query*/false);
   if (!dataset->executeBoxQuery(access, query))
     return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->executeBoxQuery() failed " + query->errormsg);
 
@@ -722,32 +1359,53 @@ NetResponse ModVisus::handlePointQuery(const NetRequest& request)
   if (!field.valid())
     return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "Cannot find fieldname(" + fieldname + ")");
 
-  //TODO: how can I get the aborted from network?
-
   Array buffer;
 
-  auto nsamples = PointNi::fromString(request.url.getParam("nsamples"));
-  VisusAssert(nsamples.getPointDim() == 3);
-
   VisusAssert(fromh == 0);
 
-  auto logic_position = Position(
-    Matrix::fromString(4, request.url.getParam("matrix")),
-    BoxNd::fromString(request.url.getParam("box"),/*bInterleave*/false).withPointDim(3));
+  //explicit points are in the body (see Dataset::createPointQueryRequest)
+  Array points;
+  if (request.body && request.body->c_size())
+  {
+    points = request.getArrayBody();
+    if (!points.valid())
+      return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "cannot decode points");
+  }
+
+  Position logic_position;
+  if (!points.valid())
+  {
+    logic_position = Position(
+      Matrix::fromString(4, request.url.getParam("matrix")),
+      BoxNd::fromString(request.url.getParam("box"),/*bInterleave*/false).withPointDim(3));
+  }
 
-  auto query = dataset->createPointQuery(logic_position, field, time);
+  auto query = dataset->createPointQuery(logic_position, field, time, request.aborted);
   query->end_resolutions = { endh };
   query->accuracy = accuracy;
 
+  if (points.valid() && !query->setPoints(points))
+    return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->setPoints failed " + query->errormsg);
+
   dataset->beginPointQuery(query);
 
   if (!query->isRunning())
     return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->beginBoxQuery() failed " + query->errormsg);
 
-  if (!query->setPoints(nsamples))
-    return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->setPoints failed " + query->errormsg);
+  if (!points.valid())
+  {
+    auto nsamples = PointNi::fromString(request.url.getParam("nsamples"));
+    VisusAssert(nsamples.getPointDim() == 3);
 
-  auto access = dataset->createAccess();
+    if (!query->setPoints(nsamples))
+      return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->setPoints failed " + query->errormsg);
+  }
+
+  auto admission = in_flight->admit(query->getByteSize(), request.aborted);
+  if (!admission)
+    return NetResponse(HttpStatus::STATUS_CANCELLED);
+
+  auto access = datasets->createAccess(dataset, /*for_block_query*/false);
   if (!dataset->executePointQuery(access, query))
     return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->executeBoxQuery() failed " + query->errormsg);
 
@@ -794,6 +1452,85 @@ NetResponse ModVisus::handlePointQuery(const NetRequest& request)
 
 
 
+///////////////////////////////////////////////////////////////////////////
+String ModVisus::getETag(const NetRequest& request, String action)
+{
+  auto version = getDatasets()->getDatasetVersion(request.url.getParam("dataset"));
+  if (version.empty())
+    return "";
+
+  //the response depends only on the dataset and on the parameters (the path is part of the security check)
+  Url url = request.url;
+  url.params.eraseValue("action");
+  return StringUtils::hexdigest(StringUtils::md5(version + " " + action + " " + url.toString() + getBodyDigest(request)));
+}
+
+///////////////////////////////////////////////////////////////////////////
+String ModVisus::getBodyDigest(const NetRequest& request)
+{
+  //for example the explicit points of a point query
+  if (!request.body || !request.body->c_size())
+    return "";
+
+  return " " + StringUtils::hexdigest(StringUtils::md5(request.getTextBody()));
+}
+
+///////////////////////////////////////////////////////////////////////////
+bool ModVisus::isCacheable(const NetResponse& response)
+{
+  if (response.status != HttpStatus::STATUS_OK)
+    return false;
+
+  //a composed response is OK even if some parts failed or were aborted, only missing blocks are part of the dataset
+  int num = cint(response.getHeader("response-compose-num"));
+  for (int I = 0; I < num; I++)
+  {
+    auto status = cint(response.getHeader("status-" + cstring(I)));
+    if (status != HttpStatus::STATUS_OK && status != HttpStatus::STATUS_NOT_FOUND)
+      return false;
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+NetResponse ModVisus::handleCachedQuery(const NetRequest& request, String action, std::function<NetResponse()> fn)
+{
+  auto etag = getETag(request, action);
+  if (etag.empty())
+    return in_flight->execute(action + " " + request.url.toString() + getBodyDigest(request), request, fn);
+
+  //conditional GET
+  for (auto it : request.headers)
+  {
+    if (StringUtils::toLower(it.first) != "if-none-match")
+      continue;
+
+    auto value = StringUtils::trim(it.second);
+    if (value == "*" || StringUtils::contains(value, "\"" + etag + "\""))
+    {
+      NetResponse response(HttpStatus::STATUS_NOT_MODIFIED);
+      response.setHeader("ETag", "\"" + etag + "\"");
+      return response;
+    }
+  }
+
+  auto response_cache = getResponseCache();
+
+  NetResponse response;
+  if (response_cache->get(etag, response))
+    return response;
+
+  response = in_flight->execute(action + " " + request.url.toString() + getBodyDigest(request), request, fn);
+  if (!request.aborted() && isCacheable(response))
+  {
+    response.setHeader("ETag", "\"" + etag + "\"");
+    response_cache->put(etag, response);
+  }
+
+  return response;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 NetResponse ModVisus::handleRequest(NetRequest request)
 {
@@ -808,13 +1545,13 @@ NetResponse ModVisus::handleRequest(NetRequest request)
   NetResponse response;
 
   if (action == "rangequery" || action == "blockquery")
-    response = handleBlockQuery(request);
+    response = handleCachedQuery(request, "blockquery", [&]() {return handleBlockQuery(request); });
 
   else if (action == "query" || action == "boxquery")
-    response = handleBoxQuery(request);
+    response = handleCachedQuery(request, "boxquery", [&]() {return handleBoxQuery(request); });
 
   else if (action == "pointquery")
-    response = handlePointQuery(request);
+    response = handleCachedQuery(request, "pointquery", [&]() {return handlePointQuery(request); });
 
   else if (action == "readdataset" || action == "read_dataset")
     response = handleReadDataset(request);
@@ -848,6 +1585,10 @@ NetResponse ModVisus::handleRequest(NetRequest request)
     response = NetResponseError(HttpStatus::STATUS_NOT_FOUND, "unknown action(" + action + ")");
   }
 
+  //the client went away in the meantime, the failure is not an error
+  if (request.aborted() && !response.isSuccessful())
+    response = NetResponse(HttpStatus::STATUS_CANCELLED);
+
   PrintInfo(
     "handleRequest, sending response",
     "REQUEST", request.url,
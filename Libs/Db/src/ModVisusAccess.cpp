@@ -39,6 +39,7 @@ For support : support@visus.net
 #include <Visus/ModVisusAccess.h>
 #include <Visus/Dataset.h>
 #include <Visus/NetService.h>
+#include <Visus/Thread.h>
 
 namespace Visus {
 
@@ -57,9 +58,11 @@ ModVisusAccess::ModVisusAccess(Dataset* dataset,StringTree config_)
 
   this->config.write("url", url.toString());
 
-  this->num_queries_per_request = cint(this->config.readString("num_queries_per_request", "8"));
+  this->num_queries_per_request = std::max(1, cint(this->config.readString("num_queries_per_request", "8")));
+  this->max_queries_per_request = std::max(num_queries_per_request, cint(this->config.readString("max_queries_per_request", "128")));
+  this->batch_window_msec = cint(this->config.readString("batch_window_msec", "10"));
 
-  if (this->num_queries_per_request>1)
+  if (this->max_queries_per_request>1)
   {
     //I may have some extra params I want to keep!
     auto request=NetRequest(url.withPath(url.getPath()));
@@ -71,10 +74,11 @@ ModVisusAccess::ModVisusAccess(Dataset* dataset,StringTree config_)
     {
       PrintInfo("Server does not support block-query-support-aggregation, so I'm overriding num_queries_per_request to be 1");
       this->num_queries_per_request = 1;
+      this->max_queries_per_request = 1;
     }
     else
     {
-      PrintInfo("Server supports block query aggregration","num_queries_per_request", this->num_queries_per_request);
+      PrintInfo("Server supports block query aggregration","num_queries_per_request", this->num_queries_per_request, "max_queries_per_request", this->max_queries_per_request);
     }
   }
 
@@ -86,45 +90,203 @@ ModVisusAccess::ModVisusAccess(Dataset* dataset,StringTree config_)
     this->netservice = std::make_shared<NetService>(nconnections);
   }
 
+  if (this->max_queries_per_request > 1)
+  {
+    this->flush_thread = Thread::start("ModVisusAccess flush", [this]() {
+      runInBackground();
+    });
+  }
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+ModVisusAccess::~ModVisusAccess() 
+{
+  {
+    std::lock_guard<std::mutex> lock(pendings_lock);
+    bExit = true;
+  }
+  pendings_changed.notify_all();
+  Thread::join(flush_thread);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+void ModVisusAccess::runInBackground()
+{
+  std::unique_lock<std::mutex> lock(pendings_lock);
+  while (!bExit)
+  {
+    if (pendings.empty())
+    {
+      pendings_changed.wait(lock);
+      continue;
+    }
+
+    //wait for the oldest batch to expire (or for something new)
+    Int64 wait_msec = batch_window_msec;
+    for (auto& pending : pendings)
+      wait_msec = std::min(wait_msec, batch_window_msec - pending.t1.elapsedMsec());
+
+    if (wait_msec > 0)
+    {
+      pendings_changed.wait_for(lock, std::chrono::milliseconds(wait_msec));
+      continue;
+    }
+
+    auto batches = popExpiredBatches(getNumQueriesPerRequest());
+    lock.unlock();
+    for (auto& batch : batches)
+      sendBatch(batch);
+    lock.lock();
+  }
 }
 
+
+
 //////////////////////////////////////////////////////////////////////////////////////
-ModVisusAccess::~ModVisusAccess() {
+void ModVisusAccess::printStatistics()
+{
+  PrintInfo(name, "hostname", url.getHostname(), "port", url.getPort(), "compression", compression, "url", url.toString());
+  Access::printStatistics();
+
+  ScopedLock lock(stats_lock);
+  PrintInfo("latency", (int)(latency * 1000), "msec", "bandwidth", StringUtils::getStringFromByteSize((Int64)bandwidth), "/sec", "block_size", StringUtils::getStringFromByteSize((Int64)block_size));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////
+int ModVisusAccess::getNumQueriesPerRequest()
+{
+  ScopedLock lock(stats_lock);
+
+  if (latency <= 0 || bandwidth <= 0 || block_size <= 0)
+    return num_queries_per_request;
 
+  //a request should keep the link busy at least for a round trip
+  auto bdp = bandwidth * latency;
+  auto ret = (int)std::ceil(bdp / block_size);
+  return Utils::clamp(ret, num_queries_per_request, max_queries_per_request);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+void ModVisusAccess::updateStatistics(int nqueries, Int64 nbytes, Int64 first_byte_msec, Int64 total_msec)
+{
+  auto ewma = [](double& value, double sample) {
+    value = value > 0 ? 0.75 * value + 0.25 * sample : sample;
+  };
+
+  ScopedLock lock(stats_lock);
+
+  //the first byte also waits for the server to read the whole batch, keep a slowly aging minimum so that bigger batches do not inflate the latency
+  auto rtt = std::max((Int64)1, first_byte_msec) / 1000.0;
+  latency = latency > 0 ? std::min(latency * 1.05, rtt) : rtt;
+
+  //a body arriving in one piece is a sign of a latency-bound link, so bigger batches are welcome
+  if (nbytes)
+    ewma(bandwidth, nbytes / (std::max((Int64)1, total_msec - first_byte_msec) / 1000.0));
+
+  if (nqueries && nbytes)
+    ewma(block_size, nbytes / (double)nqueries);
+}
 
 ///////////////////////////////////////////////////////////////////////////////////////
 void ModVisusAccess::readBlock(SharedPtr<BlockQuery> query)
 {
-  if (!batch.empty())
+  auto num_queries_per_request = getNumQueriesPerRequest();
+
+  std::vector<Batch> batches;
   {
-    bool bCompatible =
-      query->field.name == batch[0]->field.name &&
-      query->time       == batch[0]->time &&
-      query->aborted    == batch[0]->aborted;
+    std::lock_guard<std::mutex> lock(pendings_lock);
+
+    //batches are kept open across field/time changes, they cannot be mixed in the same request
+    auto it = std::find_if(pendings.begin(), pendings.end(), [&](const Pending& pending) {
+      auto first = pending.batch[0];
+      return query->field.name == first->field.name && query->time == first->time && query->aborted == first->aborted;
+    });
 
-    if (!bCompatible)
-      flushBatch();
+    if (it == pendings.end())
+    {
+      Pending pending;
+      pending.t1 = Time::now();
+      it = pendings.insert(pendings.end(), pending);
+      pendings_changed.notify_all();
+    }
+
+    it->batch.push_back(query);
+    batches = popExpiredBatches(num_queries_per_request);
   }
 
-  batch.push_back(query);
+  for (auto& batch : batches)
+    sendBatch(batch);
+}
 
-  //reached the number of queries per batch?
-  if (batch.size() >= num_queries_per_request)
-    flushBatch();
+//////////////////////////////////////////////////////////////////////////////////////
+std::vector<ModVisusAccess::Batch> ModVisusAccess::popExpiredBatches(int num_queries_per_request)
+{
+  //the batches big enough or waiting for too long
+  std::vector<Batch> ret;
+  for (int I = 0; I < (int)pendings.size(); )
+  {
+    if (pendings[I].batch.size() >= num_queries_per_request || pendings[I].t1.elapsedMsec() >= batch_window_msec)
+    {
+      ret.push_back(pendings[I].batch);
+      pendings.erase(pendings.begin() + I);
+    }
+    else
+    {
+      I++;
+    }
+  }
+  return ret;
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////////
 void ModVisusAccess::flushBatch()
+{
+  std::vector<Pending> pendings;
+  {
+    std::lock_guard<std::mutex> lock(pendings_lock);
+    pendings = std::move(this->pendings);
+    this->pendings.clear();
+  }
+
+  for (auto& pending : pendings)
+    sendBatch(pending.batch);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+void ModVisusAccess::onBlockResponse(SharedPtr<BlockQuery> query, NetResponse response)
+{
+  if (!response.hasHeader("visus-dtype"))
+    response.setHeader("visus-dtype", query->field.dtype.toString());
+
+  if (!response.hasHeader("visus-nsamples"))
+    response.setHeader("visus-nsamples", query->getNumberOfSamples().toString());
+
+  if (query->aborted())
+    return readFailed(query,"aborted");
+
+  //the server answers 404 when the block is not stored (see ModVisus::handleBlockQuery)
+  if (response.status == HttpStatus::STATUS_NOT_FOUND)
+    return readNotStored(query, "block not stored");
+
+  if (!response.isSuccessful())
+    return readFailed(query,"response not valid");
+
+  auto decoded = response.getCompatibleArrayBody(query->getNumberOfSamples(), query->field.dtype);
+  if (!decoded.valid())
+    return readFailed(query,"cannot decode array");
+
+  query->buffer = decoded;
+  readOk(query);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+void ModVisusAccess::sendBatch(Batch batch)
 {
   if (batch.empty())
     return;
 
-  Batch batch;
-  std::swap(batch,this->batch);
-
   auto compression = getCompression();
 
   Url URL(this->url.withPath(url.getPath()));
@@ -145,43 +307,58 @@ void ModVisusAccess::flushBatch()
   auto REQUEST=NetRequest(URL);
   REQUEST.aborted=batch[0]->aborted;
 
-  NetService::push(netservice, REQUEST).when_ready([this,batch](NetResponse RESPONSE)
+  //parts of the response are decoded as soon as they arrive (all callbacks run in the network thread, one after the other)
+  class Streaming
   {
-    std::vector<NetResponse> responses = NetResponse::decompose(RESPONSE);
-    responses.resize(batch.size(), NetResponse(HttpStatus::STATUS_CANCELLED));
+  public:
+    Time  run_t1;
+    Int64 first_byte_msec = -1;
+    int   ndone = 0;
+    Int64 offset = 0;
+  };
 
-    for (int I = 0; I < batch.size(); I++)
+  auto streaming = std::make_shared<Streaming>();
+
+  REQUEST.partialResponse = [this, batch, streaming](const NetRequest& request, const NetResponse& RESPONSE)
+  {
+    //not counting the time waiting for a free connection
+    if (streaming->first_byte_msec < 0)
     {
-      auto query    = batch[I];
-      auto response = responses[I];
+      streaming->run_t1 = request.statistics.run_t1;
+      streaming->first_byte_msec = streaming->run_t1.elapsedMsec();
+    }
 
-      if (!response.hasHeader("visus-dtype"))
-        response.setHeader("visus-dtype", query->field.dtype.toString());
+    if (!RESPONSE.isSuccessful() || cint(RESPONSE.getHeader("response-compose-num")) != (int)batch.size())
+      return;
 
-      if (!response.hasHeader("visus-nsamples"))
-        response.setHeader("visus-nsamples", query->getNumberOfSamples().toString());
+    NetResponse response;
+    while (streaming->ndone < (int)batch.size() && NetResponse::decomposePart(RESPONSE, streaming->ndone, streaming->offset, response))
+      onBlockResponse(batch[streaming->ndone++], response);
+  };
 
-      if (query->aborted()) {
-        readFailed(query,"aborted");
-        continue;
-      }
-      
-      if (!response.isSuccessful())
-      {
-        readFailed(query,"response not valid");
-        continue;
-      }
+  NetService::push(netservice, REQUEST).when_ready([this, batch, streaming](NetResponse RESPONSE)
+  {
+    if (RESPONSE.isSuccessful() && streaming->first_byte_msec >= 0)
+      updateStatistics((int)batch.size(), RESPONSE.body ? RESPONSE.body->c_size() : 0, streaming->first_byte_msec, streaming->run_t1.elapsedMsec());
 
-      auto decoded = response.getCompatibleArrayBody(query->getNumberOfSamples(), query->field.dtype);
-      if (!decoded.valid())
+    //the parts not streamed yet
+    if (RESPONSE.isSuccessful() && cint(RESPONSE.getHeader("response-compose-num")) == (int)batch.size())
+    {
+      NetResponse response;
+      for (int I = streaming->ndone; I < batch.size(); I++)
       {
-        readFailed(query,"cannot decode array");
-        continue;
+        if (!NetResponse::decomposePart(RESPONSE, I, streaming->offset, response))
+          response = NetResponse(HttpStatus::STATUS_INTERNAL_SERVER_ERROR, "Body too short");
+        onBlockResponse(batch[I], response);
       }
+    }
+    else
+    {
+      std::vector<NetResponse> responses = NetResponse::decompose(RESPONSE);
+      responses.resize(batch.size(), NetResponse(HttpStatus::STATUS_CANCELLED));
 
-      query->buffer = decoded;
-
-      readOk(query);
+      for (int I = streaming->ndone; I < batch.size(); I++)
+        onBlockResponse(batch[I], responses[I]);
     }
   });
 
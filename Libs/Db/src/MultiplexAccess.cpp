@@ -161,9 +161,9 @@ void MultiplexAccess::scheduleOp(int mode, int index, SharedPtr<BlockQuery> up_q
     while (isGoodIndex(index) && (!dw_access[index]->can_read || !passThought(index, blockid)))
       index++;
 
-    //invalid index
+    //invalid index (not stored only if the last access that tried said so)
     if (!isGoodIndex(index))
-      return readFailed(up_query, "wrong index");
+      return up_query->not_stored ? readNotStored(up_query, "block not stored") : readFailed(up_query, "wrong index");
     else
       VisusAssert(dw_access[index]->can_read && passThought(index, blockid));
   }
@@ -267,6 +267,7 @@ void MultiplexAccess::runInBackground()
           //if fails try the next index
           if (dw_query->failed())
           {
+            up_query->not_stored = dw_query->not_stored;
             scheduleOp('r', index + 1, up_query);
           }
           //I need to write to upper access (i.e. for caching the reading)
@@ -318,6 +319,8 @@ void MultiplexAccess::runInBackground()
 
       if (!new_mode && cur_mode)
         dw_access[index]->endIO();
+      else if (cur_mode)
+        dw_access[index]->flushBatch(); //staying open, but the requests of this cycle must start
     }
   }
 }
@@ -0,0 +1,909 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#include <Visus/PackedCacheAccess.h>
+#include <Visus/Dataset.h>
+#include <Visus/File.h>
+#include <Visus/Encoder.h>
+#include <Visus/Thread.h>
+#include <Visus/Semaphore.h>
+
+#include <unordered_map>
+#include <algorithm>
+
+namespace Visus {
+
+///////////////////////////////////////////////////////////////////////////////////////
+/*
+  index.log records (one per line, a malformed or partial line is ignored):
+
+    G <generation>                                    first line, changes when the log is rewritten
+    N <segment>                                       a new segment has been opened for appending
+    P <segment> <offset> <size> <hits> <layout> <key> block stored in segment at offset
+    D <key>                                           block evicted
+    S <segment> <size>                                segment size on disk, dead bytes included (written when the log is rewritten)
+    R <segment>                                       segment removed
+
+  Segment numbers only grow, so a stale record never points to different data.
+  Keys are <hex field name>:<time>:<blockid> (see PackedCacheAccess::getKey), index.flock protects the log from other processes.
+  Writes only append: eviction, compaction and log rewriting run in a background thread (see collect).
+*/
+class PackedCacheAccess::Store
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(Store)
+
+  //_____________________________________________________________
+  class Entry
+  {
+  public:
+    int    segment = 0;
+    Int64  offset = 0;
+    Int64  size = 0;
+    String layout;
+    Int64  last_access = 0;
+    Int64  hits = 0;
+  };
+
+  String dir;
+
+  //constructor
+  Store(String dir_) : dir(dir_) {
+    this->thread = Thread::start("PackedCacheAccess collector", [this]() {
+      runInBackground();
+    });
+  }
+
+  //destructor
+  ~Store() {
+    bExit = true;
+    wakeup.up();
+    Thread::join(thread);
+  }
+
+  //getInstance (all accesses to the same directory inside this process share one store)
+  static SharedPtr<Store> getInstance(String dir)
+  {
+    static CriticalSection instances_lock;
+    static std::map<String, std::weak_ptr<Store> > instances;
+
+    ScopedLock lock(instances_lock);
+    if (auto ret = instances[dir].lock())
+      return ret;
+
+    FileUtils::createDirectory(dir);
+    auto ret = std::make_shared<Store>(dir);
+    {
+      ScopedLock lock(ret->lock);
+      ret->refresh();
+    }
+    instances[dir] = ret;
+    return ret;
+  }
+
+  //configure
+  void configure(Int64 max_size, Int64 segment_size, bool lfu)
+  {
+    ScopedLock lock(this->lock);
+    this->max_size = max_size;
+    this->segment_size = std::max((Int64)1, segment_size);
+
+    //only dead bytes in non-current segments can be reclaimed, keep segments small compared to the budget
+    if (max_size > 0)
+      this->segment_size = std::min(this->segment_size, std::max((Int64)1, max_size / 8));
+    this->lfu = lfu;
+  }
+
+  //read
+  SharedPtr<HeapMemory> read(const String& key, String& layout)
+  {
+    for (int nattempt = 0; nattempt < 2; nattempt++)
+    {
+      Entry entry;
+      {
+        ScopedLock lock(this->lock);
+
+        //maybe another process wrote it, or moved it
+        auto it = entries.find(key);
+        if (it == entries.end() || nattempt)
+        {
+          refresh();
+          it = entries.find(key);
+        }
+
+        if (it == entries.end())
+          break;
+
+        it->second.last_access = ++clock;
+        it->second.hits++;
+        entry = it->second;
+      }
+
+      //segments are append-only, so I can read outside the lock
+      auto encoded = std::make_shared<HeapMemory>();
+      File file;
+      if (encoded->resize(entry.size, __FILE__, __LINE__) && file.open(getSegmentFilename(entry.segment), "r") && file.read(entry.offset, entry.size, encoded->c_ptr()))
+      {
+        ScopedLock lock(this->lock);
+        ++nhits;
+        layout = entry.layout;
+        return encoded;
+      }
+    }
+
+    ScopedLock lock(this->lock);
+    ++nmisses;
+    return SharedPtr<HeapMemory>();
+  }
+
+  //write
+  bool write(const String& key, SharedPtr<HeapMemory> encoded, String layout)
+  {
+    ScopedLock lock(this->lock);
+    ScopedSystemFileLock dir_lock(getLockFilename()); //cross-process
+    if (!dir_lock.isLocked())
+      return false;
+
+    refresh();
+
+    //already written by someone else
+    auto it = entries.find(key);
+    if (it != entries.end())
+    {
+      it->second.last_access = ++clock;
+      return true;
+    }
+
+    String records;
+    bool bOk = append(key, encoded->c_ptr(), encoded->c_size(), layout, 0, records);
+
+    //something went wrong, I need to start again from the log
+    if (!appendRecords(records))
+    {
+      reset();
+      return false;
+    }
+
+    //the writer never waits for eviction or compaction
+    if (bOk && !bCollectPending && needsCollect())
+    {
+      bCollectPending = true;
+      wakeup.up();
+    }
+
+    return bOk;
+  }
+
+  //printStatistics
+  void printStatistics()
+  {
+    ScopedLock lock(this->lock);
+    PrintInfo("PackedCacheAccess dir", dir, "nblocks", entries.size(), "live", StringUtils::getStringFromByteSize(live_bytes), "disk", StringUtils::getStringFromByteSize(disk_bytes),
+      "max_size", StringUtils::getStringFromByteSize(max_size), "nsegments", disk.size(), "nhits", nhits, "nmisses", nmisses, "nevicted", nevicted, "ncompacted", ncompacted);
+  }
+
+private:
+
+  CriticalSection lock;
+
+  Int64 max_size = 0;
+  Int64 segment_size = 256 * 1024 * 1024;
+  bool  lfu = false;
+
+  std::unordered_map<String, Entry> entries;
+  std::map<int, Int64> live; //live bytes for each segment
+  std::map<int, Int64> disk; //bytes on disk for each segment (live and dead)
+  Int64 live_bytes = 0;
+  Int64 disk_bytes = 0;
+  int   current_segment = 0;
+
+  Int64 generation = 0;
+  Int64 log_offset = 0;
+  Int64 nrecords = 0;
+  Int64 clock = 0;
+
+  //statistics
+  Int64 nhits = 0, nmisses = 0, nevicted = 0, ncompacted = 0;
+
+  //background collector
+  SharedPtr<std::thread> thread;
+  Semaphore              wakeup;
+  bool                   bCollectPending = false;
+  bool                   bExit = false;
+
+  //getLogFilename
+  String getLogFilename() const {
+    return dir + "/index.log";
+  }
+
+  //getLockFilename
+  String getLockFilename() const {
+    return dir + "/index.flock";
+  }
+
+  //getSegmentFilename
+  String getSegmentFilename(int segment) const {
+    return concatenate(dir, "/segment.", segment, ".bin");
+  }
+
+  //reset
+  void reset()
+  {
+    entries.clear();
+    live.clear();
+    disk.clear();
+    live_bytes = 0;
+    disk_bytes = 0;
+    generation = 0;
+    log_offset = 0;
+    nrecords = 0;
+  }
+
+  //needsCollect (dead bytes count in the budget too, they are on disk until the segment is compacted)
+  bool needsCollect() const {
+    return (max_size > 0 && disk_bytes > max_size) || (nrecords > 1024 && nrecords > 4 * (Int64)entries.size());
+  }
+
+  //growSegment
+  void growSegment(int segment, Int64 size)
+  {
+    auto& value = disk[segment];
+    if (size <= value)
+      return;
+    disk_bytes += size - value;
+    value = size;
+  }
+
+  //dropSegment
+  void dropSegment(int segment)
+  {
+    auto it = disk.find(segment);
+    if (it != disk.end())
+    {
+      disk_bytes -= it->second;
+      disk.erase(it);
+    }
+    live.erase(segment);
+  }
+
+  //addEntry
+  void addEntry(const String& key, const Entry& entry)
+  {
+    removeEntry(key);
+    entries[key] = entry;
+    live[entry.segment] += entry.size;
+    live_bytes += entry.size;
+    growSegment(entry.segment, entry.offset + entry.size);
+  }
+
+  //removeEntry
+  void removeEntry(const String& key)
+  {
+    auto it = entries.find(key);
+    if (it == entries.end())
+      return;
+    live[it->second.segment] -= it->second.size;
+    live_bytes -= it->second.size;
+    entries.erase(it);
+  }
+
+  //getRecord
+  static String getRecord(const String& key, const Entry& entry) {
+    return concatenate("P ", entry.segment, " ", entry.offset, " ", entry.size, " ", entry.hits, " ", entry.layout.empty() ? "-" : entry.layout, " ", key, "\n");
+  }
+
+  //applyRecord
+  void applyRecord(const String& line)
+  {
+    std::istringstream in(line);
+    String type; 
+    in >> type;
+
+    if (type == "N")
+    {
+      int segment = 0;
+      if (!(in >> segment))
+        return;
+      current_segment = std::max(current_segment, segment);
+      growSegment(segment, 0);
+    }
+    else if (type == "P")
+    {
+      Entry entry; 
+      if (!(in >> entry.segment >> entry.offset >> entry.size >> entry.hits >> entry.layout) || entry.size <= 0)
+        return;
+
+      String key;
+      std::getline(in, key);
+      key = StringUtils::trim(key);
+      if (key.empty())
+        return;
+
+      if (entry.layout == "-")
+        entry.layout = "";
+
+      //replay order is the access order
+      entry.last_access = ++clock;
+      addEntry(key, entry);
+      current_segment = std::max(current_segment, entry.segment);
+    }
+    else if (type == "D")
+    {
+      String key;
+      std::getline(in, key);
+      removeEntry(StringUtils::trim(key));
+    }
+    else if (type == "S")
+    {
+      int segment = 0; Int64 size = 0;
+      if (!(in >> segment >> size))
+        return;
+      growSegment(segment, size);
+    }
+    else if (type == "R")
+    {
+      int segment = 0;
+      if (!(in >> segment))
+        return;
+      dropSegment(segment);
+    }
+    else
+    {
+      return;
+    }
+
+    nrecords++;
+  }
+
+  //refresh (replay the records appended to index.log since last time)
+  void refresh()
+  {
+    File file;
+    if (!file.open(getLogFilename(), "r"))
+    {
+      //someone removed the cache
+      if (generation)
+        reset(); 
+      return;
+    }
+
+    auto size = file.size();
+
+    //rewritten by someone else?
+    String header(std::min(size, (Int64)64), ' ');
+    if (header.empty() || !file.read(0, header.size(), (unsigned char*)&header[0]))
+      return;
+
+    std::istringstream in(header.substr(0, header.find('\n')));
+    String G; Int64 log_generation = 0;
+    if (!(in >> G >> log_generation) || G != "G")
+      return;
+
+    if (log_generation != generation)
+    {
+      reset();
+      generation = log_generation;
+    }
+
+    if (size <= log_offset)
+      return;
+
+    String content(size - log_offset, ' ');
+    if (!file.read(log_offset, content.size(), (unsigned char*)&content[0]))
+      return;
+
+    //only complete lines, the last one may be still in progress
+    auto end = content.rfind('\n');
+    if (end == String::npos)
+      return;
+
+    auto lines = StringUtils::getNonEmptyLines(content.substr(0, end));
+    for (int I = (log_offset == 0 ? 1 : 0); I < (int)lines.size(); I++)
+      applyRecord(lines[I]);
+
+    log_offset += end + 1;
+  }
+
+  //appendRecords (must have the dir lock)
+  bool appendRecords(String records)
+  {
+    if (records.empty())
+      return true;
+
+    auto filename = getLogFilename();
+
+    File file;
+    if (!file.open(filename, "rw"))
+    {
+      generation = std::max(generation + 1, Time::getTimeStamp());
+      records = concatenate("G ", generation, "\n", records);
+      if (!file.createAndOpen(filename, "rw"))
+        return false;
+    }
+
+    //a crashed process could have left a partial line
+    auto size = file.size();
+    if (size > 0)
+    {
+      unsigned char last = 0;
+      if (file.read(size - 1, 1, &last) && last != '\n')
+        records = "\n" + records;
+    }
+
+    if (!file.write(size, records.size(), (unsigned char*)records.c_str()))
+      return false;
+
+    //records have already been applied
+    log_offset = size + records.size();
+    return true;
+  }
+
+  //append (must have the dir lock)
+  bool append(const String& key, const unsigned char* data, Int64 size, String layout, Int64 hits, String& records)
+  {
+    auto filename = getSegmentFilename(current_segment);
+    if (!current_segment || FileUtils::getFileSize(filename) >= segment_size)
+    {
+      //skip left-overs of crashed processes
+      do {
+        filename = getSegmentFilename(++current_segment);
+      } while (FileUtils::existsFile(filename));
+
+      records += concatenate("N ", current_segment, "\n");
+      nrecords++;
+    }
+
+    File file;
+    if (!file.open(filename, "rw") && !file.createAndOpen(filename, "rw"))
+      return false;
+
+    Entry entry;
+    entry.segment = current_segment;
+    entry.offset = file.size();
+    entry.size = size;
+    entry.layout = layout;
+    entry.hits = hits;
+    entry.last_access = ++clock;
+
+    if (!file.write(entry.offset, size, data))
+      return false;
+
+    addEntry(key, entry);
+    records += getRecord(key, entry);
+    nrecords++;
+    return true;
+  }
+
+  //runInBackground
+  void runInBackground()
+  {
+    while (true)
+    {
+      wakeup.down();
+      if (bExit)
+        return;
+      collect();
+    }
+  }
+
+  //collect (evict and compact until the cache is back in its budget, some hysteresis otherwise I would collect at each write)
+  void collect()
+  {
+    {
+      ScopedLock lock(this->lock);
+      bCollectPending = false;
+    }
+
+    while (!bExit)
+    {
+      int victim = 0;
+      std::vector< std::pair<String, Entry> > moving;
+      {
+        ScopedLock lock(this->lock);
+        ScopedSystemFileLock dir_lock(getLockFilename());
+        if (!dir_lock.isLocked())
+          return;
+
+        refresh();
+
+        String records;
+        std::vector<String> remove_segments;
+        removeEmptySegments(records, remove_segments);
+
+        auto target = (Int64)(0.9 * max_size);
+        bool bOverBudget = max_size > 0 && disk_bytes > target;
+
+        Int64 nevicted_bytes = 0;
+        if (bOverBudget)
+        {
+          //compacting a mostly dead segment gives back its dead bytes, otherwise turn some live bytes into dead ones
+          victim = getMostlyDeadSegment();
+          if (victim)
+          {
+            for (auto& it : entries)
+            {
+              if (it.second.segment == victim)
+                moving.push_back(it);
+            }
+          }
+          else
+          {
+            nevicted_bytes = evict(disk_bytes - target, records);
+          }
+        }
+
+        if (!appendRecords(records))
+        {
+          reset();
+          return;
+        }
+
+        //only now other processes can know the segments are gone
+        for (auto filename : remove_segments)
+          FileUtils::removeFile(filename);
+
+        //too many dead records
+        if (nrecords > 1024 && nrecords > 4 * (Int64)entries.size())
+          rewriteLog();
+
+        //nothing else I can do (i.e. the current segment cannot be compacted)
+        if (!bOverBudget || (!victim && !nevicted_bytes))
+          return;
+      }
+
+      if (victim && !compact(victim, moving))
+        return;
+    }
+  }
+
+  //removeEmptySegments (must have the dir lock)
+  void removeEmptySegments(String& records, std::vector<String>& remove_segments)
+  {
+    std::vector<int> empty;
+    for (auto it : disk)
+    {
+      auto jt = live.find(it.first);
+      if (it.first != current_segment && (jt == live.end() || jt->second <= 0))
+        empty.push_back(it.first);
+    }
+
+    for (auto segment : empty)
+    {
+      dropSegment(segment);
+      remove_segments.push_back(getSegmentFilename(segment));
+      records += concatenate("R ", segment, "\n");
+      nrecords++;
+    }
+  }
+
+  //getMostlyDeadSegment (the non-current segment with more dead bytes, only if at least half of it is dead)
+  int getMostlyDeadSegment()
+  {
+    int ret = 0;
+    Int64 max_dead = 0;
+    for (auto it : disk)
+    {
+      auto segment = it.first;
+      if (segment == current_segment)
+        continue;
+
+      auto dead = it.second - live[segment];
+      if (dead > max_dead && dead >= it.second / 2)
+      {
+        ret = segment;
+        max_dead = dead;
+      }
+    }
+    return ret;
+  }
+
+  //evict (must have the dir lock, blocks in the current segment are not evicted since their space cannot be reclaimed yet)
+  Int64 evict(Int64 amount, String& records)
+  {
+    std::vector< std::pair<String, Entry> > v;
+    for (auto& it : entries)
+    {
+      if (it.second.segment != current_segment)
+        v.push_back(it);
+    }
+
+    std::sort(v.begin(), v.end(), [&](const std::pair<String, Entry>& a, const std::pair<String, Entry>& b) {
+      if (lfu && a.second.hits != b.second.hits) return a.second.hits < b.second.hits;
+      return a.second.last_access < b.second.last_access;
+    });
+
+    Int64 ret = 0;
+    for (auto& it : v)
+    {
+      if (ret >= amount)
+        break;
+      removeEntry(it.first);
+      records += concatenate("D ", it.first, "\n");
+      nrecords++;
+      nevicted++;
+      ret += it.second.size;
+    }
+    return ret;
+  }
+
+  //compact (move the live blocks of a segment to the current one, the copy is read outside the locks)
+  bool compact(int segment, const std::vector< std::pair<String, Entry> >& v)
+  {
+    File file;
+    if (!file.open(getSegmentFilename(segment), "r"))
+      return false;
+
+    const Int64 batch_size = 16 * 1024 * 1024;
+    for (int I = 0; I < (int)v.size(); )
+    {
+      std::vector< std::pair<int, SharedPtr<HeapMemory> > > batch;
+      for (Int64 nbytes = 0; I < (int)v.size() && nbytes < batch_size; I++)
+      {
+        auto& entry = v[I].second;
+        auto buffer = std::make_shared<HeapMemory>();
+        if (!buffer->resize(entry.size, __FILE__, __LINE__) || !file.read(entry.offset, entry.size, buffer->c_ptr()))
+          return false;
+        batch.push_back(std::make_pair(I, buffer));
+        nbytes += entry.size;
+      }
+
+      ScopedLock lock(this->lock);
+      ScopedSystemFileLock dir_lock(getLockFilename());
+      if (!dir_lock.isLocked())
+        return false;
+
+      refresh();
+
+      String records;
+      bool bOk = true;
+      for (auto& it : batch)
+      {
+        auto& key = v[it.first].first;
+        auto& old = v[it.first].second;
+
+        //evicted or moved by someone else in the meantime
+        auto jt = entries.find(key);
+        if (jt == entries.end() || jt->second.segment != old.segment || jt->second.offset != old.offset)
+          continue;
+
+        //moving is not an access
+        auto last_access = jt->second.last_access;
+        if (!(bOk = append(key, it.second->c_ptr(), it.second->c_size(), jt->second.layout, jt->second.hits, records)))
+          break;
+        entries[key].last_access = last_access;
+      }
+
+      if (!appendRecords(records))
+      {
+        reset();
+        return false;
+      }
+
+      if (!bOk)
+        return false;
+    }
+
+    ScopedLock lock(this->lock);
+    ncompacted++;
+    return true;
+  }
+
+  //rewriteLog (must have the dir lock)
+  void rewriteLog()
+  {
+    //keep the access order, it will be the LRU order after a restart
+    std::vector< std::pair<String, Entry> > v(entries.begin(), entries.end());
+    std::sort(v.begin(), v.end(), [](const std::pair<String, Entry>& a, const std::pair<String, Entry>& b) {
+      return a.second.last_access < b.second.last_access;
+    });
+
+    auto new_generation = std::max(generation + 1, Time::getTimeStamp());
+    String content = concatenate("G ", new_generation, "\n", "N ", current_segment, "\n");
+
+    //dead bytes are not in the P records
+    for (auto it : disk)
+      content += concatenate("S ", it.first, " ", it.second, "\n");
+
+    for (auto& it : v)
+      content += getRecord(it.first, it.second);
+
+    auto filename = getLogFilename();
+    auto tmp_filename = filename + ".tmp";
+    FileUtils::removeFile(tmp_filename);
+    {
+      File file;
+      if (!file.createAndOpen(tmp_filename, "rw") || !file.write(0, content.size(), (unsigned char*)content.c_str()))
+      {
+        file.close();
+        FileUtils::removeFile(tmp_filename);
+        return;
+      }
+    }
+
+    //rename cannot overwrite on some OS
+    if (!FileUtils::moveFile(tmp_filename, filename))
+    {
+      FileUtils::removeFile(filename);
+      if (!FileUtils::moveFile(tmp_filename, filename))
+      {
+        reset();
+        return;
+      }
+    }
+
+    generation = new_generation;
+    log_offset = content.size();
+    nrecords = 1 + (Int64)disk.size() + (Int64)entries.size();
+  }
+
+};
+
+
+////////////////////////////////////////////////////////////////////
+PackedCacheAccess::PackedCacheAccess(Dataset* dataset, StringTree config)
+{
+  this->name = config.readString("name", "PackedCacheAccess");
+  this->can_read = StringUtils::find(config.readString("chmod", DefaultChMod), "r") >= 0;
+  this->can_write = StringUtils::find(config.readString("chmod", DefaultChMod), "w") >= 0;
+  this->bitsperblock = dataset->getDefaultBitsPerBlock();
+  this->compression = config.readString("compression");
+
+  Url url = config.readString("url", dataset->getUrl());
+  VisusReleaseAssert(url.valid());
+
+  if (url.isRemote() && this->compression.empty())
+    this->compression = "raw";
+
+  //same directory layout of DiskAccess
+  std::ostringstream out;
+  out << config.readString("cache_dir", GetVisusCache()) << "/" << "PackedCacheAccess" << "/";
+  if (url.isRemote())
+  {
+    out << url.getHostname() << "/" << url.getPort() << "/" << compression << url.getPath();
+    if (StringUtils::contains(url.toString(), "mod_visus"))
+      out << "/" << url.getParam("dataset");
+  }
+  else
+  {
+    out << "local" << "/" << compression << "/" << StringUtils::replaceAll(Path(url.getPath()).withoutExtension(), ":", "");
+  }
+
+  auto max_size = StringUtils::getByteSizeFromString(config.readString("max_size", Utils::getEnv("VISUS_PACKED_CACHE_SIZE", "10gb")));
+  auto segment_size = StringUtils::getByteSizeFromString(config.readString("segment_size", "256mb"));
+  auto lfu = StringUtils::toLower(config.readString("eviction", "lru")) == "lfu";
+
+  this->store = Store::getInstance(out.str());
+  this->store->configure(max_size, segment_size, lfu);
+
+  this->verbose |= cint(Utils::getEnv("VISUS_VERBOSE_DISKACCESS"));
+
+  PrintInfo("Created PackedCacheAccess", "dir", store->dir, "compression", compression, "max_size", StringUtils::getStringFromByteSize(max_size), "eviction", lfu ? "lfu" : "lru");
+}
+
+////////////////////////////////////////////////////////////////////
+PackedCacheAccess::~PackedCacheAccess()
+{
+}
+
+////////////////////////////////////////////////////////////////////
+String PackedCacheAccess::getDirectory() const
+{
+  return store->dir;
+}
+
+////////////////////////////////////////////////////////////////////
+String PackedCacheAccess::getKey(SharedPtr<BlockQuery> query)
+{
+  //the key is written in a line-based log, field names can be any expression (spaces, new lines...)
+  return concatenate(StringUtils::hexdigest(query->field.name), ":", query->time, ":", query->blockid);
+}
+
+////////////////////////////////////////////////////////////////////
+void PackedCacheAccess::readBlock(SharedPtr<BlockQuery> query)
+{
+  bool bVerbose = (this->verbose & 1) ? true : false;
+
+  auto FAILED = [&](String reason) {
+    if (bVerbose)
+      PrintInfo("PackedCacheAccess::read blockid", query->blockid, "failed ", reason);
+    return readFailed(query, reason);
+  };
+
+  if (query->aborted())
+    return FAILED("query aborted");
+
+  String layout;
+  auto encoded = store->read(getKey(query), layout);
+  if (!encoded)
+  {
+    query->not_stored = true;
+    return FAILED("not in cache");
+  }
+
+  auto nsamples = query->getNumberOfSamples();
+  auto compression = getCompression(query->field.default_compression);
+  auto decoded = ArrayUtils::decodeArray(compression, nsamples, query->field.dtype, encoded);
+  if (!decoded.valid())
+    return FAILED("cannot decode data");
+
+  VisusAssert(decoded.dims == nsamples);
+  decoded.layout = layout;
+  query->buffer = decoded;
+
+  if (bVerbose)
+    PrintInfo("PackedCacheAccess::read blockid", query->blockid, "OK");
+  return readOk(query);
+}
+
+////////////////////////////////////////////////////////////////////
+void PackedCacheAccess::writeBlock(SharedPtr<BlockQuery> query)
+{
+  bool bVerbose = this->verbose ? true : false;
+
+  auto FAILED = [&](String reason) {
+    if (bVerbose)
+      PrintInfo("PackedCacheAccess::writeBlock", query->blockid, "failed ", reason);
+    return writeFailed(query, reason);
+  };
+
+  if (query->aborted())
+    return FAILED("query aborted");
+
+  auto compression = getCompression(query->field.default_compression);
+  auto encoded = ArrayUtils::encodeArray(compression, query->buffer);
+  if (!encoded)
+    return FAILED("Failed to encode data");
+
+  if (!store->write(getKey(query), encoded, query->buffer.layout))
+    return FAILED("failed to write encoded data");
+
+  if (bVerbose)
+    PrintInfo("PackedCacheAccess::writeBlock", query->blockid, "OK");
+  return writeOk(query);
+}
+
+////////////////////////////////////////////////////////////////////
+void PackedCacheAccess::printStatistics()
+{
+  Access::printStatistics();
+  store->printStatistics();
+}
+
+} //namespace Visus
+
@@ -51,7 +51,12 @@ bool PointQuery::setPoints(PointNi npoints)
   if (!this->logic_position.valid())
     return false;
 
-  if (!this->points->resize(npoints.innerProduct()*sizeof(Int64)*3, __FILE__, __LINE__))
+  //the grid is defined by a 3d position, for 2d datasets the last coordinate is dropped
+  int pdim = dataset ? dataset->getPointDim() : 3;
+  if (pdim < 2 || pdim > 3)
+    return false;
+
+  if (!this->points->resize(npoints.innerProduct()*sizeof(Int64)*pdim, __FILE__, __LINE__))
     return false;
 
   //definition of a point query!
@@ -77,10 +82,34 @@ bool PointQuery::setPoints(PointNi npoints)
   Point3d PX = PY;  for (int I = 0; I < npoints[0]; ++I, PX += TDX) {
     *DST++ = (Int64)(PX[0]);
     *DST++ = (Int64)(PX[1]);
-    *DST++ = (Int64)(PX[2]);
+    if (pdim == 3) *DST++ = (Int64)(PX[2]);
   }}}
 
   this->npoints = npoints;
+  this->explicit_points = false;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+bool PointQuery::setPoints(Array points)
+{
+  int pdim = dataset ? dataset->getPointDim() : (int)points.dims[0];
+
+  if (points.dtype != DTypes::INT64 || points.dims.getPointDim() < 2 || points.dims[0] != pdim)
+    return false;
+
+  PointNi npoints;
+  for (int D = 1; D < points.dims.getPointDim(); D++)
+    npoints.push_back(points.dims[D]);
+
+  //no samples or overflow
+  if (npoints.innerProduct() <= 0)
+    return false;
+
+  //no copy, the memory is shared
+  this->points = points.heap;
+  this->npoints = npoints;
+  this->explicit_points = true;
   return true;
 }
 
@@ -39,6 +39,8 @@ For support : support@visus.net
 #include <Visus/RamAccess.h>
 #include <Visus/Dataset.h>
 
+#include <unordered_map>
+
 namespace Visus {
 
 ////////////////////////////////////////////////////////////////////
@@ -51,29 +53,53 @@ public:
   {
   public:
   
-    String   fieldname;
+    Uint64   fieldhash;
     double   time;
     BigInt   blockid; 
 
     //constructor
-    inline Key(String fieldname_,double time_,BigInt blockid_) : fieldname(fieldname_),time(time_), blockid(blockid_)
+    inline Key(const String& fieldname,double time_,BigInt blockid_) : fieldhash(hashFieldname(fieldname)),time(time_), blockid(blockid_)
     {}
 
     //operator==
     inline bool operator==(const Key& other) const 
-    {return blockid ==other.blockid && time==other.time && fieldname==other.fieldname;}
+    {return blockid ==other.blockid && time==other.time && fieldhash==other.fieldhash;}
+
+    //hash
+    inline Uint64 hash() const
+    {
+      Uint64 ret = fieldhash;
+      ret ^= mix((Uint64)blockid)  + 0x9e3779b97f4a7c15ULL + (ret << 6) + (ret >> 2);
+      ret ^= mix(std::hash<double>()(time)) + 0x9e3779b97f4a7c15ULL + (ret << 6) + (ret >> 2);
+      return mix(ret);
+    }
+
+    //hashFieldname (FNV-1a)
+    static inline Uint64 hashFieldname(const String& value)
+    {
+      Uint64 ret = 0xcbf29ce484222325ULL;
+      for (auto ch : value)
+        ret = (ret ^ (Uint8)ch) * 0x100000001b3ULL;
+      return ret;
+    }
 
-    //operator<
-    inline bool operator<(const Key& other) const 
+    //mix (splitmix64 finalizer)
+    static inline Uint64 mix(Uint64 x)
     {
-      return (blockid <other.blockid)
-          || (blockid ==other.blockid && time<other.time)
-          || (blockid ==other.blockid && time==other.time && fieldname<other.fieldname);
+      x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+      x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+      x ^= x >> 31;
+      return x;
     }
 
-    //valid
-    inline bool valid() 
-    {return blockid >=0 && !fieldname.empty();}
+    //Hasher
+    class Hasher
+    {
+    public:
+      inline size_t operator()(const Key& key) const {
+        return (size_t)key.hash();
+      }
+    };
 
   };
 
@@ -81,118 +107,226 @@ public:
   class Cached
   {
   public:
-    Field                        field;
-    double                       time=0;
-    BigInt                       blockid =0;
-    Array                        buffer;
-    Cached                       *prev=nullptr,*next=nullptr;
-
-    inline Key key() {
-      return Key(field.name,time, blockid);
+    Key                          key;
+    String                       fieldname; //to resolve (unlikely) hash collisions
+    Array                        buffer;    //immutable once inside the cache
+    bool                         owned = false; //false if the writer may still hold the same heap (copy on write)
+    bool                         referenced = false;
+    bool                         valid = false;
+
+    //constructor
+    Cached() : key("", 0, -1) {
     }
   };
 
-  CriticalSection        lock;
-  Int64                  available=0,used=0;
-  Cached                 *front=nullptr,*back=nullptr;
-  std::map<Key,Cached*>  index;
+  //________________________________________________________________
+  //each shard has its own lock and does CLOCK (approximate LRU) eviction
+  class Shard
+  {
+  public:
 
-  //constructor
-  Shared(Int64 available_) : available(available_) {  
-  }
+    VISUS_NON_COPYABLE_CLASS(Shard)
 
-  //destructor
-  ~Shared() {
-    while (!index.empty()) 
-      delete remove(back);
+    CriticalSection                              lock;
+    Int64                                        available = 0, used = 0;
+    std::vector<Cached>                          slots;
+    std::vector<int>                             free_slots;
+    std::unordered_map<Key, int, Key::Hasher>    index;
+    size_t                                       hand = 0;
 
-    VisusAssert(used==0);
-  }
+    //constructor
+    Shard() {
+    }
 
-  //read
-  bool read(SharedPtr<BlockQuery> query) 
-  {
-    ScopedLock lock(this->lock);
+    //read (owned is false when the heap is still shared with the writer)
+    bool read(const Key& key, const String& fieldname, Array& buffer, bool& owned)
+    {
+      ScopedLock lock(this->lock);
 
-    Key key(query->field.name, query->time, query->blockid);
-    auto it = index.find(key);
-    VisusAssert(it == index.end() || it->second->key() == key);
+      auto it = index.find(key);
+      if (it == index.end())
+        return false;
 
-    if (it == index.end())
-      return false;
+      auto& cached = slots[it->second];
+      if (cached.fieldname != fieldname)
+        return false;
 
-    query->buffer = it->second->buffer.clone();
+      //the writer is gone, nobody else can modify it
+      if (!cached.owned && cached.buffer.heap.use_count() == 1)
+        cached.owned = true;
 
-    VisusAssert(query->field.name == it->second->field.name);
-    VisusAssert(query->time == it->second->time);
-    VisusAssert(query->blockid == it->second->blockid);
+      cached.referenced = true;
+      buffer = cached.buffer;
+      owned = cached.owned;
+      return true;
+    }
 
-    if (it->second != front)
-      push_front(remove(it->second));
+    //adopt (replace a buffer still shared with its writer with a private copy)
+    void adopt(const Key& key, const Array& shared, Array copy)
+    {
+      ScopedLock lock(this->lock);
 
-    //TODO: statistics without lock?
-    return true;
-  }
+      auto it = index.find(key);
+      if (it == index.end())
+        return;
 
-  //write
-  bool write(SharedPtr<BlockQuery> query) 
-  {
-    ScopedLock lock(this->lock);
+      auto& cached = slots[it->second];
+      if (cached.buffer.heap != shared.heap)
+        return;
+
+      cached.buffer = copy;
+      cached.owned = true;
+    }
+
+    //write
+    void write(const Key& key, const String& fieldname, Array buffer, bool owned)
+    {
+      ScopedLock lock(this->lock);
+
+      auto it = index.find(key);
+      if (it != index.end())
+      {
+        auto& cached = slots[it->second];
+        used += buffer.c_size() - cached.buffer.c_size();
+        cached.fieldname = fieldname;
+        cached.buffer = buffer;
+        cached.owned = owned;
+        cached.referenced = true;
+        return;
+      }
+
+      while (available > 0 && used + buffer.c_size() > available && evict())
+        ;
+
+      int slot;
+      if (!free_slots.empty())
+      {
+        slot = free_slots.back();
+        free_slots.pop_back();
+      }
+      else
+      {
+        slot = (int)slots.size();
+        slots.push_back(Cached());
+      }
+
+      auto& cached = slots[slot];
+      cached.key = key;
+      cached.fieldname = fieldname;
+      cached.buffer = buffer;
+      cached.owned = owned;
+      cached.referenced = false;
+      cached.valid = true;
+      used += buffer.c_size();
+      index[key] = slot;
+    }
 
-    Key key(query->field.name, query->time, query->blockid);
-    auto it = index.find(key);
-    VisusAssert(it == index.end() || it->second->key() == key);
+  private:
 
-    Cached* cached = (it == index.end()) ? 0 : it->second;
-    if (!cached)
+    //evict (CLOCK: skip and clear recently referenced entries)
+    bool evict()
     {
-      while (available>0 && used >= available) 
-        delete remove(back);
-      cached = new Cached();
+      if (index.empty())
+        return false;
+
+      while (true)
+      {
+        if (hand >= slots.size())
+          hand = 0;
+
+        auto& cached = slots[hand];
+        int slot = (int)hand++;
+
+        if (!cached.valid)
+          continue;
+
+        if (cached.referenced)
+        {
+          cached.referenced = false;
+          continue;
+        }
+
+        used -= cached.buffer.c_size();
+        index.erase(cached.key);
+        cached = Cached();
+        free_slots.push_back(slot);
+        return true;
+      }
     }
 
-    cached->buffer = query->buffer.clone();
-    cached->field = query->field;
-    cached->time = query->time;
-    cached->blockid = query->blockid;
+  };
+
+  std::vector< UniquePtr<Shard> > shards;
 
-    if (it == index.end())
-      push_front(cached);
+  //constructor
+  Shared(Int64 available, int nshards)  
+  {
+    nshards = std::max(1, nshards);
+    for (int I = 0; I < nshards; I++)
+    {
+      auto shard = new Shard();
+      shard->available = available > 0 ? std::max((Int64)1, available / nshards) : 0;
+      shards.push_back(UniquePtr<Shard>(shard));
+    }
+  }
 
-    else if (cached != front)
-      push_front(remove(cached));
+  //getShard
+  Shard& getShard(const Key& key) {
+    return *shards[(key.hash() >> 32) % shards.size()];
+  }
 
-    //TODO: statistics without lock?
+  //read (the caller shares the cached buffer and must not modify it)
+  bool read(SharedPtr<BlockQuery> query, const String& fieldname) 
+  {
+    Key key(fieldname, query->time, query->blockid);
+    Array buffer;
+    bool owned = false;
+    auto& shard = getShard(key);
+    if (!shard.read(key, fieldname, buffer, owned))
+      return false;
+
+    //copy on write: the writer still holds the same heap and could modify it, make a private copy once (outside the shard lock)
+    if (!owned)
+    {
+      Array copy = buffer.clone();
+      shard.adopt(key, buffer, copy);
+      buffer = copy;
+    }
+
+    VisusAssert(buffer.dtype == query->field.dtype);
+    query->buffer = buffer;
     return true;
   }
 
-private:
+  //write (the cache adopts the buffer, memory owned by someone else, for example numpy, is copied right away)
+  bool write(SharedPtr<BlockQuery> query, const String& fieldname) 
+  {
+    Key key(fieldname, query->time, query->blockid);
+    bool unmanaged = query->buffer.heap && query->buffer.heap->isUnmanaged();
+    Array buffer = unmanaged ? query->buffer.clone() : query->buffer;
+    getShard(key).write(key, fieldname, buffer, /*owned*/unmanaged);
+    return true;
+  }
 
-  //push_front
-  void push_front(Cached* cached)
+  //getUsedMemory
+  Int64 getUsedMemory() 
   {
-    VisusAssert(cached->key().valid());
-    VisusAssert(!cached->prev && !cached->next);
-    cached->prev=0;
-    cached->next=this->front;
-    if (cached->prev) cached->prev->next=cached; else this->front = cached;
-    if (cached->next) cached->next->prev=cached; else this->back  = cached;
-    VisusAssert((cached->prev || front==cached) && (cached->next || back==cached));
-    this->used+=cached->buffer.c_size();
-    index[cached->key()]=cached;
+    Int64 ret = 0;
+    for (auto& shard : shards)
+    {
+      ScopedLock lock(shard->lock);
+      ret += shard->used;
+    }
+    return ret;
   }
 
-  //remove
-  Cached* remove(Cached* cached)
+  //getAvailableMemory
+  Int64 getAvailableMemory() 
   {
-    VisusAssert(cached->key().valid());
-    VisusAssert((cached->prev || front==cached) && (cached->next || back==cached));
-    if (cached->prev) cached->prev->next=cached->next; else front=cached->next;
-    if (cached->next) cached->next->prev=cached->prev; else back =cached->prev;
-    cached->prev=cached->next=0;
-    index.erase(cached->key());
-    this->used-=cached->buffer.c_size();
-    return cached;
+    Int64 ret = 0;
+    for (auto& shard : shards)
+      ret += shard->available;
+    return ret;
   }
 
 };
@@ -204,6 +338,7 @@ RamAccess::RamAccess(int bitsperblock,StringTree config) {
   this->bitsperblock = bitsperblock;
   this->can_read = StringUtils::contains(config.readString("chmod", Access::DefaultChMod), "r");
   this->can_write = StringUtils::contains(config.readString("chmod", Access::DefaultChMod), "w");
+  this->num_shards = config.readInt("num_shards", 16);
   this->setAvailableMemory(StringUtils::getByteSizeFromString(config.readString("available", "128mb")));
 
 }
@@ -216,7 +351,7 @@ RamAccess::~RamAccess() {
 ////////////////////////////////////////////////////////////////////////////////
 void RamAccess::setAvailableMemory(Int64 value)
 {
-  this->shared = std::make_shared<Shared>(value);
+  this->shared = std::make_shared<Shared>(value, num_shards);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -228,13 +363,16 @@ void RamAccess::shareMemoryWith(SharedPtr<RamAccess> value)
 ////////////////////////////////////////////////////////////////////////////////
 void RamAccess::readBlock(SharedPtr<BlockQuery> query)  
 {
-  return shared->read(query)? readOk(query):readFailed(query,"not found");
+  if (!shared->read(query, key_prefix + query->field.name))
+    return readNotStored(query, "not found");
+
+  return readOk(query);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void RamAccess::writeBlock(SharedPtr<BlockQuery> query)  
 {
-  return shared->write(query)? writeOk(query):writeFailed(query,"not found");
+  return shared->write(query, key_prefix + query->field.name)? writeOk(query):writeFailed(query,"not found");
 }
 
 
@@ -242,12 +380,9 @@ void RamAccess::writeBlock(SharedPtr<BlockQuery> query)
 void RamAccess::printStatistics()  {
   
   Access::printStatistics();
-
-  {
-    ScopedLock lock(shared->lock);
-    PrintInfo("RAM used", StringUtils::getStringFromByteSize(shared->used));
-    PrintInfo("RAM available", StringUtils::getStringFromByteSize(shared->available));
-  }
+  PrintInfo("RAM used", StringUtils::getStringFromByteSize(shared->getUsedMemory()));
+  PrintInfo("RAM available", StringUtils::getStringFromByteSize(shared->getAvailableMemory()));
+  PrintInfo("RAM shards", shared->shards.size());
 }
 
 } //namespace Visus 
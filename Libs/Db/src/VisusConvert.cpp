@@ -51,10 +51,13 @@ For support : support@visus.net
 #include <Visus/NetService.h>
 #include <Visus/Utils.h>
 #include <Visus/IdxDiskAccess.h>
+#include <Visus/IdxBulkWriter.h>
 #include <Visus/IdxMultipleDataset.h>
 #include <Visus/MultiplexAccess.h>
 #include <Visus/RamResource.h>
 
+#include <fstream>
+
 namespace Visus {
 
   ///////////////////////////////////////////////////////////
@@ -624,6 +627,387 @@ public:
 };
 
 
+///////////////////////////////////////////////////////////
+class BulkWrite : public VisusConvert::Step
+{
+public:
+
+  //getHelp
+  virtual String getHelp(std::vector<String> args) override
+  {
+    std::ostringstream out;
+    out << args[0]
+      << " <filename.idx>" << std::endl
+      << "   [--field <string>]" << std::endl
+      << "   [--time <double>]" << std::endl
+      << "   [--box <BoxNi>]" << std::endl
+      << "   [--compression <string>]" << std::endl
+      << "   [--nthreads <int>]" << std::endl
+      << std::endl
+      << "Write full resolution data into a fresh IDX v6 dataset (no *.bin file must exist for the timestep)" << std::endl;
+    return out.str();
+  }
+
+  //exec
+  virtual Array exec(Array data, std::vector<String> args) override
+  {
+    if (args.size() < 2)
+      ThrowException(args[0], "syntax error");
+
+    String filename = args[1];
+
+    auto db = LoadDataset(filename);
+    if (!db)
+      ThrowException(args[0], "cannot load", filename);
+
+    int pdim = db->getPointDim();
+    Field field = db->getField();
+    double time = db->getTime();
+    BoxNi box = db->getLogicBox();
+    String compression;
+    int nthreads = 0;
+
+    for (int I = 2; I < (int)args.size(); I++)
+    {
+      if (args[I] == "--field")
+        field = db->getField(args[++I]);
+
+      else if (args[I] == "--time")
+        time = cdouble(args[++I]);
+
+      else if (args[I] == "--box")
+        box = BoxNi::parseFromOldFormatString(pdim, args[++I]);
+
+      else if (args[I] == "--compression")
+        compression = args[++I];
+
+      else if (args[I] == "--nthreads")
+        nthreads = cint(args[++I]);
+
+      else
+        ThrowException(args[0], "Invalid arguments", args[I]);
+    }
+
+    if (!field.valid())
+      ThrowException(args[0], "wrong field");
+
+    //embedding in case I'm missing point-dims
+    if (pdim > data.dims.getPointDim())
+      data.dims.setPointDim(pdim, 1);
+
+    auto t1 = Time::now();
+    IdxBulkWriter writer(db, { field }, time, nthreads);
+    if (!compression.empty())
+      writer.setCompression(compression);
+    writer.writeSlab(box, data);
+    writer.close();
+
+    PrintInfo("bulk-write done", "nblocks", writer.getNumWrittenBlocks(), "nfiles", writer.getNumWrittenFiles(), "msec", t1.elapsedMsec());
+    return data;
+  }
+};
+
+///////////////////////////////////////////////////////////
+class CopyBlocks : public VisusConvert::Step
+{
+public:
+
+  //getHelp
+  virtual String getHelp(std::vector<String> args) override
+  {
+    std::ostringstream out;
+    out << args[0]
+      << " <src-url> <dst-url>" << std::endl
+      << "   [--field <string>]*" << std::endl
+      << "   [--time <double>]*" << std::endl
+      << "   [--compression <string>]" << std::endl
+      << "   [--nthreads <int>]" << std::endl
+      << "   [--blocks-per-task <int>]" << std::endl
+      << "   [--src-access <xml>]" << std::endl
+      << "   [--dst-access <xml>]" << std::endl
+      << "   [--resume]" << std::endl
+      << "   [--journal <filename>]" << std::endl
+      << std::endl
+      << "Copy (and possibly recompress) all blocks from <src-url> to <dst-url>, any access to any access." << std::endl
+      << "If <dst-url> does not exist and <src-url> is an IDX dataset, the IDX file is cloned." << std::endl
+      << "Each worker owns whole destination files, and reads the next task while writing the current one." << std::endl
+      << "Completed tasks (time, block range and fields) are appended to the journal (default <dst-url>.copy-blocks), --resume skips them." << std::endl;
+    return out.str();
+  }
+
+  //exec
+  virtual Array exec(Array data, std::vector<String> args) override
+  {
+    if (args.size() < 3)
+      ThrowException(args[0], "syntax error");
+
+    String src_url = args[1];
+    String dst_url = args[2];
+    std::vector<String> field_names;
+    std::vector<double> timesteps;
+    String compression;
+    int nthreads = 8;
+    int blocks_per_task = 64;
+    StringTree src_config, dst_config;
+    bool bResume = false;
+    String journal = Url(dst_url).isFile() ? Url(dst_url).getPath() + ".copy-blocks" : String("copy-blocks.journal");
+
+    for (int I = 3; I < (int)args.size(); I++)
+    {
+      if (args[I] == "--field")
+        field_names.push_back(args[++I]);
+
+      else if (args[I] == "--time")
+        timesteps.push_back(cdouble(args[++I]));
+
+      else if (args[I] == "--compression")
+        compression = args[++I];
+
+      else if (args[I] == "--nthreads")
+        nthreads = std::max(1, cint(args[++I]));
+
+      else if (args[I] == "--blocks-per-task")
+        blocks_per_task = std::max(1, cint(args[++I]));
+
+      else if (args[I] == "--src-access")
+        src_config = StringTree::fromString(args[++I]);
+
+      else if (args[I] == "--dst-access")
+        dst_config = StringTree::fromString(args[++I]);
+
+      else if (args[I] == "--resume")
+        bResume = true;
+
+      else if (args[I] == "--journal")
+        journal = args[++I];
+
+      else
+        ThrowException(args[0], "Invalid arguments", args[I]);
+    }
+
+    auto src = LoadDataset(src_url);
+    if (!src)
+      ThrowException(args[0], "cannot load", src_url);
+
+    //clone the idx file
+    if (Url(dst_url).isFile() && !FileUtils::existsFile(Url(dst_url).getPath()))
+    {
+      if (!std::dynamic_pointer_cast<IdxDataset>(src))
+        ThrowException(args[0], "cannot create", dst_url, "from a non-IDX dataset");
+
+      IdxFile idxfile = src->idxfile;
+      idxfile.version = 0;             //re-validate
+      idxfile.filename_template = "";  //re-guess (the path can be different)
+      if (!compression.empty())
+      {
+        for (auto& field : idxfile.fields)
+          field.default_compression = compression;
+      }
+      idxfile.save(Url(dst_url).getPath());
+    }
+
+    auto dst = LoadDataset(dst_url);
+    if (!dst)
+      ThrowException(args[0], "cannot load", dst_url);
+
+    if (src->getTotalNumberOfBlocks() != dst->getTotalNumberOfBlocks() || src->getDefaultBitsPerBlock() != dst->getDefaultBitsPerBlock())
+      ThrowException(args[0], "src and dst have different block layouts");
+
+    if (field_names.empty())
+    {
+      for (auto field : src->getFields())
+        field_names.push_back(field.name);
+    }
+
+    if (timesteps.empty())
+      timesteps = src->getTimesteps().asVector();
+
+    //a task never shares a destination file with another task (all fields in the same file are written by the same worker)
+    Int64 blocks_per_file = std::max(1, dst->idxfile.blocksperfile) * std::max(1, dst->idxfile.block_interleaving);
+    blocks_per_task = (int)(((blocks_per_task + blocks_per_file - 1) / blocks_per_file) * blocks_per_file);
+
+    BigInt tot_blocks = src->getTotalNumberOfBlocks();
+    Int64 ntasks_per_time = cint64((tot_blocks + blocks_per_task - 1) / blocks_per_task);
+
+    struct Task
+    {
+      double time;
+      BigInt A, B;
+      String key;
+    };
+
+    //resume
+    std::set<String> done;
+    if (bResume && FileUtils::existsFile(journal))
+    {
+      for (auto line : StringUtils::getNonEmptyLines(Utils::loadTextDocument(journal)))
+        done.insert(StringUtils::trim(line));
+    }
+    else if (FileUtils::existsFile(journal))
+    {
+      FileUtils::removeFile(journal);
+    }
+
+    std::vector<Task> tasks;
+    for (auto time : timesteps)
+    {
+      for (Int64 T = 0; T < ntasks_per_time; T++)
+      {
+        Task task;
+        task.time = time;
+        task.A = BigInt(T) * blocks_per_task;
+        task.B = std::min(tot_blocks, task.A + blocks_per_task);
+        task.key = concatenate(time, " ", task.A, " ", task.B, " ", StringUtils::join(field_names, ","));
+        if (!done.count(task.key))
+          tasks.push_back(task);
+      }
+    }
+
+    PrintInfo("copy-blocks", src_url, "->", dst_url,
+      "fields", StringUtils::join(field_names, " "), "ntimesteps", timesteps.size(), "tot_blocks", tot_blocks,
+      "ntasks", tasks.size(), "already-done", done.size(), "blocks-per-task", blocks_per_task, "nthreads", nthreads);
+
+    //statistics
+    std::atomic<Int64> nread(0), nmissing(0), nwritten(0), nfailed(0), nerrors(0), nbytes(0), ntasks_done(0);
+    auto t1 = Time::now();
+    auto last_report = Time::now();
+    CriticalSection report_lock;
+
+    auto printStats = [&](String what) {
+      auto sec = std::max(0.001, t1.elapsedSec());
+      PrintInfo(what, "tasks", ntasks_done.load(), "/", tasks.size(),
+        "read", nread.load(), "missing", nmissing.load(), "read-errors", nerrors.load(), "written", nwritten.load(), "failed", nfailed.load(),
+        "blocks/sec", (int)(nwritten.load() / sec),
+        "MB/sec", cstring((nbytes.load() / sec) / (1024.0 * 1024.0)),
+        "elapsed-sec", (int)sec);
+    };
+
+    Aborted aborted;
+    std::atomic<int> next(0);
+    nthreads = std::max(1, std::min(nthreads, (int)tasks.size()));
+    auto thread_pool = nthreads > 1 ? std::make_shared<ThreadPool>("CopyBlocks Worker", nthreads) : SharedPtr<ThreadPool>();
+    for (int W = 0; W < nthreads; W++)
+    {
+      ThreadPool::push(thread_pool, [&]()
+      {
+        auto raccess = src->createAccessForBlockQuery(src_config);
+        auto waccess = dst->createAccessForBlockQuery(dst_config);
+        waccess->disableWriteLocks();
+        if (!compression.empty())
+          waccess->compression = compression;
+
+        //issue all the reads of a task (they can be async, for example for remote accesses)
+        auto readTask = [&](const Task& task) {
+          std::vector< SharedPtr<BlockQuery> > ret;
+          raccess->beginRead();
+          for (auto blockid = task.A; blockid < task.B; blockid++)
+          {
+            for (auto field_name : field_names)
+            {
+              auto query = src->createBlockQuery(blockid, src->getField(field_name), task.time, 'r', aborted);
+              src->executeBlockQuery(raccess, query);
+              ret.push_back(query);
+            }
+          }
+          raccess->endRead();
+          return ret;
+        };
+
+        std::vector< SharedPtr<BlockQuery> > reads;
+        int current = next++;
+        if (current < (int)tasks.size())
+          reads = readTask(tasks[current]);
+
+        while (current < (int)tasks.size())
+        {
+          //prefetch the next task while decoding/encoding/writing this one
+          std::vector< SharedPtr<BlockQuery> > next_reads;
+          int following = next++;
+          if (following < (int)tasks.size())
+            next_reads = readTask(tasks[following]);
+
+          bool task_ok = true;
+          waccess->beginWrite();
+          for (auto read : reads)
+          {
+            read->done.get();
+
+            //it can be that the block is not stored, any other failure is a read error (and the task must be retried)
+            if (!read->ok())
+            {
+              if (read->not_stored)
+              {
+                ++nmissing;
+              }
+              else
+              {
+                ++nerrors;
+                ++nfailed;
+                task_ok = false;
+                PrintWarning("copy-blocks read failed time", read->time, "field", read->field.name, "blockid", read->blockid, read->errormsg);
+              }
+              continue;
+            }
+
+            ++nread;
+            src->convertBlockQueryToRowMajor(read);
+
+            auto write = dst->createBlockQuery(read->blockid, dst->getField(read->field.name), read->time, 'w', aborted);
+            write->buffer = read->buffer;
+            if (dst->executeBlockQueryAndWait(waccess, write))
+            {
+              ++nwritten;
+              nbytes += read->buffer.c_size();
+            }
+            else
+            {
+              ++nfailed;
+              task_ok = false;
+              PrintWarning("copy-blocks write failed time", read->time, "field", read->field.name, "blockid", read->blockid, write->errormsg);
+            }
+          }
+
+          //flush the headers before marking the task as done (a failed flush is counted as a write failure)
+          auto wfail = waccess->statistics.wfail.load();
+          waccess->endWrite();
+          if (waccess->statistics.wfail.load() != wfail)
+          {
+            ++nfailed;
+            task_ok = false;
+            PrintWarning("copy-blocks cannot flush headers task", tasks[current].key);
+          }
+
+          {
+            ScopedLock lock(report_lock);
+            if (task_ok)
+              std::ofstream(journal.c_str(), std::ios::app) << tasks[current].key << std::endl;
+            ++ntasks_done;
+            if (last_report.elapsedSec() > 5)
+            {
+              printStats("copy-blocks progress");
+              last_report = Time::now();
+            }
+          }
+
+          reads = next_reads;
+          current = following;
+        }
+      });
+    }
+
+    if (thread_pool)
+      thread_pool->waitAll();
+
+    printStats("copy-blocks done");
+
+    //keep the journal in case of failures
+    if (!nfailed.load())
+      FileUtils::removeFile(journal);
+
+    return data;
+  }
+};
+
 ///////////////////////////////////////////////////////////
 class TestIdxMemory : public VisusConvert::Step
 {
@@ -711,6 +1095,8 @@ VisusConvert::VisusConvert()
   addAction("import", []() {return std::make_shared<ImportData>(); });
   addAction("export", []() {return std::make_shared<ExportData>(); });
   addAction("paste", []() {return std::make_shared<PasteData>(); });
+  addAction("bulk-write", []() {return std::make_shared<BulkWrite>(); });
+  addAction("copy-blocks", []() {return std::make_shared<CopyBlocks>(); });
   addAction("cast", []() {return std::make_shared<Cast>(); });
   addAction("smart-cast", []() {return std::make_shared<SmartCast>(); });
   addAction("crop", []() {return std::make_shared<CropData>(); });
@@ -39,6 +39,9 @@ For support : support@visus.net
 #include <Visus/Encoder.h>
 #include <Visus/IdxDataset.h>
 #include <Visus/File.h>
+#include <Visus/ArrayUtils.h>
+#include <Visus/ModVisus.h>
+#include <Visus/Thread.h>
 
 namespace Visus {
 
@@ -288,6 +291,572 @@ protected:
 }; //end class 
 
 
+////////////////////////////////////////////////////////////////////////////////////
+//destroy an async access while its requests are still running (callbacks must not use the destroyed access)
+static void SelfTestAsyncAccessLifetime()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT8));
+
+  auto filename = "tmp/self_test_idx/temp.idx";
+  idxfile.save(filename);
+  auto dataset = LoadIdxDataset(filename);
+
+  for (int N = 0; N < 10; N++)
+  {
+    //nobody is listening on port 1, all requests fail
+    StringTree config("access");
+    config.write("type", "IdxCloudStorageAccess");
+    config.write("url", "http://127.0.0.1:1/bucket/temp.idx");
+    auto access = dataset->createAccess(config, /*for_block_query*/true);
+
+    std::vector< SharedPtr<BlockQuery> > queries;
+    access->beginRead();
+    for (BigInt blockid = 0; blockid < dataset->getTotalNumberOfBlocks(); blockid++)
+    {
+      auto query = dataset->createBlockQuery(blockid, 'r');
+      dataset->executeBlockQuery(access, query);
+      queries.push_back(query);
+    }
+    access->endRead();
+    access.reset();
+
+    for (auto query : queries)
+    {
+      query->done.get();
+      VisusReleaseAssert(query->failed());
+    }
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//point query with explicit points (no position), enough points to use the workers
+static void SelfTestExplicitPoints()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0, 0), PointNi(64, 64, 64));
+  idxfile.fields.push_back(Field("myfield", DTypes::INT32));
+
+  auto filename = "tmp/self_test_idx/temp.idx";
+  idxfile.save(filename);
+  auto dataset = LoadIdxDataset(filename);
+  auto access = dataset->createAccess();
+
+  auto write = dataset->createBoxQuery(dataset->getLogicBox(), 'w');
+  dataset->beginBoxQuery(write);
+  VisusReleaseAssert(write->isRunning());
+  write->buffer = Array(write->getNumberOfSamples(), DTypes::INT32);
+  auto dst = (Int32*)write->buffer.c_ptr();
+  for (auto loc = ForEachPoint(write->getNumberOfSamples()); !loc.end(); loc.next())
+    *dst++ = (Int32)(loc.pos[0] + 100 * loc.pos[1] + 10000 * loc.pos[2]);
+  VisusReleaseAssert(dataset->executeBoxQuery(access, write));
+
+  int npoints = 1 << 17;
+  Array points(PointNi(3, npoints), DTypes::INT64);
+  auto P = (Int64*)points.c_ptr();
+  for (int I = 0; I < npoints * 3; I++)
+    P[I] = Utils::getRandInteger(0, 63);
+
+  auto query = dataset->createPointQuery(Position(), dataset->getField(), dataset->getTime());
+  query->end_resolutions = { dataset->getMaxResolution() };
+  VisusReleaseAssert(query->setPoints(points));
+  dataset->beginPointQuery(query);
+  VisusReleaseAssert(query->isRunning());
+  VisusReleaseAssert(dataset->executePointQuery(access, query));
+
+  auto values = (Int32*)query->buffer.c_ptr();
+  for (int I = 0; I < npoints; I++)
+    VisusReleaseAssert(values[I] == P[3 * I + 0] + 100 * P[3 * I + 1] + 10000 * P[3 * I + 2]);
+
+  access.reset();
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//encoders round trip (also with a number of samples not multiple of 8, see bitshuffle leftovers)
+static void SelfTestEncoders()
+{
+  for (auto specs : { "zstd", "shuffle+zstd", "shuffle+lz4", "bitshuffle+zstd", "bitshuffle+lz4" })
+  {
+    auto encoder = Encoders::getSingleton()->createEncoder(specs);
+    VisusReleaseAssert(encoder);
+
+    for (auto dtype : { DTypes::UINT8, DTypes::INT16, DTypes::FLOAT32, DTypes::FLOAT64 })
+    {
+      for (Int64 nsamples : { 1, 7, 8, 1001, 65536 })
+      {
+        PointNi dims(1);
+        dims[0] = nsamples;
+
+        auto decoded = std::make_shared<HeapMemory>();
+        VisusReleaseAssert(decoded->resize(dtype.getByteSize(nsamples), __FILE__, __LINE__));
+        for (Int64 I = 0; I < decoded->c_size(); I++)
+          decoded->c_ptr()[I] = (Uint8)(I / 256 + Utils::getRandInteger(0, 3));
+
+        auto encoded = encoder->encode(dims, dtype, decoded);
+        VisusReleaseAssert(encoded);
+        auto check = encoder->decode(dims, dtype, encoded);
+        VisusReleaseAssert(check && HeapMemory::equals(decoded, check));
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//a reader must decode the blocks using only the idx file (block headers store the compression, the idx file the zstd dictionary)
+static void SelfTestCompression()
+{
+  auto dictionary = "tmp/self_test_idx/myfield.dict";
+  {
+    auto content = std::make_shared<HeapMemory>();
+    VisusReleaseAssert(content->resize(4096, __FILE__, __LINE__));
+    for (Int64 I = 0; I < content->c_size(); I++)
+      content->c_ptr()[I] = (Uint8)(I % 7);
+    FileUtils::createDirectory(Path("tmp/self_test_idx"));
+    Utils::saveBinaryDocument(dictionary, content);
+  }
+
+  for (String compression : std::vector<String>({ "zstd", "shuffle+zstd", "bitshuffle+zstd", "bitshuffle+lz4", String("zstd-dict=") + dictionary }))
+  {
+    IdxFile idxfile;
+    idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(128, 128));
+    Field field("myfield", DTypes::UINT16);
+    field.default_compression = compression;
+    idxfile.fields.push_back(field);
+    idxfile.setZstdDictionary(field.name, IdxFile::parseZstdDictionary(compression));
+
+    auto filename = "tmp/self_test_idx/temp.idx";
+    idxfile.save(filename);
+
+    Array data;
+    {
+      auto dataset = LoadIdxDataset(filename);
+      auto access = dataset->createAccess();
+      auto write = dataset->createBoxQuery(dataset->getLogicBox(), 'w');
+      dataset->beginBoxQuery(write);
+      VisusReleaseAssert(write->isRunning());
+      write->buffer = Array(write->getNumberOfSamples(), DTypes::UINT16);
+      auto dst = (Uint16*)write->buffer.c_ptr();
+      for (auto loc = ForEachPoint(write->getNumberOfSamples()); !loc.end(); loc.next())
+        *dst++ = (Uint16)(loc.pos[0] + loc.pos[1] + Utils::getRandInteger(0, 3));
+      VisusReleaseAssert(dataset->executeBoxQuery(access, write));
+      data = write->buffer;
+    }
+
+    //forget the compression in the fields, keep the idx file metadata
+    {
+      auto dataset = LoadIdxDataset(filename);
+      VisusReleaseAssert(dataset->idxfile.getZstdDictionary(dataset->getField()) == IdxFile::parseZstdDictionary(compression));
+      auto idxfile = dataset->idxfile;
+      idxfile.fields[0].default_compression = "";
+      idxfile.save(filename);
+    }
+
+    {
+      auto dataset = LoadIdxDataset(filename);
+      VisusReleaseAssert(dataset->getField().default_compression.empty());
+      auto access = dataset->createAccess();
+      auto read = dataset->createBoxQuery(dataset->getLogicBox(), 'r');
+      dataset->beginBoxQuery(read);
+      VisusReleaseAssert(read->isRunning());
+      VisusReleaseAssert(dataset->executeBoxQuery(access, read));
+      VisusReleaseAssert(read->buffer.c_size() == data.c_size());
+      VisusReleaseAssert(memcmp(read->buffer.c_ptr(), data.c_ptr(), (size_t)data.c_size()) == 0);
+    }
+
+    FileUtils::removeFile(Path("tmp/self_test_idx/temp.idx"));
+    FileUtils::removeDirectory(Path("tmp/self_test_idx/temp"));
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static Array CreateRandomArray(PointNi dims, DType dtype)
+{
+  Array ret(dims, dtype);
+  for (Int64 I = 0; I < ret.c_size(); I++)
+    ret.c_ptr()[I] = (Uint8)Utils::getRandInteger(0, 255);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static bool SameSamples(Array a, Array b)
+{
+  return a.dims == b.dims && a.dtype == b.dtype && memcmp(a.c_ptr(), b.c_ptr(), (size_t)a.c_size()) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//cast and scalar operations, big enough to be split in several chunks
+static void SelfTestArrayTransformSamples()
+{
+  Array src(PointNi(301, 257, 5), DType(3, DTypes::INT16));
+  auto S = (const Int16*)src.c_ptr();
+  for (Int64 I = 0, N = src.getTotalNumberOfSamples() * 3; I < N; I++)
+    ((Int16*)src.c_ptr())[I] = (Int16)Utils::getRandInteger(-32768, 32767);
+
+  auto f32 = ArrayUtils::cast(src, DType(3, DTypes::FLOAT32));
+  VisusReleaseAssert(f32.dims == src.dims && f32.dtype == DType(3, DTypes::FLOAT32));
+
+  auto add = ArrayUtils::add(src, 0.5);
+  VisusReleaseAssert(add.dtype == DType(3, DTypes::FLOAT32));
+
+  auto mul = ArrayUtils::mul(ArrayUtils::cast(src, DType(3, DTypes::FLOAT64)), -2.0);
+  VisusReleaseAssert(mul.dtype == DType(3, DTypes::FLOAT64));
+
+  for (Int64 I = 0, N = src.getTotalNumberOfSamples() * 3; I < N; I++)
+  {
+    VisusReleaseAssert(((Float32*)f32.c_ptr())[I] == (Float32)S[I]);
+    VisusReleaseAssert(((Float32*)add.c_ptr())[I] == (Float32)S[I] + 0.5f);
+    VisusReleaseAssert(((Float64*)mul.c_ptr())[I] == (Float64)S[I] * -2.0);
+  }
+
+  //same type, only the number of components changes
+  auto two = ArrayUtils::withNumberOfComponents(src, 2);
+  for (Int64 I = 0, N = src.getTotalNumberOfSamples(); I < N; I++)
+  {
+    VisusReleaseAssert(((Int16*)two.c_ptr())[2 * I + 0] == S[3 * I + 0]);
+    VisusReleaseAssert(((Int16*)two.c_ptr())[2 * I + 1] == S[3 * I + 1]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//nearest sample resampling, up and down on each axis
+static void SelfTestArrayResample()
+{
+  for (auto dtype : { DTypes::UINT8, DType(3, DTypes::UINT8), DTypes::FLOAT64 })
+  {
+    auto src = CreateRandomArray(PointNi(37, 23, 11), dtype);
+    auto sample_size = dtype.getByteSize();
+
+    for (auto dims : { PointNi(80, 50, 7), PointNi(10, 5, 3), PointNi(37, 1, 22), PointNi(37, 23, 11) })
+    {
+      auto dst = ArrayUtils::resample(dims, src);
+      VisusReleaseAssert(dst.dims == dims && dst.dtype == dtype);
+
+      auto rstride = src.dims.stride();
+      Int64 woffset = 0;
+      for (auto P = ForEachPoint(dims); !P.end(); P.next(), woffset++)
+      {
+        Int64 roffset = 0;
+        for (int D = 0; D < 3; D++)
+          roffset += rstride[D] * Utils::clamp(Int64(P.pos[D] * (src.dims[D] / (double)dims[D])), (Int64)0, src.dims[D] - 1);
+        VisusReleaseAssert(memcmp(dst.c_ptr() + woffset * sample_size, src.c_ptr() + roffset * sample_size, sample_size) == 0);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//range of a component, extremes in the first and in the last chunk
+static void SelfTestArrayComputeRange()
+{
+  Array src(PointNi(2000, 700), DType(2, DTypes::INT32));
+  auto S = (Int32*)src.c_ptr();
+  Int64 N = src.getTotalNumberOfSamples();
+  for (Int64 I = 0; I < 2 * N; I++)
+    S[I] = Utils::getRandInteger(-1000, 1000);
+
+  S[0] = 5000; S[2 * (N - 1)] = -7000;
+  S[2 * (N - 1) + 1] = 3000; S[1] = -4000;
+
+  auto range0 = ArrayUtils::computeRange(src, 0);
+  auto range1 = ArrayUtils::computeRange(src, 1);
+  VisusReleaseAssert(range0.from == -7000 && range0.to == 5000);
+  VisusReleaseAssert(range1.from == -4000 && range1.to == 3000);
+
+  Array values(3 * 1024 * 1024 + 17, DTypes::FLOAT32);
+  auto V = (Float32*)values.c_ptr();
+  Float32 m = NumericLimits<Float32>::highest(), M = NumericLimits<Float32>::lowest();
+  for (Int64 I = 0; I < values.getTotalNumberOfSamples(); I++)
+  {
+    V[I] = (Float32)Utils::getRandDouble(-1e6, 1e6);
+    m = std::min(m, V[I]);
+    M = std::max(M, V[I]);
+  }
+
+  auto range = ArrayUtils::computeRange(values, 0);
+  VisusReleaseAssert(range.from == m && range.to == M);
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static Array CreateRandomArrayWithAlpha(PointNi dims, DType dtype)
+{
+  auto ret = CreateRandomArray(dims, dtype);
+  ret.alpha = std::make_shared<Array>(dims, DTypes::UINT8);
+  for (Int64 I = 0; I < ret.alpha->c_size(); I++)
+    ret.alpha->c_ptr()[I] = Utils::getRandInteger(0, 3) ? 255 : 0;
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//a warp of a sub-region at an offset must be the same region of the full warp
+static void SelfTestArrayWarpPerspective()
+{
+  for (int pdim = 2; pdim <= 3; pdim++)
+  {
+    auto src = CreateRandomArrayWithAlpha(pdim == 2 ? PointNi(97, 61) : PointNi(37, 29, 23), DTypes::UINT16);
+    auto dims = pdim == 2 ? PointNi(150, 120) : PointNi(60, 50, 40);
+    auto offset = pdim == 2 ? PointNi(13, 17) : PointNi(5, 9, 3);
+    auto sub_dims = pdim == 2 ? PointNi(70, 50) : PointNi(30, 20, 25);
+
+    auto T = 
+      Matrix::translate(pdim == 2 ? PointNd(40.5, 30.25) : PointNd(10.5, 7.25, 3.0)) * 
+      Matrix::scale(pdim == 2 ? PointNd(1.3, 0.7) : PointNd(1.3, 0.7, 1.1));
+    T(pdim, 0) = 0.0005; //some perspective
+
+    Array full(dims, src.dtype);
+    full.fillWithValue(0);
+    full.alpha = std::make_shared<Array>(dims, DTypes::UINT8);
+    full.alpha->fillWithValue(0);
+    VisusReleaseAssert(ArrayUtils::warpPerspective(full, T, src, Aborted()));
+
+    Array sub(sub_dims, src.dtype);
+    sub.fillWithValue(0);
+    sub.alpha = std::make_shared<Array>(sub_dims, DTypes::UINT8);
+    sub.alpha->fillWithValue(0);
+    VisusReleaseAssert(ArrayUtils::warpPerspective(sub, T, src, offset, Aborted()));
+
+    auto check = ArrayUtils::crop(full, BoxNi(offset, offset + sub_dims));
+    auto check_alpha = ArrayUtils::crop(*full.alpha, BoxNi(offset, offset + sub_dims));
+    VisusReleaseAssert(SameSamples(sub, check) && SameSamples(*sub.alpha, check_alpha));
+
+    //an integer translation is a plain copy
+    auto shift = pdim == 2 ? PointNi(7, 4) : PointNi(7, 4, 2);
+    Array moved(dims, src.dtype);
+    moved.fillWithValue(0);
+    moved.alpha = std::make_shared<Array>(dims, DTypes::UINT8);
+    moved.alpha->fillWithValue(0);
+    VisusReleaseAssert(ArrayUtils::warpPerspective(moved, Matrix::translate(shift.castTo<PointNd>()), src, Aborted()));
+    VisusReleaseAssert(SameSamples(ArrayUtils::crop(moved, BoxNi(shift, shift + src.dims)), src));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//a blend argument at an offset must be the same as a full size argument transparent outside
+static void SelfTestArrayBlend()
+{
+  for (auto type : { BlendBuffers::NoBlend, BlendBuffers::GenericBlend, BlendBuffers::AverageBlend })
+  {
+    for (int pdim = 2; pdim <= 3; pdim++)
+    {
+      auto dims = pdim == 2 ? PointNi(90, 70) : PointNi(30, 25, 20);
+      auto offset = pdim == 2 ? PointNi(11, 23) : PointNi(3, 5, 7);
+      auto sub_dims = pdim == 2 ? PointNi(40, 30) : PointNi(20, 10, 9);
+
+      auto first = CreateRandomArrayWithAlpha(dims, DTypes::UINT8);
+      auto second = CreateRandomArrayWithAlpha(sub_dims, DTypes::UINT8);
+
+      Array embedded(dims, second.dtype);
+      embedded.fillWithValue(0);
+      embedded.alpha = std::make_shared<Array>(dims, DTypes::UINT8);
+      embedded.alpha->fillWithValue(0);
+      VisusReleaseAssert(ArrayUtils::paste(embedded, offset, second));
+      VisusReleaseAssert(ArrayUtils::paste(*embedded.alpha, offset, *second.alpha));
+
+      BlendBuffers a(type, Aborted());
+      a.addBlendArg(first);
+      a.addBlendArg(second, offset, dims);
+
+      BlendBuffers b(type, Aborted());
+      b.addBlendArg(first);
+      b.addBlendArg(embedded);
+
+      VisusReleaseAssert(SameSamples(a.result, b.result) && SameSamples(*a.result.alpha, *b.result.alpha));
+
+      //the first argument at an offset allocates the whole result
+      BlendBuffers c(type, Aborted());
+      c.addBlendArg(second, offset, dims);
+
+      BlendBuffers d(type, Aborted());
+      d.addBlendArg(embedded);
+
+      VisusReleaseAssert(SameSamples(c.result, d.result) && SameSamples(*c.result.alpha, *d.result.alpha));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//dense clamp-to-edge correlation, one sample at a time
+static Array ConvolveReference(Array src, Array kernel)
+{
+  int ncomponents = src.dtype.ncomponents();
+  auto S = ArrayUtils::cast(src, DType(ncomponents, DTypes::FLOAT64));
+  auto K = (const Float64*)kernel.c_ptr();
+
+  Array ret(src.dims, DType(ncomponents, DTypes::FLOAT64));
+  auto W = (Float64*)ret.c_ptr();
+
+  int pdim = src.dims.getPointDim();
+  auto center = kernel.dims.rightShift(1);
+  auto stride = src.dims.stride();
+  for (auto P = ForEachPoint(src.dims); !P.end(); P.next())
+  {
+    for (int C = 0; C < ncomponents; C++)
+    {
+      Float64 sum = 0.0;
+      Int64 koffset = 0;
+      for (auto Q = ForEachPoint(kernel.dims); !Q.end(); Q.next(), koffset++)
+      {
+        Int64 roffset = 0;
+        for (int D = 0; D < pdim; D++)
+          roffset += stride[D] * Utils::clamp(P.pos[D] + Q.pos[D] - center[D], (Int64)0, src.dims[D] - 1);
+        sum += K[koffset] * ((const Float64*)S.c_ptr())[roffset * ncomponents + C];
+      }
+      *W++ = sum;
+    }
+  }
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static Array CreateRandomKernel(PointNi dims)
+{
+  Array ret(dims, DTypes::FLOAT64);
+  for (Int64 I = 0; I < ret.getTotalNumberOfSamples(); I++)
+    ((Float64*)ret.c_ptr())[I] = Utils::getRandDouble(-1.0, 1.0);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//separable, FFT and dense paths must give the clamp-to-edge dense result
+static void SelfTestArrayConvolve()
+{
+  std::vector< std::pair<PointNi, Array> > args;
+
+  //1D and separable kernels
+  args.push_back(std::make_pair(PointNi(120, 90), CreateRandomKernel(PointNi(5, 1))));
+  {
+    Array kernel(PointNi(7, 5), DTypes::FLOAT64);
+    auto x = CreateRandomKernel(PointNi(7, 1)), y = CreateRandomKernel(PointNi(1, 5));
+    for (auto P = ForEachPoint(kernel.dims); !P.end(); P.next())
+      ((Float64*)kernel.c_ptr())[P.pos[0] + 7 * P.pos[1]] = ((Float64*)x.c_ptr())[P.pos[0]] * ((Float64*)y.c_ptr())[P.pos[1]];
+    args.push_back(std::make_pair(PointNi(120, 90), kernel));
+  }
+
+  //big non separable kernel (FFT) and small ones (dense, also more than 3D)
+  args.push_back(std::make_pair(PointNi(200, 150), CreateRandomKernel(PointNi(31, 31))));
+  args.push_back(std::make_pair(PointNi(24, 20, 18), CreateRandomKernel(PointNi(3, 3, 3))));
+  args.push_back(std::make_pair(PointNi(9, 8, 7, 6), CreateRandomKernel(PointNi(3, 3, 3, 3))));
+
+  for (auto it : args)
+  {
+    Array src(it.first, DTypes::FLOAT32);
+    for (Int64 I = 0; I < src.getTotalNumberOfSamples(); I++)
+      ((Float32*)src.c_ptr())[I] = (Float32)Utils::getRandDouble(-100.0, 100.0);
+
+    auto kernel = it.second;
+    auto check = ConvolveReference(src, kernel);
+
+    double tolerance = 0.0;
+    for (Int64 I = 0; I < kernel.getTotalNumberOfSamples(); I++)
+      tolerance += std::fabs(((Float64*)kernel.c_ptr())[I]);
+    tolerance *= 100.0 * 1e-9;
+
+    auto dst = ArrayUtils::convolve(src, kernel);
+    VisusReleaseAssert(dst.dims == src.dims && dst.dtype == DTypes::FLOAT64);
+
+    auto dst32 = ArrayUtils::convolve(src, kernel, DTypes::FLOAT32);
+    VisusReleaseAssert(dst32.dims == src.dims && dst32.dtype == DTypes::FLOAT32);
+
+    for (Int64 I = 0; I < src.getTotalNumberOfSamples(); I++)
+    {
+      auto value = ((Float64*)check.c_ptr())[I];
+      VisusReleaseAssert(std::fabs(((Float64*)dst.c_ptr())[I] - value) <= tolerance);
+      VisusReleaseAssert(std::fabs(((Float32*)dst32.c_ptr())[I] - value) <= tolerance + std::fabs(value) * 1e-6);
+    }
+  }
+
+  //integer output keeps the components, rounded and saturated (a sharpen kernel has integer results)
+  {
+    auto src = CreateRandomArray(PointNi(64, 48), DType(3, DTypes::UINT8));
+    Array kernel(PointNi(3, 3), DTypes::FLOAT64);
+    Float64 sharpen[9] = { 0, -1, 0, -1, 5, -1, 0, -1, 0 };
+    memcpy(kernel.c_ptr(), sharpen, sizeof(sharpen));
+
+    auto check = ConvolveReference(src, kernel);
+    auto dst = ArrayUtils::convolve(src, kernel, DType());
+    VisusReleaseAssert(dst.dims == src.dims && dst.dtype == src.dtype);
+    for (Int64 I = 0; I < src.getTotalNumberOfSamples() * 3; I++)
+      VisusReleaseAssert(dst.c_ptr()[I] == (Uint8)Utils::clamp(((Float64*)check.c_ptr())[I], 0.0, 255.0));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static void WriteSelfTestBox(String filename, BoxNi box, Int32 value)
+{
+  auto dataset = LoadIdxDataset(filename);
+  auto access = dataset->createAccess();
+  auto write = dataset->createBoxQuery(box, 'w');
+  dataset->beginBoxQuery(write);
+  VisusReleaseAssert(write->isRunning());
+  write->buffer = Array(write->getNumberOfSamples(), DTypes::INT32);
+  for (Int64 I = 0; I < write->buffer.getTotalNumberOfSamples(); I++)
+    ((Int32*)write->buffer.c_ptr())[I] = value;
+  VisusReleaseAssert(dataset->executeBoxQuery(access, write));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//mod_visus response cache: conditional GETs, missing blocks are cached, rewrites of the data files change the ETag
+static void SelfTestModVisusCache()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0, 0), PointNi(64, 64, 64));
+  idxfile.fields.push_back(Field("myfield", DTypes::INT32));
+  idxfile.bitsperblock = 12;
+
+  auto filename = "tmp/self_test_idx/temp.idx";
+  idxfile.save(filename);
+
+  //the finest blocks of the upper half are not stored
+  auto box = BoxNi(PointNi(0, 0, 0), PointNi(64, 64, 16));
+  WriteSelfTestBox(filename, box, 1);
+
+  auto modvisus = std::make_shared<ModVisus>();
+  VisusReleaseAssert(modvisus->configureDatasets(ConfigFile::fromString(concatenate(
+    "<visus><Configuration><ModVisus version_ttl='0' /></Configuration>",
+    "<dataset name='selftest' url='file://", GetCurrentWorkingDirectory(), "/", filename, "' permissions='public' /></visus>"))));
+
+  auto blockQuery = [&](String etag) 
+  {
+    Url url("http://localhost/mod_visus");
+    url.setParam("action", "blockquery");
+    url.setParam("dataset", "selftest");
+    url.setParam("field", "myfield");
+    url.setParam("time", "0");
+    url.setParam("compression", "raw");
+    url.setParam("block", "0 63");
+    NetRequest request(url);
+    if (!etag.empty())
+      request.setHeader("If-None-Match", etag);
+    return modvisus->handleRequest(request);
+  };
+
+  auto first = blockQuery("");
+  auto etag = first.getHeader("ETag");
+  VisusReleaseAssert(first.status == HttpStatus::STATUS_OK && !etag.empty());
+
+  auto parts = NetResponse::decompose(first);
+  VisusReleaseAssert(parts.size() == 2 && parts[0].status == HttpStatus::STATUS_OK && parts[1].status == HttpStatus::STATUS_NOT_FOUND);
+
+  VisusReleaseAssert(blockQuery(etag).status == HttpStatus::STATUS_NOT_MODIFIED);
+
+  //modification times have a resolution of one second
+  Thread::sleep(1100);
+  WriteSelfTestBox(filename, box, 2);
+
+  auto second = blockQuery(etag);
+  VisusReleaseAssert(second.status == HttpStatus::STATUS_OK && second.getHeader("ETag") != etag);
+  auto check = NetResponse::decompose(second);
+  VisusReleaseAssert(check.size() == 2 && check[0].status == HttpStatus::STATUS_OK && !HeapMemory::equals(check[0].body, parts[0].body));
+
+  modvisus.reset();
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
 /////////////////////////////////////////////////////
 void SelfTestIdx(int max_seconds)
 {
@@ -320,6 +889,50 @@ void SelfTestIdx(int max_seconds)
   }
 #endif
 
+  PrintInfo("Running SelfTestEncoders...");
+  SelfTestEncoders();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestCompression...");
+  SelfTestCompression();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestExplicitPoints...");
+  SelfTestExplicitPoints();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestAsyncAccessLifetime...");
+  SelfTestAsyncAccessLifetime();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestArrayTransformSamples...");
+  SelfTestArrayTransformSamples();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestArrayResample...");
+  SelfTestArrayResample();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestArrayComputeRange...");
+  SelfTestArrayComputeRange();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestArrayWarpPerspective...");
+  SelfTestArrayWarpPerspective();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestArrayBlend...");
+  SelfTestArrayBlend();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestArrayConvolve...");
+  SelfTestArrayConvolve();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestModVisusCache...");
+  SelfTestModVisusCache();
+  PrintInfo("...done");
+
   ////do self testing on random field
   PrintInfo("Running self test procedure max_seconds", max_seconds, "...");
 
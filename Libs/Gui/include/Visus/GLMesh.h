@@ -56,11 +56,17 @@ public:
   SharedPtr<GLArrayBuffer> normals;
   SharedPtr<GLArrayBuffer> colors;
   SharedPtr<GLArrayBuffer> texcoords;
+  SharedPtr<HeapMemory>    indices; //optional Uint32 indices, if present the batch is drawn with glDrawElements
 
   //getNumberOfVertices
   int getNumberOfVertices() const{
     return vertices? vertices->getNumberOfVertices() : 0;
   }
+
+  //getNumberOfIndices
+  int getNumberOfIndices() const {
+    return indices ? (int)(indices->c_size() / sizeof(Uint32)) : 0;
+  }
 };
 
 
@@ -132,6 +138,9 @@ public:
   void texcoord3(const Point3d& p) { texcoord3(p[0], p[1], p[2]); }
   void texcoord3(const PointNd& p) { texcoord3(p.toPoint3()); }
 
+  //addIndexedBatch (vertices and indices are flushed as a single batch, the primitive must be set by begin)
+  void addIndexedBatch(const std::vector<Point3f>& vertices, const std::vector<Uint32>& indices);
+
   //hasColorAttribute
   bool hasColorAttribute() const {
     return !batches.empty() && batches[0].colors;
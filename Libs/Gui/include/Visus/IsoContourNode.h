@@ -42,6 +42,8 @@ For support : support@visus.net
 #include <Visus/Gui.h>
 #include <Visus/Dataflow.h>
 #include <Visus/Range.h>
+#include <Visus/CriticalSection.h>
+#include <Visus/ThreadPool.h>
 #include <Visus/GLTexture.h>
 #include <Visus/GLMesh.h>
 #include <Visus/TransferFunction.h>
@@ -79,6 +81,25 @@ class VISUS_GUI_API MarchingCube
 {
 public:
 
+#if !SWIG
+  //min/max of the data for each brick of cells, can be reused as long as the data does not change (i.e. only the isovalue is moving)
+  class Bricks
+  {
+  public:
+
+    SharedPtr<HeapMemory> heap; //the data the bricks have been computed for
+    PointNi               dims;
+    int                   size = 8; //number of cells for each axis
+    PointNi               nbricks;
+    std::vector<double>   vmin;
+    std::vector<double>   vmax;
+
+    //isValidFor
+    bool isValidFor(const Array& data) const {
+      return heap && heap == data.heap && dims == data.dims;
+    }
+  };
+#endif
 
   Array    data;
   double   isovalue = 0;
@@ -86,6 +107,11 @@ public:
   int      vertices_per_batch = 16 * 1024;
   Aborted  aborted;
 
+#if !SWIG
+  SharedPtr<Bricks>     bricks; //optional, (re)computed by run() if not valid for data
+  SharedPtr<ThreadPool> thread_pool; //optional, if null run() creates a temporary one
+#endif
+
   //constructor
   MarchingCube(Array data_,double isovalue_, Aborted aborted_=Aborted())
     : data(data_),isovalue(isovalue_),aborted(aborted_) {
@@ -94,6 +120,9 @@ public:
   //run
   SharedPtr<IsoContour> run();
 
+  //getDefaultNumberOfThreads (VISUS_MARCHING_CUBE_NUM_THREADS can override it)
+  static int getDefaultNumberOfThreads();
+
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -165,6 +194,12 @@ private:
 
   Range last_field_range;
 
+#if !SWIG
+  CriticalSection                    bricks_lock;
+  SharedPtr<MarchingCube::Bricks>    last_bricks;
+  SharedPtr<ThreadPool>              thread_pool; //created by the first job, kept for all the others
+#endif
+
   double isovalue=0;
 
   //modelChanged
@@ -646,7 +646,10 @@ void GLCanvas::glRenderMesh(const GLMesh& mesh)
     int C=-1; if (batch.colors   ) batch.colors   ->enableForAttribute(*this,C=program->getAttributeLocation(GLAttribute::a_color));
     int T=-1; if (batch.texcoords) batch.texcoords->enableForAttribute(*this,T=program->getAttributeLocation(GLAttribute::a_texcoord));
 
-    glDrawArrays(mesh.primitive,0,batch.getNumberOfVertices());
+    if (batch.indices)
+      glDrawElements(mesh.primitive,batch.getNumberOfIndices(),GL_UNSIGNED_INT,batch.indices->c_ptr());
+    else
+      glDrawArrays(mesh.primitive,0,batch.getNumberOfVertices());
 
     if (batch.vertices ) batch.vertices ->disableForAttribute(*this,P);
     if (batch.normals  ) batch.normals  ->disableForAttribute(*this,N);
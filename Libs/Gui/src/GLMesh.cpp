@@ -103,6 +103,21 @@ void GLMesh::flush()
   this->building.vertices_per_batch=0;
 }
 
+///////////////////////////////////////////////
+void GLMesh::addIndexedBatch(const std::vector<Point3f>& vertices, const std::vector<Uint32>& indices)
+{
+  if (vertices.empty() || indices.empty())
+    return;
+
+  VisusAssert(building.vertices.empty());
+
+  GLBatch batch;
+  int nvertices = (int)vertices.size();
+  batch.vertices = std::make_shared<GLArrayBuffer>(DTypes::FLOAT32_RGB, nvertices, HeapMemory::createManaged((Uint8*)&vertices[0][0], nvertices * sizeof(Point3f)));
+  batch.indices  = HeapMemory::createManaged((Uint8*)&indices[0], indices.size() * sizeof(Uint32));
+  this->batches.push_back(batch);
+}
+
 
 ///////////////////////////////////////////////////////////////
 GLMesh GLMesh::SolidSphere(const int N)
@@ -38,6 +38,7 @@ For support : support@visus.net
 
 #include <Visus/IsoContourNode.h>
 #include <Visus/Dataflow.h>
+#include <Visus/ThreadPool.h>
 
 #if __GNUC__ && !__APPLE__
 #pragma GCC diagnostic ignored "-Wnarrowing"
@@ -344,12 +345,28 @@ static const int TriangleTable[256][16] =
 };
 
 
+//for each cube edge: offset of the first point and axis (0=x 1=y 2=z), edge goes from the first point to first point+axis
+static const int EdgePoints[12][4] =
+{
+  {0,0,0, 0}, {1,0,0, 1}, {0,1,0, 0}, {0,0,0, 1},
+  {0,0,1, 0}, {1,0,1, 1}, {0,1,1, 0}, {0,0,1, 1},
+  {0,0,0, 2}, {1,0,0, 2}, {1,1,0, 2}, {0,1,0, 2}
+};
+
 class MarchingCubeOp : public MarchingCube
 {
 public:
 
   SharedPtr<IsoContour> isocontour = std::make_shared<IsoContour>();
-  int ntriangles = 0;
+  Int64 ntriangles = 0;
+
+  //one slab of cells along z, each slab produces its own indexed batch
+  struct Slab
+  {
+    int                  z1 = 0, z2 = 0;
+    std::vector<Point3f> vertices;
+    std::vector<Uint32>  indices;
+  };
 
   //constructor
   MarchingCubeOp(MarchingCube& specs) : MarchingCube(specs){
@@ -374,7 +391,44 @@ public:
 
     VisusReleaseAssert(data.dtype.ncomponents()==1);
     isocontour.field = data;
-    isocontour.range = ArrayUtils::computeRange(data, 0, aborted);
+
+    // see http://local.wasp.uwa.edu.au/~pbourke/geometry/polygonise/
+    isocontour.begin(GL_TRIANGLES, vertices_per_batch);
+
+    //no cells
+    if (dims.getPointDim() < 3 || dims[0] < 2 || dims[1] < 2 || dims[2] < 2)
+    {
+      isocontour.range = ArrayUtils::computeRange(data, 0, aborted);
+      isocontour.end();
+      return true;
+    }
+
+    int nthreads = getDefaultNumberOfThreads();
+
+    auto thread_pool = this->thread_pool;
+    if (!thread_pool && nthreads > 1)
+      thread_pool = std::make_shared<ThreadPool>("MarchingCube Worker", nthreads);
+
+    //wait only for the tasks of this run (the pool can be shared)
+    auto runParallel = [&](int ntasks, std::function<void(int)> fn) {
+      Semaphore ndone;
+      for (int T = 0; T < ntasks; T++)
+        ThreadPool::push(thread_pool, [fn, T, &ndone]() {fn(T); ndone.up(); });
+      for (int T = 0; T < ntasks; T++)
+        ndone.down();
+    };
+
+    //min/max for each brick (can be reused if only the isovalue changed)
+    if (!bricks || !bricks->isValidFor(data))
+    {
+      bricks = computeBricks<CppType>(runParallel);
+      if (!bricks)
+        return false;
+    }
+
+    isocontour.range = Range(
+      *std::min_element(bricks->vmin.begin(), bricks->vmin.end()),
+      *std::max_element(bricks->vmax.begin(), bricks->vmax.end()), 0);
 
     //IsoContourenderNode NEEDS the vertices in pixel domain (for computing normals on GPU)
     CppType* voxel_used = nullptr;
@@ -385,156 +439,248 @@ public:
       voxel_used = isocontour.voxel_used.c_ptr<CppType*>();
     }
 
-    // see http://local.wasp.uwa.edu.au/~pbourke/geometry/polygonise/
-    isocontour.begin(GL_TRIANGLES, vertices_per_batch);
+    //a few slabs for each thread, aligned to bricks (vertices on the boundary between two slabs are duplicated)
+    auto S = bricks->size;
+    int nbricksz = (int)bricks->nbricks[2];
+    int bricks_per_slab = std::max(1, nbricksz / (4 * nthreads));
+    std::vector<Slab> slabs((nbricksz + bricks_per_slab - 1) / bricks_per_slab);
+    for (int I = 0; I < (int)slabs.size(); I++)
+    {
+      slabs[I].z1 = (int)std::min<Int64>(dims[2] - 1, (Int64)I * bricks_per_slab * S);
+      slabs[I].z2 = (int)std::min<Int64>(dims[2] - 1, (Int64)(I + 1) * bricks_per_slab * S);
+    }
 
-    const CppType* field = isocontour.field.c_ptr<CppType*>();
+    runParallel((int)slabs.size(), [&](int I) {
+      processSlab<CppType>(slabs[I], voxel_used);
+    });
 
-    const int stridex = 1;
-    const int stridey = stridex * dims[0];
-    const int stridez = stridey * dims[1];
+    if (aborted())
+      return false;
 
-    const int cube_strides[8] =
+    for (auto& slab : slabs)
     {
-      0,                           //(x  ,y  ,z  )
-      stridex,                     //(x+1,y  ,z  )
-      stridex + stridey,           //(x+1,y+1,z  )
-      stridey,                     //(x  ,y+1,z  )
-      stridez,                     //(x  ,y  ,z+1)
-      stridex + stridez,           //(x+1,y  ,z+1)
-      stridex + stridey + stridez, //(x_1,y+1,z+1)
-      stridey + stridez            //(x  ,y+1,z+1)
-    };
-
-    double v[12][3]; //vertices
-
-    std::ofstream ofile;
+      isocontour.addIndexedBatch(slab.vertices, slab.indices);
+      ntriangles += slab.indices.size() / 3;
+    }
+    isocontour.end();
 
     //example of exporting OBJ file
     if (false)
     {
       String filename = cstring("mesh.", StringUtils::getDateTimeForFilename(), ".obj");
-      ofile.open(filename.c_str());
+      std::ofstream ofile(filename.c_str());
+      Int64 offset = 1;
+      for (auto& slab : slabs)
+      {
+        for (auto p : slab.vertices)
+          ofile << "v " << cstring(p[0], p[1], p[2]) << std::endl;
+        for (int I = 0; I < (int)slab.indices.size(); I += 3)
+          ofile << "f " << cstring(offset + slab.indices[I + 0], offset + slab.indices[I + 1], offset + slab.indices[I + 2]) << std::endl;
+        offset += slab.vertices.size();
+      }
     }
 
-    auto PushTriangle =[&](const double* p0, const double* p1, const double* p2){
-      isocontour.vertex(float(p0[0]), float(p0[1]), float(p0[2]));
-      isocontour.vertex(float(p1[0]), float(p1[1]), float(p1[2]));
-      isocontour.vertex(float(p2[0]), float(p2[1]), float(p2[2]));
+    PrintInfo("Marching cube on",dims,"ntriangles",ntriangles,"nslabs",slabs.size(),"done in",t1.elapsedMsec(),"msec");
+    return true;
+  }
+
+private:
+
+  //computeBricks
+  template <class CppType>
+  SharedPtr<Bricks> computeBricks(std::function<void(int, std::function<void(int)>)> runParallel)
+  {
+    auto ret = std::make_shared<Bricks>();
+    ret->heap = data.heap;
+    ret->dims = data.dims;
 
-      if (ofile.is_open())
+    auto dims = data.dims;
+    auto S = ret->size;
+    ret->nbricks = PointNi(
+      (dims[0] - 1 + S - 1) / S,
+      (dims[1] - 1 + S - 1) / S,
+      (dims[2] - 1 + S - 1) / S);
+    auto nbricks = ret->nbricks;
+    ret->vmin.resize(nbricks.innerProduct());
+    ret->vmax.resize(nbricks.innerProduct());
+
+    const CppType* field = data.c_ptr<CppType*>();
+    const Int64 stridey = dims[0];
+    const Int64 stridez = dims[0] * dims[1];
+
+    //a brick includes the points on its upper boundary too
+    runParallel((int)nbricks[2], [&](int BZ)
+    {
+      for (Int64 BY = 0; BY < nbricks[1]; BY++)
       {
-        ofile << "v " << cstring(p0[0], p0[1], p0[2]) << std::endl;
-        ofile << "v " << cstring(p1[0], p1[1], p1[2]) << std::endl;
-        ofile << "v " << cstring(p2[0], p2[1], p2[2]) << std::endl;
-        ofile << "f " << cstring(ntriangles * 3 + 1, ntriangles * 3 + 2, ntriangles * 3 + 3) << std::endl;
+        if (aborted())
+          return;
+
+        for (Int64 BX = 0; BX < nbricks[0]; BX++)
+        {
+          CppType m = field[BX * S + BY * S * stridey + BZ * S * stridez], M = m;
+          for (Int64 z = BZ * S, zend = std::min<Int64>(z + S, dims[2] - 1); z <= zend; z++)
+          {
+            for (Int64 y = BY * S, yend = std::min<Int64>(y + S, dims[1] - 1); y <= yend; y++)
+            {
+              const CppType* row = field + y * stridey + z * stridez;
+              for (Int64 x = BX * S, xend = std::min<Int64>(x + S, dims[0] - 1); x <= xend; x++)
+              {
+                if (row[x] < m) m = row[x];
+                if (M < row[x]) M = row[x];
+              }
+            }
+          }
+          auto B = BX + nbricks[0] * (BY + nbricks[1] * BZ);
+          ret->vmin[B] = (double)m;
+          ret->vmax[B] = (double)M;
+        }
       }
-      ++ntriangles;
+    });
+
+    return aborted() ? SharedPtr<Bricks>() : ret;
+  }
 
+  //processSlab
+  template <class CppType>
+  void processSlab(Slab& slab, CppType* voxel_used)
+  {
+    auto dims = data.dims;
+    auto S = bricks->size;
+    auto nbricks = bricks->nbricks;
+
+    const CppType* field = data.c_ptr<CppType*>();
+    const Int64 X = dims[0], Y = dims[1];
+    const Int64 stridey = X;
+    const Int64 stridez = X * Y;
+
+    //edge caches: x and y edges for two planes of points (z parity), z edges for the current layer of cells
+    //entries are validated against the edge id of the vertex, so they never need to be cleared
+    std::vector<Int32> cache[5];
+    std::vector<Int64> vertex_edge;
+
+    const Int64 cube_strides[8] = {
+      0,                 //(x  ,y  ,z  )
+      1,                 //(x+1,y  ,z  )
+      1 + stridey,       //(x+1,y+1,z  )
+      stridey,           //(x  ,y+1,z  )
+      stridez,           //(x  ,y  ,z+1)
+      1 + stridez,       //(x+1,y  ,z+1)
+      1 + stridey + stridez, //(x+1,y+1,z+1)
+      stridey + stridez  //(x  ,y+1,z+1)
     };
 
-    for (int z = 0; (z < dims[2] - 1); z++)
+    auto getVertex = [&](Int64 x, Int64 y, Int64 z, int E) -> Uint32
     {
-      for (int y = 0; (y < dims[1] - 1); y++)
-      {
-        for (int x = 0; (x < dims[0] - 1); x++)
-        {
-          //stop signal!
-          if (aborted())
-            return false;
+      auto px = x + EdgePoints[E][0], py = y + EdgePoints[E][1], pz = z + EdgePoints[E][2];
+      int axis = EdgePoints[E][3];
+      auto point = px + py * stridey + pz * stridez;
+      auto edge  = 3 * point + axis;
+      auto& slot = cache[axis == 2 ? 4 : 2 * (pz & 1) + axis][px + py * X];
+
+      if (slot >= 0 && slot < (Int32)vertex_edge.size() && vertex_edge[slot] == edge)
+        return (Uint32)slot;
+
+      auto other = point + (axis == 0 ? 1 : (axis == 1 ? stridey : stridez));
+      double a = (double)field[point], b = (double)field[other];
+      double alpha = (a == b) ? 0.5 : (isovalue - a) / (b - a);
+      Point3f p((float)px, (float)py, (float)pz);
+      p[axis] += (float)alpha;
+
+      slot = (Int32)slab.vertices.size();
+      slab.vertices.push_back(p);
+      vertex_edge.push_back(edge);
+      return (Uint32)slot;
+    };
 
-          int index = x * stridex + y * stridey + z * stridez;
+    for (Int64 z = slab.z1; z < slab.z2; z++)
+    {
+      auto BZ = z / S;
+      for (Int64 BY = 0; BY < nbricks[1]; BY++)
+      {
+        //stop signal!
+        if (aborted())
+          return;
 
-          //field values
-          double values[8] =
-          {
-            (double)field[index + cube_strides[0]],
-            (double)field[index + cube_strides[1]],
-            (double)field[index + cube_strides[2]],
-            (double)field[index + cube_strides[3]],
-            (double)field[index + cube_strides[4]] ,
-            (double)field[index + cube_strides[5]] ,
-            (double)field[index + cube_strides[6]],
-            (double)field[index + cube_strides[7]]
-          };
-
-          int L =
-              (values[0] < isovalue ? 1 : 0)
-            | (values[1] < isovalue ? 2 : 0)
-            | (values[2] < isovalue ? 4 : 0)
-            | (values[3] < isovalue ? 8 : 0)
-            | (values[4] < isovalue ? 16 : 0)
-            | (values[5] < isovalue ? 32 : 0)
-            | (values[6] < isovalue ? 64 : 0)
-            | (values[7] < isovalue ? 128 : 0);
-
-          int et = EdgeTable[L];
-
-          if (!et)
+        for (Int64 BX = 0; BX < nbricks[0]; BX++)
+        {
+          //the isosurface does not cross the brick
+          auto B = BX + nbricks[0] * (BY + nbricks[1] * BZ);
+          if (bricks->vmax[B] < isovalue || bricks->vmin[B] >= isovalue)
             continue;
 
-          if (voxel_used)
-            voxel_used[index] = 1;
-
-          double cube_points[8][3] =
+          if (cache[0].empty())
           {
-            {(double)x    ,(double)y    ,(double)z    },
-            {(double)x + 1,(double)y    ,(double)z    },
-            {(double)x + 1,(double)y + 1,(double)z    },
-            {(double)x    ,(double)y + 1,(double)z    },
-            {(double)x    ,(double)y    ,(double)z + 1},
-            {(double)x + 1,(double)y    ,(double)z + 1},
-            {(double)x + 1,(double)y + 1,(double)z + 1},
-            {(double)x    ,(double)y + 1,(double)z + 1}
-          };
-
-    #define INTERPOLATE(d,a,b) \
-    { \
-      const double alpha=((values[a]==values[b])?(0.5):(isovalue-values[a])/(values[b]-values[a]));\
-      v[d][0]=cube_points[a][0] + alpha*(cube_points[b][0]-cube_points[a][0]);\
-      v[d][1]=cube_points[a][1] + alpha*(cube_points[b][1]-cube_points[a][1]);\
-      v[d][2]=cube_points[a][2] + alpha*(cube_points[b][2]-cube_points[a][2]);\
-    }\
-    /* -- */
-
-          if (et &    1) INTERPOLATE( 0, 0, 1);
-          if (et &    2) INTERPOLATE( 1, 1, 2);
-          if (et &    4) INTERPOLATE( 2, 2, 3);
-          if (et &    8) INTERPOLATE( 3, 3, 0);
-          if (et &   16) INTERPOLATE( 4, 4, 5);
-          if (et &   32) INTERPOLATE( 5, 5, 6);
-          if (et &   64) INTERPOLATE( 6, 6, 7);
-          if (et &  128) INTERPOLATE( 7, 7, 4);
-          if (et &  256) INTERPOLATE( 8, 0, 4);
-          if (et &  512) INTERPOLATE( 9, 1, 5);
-          if (et & 1024) INTERPOLATE(10, 2, 6);
-          if (et & 2048) INTERPOLATE(11, 3, 7);
-
-          for (int i = 0; TriangleTable[L][i] != -1; i += 3)
+            for (auto& it : cache)
+              it.resize(X * Y, -1);
+          }
+
+          for (Int64 y = BY * S, yend = std::min<Int64>(y + S, Y - 1); y < yend; y++)
           {
-            const double* p0 = v[TriangleTable[L][i + 0]]; 
-            const double* p1 = v[TriangleTable[L][i + 1]]; 
-            const double* p2 = v[TriangleTable[L][i + 2]]; 
-            PushTriangle(p0,p1,p2);
+            Int64 x = BX * S, xend = std::min<Int64>(x + S, X - 1);
+            Int64 index = x + y * stridey + z * stridez;
+
+            //corners 1,2,5,6 of a cell are corners 0,3,4,7 of the next one
+            int L =
+                (field[index + cube_strides[0]] < isovalue ?  1 : 0)
+              | (field[index + cube_strides[3]] < isovalue ?  8 : 0)
+              | (field[index + cube_strides[4]] < isovalue ? 16 : 0)
+              | (field[index + cube_strides[7]] < isovalue ?128 : 0);
+
+            for (; x < xend; x++, index++)
+            {
+              L = (L & (1 | 8 | 16 | 128))
+                | (field[index + cube_strides[1]] < isovalue ?  2 : 0)
+                | (field[index + cube_strides[2]] < isovalue ?  4 : 0)
+                | (field[index + cube_strides[5]] < isovalue ? 32 : 0)
+                | (field[index + cube_strides[6]] < isovalue ? 64 : 0);
+
+              int cube = L;
+              L = ((L >> 1) & 1) | ((L << 1) & 8) | ((L >> 1) & 16) | ((L << 1) & 128);
+
+              int et = EdgeTable[cube];
+              if (!et)
+                continue;
+
+              if (voxel_used)
+                voxel_used[index] = 1;
+
+              Uint32 v[12];
+              for (int E = 0; E < 12; E++)
+              {
+                if (et & (1 << E))
+                  v[E] = getVertex(x, y, z, E);
+              }
+
+              for (int I = 0; TriangleTable[cube][I] != -1; I++)
+                slab.indices.push_back(v[TriangleTable[cube][I]]);
+            }
           }
         }
       }
     }
-    isocontour.end();
-
-    if (ofile.is_open())
-      ofile.close();
-
-    PrintInfo("Marching cube on first",dims,"ntriangles",ntriangles,"done in",t1.elapsedMsec(),"msec");
-    return true;
   }
+
 };
 
 
+///////////////////////////////////////////////////////////////////////
+int MarchingCube::getDefaultNumberOfThreads()
+{
+  int ret = std::max(1, (int)std::thread::hardware_concurrency());
+  if (auto env = cint(Utils::getEnv("VISUS_MARCHING_CUBE_NUM_THREADS")))
+    ret = std::max(1, env);
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////
 SharedPtr<IsoContour> MarchingCube::run() 
 {
   MarchingCubeOp op(*this);
-  return ExecuteOnCppSamples(op, data.dtype) ? op.isocontour : SharedPtr<IsoContour>();
+  if (!ExecuteOnCppSamples(op, data.dtype))
+    return SharedPtr<IsoContour>();
+  this->bricks = op.bricks;
+  return op.isocontour;
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -542,16 +688,27 @@ class IsoContourNode::MyJob : public NodeJob
 {
 public:
 
-  Node*  node;
-  Array  data;
-  double isovalue;
-  bool   enable_vortex_used;
+  IsoContourNode*                 node;
+  Array                           data;
+  double                          isovalue;
+  bool                            enable_vortex_used;
+  SharedPtr<MarchingCube::Bricks> bricks;
+  SharedPtr<ThreadPool>           thread_pool;
 
   //constructor
-  MyJob(Node* node_, Array data_, double isovalue_)
+  MyJob(IsoContourNode* node_, Array data_, double isovalue_)
     : node(node_),data(data_),isovalue(isovalue_)
   {
     enable_vortex_used= node->isOutputConnected("cell_array");
+
+    ScopedLock lock(node->bricks_lock);
+    bricks = node->last_bricks;
+
+    //persistent workers, a new job starts every time the isovalue changes
+    int nthreads = MarchingCube::getDefaultNumberOfThreads();
+    if (!node->thread_pool && nthreads > 1)
+      node->thread_pool = std::make_shared<ThreadPool>("MarchingCube Worker", nthreads);
+    thread_pool = node->thread_pool;
   }
 
   //destructor
@@ -568,10 +725,17 @@ public:
 
     MarchingCube mc(components[0], isovalue, this->aborted);
     mc.enable_vortex_used = enable_vortex_used;
+    mc.bricks = bricks;
+    mc.thread_pool = thread_pool;
 
     //tell that the output has changed, if the port is not connected, this is a NOP!
     if (auto isocontour = mc.run())
     {
+      {
+        ScopedLock lock(node->bricks_lock);
+        node->last_bricks = mc.bricks;
+      }
+
       Utils::pop_front(components);
       isocontour->second_field = ArrayUtils::interleave(components, aborted);
 
@@ -21,7 +21,9 @@
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wignored-qualifiers"
 #endif
+#if !defined(VISUS_IDX2) // inside OpenVisus zstd is compiled once in VisusKernel
 #include "zstd/zstd.c"
+#endif
 #include "zstd/zstd.h"
 #if defined(__clang__) || defined(__GNUC__)
 #pragma GCC diagnostic pop
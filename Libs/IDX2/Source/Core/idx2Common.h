@@ -13,6 +13,8 @@
 #if VISUS_IDX2
 #include <functional>
 #include <future>
+#include <memory>
+#include <string>
 #endif
 
 /* ---------------------- MACROS ----------------------*/
@@ -53,7 +55,8 @@ idx2_Enum(idx2_err_code,
           ChunkNotFound,
           BrickNotFound,
           FileNotFound,
-          UnsupportedScheme);
+          UnsupportedScheme,
+          Aborted);
 
 idx2_Enum(func_level, u8, Subband, Sum, Max);
 
@@ -64,6 +67,10 @@ namespace idx2
 
 /* ---------------------- TYPES ----------------------*/
 
+#if VISUS_IDX2
+struct shared_chunk_cache;
+#endif
+
 struct file_id
 {
   stref Name;
@@ -180,6 +187,13 @@ struct idx2_file
 
   //write is always syncronous and slow, don't use this
   std::function<bool(const idx2_file&, buffer&, u64)> external_write;
+
+  //decompressed chunks shared by all the decodes (optional, see shared_chunk_cache), keys are prefixed by external_cache_prefix
+  std::shared_ptr<shared_chunk_cache> external_cache;
+  std::string external_cache_prefix;
+
+  //decode tasks stop as soon as it returns true (optional)
+  std::function<bool()> external_aborted;
 #endif
 };
 
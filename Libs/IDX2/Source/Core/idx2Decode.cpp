@@ -39,6 +39,7 @@ Dealloc(decode_data* D)
   DeallocFileCacheTable(&D->FileCacheTable);
 #if VISUS_IDX2
   Dealloc(&D->FileCache);
+  D->PinnedChunks.clear();
 #endif
 }
 
@@ -9,6 +9,11 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#if VISUS_IDX2
+#include <list>
+#include <map>
+#include <tuple>
+#endif
 
 
 namespace idx2
@@ -51,9 +56,44 @@ struct decode_data
   std::atomic<u64> DataMovementTime_ = 0;
   std::atomic<i64> NSignificantBlocks = 0;
   std::atomic<i64> NInsignificantSubbands = 0;
+
+#if VISUS_IDX2
+  std::vector<std::shared_ptr<void>> PinnedChunks; // shared chunks used by this decode (cannot be freed until the decode ends)
+#endif
 };
 
 
+#if VISUS_IDX2
+/*
+Decompressed chunks (and exponent chunks) shared by several decodes, i.e. they survive the decode_data.
+A chunk is read/decompressed only once even if several tasks ask for it at the same time.
+When the total size exceeds MaxBytes the least recently used chunks are evicted (never the ones still loading).
+*/
+struct shared_chunk_cache
+{
+  using key = std::tuple<std::string, u64, bool>; // (prefix, chunk address, exponent chunk)
+
+  struct entry
+  {
+    std::shared_future<std::shared_ptr<void>> Value;
+    i64 Bytes = 0;
+    bool Loading = true;
+    u64 Ticket = 0; // the entry of a loader can be dropped and replaced while it is loading
+    std::list<key>::iterator LruIt;
+  };
+
+  std::mutex Mutex;
+  i64 MaxBytes = i64(512) << 20;
+  i64 Bytes = 0;
+  u64 NextTicket = 0;
+  std::map<key, entry> Entries;
+  std::list<key> Lru; // most recently used first
+  std::atomic<i64> NHits = 0;
+  std::atomic<i64> NMisses = 0;
+};
+#endif
+
+
 /* ---------------------- FUNCTIONS ----------------------*/
 
 void
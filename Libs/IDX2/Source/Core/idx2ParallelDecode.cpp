@@ -340,6 +340,13 @@ TraverseSecondLevel(const idx2_file& Idx2,
   expected<brick_volume, idx2_err_code> Result;
   while (Size(BrickStack) > 0)
   {
+#if VISUS_IDX2
+    if (Idx2.external_aborted && Idx2.external_aborted())
+    {
+      Result = idx2_Error(idx2_err_code::Aborted);
+      goto EXIT;
+    }
+#endif
     decode_state Current = Back(BrickStack);
     //printf("level %d current " idx2_PrStrV3i "\n", Current.Level, idx2_PrV3i(Current.Brick3));
     PopBack(&BrickStack);
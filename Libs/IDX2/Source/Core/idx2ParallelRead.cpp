@@ -114,11 +114,118 @@ ParallelReadFile(const idx2_file& Idx2,
 }
 
 
+#if VISUS_IDX2
+/* Get a chunk from the shared cache, the first task asking for it reads and decompresses it (the others wait) */
+template <typename t> static std::shared_ptr<t>
+GetSharedChunk(const idx2_file& Idx2, decode_data* D, u64 ChunkAddress, bool Exponents, const std::function<bool(t*)>& Load)
+{
+  shared_chunk_cache* C = Idx2.external_cache.get();
+  shared_chunk_cache::key Key(Idx2.external_cache_prefix, ChunkAddress, Exponents);
+
+  std::shared_ptr<t> Result;
+  bool Owner = false;
+  while (!Result && !Owner)
+  {
+    std::promise<std::shared_ptr<void>> Promise;
+    std::shared_future<std::shared_ptr<void>> Future;
+    u64 Ticket = 0;
+    {
+      std::unique_lock<std::mutex> Lock(C->Mutex);
+      auto It = C->Entries.find(Key);
+      if (It != C->Entries.end())
+      {
+        C->Lru.splice(C->Lru.begin(), C->Lru, It->second.LruIt);
+        Future = It->second.Value;
+      }
+      else
+      {
+        Owner = true;
+        Ticket = ++C->NextTicket;
+        Future = Promise.get_future().share();
+        C->Lru.push_front(Key);
+        shared_chunk_cache::entry Entry;
+        Entry.Value = Future;
+        Entry.Ticket = Ticket;
+        Entry.LruIt = C->Lru.begin();
+        C->Entries[Key] = Entry;
+      }
+    }
+
+    if (!Owner)
+    {
+      // the loader failed (e.g. its own query has been aborted), try again (and probably load it myself)
+      ++C->NHits;
+      Result = std::static_pointer_cast<t>(Future.get());
+      continue;
+    }
+
+    ++C->NMisses;
+    Result = std::shared_ptr<t>(new t(), [](t* Chunk) { Dealloc(Chunk); delete Chunk; });
+    if (!Load(Result.get()))
+      Result.reset();
+    Promise.set_value(Result);
+
+    std::unique_lock<std::mutex> Lock(C->Mutex);
+    auto It = C->Entries.find(Key);
+    if (It == C->Entries.end() || It->second.Ticket != Ticket)
+    {
+      // the cache has been cleared while loading, the entry (if any) is not mine
+    }
+    else if (!Result)
+    {
+      // failed reads are not cached (e.g. aborted)
+      C->Lru.erase(It->second.LruIt);
+      C->Entries.erase(It);
+    }
+    else
+    {
+      It->second.Loading = false;
+      It->second.Bytes = Size(*Result);
+      C->Bytes += It->second.Bytes;
+
+      // least recently used first, skipping my own entry and the ones still loading (their loaders will update them)
+      for (auto LruIt = C->Lru.end(); C->Bytes > C->MaxBytes && LruIt != C->Lru.begin();)
+      {
+        --LruIt;
+        auto Victim = C->Entries.find(*LruIt);
+        if (Victim == It || Victim->second.Loading)
+          continue;
+        C->Bytes -= Victim->second.Bytes;
+        C->Entries.erase(Victim);
+        LruIt = C->Lru.erase(LruIt);
+      }
+    }
+  }
+
+  if (Result)
+  {
+    std::unique_lock<std::mutex> Lock(D->FileCacheMutex);
+    D->PinnedChunks.push_back(Result);
+  }
+  return Result;
+}
+#endif
+
+
 /* Given a brick address, read the chunk associated with the brick and cache the chunk */
 expected<chunk_cache, idx2_err_code>
 ParallelReadChunk(const idx2_file& Idx2, decode_data* D, u64 Brick, i8 Level, i8 Subband, i16 BpKey)
 {
 #if VISUS_IDX2
+  if (Idx2.external_read && Idx2.external_cache)
+  {
+    u64 ChunkAddress = GetChunkAddress(Idx2, Brick, Level, Subband, BpKey);
+    auto ChunkCache = GetSharedChunk<chunk_cache>(Idx2, D, ChunkAddress, false, [&](chunk_cache* Chunk) {
+      bitstream ChunkStream;
+      if (!Idx2.external_read(Idx2, ChunkStream.Stream, ChunkAddress).get())
+        return false;
+      DecompressChunk(&ChunkStream, Chunk, ChunkAddress, Log2Ceil(Idx2.BricksPerChunk[Level]));
+      return true;
+    });
+    idx2_ReturnErrorIf(!ChunkCache, idx2_err_code::ChunkNotFound);
+    return *ChunkCache;
+  }
+
   if (Idx2.external_read)
   {
     std::unique_lock<std::mutex> Lock(D->FileCacheMutex);
@@ -309,6 +416,22 @@ expected<chunk_exp_cache, idx2_err_code>
 ParallelReadChunkExponents(const idx2_file& Idx2, decode_data* D, u64 Brick, i8 Level, i8 Subband)
 {
 #if VISUS_IDX2
+  if (Idx2.external_read && Idx2.external_cache)
+  {
+    u64 ChunkAddress = GetChunkAddress(Idx2, Brick, Level, Subband, ExponentBitPlane_);
+    auto ChunkExpCache = GetSharedChunk<chunk_exp_cache>(Idx2, D, ChunkAddress, true, [&](chunk_exp_cache* Chunk) {
+      buffer Buf;
+      if (!Idx2.external_read(Idx2, Buf, ChunkAddress).get())
+        return false;
+      DecompressBufZstd(Buf, &Chunk->ChunkExpStream);
+      InitRead(&Chunk->ChunkExpStream, Chunk->ChunkExpStream.Stream);
+      DeallocBuf(&Buf);
+      return true;
+    });
+    idx2_ReturnErrorIf(!ChunkExpCache, idx2_err_code::ChunkNotFound);
+    return *ChunkExpCache;
+  }
+
   if (Idx2.external_read)
   {
     std::unique_lock<std::mutex> Lock(D->FileCacheMutex);
@@ -194,6 +194,10 @@ public:
   //convolve
   static Array convolve(Array src, Array kernel, Aborted aborted = Aborted());
 
+  //convolve (output has the components of src with dtype as sample type, the src one if dtype is not valid)
+  //separable kernels run one 1D pass for each axis, big kernels use a FFT
+  static Array convolve(Array src, Array kernel, DType dtype, Aborted aborted = Aborted());
+
   //medianHybrid
   static Array medianHybrid(Array src, Array krn_size, Aborted aborted = Aborted());
 
@@ -339,6 +343,9 @@ public:
   //warpPerspective
   static bool warpPerspective(Array& dst, Matrix T, Array src, Aborted aborted);
 
+  //warpPerspective (dst covers only the samples starting at offset)
+  static bool warpPerspective(Array& dst, Matrix T, Array src, PointNi offset, Aborted aborted);
+
   //setBufferColor
   static void setBufferColor(Array& buffer, Color color);
 
@@ -381,6 +388,9 @@ public:
   //addBlendArg
   void addBlendArg(Array arg);
 
+  //addBlendArg (arg covers only the samples of the result, made of dims samples, starting at offset)
+  void addBlendArg(Array arg, PointNi offset, PointNi dims);
+
 private:
 
   Type type;
@@ -55,6 +55,7 @@ public:
   String                 fullname;
   StringMap              metadata;
   bool                   is_directory = false;
+  int                    status = 0; //http status when the item is not valid (e.g. 404 if it does not exist)
 
   //is_directory==false
   SharedPtr<HeapMemory>  body;
@@ -81,6 +82,13 @@ public:
     return ret;
   }
 
+  //createNotValid (returned by getBlob on failure, so that the caller knows why)
+  static SharedPtr<CloudStorageItem> createNotValid(int status) {
+    auto ret = std::make_shared<CloudStorageItem>();
+    ret->status = status;
+    return ret;
+  }
+
   //constructor
   static SharedPtr<CloudStorageItem> createDir(String fullname, StringMap metadata = StringMap()) {
     auto ret = std::make_shared<CloudStorageItem>();
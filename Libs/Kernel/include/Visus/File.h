@@ -327,6 +327,33 @@ private:
 };
 
 
+////////////////////////////////////////////////////////////////////////////////////////////
+//lock held by the operating system (flock/LockFileEx), released even if the process crashes
+//NOTE: ScopedFileLock would leave the .lock file behind and the other processes would wait forever
+class VISUS_KERNEL_API ScopedSystemFileLock
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(ScopedSystemFileLock)
+
+  //constructor (blocks until the lock is acquired, the file is created if needed)
+  ScopedSystemFileLock(String filename);
+
+  //destructor
+  ~ScopedSystemFileLock();
+
+  //isLocked (false if the file cannot be opened or locked)
+  bool isLocked() const {
+    return handle != -1;
+  }
+
+private:
+
+  String filename;
+  Int64  handle = -1;
+};
+
+
 } //namespace Visus
 
 #endif //__VISUS_FILE_IO_H__
@@ -68,6 +68,11 @@ public:
   //clone
   SharedPtr<HeapMemory> clone() const;
 
+  //isUnmanaged (i.e. the memory belongs to someone else, for example a numpy array)
+  bool isUnmanaged() const {
+    return unmanaged;
+  }
+
   //reserve (i.e. change the c_capacity() but not the c_size() neither dims neither dtype)
   bool reserve(Int64 new_m, const char* file, int line);
 
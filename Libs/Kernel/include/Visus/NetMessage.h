@@ -311,6 +311,8 @@ public:
 
 };
 
+class NetResponse;
+
 ///////////////////////////////////////////////////////////////////////////////////////
 class VISUS_KERNEL_API NetRequest : public NetMessage
 {
@@ -320,6 +322,11 @@ public:
 
   //aborted
   Aborted aborted;
+
+#if !SWIG
+  //partialResponse (optional, called from the network thread each time a piece of the body arrives; the final response is still delivered as usual)
+  std::function<void(const NetRequest&, const NetResponse&)> partialResponse;
+#endif
   
   //url
   Url url;
@@ -419,6 +426,9 @@ public:
   //decompose
   static std::vector<NetResponse> decompose(NetResponse RESPONSE);
 
+  //decomposePart (part I starting at body offset, which is moved to the next part; returns false if its body is not complete yet)
+  static bool decomposePart(const NetResponse& RESPONSE, int I, Int64& offset, NetResponse& response);
+
 };
 
 } //namespace Visus
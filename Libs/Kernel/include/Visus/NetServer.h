@@ -84,6 +84,31 @@ public:
     this->verbose = value;
   }
 
+  //setEventDriven (epoll loop with persistent connections, only available on linux)
+  void setEventDriven(bool value) {
+    this->event_driven = value;
+  }
+
+  //isEventDriven
+  bool isEventDriven() const {
+    return event_driven;
+  }
+
+  //setKeepAliveTimeout (in seconds, idle connections are closed after it)
+  void setKeepAliveTimeout(int value) {
+    this->keep_alive_timeout = value;
+  }
+
+  //setMaxPipelinedRequests (per connection, stop reading from the socket when reached)
+  void setMaxPipelinedRequests(int value) {
+    this->max_pipelined_requests = std::max(1, value);
+  }
+
+  //setCancelOnDisconnect (abort the requests of a client that closes its connection or cannot be written; only for the event driven loop)
+  void setCancelOnDisconnect(bool value) {
+    this->cancel_on_disconnect = value;
+  }
+
   //runInThisThread
   void runInThisThread();
 
@@ -105,10 +130,20 @@ protected:
   UniquePtr<NetServerModule> module;
   SharedPtr<std::thread>     thread;
   bool                       bExitThread = false;
+  bool                       event_driven = false;
+  int                        keep_alive_timeout = 60;
+  int                        max_pipelined_requests = 16;
+  bool                       cancel_on_disconnect = true;
+
+  //prepareResponse
+  void prepareResponse(NetResponse& response, bool keep_alive);
 
   //writeResponse
   bool writeResponse(NetSocket* client, NetResponse response);
 
+  //runEventLoop
+  void runEventLoop(SharedPtr<NetSocket> server, SharedPtr<ThreadPool> thread_pool);
+
 }; //end class
 
 } //namespace Visus
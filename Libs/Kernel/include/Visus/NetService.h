@@ -60,18 +60,31 @@ public:
   std::atomic<Int64> rbytes;
   std::atomic<Int64> wbytes;
   std::atomic<Int64> running_requests;
+  std::atomic<Int64> new_connections;
+  std::atomic<Int64> reused_connections;
 #endif
 
   //constructor
-  NetGlobalStats() : tot_requests(0), running_requests(0), rbytes(0),wbytes(0) {
+  NetGlobalStats() : tot_requests(0), running_requests(0), rbytes(0),wbytes(0), new_connections(0), reused_connections(0) {
   }
 
   //resetStats
   void resetStats() {
     tot_requests = rbytes = wbytes = 0;
+    new_connections = reused_connections = 0;
     //running_requests is a real number
   }
 
+  //getNumNewConnections (i.e. requests that needed a TCP/TLS handshake)
+  Int64 getNumNewConnections() const {
+    return new_connections;
+  }
+
+  //getNumReusedConnections (i.e. requests served on a keep-alive connection of the pool)
+  Int64 getNumReusedConnections() const {
+    return reused_connections;
+  }
+
   //getNumRequests
   Int64 getNumRequests() const {
     return tot_requests;
@@ -143,6 +156,36 @@ public:
     this->connect_timeout=value;
   }
 
+  //isKeepAlive
+  bool isKeepAlive() const {
+    return keep_alive;
+  }
+
+  //setKeepAlive (reuse connections to the same host instead of a new handshake for each request, applies to next requests)
+  void setKeepAlive(bool value) {
+    this->keep_alive = value;
+  }
+
+  //getMaxConnectionsPerHost
+  int getMaxConnectionsPerHost() const {
+    return max_connections_per_host;
+  }
+
+  //setMaxConnectionsPerHost (0 means no limit)
+  void setMaxConnectionsPerHost(int value) {
+    this->max_connections_per_host = value;
+  }
+
+  //isHttp2
+  bool isHttp2() const {
+    return http2;
+  }
+
+  //setHttp2 (multiplex requests on the same connection if both libcurl and the server support it)
+  void setHttp2(bool value) {
+    this->http2 = value;
+  }
+
   //push
   static Future<NetResponse> push(SharedPtr<NetService> service, NetRequest request);
 
@@ -161,6 +204,9 @@ private:
   int                          max_connections_per_sec = 0;
   int                          connect_timeout = 10; //in seconds (explanation in CONNECTTIMEOUT)
   int                          verbose = 0;
+  bool                         keep_alive = true;
+  int                          max_connections_per_host = 0;
+  bool                         http2 = false;
 
   CriticalSection              waiting_lock;
   Waiting                      waiting;
@@ -68,6 +68,9 @@ public:
   //destructor
   virtual ~NetSocket();
 
+  //getDescriptor (-1 if not valid)
+  int getDescriptor() const;
+
   //shutdownSend
   void shutdownSend();
 
@@ -443,6 +443,10 @@ public:
         if (!blob->getContentLength())
           blob.reset();
       }
+      else
+      {
+        blob = CloudStorageItem::createNotValid(response.status);
+      }
 
       ret.get_promise()->set_value(blob);
     });
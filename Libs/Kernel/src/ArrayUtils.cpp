@@ -42,6 +42,11 @@ For support : support@visus.net
 #include <Visus/Path.h>
 #include <Visus/File.h>
 #include <Visus/TransferFunction.h>
+#include <Visus/Thread.h>
+
+#include <condition_variable>
+#include <complex>
+#include <deque>
 
 namespace Visus {
 
@@ -221,6 +226,191 @@ Array ArrayUtils::decodeArray(StringMap metadata, SharedPtr<HeapMemory> encoded)
 }
 
   
+//////////////////////////////////////////////////////////////////////////////////////////
+//data-parallel layer for the sample kernels: [0,tot) is split in chunks of about ChunkBytes, taken by a
+//shared set of workers and by the calling thread too (so nested calls cannot deadlock).
+//aborted is checked once per chunk, so the inner loops stay free of branches and can be vectorized
+class ParallelFor
+{
+public:
+
+  enum { ChunkBytes = 1024 * 1024 };
+
+  //getNumThreads
+  static int getNumThreads()
+  {
+    static int ret = []() {
+      auto value = Utils::getEnv("VISUS_ARRAYUTILS_NUM_THREADS");
+      return std::max(1, value.empty() ? (int)std::thread::hardware_concurrency() : cint(value));
+    }();
+    return ret;
+  }
+
+  //run (item_nbytes is the memory touched by one item, 0 means do not split)
+  static bool run(Int64 tot, Int64 item_nbytes, Aborted aborted, std::function<void(Int64, Int64)> fn)
+  {
+    if (tot <= 0)
+      return !aborted();
+
+    auto job = std::make_shared<Job>();
+    job->fn      = fn;
+    job->aborted = aborted;
+    job->tot     = tot;
+    job->chunk   = item_nbytes > 0 ? std::max((Int64)1, (Int64)ChunkBytes / item_nbytes) : tot;
+    job->nchunks = (tot + job->chunk - 1) / job->chunk;
+
+    int nworkers = (int)std::min((Int64)getNumThreads(), job->nchunks) - 1;
+    if (nworkers > 0)
+      Workers::getSingleton()->push(job, nworkers);
+
+    job->work();
+
+    {
+      std::unique_lock<CriticalSection> lock(job->lock);
+      job->all_done.wait(lock, [job]() {return job->ndone == job->nchunks; });
+    }
+
+    return !aborted();
+  }
+
+private:
+
+  //Job
+  class Job
+  {
+  public:
+
+    std::function<void(Int64, Int64)> fn;
+    Aborted                           aborted;
+    Int64                             tot = 0, chunk = 0, nchunks = 0;
+    std::atomic<Int64>                next, ndone;
+    CriticalSection                   lock;
+    std::condition_variable           all_done;
+
+    //constructor
+    Job() : next(0), ndone(0) {
+    }
+
+    //work
+    void work()
+    {
+      for (Int64 I = next++; I < nchunks; I = next++)
+      {
+        if (!aborted())
+          fn(I * chunk, std::min(tot, (I + 1) * chunk));
+
+        if (++ndone == nchunks)
+        {
+          ScopedLock lock(this->lock);
+          all_done.notify_all();
+        }
+      }
+    }
+  };
+
+  //Workers (a job can be queued more than once, one for each worker that should help)
+  class Workers
+  {
+  public:
+
+    //getSingleton (never destroyed, joining threads from static destructors can hang at exit)
+    static Workers* getSingleton() {
+      static Workers* ret = new Workers(getNumThreads() - 1);
+      return ret;
+    }
+
+    //push
+    void push(SharedPtr<Job> job, int num)
+    {
+      {
+        ScopedLock lock(this->lock);
+        for (int I = 0; I < num; I++)
+          jobs.push_back(job);
+      }
+      something_happened.notify_all();
+    }
+
+  private:
+
+    CriticalSection                      lock;
+    std::condition_variable              something_happened;
+    std::deque< SharedPtr<Job> >         jobs;
+    std::vector< SharedPtr<std::thread> > threads;
+
+    //constructor
+    Workers(int num)
+    {
+      for (int I = 0; I < num; I++)
+        threads.push_back(Thread::start("ArrayUtils Worker " + cstring(I), [this]() {entryProc(); }));
+    }
+
+    //entryProc
+    void entryProc()
+    {
+      while (true)
+      {
+        SharedPtr<Job> job;
+        {
+          std::unique_lock<CriticalSection> lock(this->lock);
+          something_happened.wait(lock, [this]() {return !jobs.empty(); });
+          job = jobs.front();
+          jobs.pop_front();
+        }
+        job->work();
+      }
+    }
+  };
+
+};
+
+//bit-aligned samples can share the same byte, so they cannot be written by different chunks
+template <class Sample>
+inline bool IsByteAlignedSample() { return true; }
+
+template <>
+inline bool IsByteAlignedSample<BitAlignedSample>() { return false; }
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//dst[I*dst_stride]=fn(src[I*src_stride]), the unit-stride case is a plain loop the compiler can vectorize
+template <typename DstType, typename SrcType, class Function>
+static bool TransformSamples(DstType* dst, int dst_stride, const SrcType* src, int src_stride, Int64 tot, Aborted aborted, Function fn)
+{
+  Int64 item_nbytes = sizeof(DstType) * dst_stride + sizeof(SrcType) * src_stride;
+  return ParallelFor::run(tot, item_nbytes, aborted, [&](Int64 from, Int64 to)
+  {
+    if (dst_stride == 1 && src_stride == 1)
+    {
+      for (Int64 I = from; I < to; I++)
+        dst[I] = fn(src[I]);
+    }
+    else
+    {
+      for (Int64 I = from; I < to; I++)
+        dst[I * dst_stride] = fn(src[I * src_stride]);
+    }
+  });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template <class Sample>
+static inline void CopySampleRow(GetSamples<Sample>& write, Int64 woffset, Int64 wdelta, GetSamples<Sample>& read, Int64 roffset, Int64 rdelta, Int64 num)
+{
+  if (num <= 0)
+    return;
+
+  //plain pointers, Sample is a struct of bytes and would alias the offsets
+  Sample* W = &write[woffset];
+  const Sample* R = &read[roffset];
+  for (Int64 I = 0; I < num; I++)
+    W[I * wdelta] = R[I * rdelta];
+}
+
+static inline void CopySampleRow(GetSamples<BitAlignedSample>& write, Int64 woffset, Int64 wdelta, GetSamples<BitAlignedSample>& read, Int64 roffset, Int64 rdelta, Int64 num)
+{
+  for (Int64 I = 0; I < num; I++)
+    write[woffset + I * wdelta] = read[roffset + I * rdelta];
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 class InsertArraySamples 
 {
@@ -244,6 +434,10 @@ public:
     int sample_bitsize = dst.dtype.getBitSize();
 
     int pdim = src.getPointDim();
+    if (pdim < 1 || pdim > 5) {
+      VisusAssert(false);
+      return false;
+    }
 
     /*
     equivalent to:
@@ -311,6 +505,34 @@ public:
       }
     }
 
+    //split the outermost axis with more than one sample, each chunk is an independent copy
+    int P = pdim - 1;
+    while (P > 0 && tot[P] <= 1)
+      P--;
+
+    Int64 slice_nbytes = IsByteAlignedSample<Sample>() ? (tot.innerProduct() / std::max(tot[P], (Int64)1)) * sizeof(Sample) : 0;
+    return ParallelFor::run(tot[P], slice_nbytes, aborted, [&](Int64 from, Int64 to)
+    {
+      PointNi chunk_tot = tot;               chunk_tot[P]    = to - from;
+      PointNi chunk_wbegin = wbegin;         chunk_wbegin[P] += from * wdelta[P];
+      PointNi chunk_rbegin = rbegin;         chunk_rbegin[P] += from * rdelta[P];
+      PointNi chunk_ncontiguos = ncontiguos;
+      for (int D = P + 1; D < pdim; D++)
+        chunk_ncontiguos[D] = 0;
+      if (ncontiguos[P])
+        chunk_ncontiguos[P] = (P ? ncontiguos[P - 1] : 1) * (to - from);
+      copySamples(write, read, pdim, chunk_tot, chunk_wbegin, chunk_rbegin, wdelta, rdelta, chunk_ncontiguos, aborted);
+    });
+  }
+
+private:
+
+  //copySamples
+  template <class Sample>
+  static bool copySamples(GetSamples<Sample>& write, GetSamples<Sample>& read, int pdim,
+    const PointNi& tot, const PointNi& wbegin, const PointNi& rbegin, const PointNi& wdelta, const PointNi& rdelta, const PointNi& ncontiguos,
+    Aborted& aborted)
+  {
     PointNi p(pdim);
     PointNi woffset(pdim);
     PointNi roffset(pdim);
@@ -324,22 +546,28 @@ public:
         for (p[D] = 0; p[D] < tot[D]; ++p[D], woffset[D] += wdelta[D], roffset[D] += rdelta[D]) { \
       /*--*/
 
-    #define ForBody() \
-      write[woffset[0]]=read[roffset[0]]; \
+    //innermost axis: a block copy or a plain strided loop
+    #define ForRow() \
+      woffset[0] = (pdim==1? 0 : woffset[1]) + wbegin[0]; \
+      roffset[0] = (pdim==1? 0 : roffset[1]) + rbegin[0]; \
+      if (ncontiguos[0]) \
+        write.range(woffset[0], ncontiguos[0]) = read.range(roffset[0], ncontiguos[0]); \
+      else \
+        CopySampleRow(write, woffset[0], wdelta[0], read, roffset[0], rdelta[0], tot[0]); \
       /*--*/
 
     switch (pdim) 
     { 
-    case 1:                                  if (aborted()) return false;            ForExpr(0) ForBody() }     break;
-    case 2:                                  if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}    break;
-    case 3:                       ForExpr(2) if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}}   break;
-    case 4:            ForExpr(3) ForExpr(2) if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}}}  break;
-    case 5: ForExpr(4) ForExpr(3) ForExpr(2) if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}}}} break;
+    case 1:                                  if (aborted()) return false;            ForRow()     break;
+    case 2:                                  if (aborted()) return false; ForExpr(1) ForRow() }    break;
+    case 3:                       ForExpr(2) if (aborted()) return false; ForExpr(1) ForRow() }}   break;
+    case 4:            ForExpr(3) ForExpr(2) if (aborted()) return false; ForExpr(1) ForRow() }}}  break;
+    case 5: ForExpr(4) ForExpr(3) ForExpr(2) if (aborted()) return false; ForExpr(1) ForRow() }}}} break;
     default: VisusAssert(false); return false;
     }
 
     #undef ForExpr
-    #undef ForBody
+    #undef ForRow
 
     return true;
   }
@@ -490,6 +718,37 @@ Array ArrayUtils::mirror(Array src, int axis, Aborted aborted)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
+class InterleaveArraySamples
+{
+public:
+
+  template <class Sample>
+  bool execute(Array& dst, std::vector<Array>& v, Aborted& aborted)
+  {
+    int N = (int)v.size();
+
+    //bit-aligned samples (or vectors of vectors) go one component at a time
+    if (!IsByteAlignedSample<Sample>() || dst.dtype.getByteSize() != N * (Int64)sizeof(Sample))
+    {
+      for (int I = 0; !aborted() && I < N; I++)
+        dst.setComponent(I, v[I], aborted);
+      return !aborted();
+    }
+
+    Sample* write = (Sample*)dst.c_ptr();
+    return ParallelFor::run(dst.getTotalNumberOfSamples(), N * sizeof(Sample), aborted, [&](Int64 from, Int64 to)
+    {
+      for (int I = 0; I < N; I++)
+      {
+        const Sample* read = (const Sample*)v[I].c_ptr();
+        for (Int64 J = from; J < to; J++)
+          write[J * N + I] = read[J];
+      }
+    });
+  }
+
+};
+
 Array ArrayUtils::interleave(std::vector<Array> v, Aborted aborted)
 {
   if (v.empty())
@@ -512,10 +771,8 @@ Array ArrayUtils::interleave(std::vector<Array> v, Aborted aborted)
   if (!dst.resize(dims, dtype, __FILE__, __LINE__))
     return Array();
 
-  for (int I = 0; !aborted() && I < (int)v.size(); I++)
-    dst.setComponent(I, v[I], aborted);
-
-  if (aborted())
+  InterleaveArraySamples op;
+  if (!NeedToCopySamples(op, first.dtype, dst, v, aborted))
     return Array();
 
   dst.shareProperties(v[0]);
@@ -571,13 +828,8 @@ struct ConvertToSameDTypeOp
     //for each component...
     for (int C = 0; C < ncomponents; C++)
     {
-      Type* src_p = ((Type*)src.c_ptr()) + C;
-      Type* dst_p = ((Type*)dst.c_ptr()) + C;
-      for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
-      {
-        if (aborted()) return false;
-        *dst_p = *src_p;
-      }
+      if (!TransformSamples(((Type*)dst.c_ptr()) + C, m, ((const Type*)src.c_ptr()) + C, n, totsamples, aborted, [](Type value) {return value; }))
+        return false;
     }
     return true;
   }
@@ -619,30 +871,15 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
   {
     for (int C = 0; C < ncomponents; C++)
     {
-      //compute the range
-      Uint16 min, max;
-      {
-        Uint16* src_p = ((Uint16*)src.c_ptr()) + C;
-        min = *src_p;
-        max = *src_p;
-        for (Int64 I = 0; I < totsamples; I++, src_p += n)
-        {
-          if (aborted()) return Array();
-          min = std::min(min, *src_p);
-          max = std::max(max, *src_p);
-        }
-        //PrintInfo("Range for component C",C,"min",min,"max",max);
-      }
-
-      {
-        Uint16* src_p = ((Uint16*)src.c_ptr()) + C;
-        Uint8*  dst_p = ((Uint8*)dst.c_ptr()) + C;
-        for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
-        {
-          if (aborted()) return Array();
-          *dst_p = (Uint8)(255.0*(*src_p - min) / (double)(max - min));
-        }
-      }
+      auto range = computeRange(src, C, aborted);
+      if (aborted()) return Array();
+      //PrintInfo("Range for component C",C,"min",range.from,"max",range.to);
+
+      double min = range.from, delta = range.to - range.from;
+      if (!TransformSamples(((Uint8*)dst.c_ptr()) + C, m, ((const Uint16*)src.c_ptr()) + C, n, totsamples, aborted, [min, delta](Uint16 value) {
+        return (Uint8)(255.0 * (value - min) / delta);
+      }))
+        return Array();
     }
     return dst;
   }
@@ -652,13 +889,8 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
   {
     for (int C = 0; C < ncomponents; C++)
     {
-      Uint8*   src_p = ((Uint8*)src.c_ptr()) + C;
-      Float32* dst_p = ((Float32*)dst.c_ptr()) + C;
-      for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
-      {
-        if (aborted()) return Array();
-        *dst_p = (*src_p) / 255.0f;
-      }
+      if (!TransformSamples(((Float32*)dst.c_ptr()) + C, m, ((const Uint8*)src.c_ptr()) + C, n, totsamples, aborted, [](Uint8 value) {return value / 255.0f; }))
+        return Array();
     }
     return dst;
   }
@@ -668,13 +900,8 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
   {
     for (int C = 0; C < ncomponents; C++)
     {
-      Uint8*   src_p = ((Uint8*)src.c_ptr()) + C;
-      Float64* dst_p = ((Float64*)dst.c_ptr()) + C;
-      for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
-      {
-        if (aborted()) return Array();
-        *dst_p = (*src_p) / 255.0;
-      }
+      if (!TransformSamples(((Float64*)dst.c_ptr()) + C, m, ((const Uint8*)src.c_ptr()) + C, n, totsamples, aborted, [](Uint8 value) {return value / 255.0; }))
+        return Array();
     }
     return dst;
   }
@@ -684,13 +911,8 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
   {
     for (int C = 0; C < ncomponents; C++)
     {
-      Float32* src_p = ((Float32*)src.c_ptr()) + C;
-      Float64* dst_p = ((Float64*)dst.c_ptr()) + C;
-      for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
-      {
-        if (aborted()) return Array();
-        *dst_p = *src_p;
-      }
+      if (!TransformSamples(((Float64*)dst.c_ptr()) + C, m, ((const Float32*)src.c_ptr()) + C, n, totsamples, aborted, [](Float32 value) {return (Float64)value; }))
+        return Array();
     }
     return dst;
   }
@@ -701,14 +923,12 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
     for (int C = 0; C < ncomponents; C++)
     {
       Range range = src.dtype.getDTypeRange(C);
-      if (!range.delta()) range = computeRange(src,C);
-      Float32*  src_p = ((Float32*)src.c_ptr()) + C;
-      Uint8*    dst_p = ((Uint8*)dst.c_ptr()) + C;
-      for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
-      {
-        if (aborted()) return Array();
-        *dst_p = (Uint8)(255 * Utils::clamp((Float32)((*src_p) - range.from) / (Float32)(range.to - range.from), 0.0f, 1.0f));
-      }
+      if (!range.delta()) range = computeRange(src,C,aborted);
+      double from = range.from; Float32 delta = (Float32)(range.to - range.from);
+      if (!TransformSamples(((Uint8*)dst.c_ptr()) + C, m, ((const Float32*)src.c_ptr()) + C, n, totsamples, aborted, [from, delta](Float32 value) {
+        return (Uint8)(255 * Utils::clamp((Float32)(value - from) / delta, 0.0f, 1.0f));
+      }))
+        return Array();
     }
     return dst;
   }
@@ -719,14 +939,12 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
     for (int C = 0; C < ncomponents; C++)
     {
       Range range = src.dtype.getDTypeRange(C);
-      if (!range.delta()) range = computeRange(src,C);
-      Float64*  src_p = ((Float64*)src.c_ptr()) + C;
-      Uint8*    dst_p = ((Uint8*)dst.c_ptr()) + C;
-      for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
-      {
-        if (aborted()) return Array();
-        *dst_p = (Uint8)(255 * Utils::clamp((Float64)((*src_p) - range.from) / (Float64)(range.to - range.from), 0.0, 1.0));
-      }
+      if (!range.delta()) range = computeRange(src,C,aborted);
+      Float64 from = range.from, delta = range.to - range.from;
+      if (!TransformSamples(((Uint8*)dst.c_ptr()) + C, m, ((const Float64*)src.c_ptr()) + C, n, totsamples, aborted, [from, delta](Float64 value) {
+        return (Uint8)(255 * Utils::clamp((value - from) / delta, 0.0, 1.0));
+      }))
+        return Array();
     }
     return dst;
   }
@@ -777,14 +995,9 @@ static Array CastArray(Array src, DType dtype, Aborted& aborted)
 
   //what to do with the SingleComponentRange?
 
-  Dtype* dst_p = (Dtype*)dst.c_ptr();
-  Stype* src_p = (Stype*)src.c_ptr();
   Int64 tot = src.getTotalNumberOfSamples()*ncomponents;
-  for (Int64 I = 0; I < tot; I++)
-  {
-    if (aborted()) return Array();
-    dst_p[I] = (Dtype)(src_p[I]);
-  }
+  if (!TransformSamples((Dtype*)dst.c_ptr(), 1, (const Stype*)src.c_ptr(), 1, tot, aborted, [](Stype value) {return (Dtype)value; }))
+    return Array();
   return dst;
 }
 
@@ -840,14 +1053,9 @@ Array SqrtArray(Array src, Aborted& aborted)
     return Array();
   dst.shareProperties(src);
 
-  CppType* dst_p = (CppType*)dst.c_ptr();
-  CppType* src_p = (CppType*)src.c_ptr();
   Int64 tot = src.getTotalNumberOfSamples()*ncomponents;
-  for (Int64 I = 0; I < tot; I++)
-  {
-    if (aborted()) return Array();
-    dst_p[I] = (CppType)sqrt(src_p[I]);
-  }
+  if (!TransformSamples((CppType*)dst.c_ptr(), 1, (const CppType*)src.c_ptr(), 1, tot, aborted, [](CppType value) {return (CppType)sqrt(value); }))
+    return Array();
   return dst;
 }
 
@@ -877,14 +1085,9 @@ Array AddArray(Array src, CppType value, Aborted& aborted)
 
   dst.shareProperties(src);
 
-  CppType* dst_p = (CppType*)dst.c_ptr();
-  CppType* src_p = (CppType*)src.c_ptr();
   Int64 tot = src.getTotalNumberOfSamples()*ncomponents;
-  for (Int64 I = 0; I < tot; I++)
-  {
-    if (aborted()) return Array();
-    dst_p[I] = (CppType)(src_p[I] + value);
-  }
+  if (!TransformSamples((CppType*)dst.c_ptr(), 1, (const CppType*)src.c_ptr(), 1, tot, aborted, [value](CppType it) {return (CppType)(it + value); }))
+    return Array();
   return dst;
 }
 
@@ -913,14 +1116,9 @@ Array SubArrayAndValue(Array a, CppType b, Aborted& aborted)
     return Array();
   dst.shareProperties(a);
 
-  CppType* dst_p = (CppType*)dst.c_ptr();
-  CppType* src_p = (CppType*)a.c_ptr();
   Int64 tot = a.getTotalNumberOfSamples()*ncomponents;
-  for (Int64 I = 0; I < tot; I++)
-  {
-    if (aborted()) return Array();
-    dst_p[I] = (CppType)(src_p[I] - b);
-  }
+  if (!TransformSamples((CppType*)dst.c_ptr(), 1, (const CppType*)a.c_ptr(), 1, tot, aborted, [b](CppType it) {return (CppType)(it - b); }))
+    return Array();
   return dst;
 }
 
@@ -950,15 +1148,9 @@ Array SubNumberAndArray(CppType num, Array src, Aborted& aborted)
     return Array();
   dst.shareProperties(src);
 
-  CppType* DST = (CppType*)dst.c_ptr();
-  CppType* SRC = (CppType*)src.c_ptr();
-  for (Int64 I = 0, tot = src.getTotalNumberOfSamples()*ncomponents; I < tot; I++)
-  {
-    if (aborted()) 
-      return Array();
-
-    DST[I] = (CppType)(num - SRC[I]);
-  }
+  Int64 tot = src.getTotalNumberOfSamples()*ncomponents;
+  if (!TransformSamples((CppType*)dst.c_ptr(), 1, (const CppType*)src.c_ptr(), 1, tot, aborted, [num](CppType it) {return (CppType)(num - it); }))
+    return Array();
   return dst;
 }
 
@@ -990,14 +1182,9 @@ Array MulArray(Array src, CppType coeff, Aborted& aborted)
 
   dst.shareProperties(src);
 
-  CppType* dst_p = (CppType*)dst.c_ptr();
-  CppType* src_p = (CppType*)src.c_ptr();
   Int64 tot = src.getTotalNumberOfSamples()*ncomponents;
-  for (Int64 I = 0; I < tot; I++)
-  {
-    if (aborted()) return Array();
-    dst_p[I] = (CppType)(coeff*src_p[I]);
-  }
+  if (!TransformSamples((CppType*)dst.c_ptr(), 1, (const CppType*)src.c_ptr(), 1, tot, aborted, [coeff](CppType it) {return (CppType)(coeff*it); }))
+    return Array();
   return dst;
 }
 
@@ -1028,14 +1215,9 @@ Array DivArray(CppType coeff, Array src, Aborted& aborted)
     return Array();
   dst.shareProperties(src);
 
-  CppType* dst_p = (CppType*)dst.c_ptr();
-  CppType* src_p = (CppType*)src.c_ptr();
   Int64 tot = src.getTotalNumberOfSamples()*ncomponents;
-  for (Int64 I = 0; I < tot; I++)
-  {
-    if (aborted()) return Array();
-    dst_p[I] = (CppType)(coeff / src_p[I]);
-  }
+  if (!TransformSamples((CppType*)dst.c_ptr(), 1, (const CppType*)src.c_ptr(), 1, tot, aborted, [coeff](CppType it) {return (CppType)(coeff / it); }))
+    return Array();
   return dst;
 }
 
@@ -1076,38 +1258,35 @@ public:
     auto read =GetSamples<Sample>(rbuffer);
 
     int pdim = wdims.getPointDim();
-    
-    PointNd vs(pdim);
-    for (int D=0; D<pdim; D++)
-      vs[D] = rdims[D] / (double)wdims[D];
-
-    PointNi w(pdim); Int64 woffset = 0;
-    PointNi r(pdim); PointNi          roffset(pdim);
     PointNi rstride = rdims.stride();
 
-    #define ForExpr(D) \
-      for (w[D] = 0; w[D] < wdims[D]; w[D] += 1) { \
-        r[D] = Utils::clamp(Int64(w[D]* vs[D]),(Int64)0, rdims[D] - 1);  \
-        roffset[D] = (D==pdim-1? 0 : roffset[D+1]) + rstride[D]*r[D]; \
-    /*--*/
-
-    #define ForBody() \
-      write[woffset++]=read[roffset[0]];\
-      /*--*/
-
-    switch (pdim) 
-    { 
-    case 1:                                  if (aborted()) return false;            ForExpr(0) ForBody() }     break;
-    case 2:                                  if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}    break;
-    case 3:                       ForExpr(2) if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}}   break;
-    case 4:            ForExpr(3) ForExpr(2) if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}}}  break;
-    case 5: ForExpr(4) ForExpr(3) ForExpr(2) if (aborted()) return false; ForExpr(1) ForExpr(0) ForBody() }}}}} break;
-    default: VisusAssert(false); return false;
+    //read offset for each write coordinate, one table for each axis
+    std::vector< std::vector<Int64> > roffset(pdim);
+    for (int D = 0; D < pdim; D++)
+    {
+      double vs = rdims[D] / (double)wdims[D];
+      roffset[D].resize(wdims[D]);
+      for (Int64 W = 0; W < wdims[D]; W++)
+        roffset[D][W] = rstride[D] * Utils::clamp(Int64(W * vs), (Int64)0, rdims[D] - 1);
     }
-    #undef ForExpr
-    #undef ForBody
 
-    return true;
+    //chunks are made of rows along the first axis
+    Int64 width = wdims[0];
+    Int64 nrows = wdims.innerProduct() / width;
+    Int64 row_nbytes = IsByteAlignedSample<Sample>() ? width * sizeof(Sample) : 0;
+    return ParallelFor::run(nrows, row_nbytes, aborted, [&](Int64 from, Int64 to)
+    {
+      const Int64* xoffset = &roffset[0][0];
+      for (Int64 row = from; row < to; row++)
+      {
+        Int64 rbase = 0;
+        for (Int64 D = 1, I = row; D < pdim; I /= wdims[D], D++)
+          rbase += roffset[D][I % wdims[D]];
+
+        for (Int64 X = 0, woffset = row * width; X < width; X++, woffset++)
+          write[woffset] = read[rbase + xoffset[X]];
+      }
+    });
   }
 
 };
@@ -1129,21 +1308,43 @@ struct ComputeSingleComponentRangeOp
     if (!tot)  
       return false;
     
-    range.from = NumericLimits<double>::highest();
-    range.to   = NumericLimits<double>::lowest();
-
-    auto samples=GetComponentSamples<CppType>(src,ncomponent);
-
-    for (int I = 0; I < tot; I++)
+    int stride = src.dtype.ncomponents();
+    const CppType* samples = ((const CppType*)src.c_ptr()) + ncomponent;
+
+    //each chunk reduces in the native type (NaNs never pass the comparisons), then chunks are merged
+    CriticalSection lock;
+    CppType m = NumericLimits<CppType>::highest();
+    CppType M = NumericLimits<CppType>::lowest();
+    bool bOk = ParallelFor::run(tot, sizeof(CppType) * stride, aborted, [&](Int64 from, Int64 to)
     {
-      if (aborted()) 
-        return false;
-      
-      double value = (double)samples[I];
-      if (value < range.from) range.from = value;
-      if (value > range.to  ) range.to   = value;
-    }
+      CppType chunk_m = NumericLimits<CppType>::highest();
+      CppType chunk_M = NumericLimits<CppType>::lowest();
+      if (stride == 1)
+      {
+        for (Int64 I = from; I < to; I++)
+        {
+          chunk_m = samples[I] < chunk_m ? samples[I] : chunk_m;
+          chunk_M = chunk_M < samples[I] ? samples[I] : chunk_M;
+        }
+      }
+      else
+      {
+        for (Int64 I = from; I < to; I++)
+        {
+          chunk_m = samples[I * stride] < chunk_m ? samples[I * stride] : chunk_m;
+          chunk_M = chunk_M < samples[I * stride] ? samples[I * stride] : chunk_M;
+        }
+      }
+      ScopedLock lock_chunk(lock);
+      m = std::min(m, chunk_m);
+      M = std::max(M, chunk_M);
+    });
 
+    if (!bOk)
+      return false;
+      
+    range.from = M < m ? NumericLimits<double>::highest() : (double)m;
+    range.to   = M < m ? NumericLimits<double>::lowest () : (double)M;
     return true;
   }
 };
@@ -1188,19 +1389,21 @@ public:
       auto write=GetComponentSamples<Sample>(dst,C);
       auto read =GetComponentSamples<Sample>(src,C);
 
-      int offset=0;
-      for (auto P=ForEachPoint(src.dims);!P.end();P.next(), offset++)
+      bool bOk = ParallelFor::run(read.tot, 2 * src.dtype.getByteSize(), aborted, [&](Int64 from, Int64 to)
       {
-        if (aborted()) 
-          return Array();
-
-        double value = read[offset];
-        value = (value- m) / (M - m);
-        value = filter.transform(value);
-        value = Utils::clamp(value, 0.0, 1.0);
-        value = (m + (M - m)*value);
-        write[offset] = (Sample) value;
-      }
+        for (Int64 offset = from; offset < to; offset++)
+        {
+          double value = read[offset];
+          value = (value- m) / (M - m);
+          value = filter.transform(value);
+          value = Utils::clamp(value, 0.0, 1.0);
+          value = (m + (M - m)*value);
+          write[offset] = (Sample) value;
+        }
+      });
+
+      if (!bOk)
+        return Array();
     }
 
     return dst;
@@ -1389,7 +1592,7 @@ class WarpPerspective
 public:
 
   template <class Sample>
-  bool execute(Array& dst,Matrix T,Array src,Aborted& aborted)
+  bool execute(Array& dst,Matrix T,Array src,PointNi offset,Aborted& aborted)
   {
     //not compatible
     if (dst.dtype != src.dtype) {
@@ -1397,7 +1600,7 @@ public:
       return false;
     }
 
-    if (T.isIdentity() && src.dims==dst.dims)
+    if (T.isIdentity() && src.dims==dst.dims && offset==PointNi(offset.getPointDim()))
     {
       dst = src;
       return true;
@@ -1420,94 +1623,116 @@ public:
     auto wstride = wdims.stride();
     auto rstride = rdims.stride();
 
-    int wfrom = 0;
+    //chunks are made of rows along the first axis
+    Int64 row_nbytes = IsByteAlignedSample<Sample>() ? wdims[0] * (sizeof(Sample) + 1) : 0;
 
     if (pdim == 2)
     {
-      Int64 rfrom;
-      double py[3], px[3];
-      Int64 X, Y;
-
-      for (Y = 0; Y < wdims[1]; Y++)
+      bool bOk = ParallelFor::run(wdims[1], row_nbytes, aborted, [&](Int64 from, Int64 to)
       {
-        if (aborted())
-          return false;
-
-        py[0] = Ti[1] * Y + Ti[2];
-        py[1] = Ti[4] * Y + Ti[5];
-        py[2] = Ti[7] * Y + Ti[8];
-
-        for (X = 0; X < wdims[0]; X++, wfrom++)
+        //local copies, otherwise they are reloaded after each (byte-aliasing) sample store
+        auto W = write; auto W_alpha = write_alpha;
+        auto R = read;  auto R_alpha = read_alpha;
+        const double dx[3] = { Ti[0], Ti[3], Ti[6] };
+        const double rw = (double)rdims[0], rh = (double)rdims[1];
+        const Int64 width = wdims[0], X0 = offset[0], rs0 = rstride[0], rs1 = rstride[1];
+
+        Int64 rfrom, wfrom = from * width;
+        double py[3], px[3];
+        Int64 X, Y;
+
+        for (Y = from; Y < to; Y++)
         {
-          px[0] = Ti[0] * X + py[0];
-          px[1] = Ti[3] * X + py[1];
-          px[2] = Ti[6] * X + py[2];
-
-          px[0] /= px[2];
-          px[1] /= px[2];
+          py[0] = Ti[1] * (Y + offset[1]) + Ti[2];
+          py[1] = Ti[4] * (Y + offset[1]) + Ti[5];
+          py[2] = Ti[7] * (Y + offset[1]) + Ti[8];
 
-          if (px[0] >= 0 && px[0] < rdims[0] && px[1] >= 0 && px[1] < rdims[1])
+          for (X = 0; X < width; X++, wfrom++)
           {
-            rfrom = Int64(px[0]) * rstride[0] + Int64(px[1]) * rstride[1];
-            write      [wfrom] = read      [rfrom];
-            write_alpha[wfrom] = read_alpha[rfrom];
+            px[0] = dx[0] * (X + X0) + py[0];
+            px[1] = dx[1] * (X + X0) + py[1];
+            px[2] = dx[2] * (X + X0) + py[2];
+
+            px[0] /= px[2];
+            px[1] /= px[2];
+
+            if (px[0] >= 0 && px[0] < rw && px[1] >= 0 && px[1] < rh)
+            {
+              rfrom = Int64(px[0]) * rs0 + Int64(px[1]) * rs1;
+              W      [wfrom] = R      [rfrom];
+              W_alpha[wfrom] = R_alpha[rfrom];
+            }
           }
         }
-      }
+      });
+
+      if (!bOk)
+        return false;
     }
     else if (pdim == 3)
     {
-      double px[4], py[4], pz[4];
-      Int64 X,Y,Z,rfrom;
-      for (Z = 0; Z < wdims[2]; Z++)
+      bool bOk = ParallelFor::run(wdims[1] * wdims[2], row_nbytes, aborted, [&](Int64 from, Int64 to)
       {
-        pz[0] = Ti[ 2] * Z + Ti[ 3];
-        pz[1] = Ti[ 6] * Z + Ti[ 7];
-        pz[2] = Ti[10] * Z + Ti[11];
-        pz[3] = Ti[14] * Z + Ti[15];
-
-        for (Y = 0; Y < wdims[1]; Y++)
+        //local copies, otherwise they are reloaded after each (byte-aliasing) sample store
+        auto W = write; auto W_alpha = write_alpha;
+        auto R = read;  auto R_alpha = read_alpha;
+        const double dx[4] = { Ti[0], Ti[4], Ti[8], Ti[12] };
+        const double rw = (double)rdims[0], rh = (double)rdims[1], rd = (double)rdims[2];
+        const Int64 width = wdims[0], X0 = offset[0], rs0 = rstride[0], rs1 = rstride[1], rs2 = rstride[2];
+
+        double px[4], py[4], pz[4];
+        Int64 X, Y, Z, rfrom, wfrom = from * width;
+        for (Int64 row = from; row < to; row++)
         {
-          if (aborted())
-            return false;
+          Y = row % wdims[1];
+          Z = row / wdims[1];
 
-          py[0] = Ti[ 1] * Y + pz[0];
-          py[1] = Ti[ 5] * Y + pz[1];
-          py[2] = Ti[ 9] * Y + pz[2];
-          py[3] = Ti[13] * Y + pz[3];
+          pz[0] = Ti[ 2] * (Z + offset[2]) + Ti[ 3];
+          pz[1] = Ti[ 6] * (Z + offset[2]) + Ti[ 7];
+          pz[2] = Ti[10] * (Z + offset[2]) + Ti[11];
+          pz[3] = Ti[14] * (Z + offset[2]) + Ti[15];
 
-          for (X = 0; X < wdims[0]; X++, wfrom++)
+          py[0] = Ti[ 1] * (Y + offset[1]) + pz[0];
+          py[1] = Ti[ 5] * (Y + offset[1]) + pz[1];
+          py[2] = Ti[ 9] * (Y + offset[1]) + pz[2];
+          py[3] = Ti[13] * (Y + offset[1]) + pz[3];
+
+          for (X = 0; X < width; X++, wfrom++)
           {
-            px[0] = Ti[ 0] * X + py[0];
-            px[1] = Ti[ 4] * X + py[1];
-            px[2] = Ti[ 8] * X + py[2];
-            px[3] = Ti[12] * X + py[3];
+            px[0] = dx[0] * (X + X0) + py[0];
+            px[1] = dx[1] * (X + X0) + py[1];
+            px[2] = dx[2] * (X + X0) + py[2];
+            px[3] = dx[3] * (X + X0) + py[3];
 
             px[0] /= px[3];
             px[1] /= px[3];
             px[2] /= px[3];
 
             if (
-              px[0] >= 0 && px[0] < rdims[0] &&
-              px[1] >= 0 && px[1] < rdims[1] &&
-              px[2] >= 0 && px[2] < rdims[2])
+              px[0] >= 0 && px[0] < rw &&
+              px[1] >= 0 && px[1] < rh &&
+              px[2] >= 0 && px[2] < rd)
             {
-              rfrom = Int64(px[0]) * rstride[0] + Int64(px[1]) * rstride[1] + Int64(px[2]) * rstride[2];
-              write      [wfrom] = read      [rfrom];
-              write_alpha[wfrom] = read_alpha[rfrom];
+              rfrom = Int64(px[0]) * rs0 + Int64(px[1]) * rs1 + Int64(px[2]) * rs2;
+              W      [wfrom] = R      [rfrom];
+              W_alpha[wfrom] = R_alpha[rfrom];
             }
           }
         }
-      }
+      });
+
+      if (!bOk)
+        return false;
     }
     else
     {
+      Int64 wfrom = 0;
       for (auto P = ForEachPoint(wdims); !P.end(); P.next(), ++wfrom)
       {
         if (aborted()) 
           return false;
 
-        auto S = Ti* P.pos;
+        auto S = Ti* (P.pos + offset);
 
         VisusAssert(false);//todo...
 
@@ -1537,9 +1762,14 @@ public:
 };
 
 bool ArrayUtils::warpPerspective(Array& dst, Matrix T,Array src,Aborted aborted)
+{
+  return warpPerspective(dst, T, src, PointNi(dst.dims.getPointDim()), aborted);
+}
+
+bool ArrayUtils::warpPerspective(Array& dst, Matrix T, Array src, PointNi offset, Aborted aborted)
 {
   WarpPerspective op;
-  return NeedToCopySamples(op,src.dtype,dst, T,src, aborted);
+  return NeedToCopySamples(op,src.dtype,dst, T,src, offset, aborted);
 }
 
 
@@ -1556,9 +1786,9 @@ public:
   //for voronoi
   Array         best_distance;
 
-  //execute
+  //execute (src covers the samples of dst starting at offset)
   template <class CppType>
-  bool execute(Type type, Array& dst, Array src, Aborted aborted)
+  bool execute(Type type, Array& dst, Array src, PointNi offset, PointNi dst_dims, Aborted aborted)
   {
     if (!src.valid()) {
       VisusAssert(false);
@@ -1576,15 +1806,13 @@ public:
     //first argument
     if (!dst.valid())
     {
-      auto dims = src.dims;
-
-      if (!dst.resize(dims, src.dtype, __FILE__, __LINE__))
+      if (!dst.resize(dst_dims, src.dtype, __FILE__, __LINE__))
         return false;
 
       dst.fillWithValue(0);
       dst.shareProperties(src);
 
-      dst.alpha = std::make_shared<Array>(dims, DTypes::UINT8);
+      dst.alpha = std::make_shared<Array>(dst_dims, DTypes::UINT8);
       dst.alpha->fillWithValue(0);
     }
 
@@ -1592,9 +1820,13 @@ public:
     if (!dst.getTotalNumberOfSamples())
       return true;
 
-    auto dims   = dst.dims;
-    auto pdim   = dims.getPointDim(); 
+    auto pdim = dst.dims.getPointDim(); 
     VisusReleaseAssert(pdim <= 3); //todo other cases
+    VisusReleaseAssert(src.dims.getPointDim() == pdim && offset.getPointDim() == pdim);
+    for (int D = 0; D < pdim; D++)
+      VisusReleaseAssert(offset[D] >= 0 && offset[D] + src.dims[D] <= dst.dims[D]);
+
+    auto dims = src.dims;
     dims.setPointDim(3,1);
 
     auto width  = dims[0];
@@ -1602,13 +1834,21 @@ public:
     auto depth  = dims[2];
     auto ncomponents = dst.dtype.ncomponents();
 
+    auto DIMS = dst.dims;
+    DIMS.setPointDim(3, 1);
+    offset.setPointDim(3, 0);
+
+    //first sample of the (Y,Z) line inside dst
+    auto getDstLine = [&](Int64 Y, Int64 Z) {
+      return offset[0] + DIMS[0] * ((Y + offset[1]) + DIMS[1] * (Z + offset[2]));
+    };
+
     #define isEmptyLine() (!SRC_ALPHA[SampleId]  && (width == 1 || memcmp(&SRC_ALPHA[SampleId], &SRC_ALPHA[SampleId + 1], width - 1)==0))
 
     if (type == GenericBlend)
     {
       for (int C = 0; C < ncomponents; C++)
       {
-        Int64 SampleId = 0;
         GetComponentSamples<CppType> DST(dst, C); GetSamples<Uint8> DST_ALPHA(*dst.alpha);
         GetComponentSamples<CppType> SRC(src, C); GetSamples<Uint8> SRC_ALPHA(*src.alpha);
 
@@ -1619,19 +1859,17 @@ public:
             if (aborted())
               return false;
 
+            Int64 SampleId = width * (Y + height * Z);
             if (isEmptyLine())
-            {
-              SampleId += width;
               continue;
-            }
 
-            for (int X = 0; X < width; X++, ++SampleId)
+            for (Int64 X = 0, DstId = getDstLine(Y, Z); X < width; X++, ++SampleId, ++DstId)
             {
               if (SRC_ALPHA[SampleId])
               {
                 auto alpha = SRC_ALPHA[SampleId] / 255.0;
-                DST[SampleId] += (CppType)(alpha*SRC[SampleId]);
-                DST_ALPHA[SampleId] = 255;
+                DST[DstId] += (CppType)(alpha*SRC[SampleId]);
+                DST_ALPHA[DstId] = 255;
               }
             }
           }
@@ -1644,7 +1882,6 @@ public:
     {
       for (int C = 0; C < ncomponents; C++)
       {
-        Int64 SampleId = 0;
         GetComponentSamples<CppType> DST(dst, C); GetSamples<Uint8> DST_ALPHA(*dst.alpha);
         GetComponentSamples<CppType> SRC(src, C); GetSamples<Uint8> SRC_ALPHA(*src.alpha);
 
@@ -1655,18 +1892,16 @@ public:
             if (aborted())
               return false;
 
+            Int64 SampleId = width * (Y + height * Z);
             if (isEmptyLine())
-            {
-              SampleId += width;
               continue;
-            }
 
-            for (int X = 0; X < width; X++, ++SampleId)
+            for (Int64 X = 0, DstId = getDstLine(Y, Z); X < width; X++, ++SampleId, ++DstId)
             {
               if (SRC_ALPHA[SampleId])
               {
-                DST[SampleId] = SRC[SampleId];
-                DST_ALPHA[SampleId] = 255;
+                DST[DstId] = SRC[SampleId];
+                DST_ALPHA[DstId] = 255;
               }
             }
           }
@@ -1679,10 +1914,10 @@ public:
     {
       if (!num.valid())
       {
-        if (!num.resize(dims, DType(ncomponents , DTypes::FLOAT64), __FILE__, __LINE__))
+        if (!num.resize(DIMS, DType(ncomponents , DTypes::FLOAT64), __FILE__, __LINE__))
           return false;
 
-        if (!den.resize(dims, DType(ncomponents , DTypes::FLOAT64), __FILE__, __LINE__))
+        if (!den.resize(DIMS, DType(ncomponents , DTypes::FLOAT64), __FILE__, __LINE__))
           return false;
 
         num.fillWithValue(0);
@@ -1691,7 +1926,6 @@ public:
 
       for (int C = 0; C < ncomponents; C++)
       {
-        Int64 SampleId = 0;
         GetComponentSamples<CppType> DST(dst, C); GetSamples<Uint8> DST_ALPHA(*dst.alpha);
         GetComponentSamples<CppType> SRC(src, C); GetSamples<Uint8> SRC_ALPHA(*src.alpha);
         GetComponentSamples<Float64> NUM(num, C);
@@ -1704,21 +1938,19 @@ public:
             if (aborted())
               return false;
 
+            Int64 SampleId = width * (Y + height * Z);
             if (isEmptyLine())
-            {
-              SampleId += width;
               continue;
-            }
 
-            for (int X = 0; X < width; X++, ++SampleId)
+            for (Int64 X = 0, DstId = getDstLine(Y, Z); X < width; X++, ++SampleId, ++DstId)
             {
               if (SRC_ALPHA[SampleId])
               {
                 double alpha = SRC_ALPHA[SampleId] / 255.0;
-                NUM[SampleId] += alpha * SRC[SampleId];
-                DEN[SampleId] += alpha;
-                DST[SampleId] = (CppType)(NUM[SampleId] / DEN[SampleId]);
-                DST_ALPHA[SampleId] = 255;
+                NUM[DstId] += alpha * SRC[SampleId];
+                DEN[DstId] += alpha;
+                DST[DstId] = (CppType)(NUM[DstId] / DEN[DstId]);
+                DST_ALPHA[DstId] = 255;
               }
             }
           }
@@ -1732,13 +1964,13 @@ public:
     { 
       if (!best_distance.valid())
       {
-        if (!best_distance.resize(src.dims, DType(ncomponents, DTypes::FLOAT64), __FILE__, __LINE__))
+        if (!best_distance.resize(dst.dims, DType(ncomponents, DTypes::FLOAT64), __FILE__, __LINE__))
           return false;
 
         for (int C = 0; C < ncomponents; C++)
         {
           GetComponentSamples<Float64> DST(best_distance, C);
-          for (Int64 I = 0, Tot = dims.innerProduct(); I < Tot; I++)
+          for (Int64 I = 0, Tot = DIMS.innerProduct(); I < Tot; I++)
             DST[I] = NumericLimits<double>::highest();
         }
       }
@@ -1746,6 +1978,7 @@ public:
       VisusReleaseAssert(src.run_time_attributes.hasValue("PIXEL_TO_LOGIC"));
       VisusReleaseAssert(src.run_time_attributes.hasValue("LOGIC_CENTROID"));
 
+      //NOTE: PIXEL_TO_LOGIC is relative to dst samples
       auto pixel_to_logic = Matrix::fromString(src.run_time_attributes.getValue("PIXEL_TO_LOGIC"));
       auto logic_centroid = PointNd::fromString(src.run_time_attributes.getValue("LOGIC_CENTROID"));
 
@@ -1758,14 +1991,13 @@ public:
       {
         for (int C = 0; C < ncomponents; C++)
         {
-          int SampleId = 0;
           GetComponentSamples<CppType> DST(dst, C); 
           GetComponentSamples<CppType> SRC(src, C); 
           GetSamples<Uint8> DST_ALPHA(*dst.alpha);
           GetSamples<Uint8> SRC_ALPHA(*src.alpha);
           GetComponentSamples<Float64> BEST_DISTANCE(best_distance, C);
 
-          Int64 X, Y;
+          Int64 X, Y, SampleId, DstId;
           double py[3], px[3], distance;
 
           for (Y = 0; Y < height; Y++)
@@ -1773,18 +2005,18 @@ public:
             if (aborted())
               return false;
 
-            py[0] = T[1] * Y + T[2];
-            py[1] = T[4] * Y + T[5];
-            py[2] = T[7] * Y + T[8];
+            py[0] = T[1] * (Y + offset[1]) + T[2];
+            py[1] = T[4] * (Y + offset[1]) + T[5];
+            py[2] = T[7] * (Y + offset[1]) + T[8];
 
-            for (X = 0; X < width; X++, ++SampleId)
+            for (X = 0, SampleId = width * Y, DstId = getDstLine(Y, 0); X < width; X++, ++SampleId, ++DstId)
             {
               if (SRC_ALPHA[SampleId])
               {
                 //(T * Point3d(X, Y) - logic_centroid).module2();
-                px[0] = T[0] * X + py[0];
-                px[1] = T[3] * X + py[1];
-                px[2] = T[6] * X + py[2];
+                px[0] = T[0] * (X + offset[0]) + py[0];
+                px[1] = T[3] * (X + offset[0]) + py[1];
+                px[2] = T[6] * (X + offset[0]) + py[2];
 
                 px[0] /= px[2];
                 px[1] /= px[2];
@@ -1793,11 +2025,11 @@ public:
                 px[1] -= logic_centroid[1];
 
                 distance = px[0] * px[0] + px[1] * px[1];
-                if (distance < BEST_DISTANCE[SampleId])
+                if (distance < BEST_DISTANCE[DstId])
                 {
-                  BEST_DISTANCE[SampleId] = distance;
-                  DST[SampleId] = SRC[SampleId];
-                  DST_ALPHA[SampleId] = 255;
+                  BEST_DISTANCE[DstId] = distance;
+                  DST[DstId] = SRC[SampleId];
+                  DST_ALPHA[DstId] = 255;
                 }
               }
             }
@@ -1808,46 +2040,43 @@ public:
       {
         for (int C = 0; C < ncomponents; C++)
         {
-          Int64 SampleId = 0;
           GetComponentSamples<CppType> DST(dst, C); GetSamples<Uint8> DST_ALPHA(*dst.alpha);
           GetComponentSamples<CppType> SRC(src, C); GetSamples<Uint8> SRC_ALPHA(*src.alpha);
           GetComponentSamples<Float64> BEST_DISTANCE(best_distance, C);
 
-          Int64 X, Y, Z;
+          Int64 X, Y, Z, DstId;
           double pz[4], py[4], px[4], distance;
 
           for (Z = 0; Z < depth; Z++)
           {
-            pz[0] = T[ 2] * Z + T[ 3];
-            pz[1] = T[ 6] * Z + T[ 7];
-            pz[2] = T[10] * Z + T[11];
-            pz[3] = T[14] * Z + T[15];
+            pz[0] = T[ 2] * (Z + offset[2]) + T[ 3];
+            pz[1] = T[ 6] * (Z + offset[2]) + T[ 7];
+            pz[2] = T[10] * (Z + offset[2]) + T[11];
+            pz[3] = T[14] * (Z + offset[2]) + T[15];
 
             for (Y = 0; Y < height; Y++)
             {
               if (aborted())
                 return false;
 
+              Int64 SampleId = width * (Y + height * Z);
               if (isEmptyLine())
-              {
-                SampleId += width;
                 continue;
-              }
 
-              py[0] = T[ 1] * Y + pz[0];
-              py[1] = T[ 5] * Y + pz[1];
-              py[2] = T[ 9] * Y + pz[2];
-              py[3] = T[13] * Y + pz[3];
+              py[0] = T[ 1] * (Y + offset[1]) + pz[0];
+              py[1] = T[ 5] * (Y + offset[1]) + pz[1];
+              py[2] = T[ 9] * (Y + offset[1]) + pz[2];
+              py[3] = T[13] * (Y + offset[1]) + pz[3];
 
-              for (X = 0; X < width; X++, ++SampleId)
+              for (X = 0, DstId = getDstLine(Y, Z); X < width; X++, ++SampleId, ++DstId)
               {
                 if (SRC_ALPHA[SampleId])
                 {
                   //(T * Point3d(X, Y, Z) - logic_centroid).module2();
-                  px[0] = T[ 0] * X + py[0];
-                  px[1] = T[ 4] * X + py[1];
-                  px[2] = T[ 8] * X + py[2];
-                  px[3] = T[12] * X + py[3];
+                  px[0] = T[ 0] * (X + offset[0]) + py[0];
+                  px[1] = T[ 4] * (X + offset[0]) + py[1];
+                  px[2] = T[ 8] * (X + offset[0]) + py[2];
+                  px[3] = T[12] * (X + offset[0]) + py[3];
 
                   px[0] /= px[3]; 
                   px[1] /= px[3]; 
@@ -1858,11 +2087,11 @@ public:
                   px[2] -= logic_centroid[2];
 
                   distance = px[0] * px[0] + px[1] * px[1] + px[2] * px[2];
-                  if (distance < BEST_DISTANCE[SampleId])
+                  if (distance < BEST_DISTANCE[DstId])
                   {
-                    BEST_DISTANCE[SampleId] = distance;
-                    DST[SampleId] = SRC[SampleId];
-                    DST_ALPHA[SampleId] = 255;
+                    BEST_DISTANCE[DstId] = distance;
+                    DST[DstId] = SRC[SampleId];
+                    DST_ALPHA[DstId] = 255;
                   }
                 }
               }
@@ -1885,7 +2114,7 @@ public:
 
 
 /////////////////////////////////////////////////////
-BlendBuffers::BlendBuffers(Type type_, Aborted aborted_) : type(type_),aborted(aborted_) {
+BlendBuffers::BlendBuffers(Type type_, Aborted aborted_) : type(type_),aborted(aborted_),nargs(0) {
   pimpl = new Pimpl();
 }
 
@@ -1894,8 +2123,12 @@ BlendBuffers::~BlendBuffers() {
 }
 
 void BlendBuffers::addBlendArg(Array src) {
+  addBlendArg(src, PointNi(src.dims.getPointDim()), src.dims);
+}
+
+void BlendBuffers::addBlendArg(Array src, PointNi offset, PointNi dims) {
   ++nargs;
-  ExecuteOnCppSamples(*pimpl, src.dtype, type, result,src, aborted);
+  ExecuteOnCppSamples(*pimpl, src.dtype, type, result, src, offset, dims, aborted);
 }
 
 
@@ -1972,6 +2205,18 @@ public:
     inline void operator++(int)
     {ptr+=stride;}
 
+    //advance
+    inline void advance(Int64 num)
+    {ptr+=num*stride;}
+
+    //isContiguous
+    inline bool isContiguous() const
+    {return stride==(int)sizeof(Type);}
+
+    //c_ptr
+    inline Type* c_ptr() const
+    {return (Type*)ptr;}
+
   private:
 
     DType     dtype;
@@ -2013,6 +2258,10 @@ public:
     inline void operator++()
     {for (int I=0;I<niterators;I++) ++iterators[I];}
 
+    //advance
+    inline void advance(Int64 num)
+    {for (int I=0;I<niterators;I++) iterators[I].advance(num);}
+
   private:
 
     int                                niterators;
@@ -2039,6 +2288,14 @@ public:
       for (int I=0;I<nargs;I++) add+=(double)(*args[I]);
       (*dst)=(Type)add;
     }
+
+    //fold (contiguous case, acc starts from the first argument)
+    static inline double fold(double acc,double value)
+    {return acc+value;}
+
+    //finish
+    inline double finish(double acc) const
+    {return acc;}
   };
 
   //________________________________________________________________
@@ -2060,6 +2317,14 @@ public:
       for (int I=1;I<nargs;I++) sub-=(double)(*args[I]);
       (*dst)=((Type)sub);
     }
+
+    //fold (contiguous case, acc starts from the first argument)
+    static inline double fold(double acc,double value)
+    {return acc-value;}
+
+    //finish
+    inline double finish(double acc) const
+    {return acc;}
   };
 
   //________________________________________________________________
@@ -2081,6 +2346,14 @@ public:
       for (int I=0;I<nargs;I++) mul*=(double)(*args[I]);
       (*dst)=(Type)mul;
     }
+
+    //fold (contiguous case, acc starts from the first argument)
+    static inline double fold(double acc,double value)
+    {return acc*value;}
+
+    //finish
+    inline double finish(double acc) const
+    {return acc;}
   };
 
   //________________________________________________________________
@@ -2124,6 +2397,14 @@ public:
       for (int I=1;I<nargs;I++) min=std::min(min,*args[I]);
       (*dst)=(Type)min;
     }
+
+    //fold (contiguous case, acc starts from the first argument)
+    static inline double fold(double acc,double value)
+    {return value<acc? value : acc;}
+
+    //finish
+    inline double finish(double acc) const
+    {return acc;}
   };
 
   //________________________________________________________________
@@ -2145,6 +2426,14 @@ public:
       for (int I=1;I<nargs;I++) max=std::max(max,*args[I]);
       (*dst)=(Type)max;
     }
+
+    //fold (contiguous case, acc starts from the first argument)
+    static inline double fold(double acc,double value)
+    {return acc<value? value : acc;}
+
+    //finish
+    inline double finish(double acc) const
+    {return acc;}
   };
 
   //________________________________________________________________
@@ -2167,6 +2456,14 @@ public:
       avg/=nargs;
       (*dst)=(Type)avg;
     }
+
+    //fold (contiguous case, acc starts from the first argument)
+    static inline double fold(double acc,double value)
+    {return acc+value;}
+
+    //finish
+    inline double finish(double acc) const
+    {return acc/nargs;}
   };
 
   //________________________________________________________________
@@ -2283,13 +2580,57 @@ public:
   bool computeOperation(ArrayIterator<Type> dst,ArrayMultiIterator<Type> args)
   {
     Int64 tot=this->dst.getTotalNumberOfSamples();
-    OperationClass op((int)args.size());
-    for (Int64 I=0;I<tot;I++,++dst,++args)
+    Int64 item_nbytes=(Int64)this->dst.dtype.getByteSize()*(1+args.size());
+    return ParallelFor::run(tot,item_nbytes,aborted,[&](Int64 from,Int64 to)
     {
-      if (aborted()) return false;
-      op.compute(dst,args);
-    }
-    return true;
+      auto chunk_dst =dst ; chunk_dst .advance(from);
+      auto chunk_args=args; chunk_args.advance(from);
+      OperationClass op((int)args.size());
+      for (Int64 I=from;I<to;I++,++chunk_dst,++chunk_args)
+        op.compute(chunk_dst,chunk_args);
+    });
+  }
+
+  //computeFoldOperation (single-component arguments: one unit-stride loop for each argument on a block of samples)
+  template <class OperationClass, typename Type>
+  bool computeFoldOperation(ArrayIterator<Type> dst,ArrayMultiIterator<Type> args)
+  {
+    int nargs=args.size();
+
+    //Int64 does not fit in a double
+    bool contiguous=dst.isContiguous() && std::numeric_limits<Type>::digits<=std::numeric_limits<double>::digits;
+    for (int I=0;I<nargs;I++) 
+      contiguous=contiguous && args[I].isContiguous();
+
+    if (!contiguous)
+      return computeOperation<OperationClass,Type>(dst,args);
+
+    Int64 tot=this->dst.getTotalNumberOfSamples();
+    return ParallelFor::run(tot,sizeof(Type)*(1+nargs),aborted,[&](Int64 from,Int64 to)
+    {
+      const int BlockSize=1024;
+      double acc[BlockSize];
+      OperationClass op(nargs);
+      for (Int64 B=from;B<to;B+=BlockSize)
+      {
+        int num=(int)std::min((Int64)BlockSize,to-B);
+
+        const Type* first=args[0].c_ptr()+B;
+        for (int I=0;I<num;I++) 
+          acc[I]=(double)first[I];
+
+        for (int A=1;A<nargs;A++)
+        {
+          const Type* arg=args[A].c_ptr()+B;
+          for (int I=0;I<num;I++) 
+            acc[I]=OperationClass::fold(acc[I],(double)arg[I]);
+        }
+
+        Type* write=dst.c_ptr()+B;
+        for (int I=0;I<num;I++) 
+          write[I]=(Type)op.finish(acc[I]);
+      }
+    });
   }
 
   //assignOperation
@@ -2298,13 +2639,13 @@ public:
   {
     switch (op)
     {
-      case ArrayUtils::AddOperation               : return computeOperation< AddOperation                <Type> , Type >(dst,args);
-      case ArrayUtils::SubOperation               : return computeOperation< SubOperation                <Type> , Type >(dst,args);
-      case ArrayUtils::MulOperation               : return computeOperation< MulOperation                <Type> , Type >(dst,args);
+      case ArrayUtils::AddOperation               : return computeFoldOperation< AddOperation            <Type> , Type >(dst,args);
+      case ArrayUtils::SubOperation               : return computeFoldOperation< SubOperation            <Type> , Type >(dst,args);
+      case ArrayUtils::MulOperation               : return computeFoldOperation< MulOperation            <Type> , Type >(dst,args);
       case ArrayUtils::DivOperation               : return computeOperation< DivOperation                <Type> , Type >(dst,args);
-      case ArrayUtils::MinOperation               : return computeOperation< MinOperation                <Type> , Type >(dst,args);
-      case ArrayUtils::MaxOperation               : return computeOperation< MaxOperaration              <Type> , Type >(dst,args);
-      case ArrayUtils::AverageOperation           : return computeOperation< AverageOperation            <Type> , Type >(dst,args);
+      case ArrayUtils::MinOperation               : return computeFoldOperation< MinOperation            <Type> , Type >(dst,args);
+      case ArrayUtils::MaxOperation               : return computeFoldOperation< MaxOperaration          <Type> , Type >(dst,args);
+      case ArrayUtils::AverageOperation           : return computeFoldOperation< AverageOperation        <Type> , Type >(dst,args);
       case ArrayUtils::StandardDeviationOperation : return computeOperation< StandardDeviationOperation  <Type> , Type >(dst,args);
       case ArrayUtils::MedianOperation            : return computeOperation< MedianOperation             <Type> , Type >(dst,args);
       default: break;
@@ -2439,23 +2780,175 @@ Array ArrayUtils::executeOperation(Operation op,std::vector<Array> args,Aborted
   return ExecuteOperation(op,dst,args,aborted).execute()? dst : Array();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//mixed-radix complex FFT (decimation in time, see kissfft), sizes must have only 2,3,5 as factors
+class ConvolveFFT
+{
+public:
+
+  typedef std::complex<Float64> Complex;
+
+  //constructor
+  ConvolveFFT(Int64 n_, bool inverse) : n(n_)
+  {
+    twiddles.resize(n);
+    for (Int64 I = 0; I < n; I++)
+    {
+      double phase = (inverse ? +2.0 : -2.0) * Math::Pi * I / n;
+      twiddles[I] = Complex(cos(phase), sin(phase));
+    }
+
+    for (Int64 m = n, p = 2; m > 1; )
+    {
+      while (m % p) p++;
+      VisusReleaseAssert(p <= 5);
+      m /= p;
+      factors.push_back(std::make_pair((int)p, m));
+    }
+  }
+
+  //getGoodSize (smallest 2^a*3^b*5^c not smaller than value)
+  static Int64 getGoodSize(Int64 value)
+  {
+    for (Int64 ret = std::max(value, (Int64)1); ; ret++)
+    {
+      Int64 m = ret;
+      while (m % 2 == 0) m /= 2;
+      while (m % 3 == 0) m /= 3;
+      while (m % 5 == 0) m /= 5;
+      if (m == 1)
+        return ret;
+    }
+  }
+
+  //execute (in is read with a stride, out must be a different buffer)
+  void execute(const Complex* in, Int64 in_stride, Complex* out) const
+  {
+    if (n == 1)
+      out[0] = in[0];
+    else
+      work(out, in, 1, in_stride, 0);
+  }
+
+  //transform (all the axes of a buffer with dims L, in place)
+  static bool transform(std::vector<Complex>& data, const std::vector<Int64>& L, bool inverse, Aborted aborted)
+  {
+    Int64 tot = (Int64)data.size(), inner = 1;
+    for (int D = 0; D < (int)L.size(); inner *= L[D++])
+    {
+      Int64 n = L[D];
+      if (n == 1)
+        continue;
+
+      ConvolveFFT fft(n, inverse);
+      Int64 nlines = tot / n;
+      bool bOk = ParallelFor::run(nlines, n * sizeof(Complex), aborted, [&](Int64 from, Int64 to)
+      {
+        std::vector<Complex> line(n);
+        for (Int64 I = from; I < to; I++)
+        {
+          Complex* first = &data[(I / inner) * inner * n + (I % inner)];
+          fft.execute(first, inner, &line[0]);
+          for (Int64 J = 0; J < n; J++)
+            first[J * inner] = line[J];
+        }
+      });
+
+      if (!bOk)
+        return false;
+    }
+    return true;
+  }
+
+private:
+
+  Int64                               n;
+  std::vector<Complex>                twiddles;
+  std::vector< std::pair<int, Int64> > factors;
+
+  //work
+  void work(Complex* out, const Complex* in, Int64 fstride, Int64 in_stride, int stage) const
+  {
+    int   p = factors[stage].first;
+    Int64 m = factors[stage].second;
+
+    for (int K = 0; K < p; K++, in += fstride * in_stride)
+    {
+      if (m == 1)
+        out[K] = *in;
+      else
+        work(out + K * m, in, fstride * p, in_stride, stage + 1);
+    }
+
+    if (p == 2)
+    {
+      for (Int64 K = 0; K < m; K++)
+      {
+        Complex t = out[K + m] * twiddles[K * fstride];
+        out[K + m] = out[K] - t;
+        out[K] += t;
+      }
+      return;
+    }
+
+    //generic butterfly (p is 3 or 5)
+    Complex scratch[5];
+    for (Int64 U = 0; U < m; U++)
+    {
+      for (Int64 Q1 = 0, K = U; Q1 < p; Q1++, K += m)
+        scratch[Q1] = out[K];
+
+      for (Int64 Q1 = 0, K = U; Q1 < p; Q1++, K += m)
+      {
+        Int64 twidx = 0;
+        out[K] = scratch[0];
+        for (int Q = 1; Q < p; Q++)
+        {
+          twidx += fstride * K;
+          if (twidx >= n) twidx -= n;
+          out[K] += scratch[Q] * twiddles[twidx];
+        }
+      }
+    }
+  }
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename DstType>
+inline DstType ConvolveCast(Float64 value)
+{
+  //integer outputs are rounded and saturated
+  if (std::numeric_limits<DstType>::is_integer)
+  {
+    if (!(value >= (Float64)std::numeric_limits<DstType>::lowest())) return std::numeric_limits<DstType>::lowest();
+    if (!(value <= (Float64)std::numeric_limits<DstType>::max   ())) return std::numeric_limits<DstType>::max();
+    return (DstType)floor(value + 0.5);
+  }
+  return (DstType)value;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 struct ConvolveOp
 {
+  DType output_dtype = DTypes::FLOAT64;
+
+  //cost of one FFT butterfly (for each sample and each stage) compared to one multiply-add of the dense kernel
+  enum { FFTCostFactor = 12 };
+
   template<typename SrcType>
   bool execute(Array& dst,Array src,Array& kernel,Aborted aborted)
   {
     //necessary conditions
     if (!src.dtype.valid() ||
         !kernel.getTotalNumberOfSamples() ||
-        !kernel.dtype.valid() ||
-        kernel.dtype.ncomponents()!=1)
+        kernel.dtype!=DTypes::FLOAT64)
     {
       VisusAssert(aborted());
       return false;
     }
 
-    if (!dst.resize(src.dims,DType(src.dtype.ncomponents(),DTypes::FLOAT64),__FILE__,__LINE__))
+    if (!dst.resize(src.dims,DType(src.dtype.ncomponents(),output_dtype),__FILE__,__LINE__))
       return false;
 
     dst.shareProperties(src);
@@ -2464,6 +2957,21 @@ struct ConvolveOp
     if (!src.getTotalNumberOfSamples())
       return true;
 
+    if (output_dtype==src.dtype.get(0)) return doExecute<SrcType,SrcType>(dst,src,kernel,aborted);
+    if (output_dtype==DTypes::FLOAT32 ) return doExecute<SrcType,Float32>(dst,src,kernel,aborted);
+    if (output_dtype==DTypes::FLOAT64 ) return doExecute<SrcType,Float64>(dst,src,kernel,aborted);
+    VisusAssert(false);
+    return false;
+  }
+
+private:
+
+  typedef ConvolveFFT::Complex Complex;
+
+  //doExecute
+  template<typename SrcType,typename DstType>
+  bool doExecute(Array& dst,Array src,Array& kernel,Aborted aborted)
+  {
     int pdim = src.getPointDim();
 
     //dimensions (ignore where dims==1 i.e. where memory layout does not change (for example src has dims (1,200,300,1,1)->(200,300))
@@ -2491,57 +2999,381 @@ struct ConvolveOp
 
     //what to do with (set|get)SingleComponentRange?
 
-    //for each component...
-    int ncomponents=src.dtype.ncomponents();
-    for (int C=0;C<ncomponents;C++)
+    int            ncomponents=src.dtype.ncomponents();
+    const SrcType* src_p=(const SrcType*)src.c_ptr();
+    DstType*       dst_p=(DstType*)dst.c_ptr();
+    const Float64* kernel_p=(const Float64*)kernel.c_ptr();
+
+    //separable kernel: one 1D pass for each axis
+    std::vector< std::vector<Float64> > factors;
+    if (getSeparableFactors(kernel_p, Kdims, Kspace, factors))
+      return convolveSeparable(dst_p, src_p, ncomponents, Sdims, Kspace, factors, aborted);
+
+    //big kernel: product in the frequency domain
+    std::vector<Int64> L(Kspace);
+    double Ltot = 1.0, Ntot = (double)Sdims.innerProduct(), Kvol = (double)Kdims.innerProduct();
+    for (int D = 0; D < Kspace; D++)
+      Ltot *= (double)(L[D] = ConvolveFFT::getGoodSize(Sdims[D] + Kdims[D] - 1));
+
+    const double fft_cost   = FFTCostFactor * (2 * ncomponents + 1) * Ltot * std::max(1.0, log2(Ltot));
+    const double dense_cost = ncomponents * Ntot * Kvol;
+    const double fft_nbytes = 2 * Ltot * sizeof(Complex);
+    if (fft_cost < dense_cost && fft_nbytes <= getFFTMaxMemory())
+      return convolveFFT(dst_p, src_p, ncomponents, Sdims, Kdims, Kspace, L, kernel_p, aborted);
+
+    return convolveDense(dst_p, src_p, ncomponents, Sdims, Kdims, kernel_p, aborted);
+  }
+
+  //getFFTMaxMemory
+  static double getFFTMaxMemory()
+  {
+    static double ret = []() {
+      auto value = Utils::getEnv("VISUS_CONVOLVE_FFT_MAX_MEMORY");
+      return value.empty() ? 1024.0 * 1024.0 * 1024.0 : (double)StringUtils::getByteSizeFromString(value);
+    }();
+    return ret;
+  }
+
+  //getSeparableFactors (kernel(p) must be factors[0][p[0]]*factors[1][p[1]]*...)
+  static bool getSeparableFactors(const Float64* kernel, PointNi Kdims, int Kspace, std::vector< std::vector<Float64> >& factors)
+  {
+    Int64 tot = Kdims.innerProduct();
+
+    //the biggest coefficient, taking rows and columns through it
+    Int64 M = 0;
+    for (Int64 I = 1; I < tot; I++)
     {
-      PointNi        stride=Sdims.stride()*ncomponents;
-      const SrcType* src_p=((SrcType*)src.c_ptr())+C;
-      Float64*       dst_p=((Float64*)dst.c_ptr())+C;
-      const Float64* kernel_begin=(Float64*)kernel.c_ptr();
+      if (fabs(kernel[I]) > fabs(kernel[M]))
+        M = I;
+    }
 
-      PointNi to=Sdims;
+    Float64 peak = kernel[M];
+    if (!peak || !Utils::isValidNumber(peak))
+      return false;
 
-      // this is a trick to let the inner most loop executing only once
-      to[0]=1; 
+    PointNi stride = Kdims.stride();
+    factors.resize(Kspace);
+    for (int D = 0; D < Kspace; D++)
+    {
+      Int64 m = (M / stride[D]) % Kdims[D];
+      factors[D].resize(Kdims[D]);
+      for (Int64 I = 0; I < Kdims[D]; I++)
+        factors[D][I] = kernel[M + (I - m) * stride[D]] / (D ? peak : 1.0);
+    }
+
+    const Float64 tolerance = 1e-9 * fabs(peak);
+    for (Int64 I = 0; I < tot; I++)
+    {
+      Float64 value = 1.0;
+      for (int D = 0; D < Kspace; D++)
+        value *= factors[D][(I / stride[D]) % Kdims[D]];
+
+      if (!(fabs(value - kernel[I]) <= tolerance))
+        return false;
+    }
+
+    return true;
+  }
+
+  //convolveSeparable
+  template <typename SrcType, typename DstType>
+  static bool convolveSeparable(DstType* dst, const SrcType* src, int ncomponents, PointNi dims, int Kspace, std::vector< std::vector<Float64> > factors, Aborted aborted)
+  {
+    //axis where the kernel has size 1 are just a scale factor
+    std::vector<int> axis;
+    Float64 scale = 1.0;
+    for (int D = 0; D < Kspace; D++)
+    {
+      if (factors[D].size() > 1)
+        axis.push_back(D);
+      else
+        scale *= factors[D][0];
+    }
+
+    Int64 tot = dims.innerProduct() * ncomponents;
+    if (axis.empty())
+      return TransformSamples(dst, 1, src, 1, tot, aborted, [scale](SrcType value) {return ConvolveCast<DstType>((Float64)value * scale); });
+
+    for (auto& it : factors[axis[0]])
+      it *= scale;
+
+    if (axis.size() == 1)
+      return convolveAxis(dst, src, ncomponents, dims, axis[0], factors[axis[0]], aborted);
+
+    //intermediate results are in double precision
+    std::vector<Float64> tmp[2];
+    tmp[0].resize(tot);
+    if (axis.size() > 2)
+      tmp[1].resize(tot);
+
+    if (!convolveAxis(&tmp[0][0], src, ncomponents, dims, axis[0], factors[axis[0]], aborted))
+      return false;
 
-      const Int64 num_step_x=(Sdims[0])/1;
+    for (int I = 1; I < (int)axis.size() - 1; I++)
+    {
+      if (!convolveAxis(&tmp[I % 2][0], &tmp[(I - 1) % 2][0], ncomponents, dims, axis[I], factors[axis[I]], aborted))
+        return false;
+    }
+
+    int last = (int)axis.size() - 1;
+    return convolveAxis(dst, &tmp[(last - 1) % 2][0], ncomponents, dims, axis[last], factors[axis[last]], aborted);
+  }
+
+  //convolveAxis (1D convolution along one axis, samples outside are clamped to the border)
+  template <typename SrcType, typename DstType>
+  static bool convolveAxis(DstType* dst, const SrcType* src, int ncomponents, PointNi dims, int axis, const std::vector<Float64>& taps, Aborted aborted)
+  {
+    const Int64 n = dims[axis], ntaps = (Int64)taps.size(), radius = ntaps / 2;
 
-      for (auto P = ForEachPoint(to); !P.end(); P.next())
+    Int64 inner = ncomponents;
+    for (int D = 0; D < axis; D++)
+      inner *= dims[D];
+
+    Int64 outer = dims.innerProduct() * ncomponents / (inner * n);
+
+    //samples of a line are interleaved with other components only: copy the line extended with the border samples so the taps loop is unit-stride
+    if (inner == ncomponents)
+    {
+      return ParallelFor::run(outer * inner, n * (sizeof(SrcType) + sizeof(DstType)), aborted, [&](Int64 from, Int64 to)
       {
-        // we take out the most inner loop for parallelization
-        for (Int64 i=0;i<Sdims[0];i++) 
+        std::vector<Float64> line(n + ntaps - 1), sum(n);
+        for (Int64 I = from; I < to; I++)
         {
-          // copy P so that different threads don't modify the same variable P
-          PointNi Q=P.pos; 
-          Q[0]=i;
-          Float64 sum=0.0;
-          const Float64* kernel_p=kernel_begin;
-          PointNi Sp(pdim), Kp(pdim), Tp(pdim);
-          //#define ForKernel(n) for (Kp[n]=0, Sp[n]=Q[n]-Kcenter[n]; Kp[n]<Kdims[n]; ++Kp[n], ++Sp[n]) { if (Sp[n]<0 || Sp[n]>=Sdims[n]) { int skip=1; int n1=n; while(n1-- != 0) skip *= Kdims[n1]; kernel_p += skip; continue; }
-          #define ForKernel(n) for (Kp[n]=0, Sp[n]=Q[n]-Kcenter[n]; Kp[n]<Kdims[n]; ++Kp[n], ++Sp[n]) { Tp[n] = Sp[n] < 0 ? 0 : Sp[n]>=Sdims[n] ? Sdims[n]-1 : Sp[n];
-          switch (Kspace)
+          Int64 offset = (I / inner) * inner * n + (I % inner);
+
+          for (Int64 J = 0; J < n + ntaps - 1; J++)
+            line[J] = (Float64)src[offset + Utils::clamp(J - radius, (Int64)0, n - 1) * inner];
+
+          std::fill(sum.begin(), sum.end(), 0.0);
+          for (Int64 T = 0; T < ntaps; T++)
           {
-          case 1:                           ForKernel(0) sum+=(Float64)(src_p[Tp[0]*stride[0]                                ]) * (Float64)(*kernel_p++);}    break;
-          case 2:              ForKernel(1) ForKernel(0) sum+=(Float64)(src_p[Tp[0]*stride[0]+Tp[1]*stride[1]                ]) * (Float64)(*kernel_p++);}}   break;
-          case 3: ForKernel(2) ForKernel(1) ForKernel(0) sum+=(Float64)(src_p[Tp[0]*stride[0]+Tp[1]*stride[1]+Tp[2]*stride[2]]) * (Float64)(*kernel_p++);}}}  break;
-          default:VisusAssert(false);
+            const Float64  k = taps[T];
+            const Float64* shifted = &line[T];
+            for (Int64 J = 0; J < n; J++)
+              sum[J] += shifted[J] * k;
           }
-          #undef ForKernel
-          dst_p[stride[0]*Q[0]]=sum;
+
+          for (Int64 J = 0; J < n; J++)
+            dst[offset + J * inner] = ConvolveCast<DstType>(sum[J]);
         }
-        dst_p+=stride[0]*num_step_x;
-        if (aborted()) return false;
+      });
+    }
+
+    //otherwise accumulate whole rows of inner samples
+    return ParallelFor::run(outer * n, inner * (sizeof(SrcType) + sizeof(DstType)), aborted, [&](Int64 from, Int64 to)
+    {
+      std::vector<Float64> sum(inner);
+      for (Int64 I = from; I < to; I++)
+      {
+        Int64 O = I / n, Q = I % n;
+
+        std::fill(sum.begin(), sum.end(), 0.0);
+        for (Int64 T = 0; T < ntaps; T++)
+        {
+          const Float64  k = taps[T];
+          const SrcType* row = src + (O * n + Utils::clamp(Q - radius + T, (Int64)0, n - 1)) * inner;
+          for (Int64 J = 0; J < inner; J++)
+            sum[J] += (Float64)row[J] * k;
+        }
+
+        DstType* write = dst + I * inner;
+        for (Int64 J = 0; J < inner; J++)
+          write[J] = ConvolveCast<DstType>(sum[J]);
       }
-    }//for each component...
+    });
+  }
+
+  //convolveFFT (source extended with the border samples, correlated with the kernel by a product in frequency domain)
+  template <typename SrcType, typename DstType>
+  static bool convolveFFT(DstType* dst, const SrcType* src, int ncomponents, PointNi Sdims, PointNi Kdims, int Kspace, const std::vector<Int64>& L, const Float64* kernel, Aborted aborted)
+  {
+    Int64 Ltot = 1;
+    for (auto it : L)
+      Ltot *= it;
+
+    const Int64 Stot = Sdims.innerProduct(), Ktot = Kdims.innerProduct();
+    const Int64 nrows = Ltot / L[0];
+    PointNi Sstride = Sdims.stride();
+    PointNi Kstride = Kdims.stride();
+
+    //calls fn(row,first) for each row along the first axis of L, first is the position of the first sample
+    auto forEachRow = [&](std::function<void(Int64, const std::vector<Int64>&)> fn) {
+      return ParallelFor::run(nrows, L[0] * sizeof(Complex), aborted, [&](Int64 from, Int64 to)
+      {
+        std::vector<Int64> first(Kspace, 0);
+        for (Int64 I = from; I < to; I++)
+        {
+          for (Int64 D = 1, rest = I; D < Kspace; rest /= L[D++])
+            first[D] = rest % L[D];
+          fn(I, first);
+        }
+      });
+    };
+
+    //flipped kernel
+    std::vector<Complex> K(Ltot);
+    for (Int64 I = 0; I < Ktot; I++)
+    {
+      Int64 offset = 0;
+      for (Int64 D = Kspace - 1; D >= 0; D--)
+        offset = offset * L[D] + (Kdims[D] - 1 - (I / Kstride[D]) % Kdims[D]);
+      K[offset] = kernel[I];
+    }
+
+    if (!ConvolveFFT::transform(K, L, false, aborted))
+      return false;
+
+    std::vector<Complex> E(Ltot);
+    for (int C = 0; C < ncomponents; C++)
+    {
+      //E(t)=src(clamp(t-Kcenter)) for t<Sdims+Kdims-1, zero elsewhere
+      bool bOk = forEachRow([&](Int64 row, const std::vector<Int64>& first)
+      {
+        Complex* write = &E[row * L[0]];
+
+        Int64 offset = 0;
+        for (int D = 1; D < Kspace; D++)
+        {
+          if (first[D] >= Sdims[D] + Kdims[D] - 1)
+          {
+            std::fill(write, write + L[0], Complex());
+            return;
+          }
+          offset += Utils::clamp(first[D] - Kdims[D] / 2, (Int64)0, Sdims[D] - 1) * Sstride[D];
+        }
+
+        const SrcType* read = src + offset * ncomponents + C;
+        const Int64 n = Sdims[0], radius = Kdims[0] / 2;
+        for (Int64 J = 0; J < L[0]; J++)
+          write[J] = J < n + Kdims[0] - 1 ? Complex((Float64)read[Utils::clamp(J - radius, (Int64)0, n - 1) * ncomponents]) : Complex();
+      });
+
+      if (!bOk || !ConvolveFFT::transform(E, L, false, aborted))
+        return false;
+
+      bOk = ParallelFor::run(Ltot, sizeof(Complex) * 2, aborted, [&](Int64 from, Int64 to) {
+        for (Int64 I = from; I < to; I++)
+          E[I] *= K[I];
+      });
+
+      if (!bOk || !ConvolveFFT::transform(E, L, true, aborted))
+        return false;
+
+      //dst(q)=E(q+Kdims-1)/Ltot
+      bOk = forEachRow([&](Int64 row, const std::vector<Int64>& first)
+      {
+        Int64 offset = 0;
+        for (int D = 1; D < Kspace; D++)
+        {
+          Int64 q = first[D] - (Kdims[D] - 1);
+          if (q < 0 || q >= Sdims[D])
+            return;
+          offset += q * Sstride[D];
+        }
+
+        const Complex* read = &E[row * L[0] + Kdims[0] - 1];
+        DstType* write = dst + offset * ncomponents + C;
+        for (Int64 J = 0; J < Sdims[0]; J++)
+          write[J * ncomponents] = ConvolveCast<DstType>(read[J].real() / (Float64)Ltot);
+      });
+
+      if (!bOk)
+        return false;
+    }
+
     return true;
   }
+
+  //convolveDense (one item is a row along the first axis, accumulated from the extended source rows under each kernel row)
+  template <typename SrcType, typename DstType>
+  static bool convolveDense(DstType* dst, const SrcType* src, int ncomponents, PointNi Sdims, PointNi Kdims, const Float64* kernel, Aborted aborted)
+  {
+    Int64 nrows = Sdims.innerProduct() / Sdims[0] * ncomponents;
+    return ParallelFor::run(nrows, Sdims[0] * Kdims.innerProduct() * sizeof(Float64), aborted, [&](Int64 from, Int64 to) {
+      convolveDenseRows(dst, src, ncomponents, Sdims, Kdims, kernel, from, to);
+    });
+  }
+
+  //convolveDenseRows
+  template <typename SrcType, typename DstType>
+  static void convolveDenseRows(DstType* dst, const SrcType* src, int ncomponents, const PointNi Sdims, const PointNi Kdims, const Float64* kernel, Int64 from, Int64 to)
+  {
+    const int     pdim = Sdims.getPointDim();
+    const PointNi stride = Sdims.stride();
+    const Int64   n = Sdims[0], ntaps = Kdims[0], radius = ntaps / 2, nkrows = Kdims.innerProduct() / ntaps;
+
+    std::vector<Float64> line(n + ntaps - 1), sum(n);
+    PointNi Q(pdim);
+    for (Int64 R = from; R < to; R++)
+    {
+      int   C = (int)(R % ncomponents);
+      Int64 offset = 0;
+      for (Int64 D = 1, rest = R / ncomponents; D < pdim; rest /= Sdims[D++])
+      {
+        Q[D] = rest % Sdims[D];
+        offset += Q[D] * stride[D];
+      }
+
+      std::fill(sum.begin(), sum.end(), 0.0);
+      for (Int64 KR = 0; KR < nkrows; KR++)
+      {
+        //source row under the kernel row, clamped to the border
+        Int64 read = 0;
+        for (Int64 D = 1, rest = KR; D < pdim; rest /= Kdims[D++])
+          read += Utils::clamp(Q[D] - Kdims[D] / 2 + rest % Kdims[D], (Int64)0, Sdims[D] - 1) * stride[D];
+
+        const SrcType* row = src + read * ncomponents + C;
+        for (Int64 J = 0; J < n + ntaps - 1; J++)
+          line[J] = (Float64)row[Utils::clamp(J - radius, (Int64)0, n - 1) * ncomponents];
+
+        const Float64* taps = kernel + KR * ntaps;
+        for (Int64 T = 0; T < ntaps; T++)
+        {
+          const Float64  k = taps[T];
+          const Float64* shifted = &line[T];
+          for (Int64 J = 0; J < n; J++)
+            sum[J] += shifted[J] * k;
+        }
+      }
+
+      DstType* write = dst + offset * ncomponents + C;
+      for (Int64 J = 0; J < n; J++)
+        write[J * ncomponents] = ConvolveCast<DstType>(sum[J]);
+    }
+  }
+
 };
 
 Array ArrayUtils::convolve(Array src,Array kernel,Aborted aborted) {
+  return convolve(src,kernel,DTypes::FLOAT64,aborted);
+}
+
+Array ArrayUtils::convolve(Array src,Array kernel,DType dtype,Aborted aborted)
+{
+  if (!kernel.dtype.valid() || kernel.dtype.ncomponents()!=1)
+  {
+    VisusAssert(aborted());
+    return Array();
+  }
+
+  if (kernel.dtype!=DTypes::FLOAT64)
+  {
+    kernel=ArrayUtils::cast(kernel,DTypes::FLOAT64,aborted);
+    if (!kernel.valid())
+      return Array();
+  }
+
+  //output in the source type, float32 or float64 directly, otherwise float64 and cast
+  auto output_dtype=dtype.valid()? dtype.get(0) : src.dtype.get(0);
+  bool bDirect=output_dtype==src.dtype.get(0) || output_dtype==DTypes::FLOAT32 || output_dtype==DTypes::FLOAT64;
+
   Array dst;
   ConvolveOp op;
-  return ExecuteOnCppSamples(op,src.dtype,dst,src,kernel,aborted)? dst : Array();
+  op.output_dtype=bDirect? output_dtype : DTypes::FLOAT64;
+  if (!ExecuteOnCppSamples(op,src.dtype,dst,src,kernel,aborted))
+    return Array();
+
+  return bDirect? dst : ArrayUtils::cast(dst,DType(src.dtype.ncomponents(),output_dtype),aborted);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -184,6 +184,10 @@ public:
         if (!blob->getContentLength())
           blob.reset();
       }
+      else
+      {
+        blob = CloudStorageItem::createNotValid(response.status);
+      }
 
       ret.get_promise()->set_value(blob);
     });
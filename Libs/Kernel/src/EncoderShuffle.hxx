@@ -0,0 +1,351 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#ifndef VISUS_SHUFFLE_ENCODER_H
+#define VISUS_SHUFFLE_ENCODER_H
+
+#include <Visus/Kernel.h>
+#include <Visus/Encoder.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VISUS_SHUFFLE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Visus {
+
+//////////////////////////////////////////////////////////////
+/*
+Byte shuffle pre-filter: the Nth byte of all samples are stored together before the (N+1)th byte.
+Smooth fields (float32, uint16...) have very repetitive high bytes and compress a lot better this way.
+
+Bit shuffle does the same with bits: the Nth bit of all samples are stored together (in groups of 8 samples).
+It is slower, but better for integer fields with small differences and for noisy low bits.
+
+  specs:=shuffle+zstd | shuffle+lz4 | shuffle+zip | bitshuffle+zstd | bitshuffle+lz4   (the only ones IDX v6 block headers can store)
+*/
+class VISUS_KERNEL_API ShuffleEncoder : public Encoder
+{
+public:
+
+  VISUS_CLASS(ShuffleEncoder)
+
+  SharedPtr<Encoder> encoder;
+  bool               bitshuffle = false;
+
+  //constructor
+  ShuffleEncoder(String specs)
+  {
+    bitshuffle = StringUtils::startsWith(specs, "bitshuffle");
+
+    auto plus = specs.find('+');
+    if (plus != String::npos)
+      encoder = Encoders::getSingleton()->createEncoder(specs.substr(plus + 1));
+  }
+
+  //destructor
+  virtual ~ShuffleEncoder() {
+  }
+
+  //isLossy
+  virtual bool isLossy() const override {
+    return encoder ? encoder->isLossy() : false;
+  }
+
+  //encode
+  virtual SharedPtr<HeapMemory> encode(PointNi dims, DType dtype, SharedPtr<HeapMemory> decoded) override
+  {
+    if (!decoded || !encoder)
+      return SharedPtr<HeapMemory>();
+
+    auto typesize = getTypeSize(dtype);
+    if (typesize <= 1 && !bitshuffle)
+      return encoder->encode(dims, dtype, decoded);
+
+    auto shuffled = std::make_shared<HeapMemory>();
+    if (!shuffled->resize(decoded->c_size(), __FILE__, __LINE__))
+      return SharedPtr<HeapMemory>();
+
+    if (bitshuffle)
+      bitShuffle(shuffled->c_ptr(), decoded->c_ptr(), decoded->c_size(), typesize);
+    else
+      shuffle(shuffled->c_ptr(), decoded->c_ptr(), decoded->c_size(), typesize);
+
+    return encoder->encode(dims, dtype, shuffled);
+  }
+
+  //decode
+  virtual SharedPtr<HeapMemory> decode(PointNi dims, DType dtype, SharedPtr<HeapMemory> encoded) override
+  {
+    if (!encoded || !encoder)
+      return SharedPtr<HeapMemory>();
+
+    auto shuffled = encoder->decode(dims, dtype, encoded);
+    if (!shuffled)
+      return SharedPtr<HeapMemory>();
+
+    auto typesize = getTypeSize(dtype);
+    if (typesize <= 1 && !bitshuffle)
+      return shuffled;
+
+    auto decoded = std::make_shared<HeapMemory>();
+    if (!decoded->resize(shuffled->c_size(), __FILE__, __LINE__))
+      return SharedPtr<HeapMemory>();
+
+    if (bitshuffle)
+      bitUnshuffle(decoded->c_ptr(), shuffled->c_ptr(), shuffled->c_size(), typesize);
+    else
+      unshuffle(decoded->c_ptr(), shuffled->c_ptr(), shuffled->c_size(), typesize);
+
+    return decoded;
+  }
+
+  //getTypeSize (component size for multi-component dtypes, i.e. float32[3] is shuffled as float32)
+  static int getTypeSize(DType dtype)
+  {
+    if (!dtype.valid() || (dtype.getBitSize() % 8))
+      return 1;
+
+    int ncomponents = dtype.ncomponents();
+    auto first = dtype.get(0);
+    for (int C = 1; C < ncomponents; C++)
+    {
+      if (dtype.get(C).getBitSize() != first.getBitSize())
+        return dtype.getByteSize();
+    }
+    return (first.getBitSize() % 8) ? dtype.getByteSize() : first.getByteSize();
+  }
+
+  //shuffle
+  static void shuffle(Uint8* dst, const Uint8* src, Int64 nbytes, int typesize)
+  {
+    Int64 nelements = nbytes / typesize;
+    Int64 done = 0;
+
+#if VISUS_SHUFFLE_SSE2
+    if (typesize == 2) done = shuffle2_sse2(dst, src, nelements);
+    if (typesize == 4) done = shuffle4_sse2(dst, src, nelements);
+#endif
+
+    for (int B = 0; B < typesize; B++)
+    {
+      auto out = dst + B * nelements;
+      for (Int64 I = done; I < nelements; I++)
+        out[I] = src[I * typesize + B];
+    }
+
+    //leftover bytes (not a multiple of the typesize)
+    for (Int64 I = nelements * typesize; I < nbytes; I++)
+      dst[I] = src[I];
+  }
+
+  //unshuffle
+  static void unshuffle(Uint8* dst, const Uint8* src, Int64 nbytes, int typesize)
+  {
+    Int64 nelements = nbytes / typesize;
+    Int64 done = 0;
+
+#if VISUS_SHUFFLE_SSE2
+    if (typesize == 2) done = unshuffle2_sse2(dst, src, nelements);
+    if (typesize == 4) done = unshuffle4_sse2(dst, src, nelements);
+#endif
+
+    for (int B = 0; B < typesize; B++)
+    {
+      auto in = src + B * nelements;
+      for (Int64 I = done; I < nelements; I++)
+        dst[I * typesize + B] = in[I];
+    }
+
+    for (Int64 I = nelements * typesize; I < nbytes; I++)
+      dst[I] = src[I];
+  }
+
+  //bitShuffle (bit plane P=B*8+J holds bit J of byte B of all the elements, one byte for each group of 8 elements)
+  static void bitShuffle(Uint8* dst, const Uint8* src, Int64 nbytes, int typesize)
+  {
+    Int64 ngroups = (nbytes / typesize) / 8;
+    for (Int64 G = 0; G < ngroups; G++)
+    {
+      auto in = src + G * 8 * typesize;
+      for (int B = 0; B < typesize; B++)
+      {
+        Uint64 x = 0;
+        for (int E = 0; E < 8; E++)
+          x |= (Uint64)in[E * typesize + B] << (8 * E);
+
+        x = transposeBits8x8(x);
+
+        for (int J = 0; J < 8; J++)
+          dst[(B * 8 + J) * ngroups + G] = (Uint8)(x >> (8 * J));
+      }
+    }
+
+    //leftover elements (not a multiple of 8) and bytes are not shuffled
+    for (Int64 I = ngroups * 8 * typesize; I < nbytes; I++)
+      dst[I] = src[I];
+  }
+
+  //bitUnshuffle
+  static void bitUnshuffle(Uint8* dst, const Uint8* src, Int64 nbytes, int typesize)
+  {
+    Int64 ngroups = (nbytes / typesize) / 8;
+    for (Int64 G = 0; G < ngroups; G++)
+    {
+      auto out = dst + G * 8 * typesize;
+      for (int B = 0; B < typesize; B++)
+      {
+        Uint64 x = 0;
+        for (int J = 0; J < 8; J++)
+          x |= (Uint64)src[(B * 8 + J) * ngroups + G] << (8 * J);
+
+        x = transposeBits8x8(x);
+
+        for (int E = 0; E < 8; E++)
+          out[E * typesize + B] = (Uint8)(x >> (8 * E));
+      }
+    }
+
+    for (Int64 I = ngroups * 8 * typesize; I < nbytes; I++)
+      dst[I] = src[I];
+  }
+
+  //transposeBits8x8 (bit J of byte E goes to bit E of byte J)
+  static inline Uint64 transposeBits8x8(Uint64 x)
+  {
+    Uint64 t;
+    t = (x ^ (x >> 7))  & 0x00AA00AA00AA00AAULL; x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x = x ^ t ^ (t << 28);
+    return x;
+  }
+
+private:
+
+#if VISUS_SHUFFLE_SSE2
+
+  //16 elements at a time, returns the number of elements done
+  static Int64 shuffle2_sse2(Uint8* dst, const Uint8* src, Int64 nelements)
+  {
+    Int64 I = 0;
+    for (; I + 16 <= nelements; I += 16)
+    {
+      __m128i v0 = _mm_loadu_si128((const __m128i*)(src + 2 * I + 0));
+      __m128i v1 = _mm_loadu_si128((const __m128i*)(src + 2 * I + 16));
+      __m128i a = _mm_unpacklo_epi8(v0, v1), b = _mm_unpackhi_epi8(v0, v1);
+      v0 = _mm_unpacklo_epi8(a, b); v1 = _mm_unpackhi_epi8(a, b);
+      a  = _mm_unpacklo_epi8(v0, v1); b = _mm_unpackhi_epi8(v0, v1);
+      v0 = _mm_unpacklo_epi8(a, b); v1 = _mm_unpackhi_epi8(a, b);
+      _mm_storeu_si128((__m128i*)(dst + 0 * nelements + I), v0);
+      _mm_storeu_si128((__m128i*)(dst + 1 * nelements + I), v1);
+    }
+    return I;
+  }
+
+  //unshuffle2_sse2
+  static Int64 unshuffle2_sse2(Uint8* dst, const Uint8* src, Int64 nelements)
+  {
+    Int64 I = 0;
+    for (; I + 16 <= nelements; I += 16)
+    {
+      __m128i p0 = _mm_loadu_si128((const __m128i*)(src + 0 * nelements + I));
+      __m128i p1 = _mm_loadu_si128((const __m128i*)(src + 1 * nelements + I));
+      _mm_storeu_si128((__m128i*)(dst + 2 * I + 0),  _mm_unpacklo_epi8(p0, p1));
+      _mm_storeu_si128((__m128i*)(dst + 2 * I + 16), _mm_unpackhi_epi8(p0, p1));
+    }
+    return I;
+  }
+
+  //shuffle4_sse2
+  static Int64 shuffle4_sse2(Uint8* dst, const Uint8* src, Int64 nelements)
+  {
+    Int64 I = 0;
+    for (; I + 16 <= nelements; I += 16)
+    {
+      __m128i v0 = _mm_loadu_si128((const __m128i*)(src + 4 * I + 0));
+      __m128i v1 = _mm_loadu_si128((const __m128i*)(src + 4 * I + 16));
+      __m128i v2 = _mm_loadu_si128((const __m128i*)(src + 4 * I + 32));
+      __m128i v3 = _mm_loadu_si128((const __m128i*)(src + 4 * I + 48));
+
+      __m128i a = _mm_unpacklo_epi8(v0, v1), b = _mm_unpackhi_epi8(v0, v1);
+      __m128i c = _mm_unpacklo_epi8(v2, v3), d = _mm_unpackhi_epi8(v2, v3);
+
+      v0 = _mm_unpacklo_epi8(a, b); v1 = _mm_unpackhi_epi8(a, b);
+      v2 = _mm_unpacklo_epi8(c, d); v3 = _mm_unpackhi_epi8(c, d);
+
+      a = _mm_unpacklo_epi8(v0, v1); b = _mm_unpackhi_epi8(v0, v1);
+      c = _mm_unpacklo_epi8(v2, v3); d = _mm_unpackhi_epi8(v2, v3);
+
+      _mm_storeu_si128((__m128i*)(dst + 0 * nelements + I), _mm_unpacklo_epi64(a, c));
+      _mm_storeu_si128((__m128i*)(dst + 1 * nelements + I), _mm_unpackhi_epi64(a, c));
+      _mm_storeu_si128((__m128i*)(dst + 2 * nelements + I), _mm_unpacklo_epi64(b, d));
+      _mm_storeu_si128((__m128i*)(dst + 3 * nelements + I), _mm_unpackhi_epi64(b, d));
+    }
+    return I;
+  }
+
+  //unshuffle4_sse2
+  static Int64 unshuffle4_sse2(Uint8* dst, const Uint8* src, Int64 nelements)
+  {
+    Int64 I = 0;
+    for (; I + 16 <= nelements; I += 16)
+    {
+      __m128i p0 = _mm_loadu_si128((const __m128i*)(src + 0 * nelements + I));
+      __m128i p1 = _mm_loadu_si128((const __m128i*)(src + 1 * nelements + I));
+      __m128i p2 = _mm_loadu_si128((const __m128i*)(src + 2 * nelements + I));
+      __m128i p3 = _mm_loadu_si128((const __m128i*)(src + 3 * nelements + I));
+
+      __m128i a = _mm_unpacklo_epi8(p0, p1), b = _mm_unpackhi_epi8(p0, p1);
+      __m128i c = _mm_unpacklo_epi8(p2, p3), d = _mm_unpackhi_epi8(p2, p3);
+
+      _mm_storeu_si128((__m128i*)(dst + 4 * I + 0),  _mm_unpacklo_epi16(a, c));
+      _mm_storeu_si128((__m128i*)(dst + 4 * I + 16), _mm_unpackhi_epi16(a, c));
+      _mm_storeu_si128((__m128i*)(dst + 4 * I + 32), _mm_unpacklo_epi16(b, d));
+      _mm_storeu_si128((__m128i*)(dst + 4 * I + 48), _mm_unpackhi_epi16(b, d));
+    }
+    return I;
+  }
+
+#endif
+
+};
+
+} //namespace Visus
+
+#endif //VISUS_SHUFFLE_ENCODER_H
@@ -0,0 +1,221 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#ifndef VISUS_ZSTD_ENCODER_H
+#define VISUS_ZSTD_ENCODER_H
+
+#include <Visus/Kernel.h>
+#include <Visus/Encoder.h>
+#include <Visus/CriticalSection.h>
+#include <Visus/Utils.h>
+
+#include <zstd/zstd.h>
+
+namespace Visus {
+
+//////////////////////////////////////////////////////////////
+class VISUS_KERNEL_API ZstdEncoder : public Encoder
+{
+public:
+
+  VISUS_CLASS(ZstdEncoder)
+
+  int    compression_level = 3;
+  String dictionary;
+
+  //constructor
+  //  specs:=zstd[-<level::int>][-dict=<filename>] 
+  //  (dict= must be the last option since the filename can contain '-')
+  ZstdEncoder(String specs)
+  {
+    auto options = specs.substr(String("zstd").size());
+    while (StringUtils::startsWith(options, "-"))
+    {
+      options = options.substr(1);
+
+      if (StringUtils::startsWith(options, "dict="))
+      {
+        dictionary = options.substr(String("dict=").size());
+        break;
+      }
+
+      auto next = options.find('-');
+      auto value = options.substr(0, next);
+      options = next == String::npos ? "" : options.substr(next);
+      if (!value.empty())
+        compression_level = Utils::clamp(cint(value), 1, ZSTD_maxCLevel());
+    }
+  }
+
+  //destructor
+  virtual ~ZstdEncoder() {
+  }
+
+  //isLossy
+  virtual bool isLossy() const override {
+    return false;
+  }
+
+  //encode
+  virtual SharedPtr<HeapMemory> encode(PointNi dims, DType dtype, SharedPtr<HeapMemory> decoded) override
+  {
+    if (!decoded)
+      return SharedPtr<HeapMemory>();
+
+    auto encoded = std::make_shared<HeapMemory>();
+    if (!encoded->resize(ZSTD_compressBound(decoded->c_size()), __FILE__, __LINE__))
+      return SharedPtr<HeapMemory>();
+
+    size_t encoded_size;
+    if (dictionary.empty())
+    {
+      encoded_size = ZSTD_compressCCtx(getContexts().cctx, encoded->c_ptr(), encoded->c_size(), decoded->c_ptr(), decoded->c_size(), compression_level);
+    }
+    else
+    {
+      auto dict = getDictionary(dictionary, compression_level);
+      if (!dict)
+        return SharedPtr<HeapMemory>();
+      encoded_size = ZSTD_compress_usingCDict(getContexts().cctx, encoded->c_ptr(), encoded->c_size(), decoded->c_ptr(), decoded->c_size(), dict->cdict);
+    }
+
+    if (ZSTD_isError(encoded_size))
+      return SharedPtr<HeapMemory>();
+
+    if (!encoded->resize(encoded_size, __FILE__, __LINE__))
+      return SharedPtr<HeapMemory>();
+
+    return encoded;
+  }
+
+  //decode
+  virtual SharedPtr<HeapMemory> decode(PointNi dims, DType dtype, SharedPtr<HeapMemory> encoded) override
+  {
+    if (!encoded)
+      return SharedPtr<HeapMemory>();
+
+    VisusAssert(dtype.getByteSize(dims));
+
+    //I need to know the final decompressed size
+    auto decoded = std::make_shared<HeapMemory>();
+    if (!decoded->resize(dtype.getByteSize(dims), __FILE__, __LINE__))
+      return SharedPtr<HeapMemory>();
+
+    size_t nbytes;
+    if (dictionary.empty())
+    {
+      nbytes = ZSTD_decompressDCtx(getContexts().dctx, decoded->c_ptr(), decoded->c_size(), encoded->c_ptr(), encoded->c_size());
+    }
+    else
+    {
+      auto dict = getDictionary(dictionary, compression_level);
+      if (!dict)
+        return SharedPtr<HeapMemory>();
+      nbytes = ZSTD_decompress_usingDDict(getContexts().dctx, decoded->c_ptr(), decoded->c_size(), encoded->c_ptr(), encoded->c_size(), dict->ddict);
+    }
+
+    if (ZSTD_isError(nbytes))
+      return SharedPtr<HeapMemory>();
+
+    if (nbytes != decoded->c_size()) {
+      VisusAssert(false);
+      return SharedPtr<HeapMemory>();
+    }
+
+    return decoded;
+  }
+
+private:
+
+  //one compression/decompression context for each thread (they are expensive to create)
+  class Contexts
+  {
+  public:
+    ZSTD_CCtx* cctx = nullptr;
+    ZSTD_DCtx* dctx = nullptr;
+    Contexts() : cctx(ZSTD_createCCtx()), dctx(ZSTD_createDCtx()) {}
+    ~Contexts() { ZSTD_freeCCtx(cctx); ZSTD_freeDCtx(dctx); }
+  };
+
+  //digested dictionary, loaded only once
+  class Dictionary
+  {
+  public:
+    ZSTD_CDict* cdict = nullptr;
+    ZSTD_DDict* ddict = nullptr;
+    Dictionary(SharedPtr<HeapMemory> content, int level)
+      : cdict(ZSTD_createCDict(content->c_ptr(), content->c_size(), level)), ddict(ZSTD_createDDict(content->c_ptr(), content->c_size())) {}
+    ~Dictionary() { ZSTD_freeCDict(cdict); ZSTD_freeDDict(ddict); }
+  };
+
+  //getContexts
+  static Contexts& getContexts() {
+    static thread_local Contexts ret;
+    return ret;
+  }
+
+  //getDictionary
+  static SharedPtr<Dictionary> getDictionary(String filename, int level)
+  {
+    static CriticalSection lock;
+    static std::map< std::pair<String, int>, SharedPtr<Dictionary> > dictionaries;
+
+    ScopedLock lock_it(lock);
+    auto key = std::make_pair(filename, level);
+    auto it = dictionaries.find(key);
+    if (it != dictionaries.end())
+      return it->second;
+
+    SharedPtr<Dictionary> ret;
+    auto content = Utils::loadBinaryDocument(filename);
+    if (content && content->c_size())
+      ret = std::make_shared<Dictionary>(content, level);
+    else
+      PrintWarning("cannot load zstd dictionary", filename);
+
+    //cache failures too, so I don't try to load a missing dictionary for every block
+    dictionaries[key] = ret;
+    return ret;
+  }
+
+};
+
+} //namespace Visus
+
+#endif //VISUS_ZSTD_ENCODER_H
@@ -42,6 +42,10 @@ For support : support@visus.net
 #include <Visus/Time.h>
 #include "osdep.hxx"
 
+#if !WIN32
+#include <sys/file.h>
+#endif
+
 
 namespace Visus {
 
@@ -973,6 +977,74 @@ void FileUtils::unlock(Path path)
 
 }
 
+/////////////////////////////////////////////////////////////////////////
+ScopedSystemFileLock::ScopedSystemFileLock(String filename_) : filename(filename_)
+{
+  //same as File::createAndOpen, create the directory only if needed
+#if WIN32
+  HANDLE h = INVALID_HANDLE_VALUE;
+  for (int nattempt = 0; nattempt < 2 && h == INVALID_HANDLE_VALUE; nattempt++)
+  {
+    if (nattempt)
+      FileUtils::createDirectory(Path(filename).getParent());
+    h = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  }
+
+  if (h == INVALID_HANDLE_VALUE)
+    return;
+
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  if (!LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped))
+  {
+    CloseHandle(h);
+    return;
+  }
+
+  this->handle = (Int64)h;
+#else
+  int fd = -1;
+  for (int nattempt = 0; nattempt < 2 && fd == -1; nattempt++)
+  {
+    if (nattempt)
+      FileUtils::createDirectory(Path(filename).getParent());
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+  }
+
+  if (fd == -1)
+    return;
+
+  while (::flock(fd, LOCK_EX) != 0)
+  {
+    if (errno != EINTR)
+    {
+      ::close(fd);
+      return;
+    }
+  }
+
+  this->handle = fd;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+ScopedSystemFileLock::~ScopedSystemFileLock()
+{
+  if (handle == -1)
+    return;
+
+  //NOTE: the file is not removed, someone else could be waiting on it
+#if WIN32
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  UnlockFileEx((HANDLE)handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+  CloseHandle((HANDLE)handle);
+#else
+  ::flock((int)handle, LOCK_UN);
+  ::close((int)handle);
+#endif
+}
+
 /////////////////////////////////////////////////////////////////////////
 bool FileUtils::copyFile(String src_filename, String dst_filename, bool bFailIfExist)
 {
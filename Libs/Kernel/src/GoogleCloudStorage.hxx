@@ -241,7 +241,7 @@ public:
         auto blob_id = json["files"].size() ? json["files"].at(0)["id"].get<std::string>() : String();
         if (blob_id.empty())
         {
-          ret.get_promise()->set_value(SharedPtr<CloudStorageItem>());
+          ret.get_promise()->set_value(CloudStorageItem::createNotValid(HttpStatus::STATUS_NOT_FOUND));
           return;
         }
 
@@ -276,7 +276,7 @@ public:
             if (!response.isSuccessful())
             {
               PrintWarning("ERROR. Cannot get blob status",response.status,"errormsg",response.getErrorMessage());
-              ret.get_promise()->set_value(SharedPtr<CloudStorageItem>());
+              ret.get_promise()->set_value(CloudStorageItem::createNotValid(response.status));
               return;
             }
 
@@ -72,6 +72,8 @@ For support : support@visus.net
 #include "EncoderLz4.hxx"
 #include "EncoderZip.hxx"
 #include "EncoderZfp.hxx"
+#include "EncoderZstd.hxx"
+#include "EncoderShuffle.hxx"
 
 #include "ArrayPluginDevnull.hxx"
 #include "ArrayPluginRawArray.hxx"
@@ -426,6 +428,9 @@ void KernelModule::attach()
     Encoders::getSingleton()->registerEncoder("lz4", [](String specs) {return std::make_shared<LZ4Encoder>(specs); });
     Encoders::getSingleton()->registerEncoder("zip", [](String specs) {return std::make_shared<ZipEncoder>(specs); });
     Encoders::getSingleton()->registerEncoder("zfp", [](String specs) {return std::make_shared<ZfpEncoder>(specs); });
+    Encoders::getSingleton()->registerEncoder("zstd", [](String specs) {return std::make_shared<ZstdEncoder>(specs); });
+    Encoders::getSingleton()->registerEncoder("shuffle", [](String specs) {return std::make_shared<ShuffleEncoder>(specs); });
+    Encoders::getSingleton()->registerEncoder("bitshuffle", [](String specs) {return std::make_shared<ShuffleEncoder>(specs); });
 
 #if VISUS_IMAGE
     Encoders::getSingleton()->registerEncoder("png", [](String specs) {return std::make_shared<FreeImageEncoder>(specs); });
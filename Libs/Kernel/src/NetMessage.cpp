@@ -319,36 +319,45 @@ std::vector<NetResponse> NetResponse::decompose(NetResponse RESPONSE)
 
   std::vector<NetResponse> responses(num);
     
-  Uint8* BODY=RESPONSE.body? RESPONSE.body->c_ptr() : nullptr;
-
+  Int64 offset = 0;
   for (int I=0;I<num;I++)
   {
-    auto postfix="-"+cstring(I);
+    if (!decomposePart(RESPONSE, I, offset, responses[I]))
+      responses[I] = NetResponse(HttpStatus::STATUS_INTERNAL_SERVER_ERROR, "Body too short");
+  }
 
-    responses[I].status=RESPONSE.isSuccessful()? cint(RESPONSE.getHeader("status"+postfix,cstring(RESPONSE.status))) : RESPONSE.status;
+  return responses;
+}
 
-    for (auto header : RESPONSE.headers)
-    {
-      if (StringUtils::endsWith(header.first,postfix))
-        responses[I].setHeader(header.first.substr(0,header.first.size()-postfix.size()),header.second);
-    }
+///////////////////////////////////////////////////////////////////
+bool NetResponse::decomposePart(const NetResponse& RESPONSE, int I, Int64& offset, NetResponse& response)
+{
+  auto postfix="-"+cstring(I);
 
-    auto body_size=cint64(RESPONSE.getHeader("body-size"+postfix));
-    if (!body_size)
-      continue;
+  auto body_size=cint64(RESPONSE.getHeader("body-size"+postfix));
+  if (body_size && (!RESPONSE.body || offset + body_size > RESPONSE.body->c_size()))
+    return false;
 
-    responses[I].body=std::make_shared<HeapMemory>();
-    if (!responses[I].body->resize(body_size,__FILE__,__LINE__)) 
-    {
-      responses[I]=NetResponse(HttpStatus::STATUS_INTERNAL_SERVER_ERROR,"Out of memory");
-      continue;
-    }
+  response=NetResponse();
+  response.status=RESPONSE.isSuccessful()? cint(RESPONSE.getHeader("status"+postfix,cstring(RESPONSE.status))) : RESPONSE.status;
 
-    memcpy(responses[I].body->c_ptr(),BODY,body_size);
-    BODY+=body_size;
+  for (auto header : RESPONSE.headers)
+  {
+    if (StringUtils::endsWith(header.first,postfix))
+      response.setHeader(header.first.substr(0,header.first.size()-postfix.size()),header.second);
   }
 
-  return responses;
+  if (!body_size)
+    return true;
+
+  response.body=std::make_shared<HeapMemory>();
+  if (!response.body->resize(body_size,__FILE__,__LINE__)) 
+    response=NetResponse(HttpStatus::STATUS_INTERNAL_SERVER_ERROR,"Out of memory");
+  else
+    memcpy(response.body->c_ptr(),RESPONSE.body->c_ptr() + offset,body_size);
+
+  offset+=body_size;
+  return true;
 }
 
 } //namespace Visus
@@ -38,6 +38,20 @@ For support : support@visus.net
 
 #include <Visus/NetServer.h>
 #include <Visus/StringTree.h>
+#include <Visus/CriticalSection.h>
+#include <Visus/Utils.h>
+
+#if __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
 
 namespace Visus {
 
@@ -50,6 +64,17 @@ NetServer::NetServer(int port_, NetServerModule* module_,int nthreads_) : port(p
 #else
   this->verbose = 0;
 #endif
+
+#if __linux__
+  this->event_driven = true;
+  String s_event_driven = Utils::getEnv("VISUS_NETSERVER_EVENT_DRIVEN");
+  if (!s_event_driven.empty())
+    this->event_driven = cbool(s_event_driven);
+#endif
+
+  String s_cancel_on_disconnect = Utils::getEnv("VISUS_NETSERVER_CANCEL_ON_DISCONNECT");
+  if (!s_cancel_on_disconnect.empty())
+    this->cancel_on_disconnect = cbool(s_cancel_on_disconnect);
 }
 
 
@@ -86,11 +111,22 @@ void NetServer::waitForExit() {
 
 
 ///////////////////////////////////////////////////////////////
-bool NetServer::writeResponse(NetSocket* client, NetResponse response)
+void NetServer::prepareResponse(NetResponse& response, bool keep_alive)
 {
-  response.setHeader("Connection", "Close");//in this debug version I don't keep the connections alive!
+  response.setHeader("Connection", keep_alive ? "Keep-Alive" : "Close");
   response.setHeader("NetServer", "Visus debugging server");//just as double check
   response.setHeader("Access-Control-Allow-Origin", "*");//accept connections from localhost
+
+  //the client needs it to find where the next response starts
+  if (!response.body)
+    response.setContentLength(0);
+}
+
+
+///////////////////////////////////////////////////////////////
+bool NetServer::writeResponse(NetSocket* client, NetResponse response)
+{
+  prepareResponse(response, false); //the thread-per-request version does not keep the connections alive
   client->sendResponse(response);
   client->shutdownSend();
   return true;
@@ -113,6 +149,15 @@ void NetServer::runInThisThread()
 
   auto thread_pool = std::make_shared<ThreadPool>("HttpServer Worker", nthreads);
 
+#if __linux__
+  if (event_driven)
+  {
+    runEventLoop(server, thread_pool);
+    thread_pool.reset();
+    return;
+  }
+#endif
+
   //loop accept connections/handle operation
   while (!bExitThread)
   {
@@ -161,5 +206,514 @@ void NetServer::runInThisThread()
 //waitForExit
 
 
+#if __linux__
+
+///////////////////////////////////////////////////////////////
+class NetServerConnection
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(NetServerConnection)
+
+  //one for each pipelined request, responses go out in the same order the requests came in
+  class Slot
+  {
+  public:
+    bool        ready = false; //owned by the event loop
+    bool        keep_alive = true;
+    Aborted     aborted;       //shared with the request, set when the client goes away
+    NetResponse response;
+    String      headers;
+    Int64       offset = 0; //bytes already sent (headers+body)
+
+    //getTotalSize
+    Int64 getTotalSize() const {
+      return (Int64)headers.size() + (response.body ? response.body->c_size() : 0);
+    }
+  };
+
+  int                           fd = -1;
+  String                        inbuf;
+  size_t                        inpos = 0;
+  std::deque< SharedPtr<Slot> > slots;
+  bool                          no_more_requests = false;
+  bool                          peer_closed = false;
+  bool                          closed = false;
+  Uint32                        events = 0;
+  Time                          last_activity = Time::now();
+
+  //constructor
+  NetServerConnection(int fd_) : fd(fd_) {
+  }
+
+  //findHeader (case insensitive)
+  static String findHeader(const NetMessage& msg, String key) 
+  {
+    key = StringUtils::toLower(key);
+    for (auto it : msg.headers)
+    {
+      if (StringUtils::toLower(it.first) == key)
+        return it.second;
+    }
+    return "";
+  }
+
+};
+
+
+///////////////////////////////////////////////////////////////
+void NetServer::runEventLoop(SharedPtr<NetSocket> server, SharedPtr<ThreadPool> thread_pool)
+{
+  typedef NetServerConnection Connection;
+  typedef NetServerConnection::Slot Slot;
+
+  const size_t max_headers_size = 1024 * 1024;
+
+  int listenfd = server->getDescriptor();
+  fcntl(listenfd, F_SETFL, fcntl(listenfd, F_GETFL, 0) | O_NONBLOCK);
+
+  int epollfd  = epoll_create1(EPOLL_CLOEXEC);
+  int wakeupfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epollfd < 0 || wakeupfd < 0)
+  {
+    PrintError("NetServer epoll/eventfd failed", strerror(errno));
+    if (epollfd  >= 0) ::close(epollfd);
+    if (wakeupfd >= 0) ::close(wakeupfd);
+    return;
+  }
+
+  auto watch = [&](int op, int fd, Uint32 events) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(epollfd, op, fd, &ev) == 0;
+  };
+
+  watch(EPOLL_CTL_ADD, listenfd, EPOLLIN);
+  watch(EPOLL_CTL_ADD, wakeupfd, EPOLLIN);
+
+  std::map<int, SharedPtr<Connection> > connections;
+
+  //filled by the workers, consumed by the event loop
+  CriticalSection completed_lock;
+  std::vector< std::pair< SharedPtr<Connection>, SharedPtr<Slot> > > completed;
+
+  //the workers stop processing requests nobody is waiting for
+  auto abortRequests = [&](SharedPtr<Connection> conn) {
+    for (auto slot : conn->slots)
+    {
+      if (!slot->ready)
+        slot->aborted.setTrue();
+    }
+  };
+
+  auto closeConnection = [&](SharedPtr<Connection> conn) {
+    if (conn->closed) return;
+    if (cancel_on_disconnect)
+      abortRequests(conn);
+    epoll_ctl(epollfd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    ::close(conn->fd);
+    conn->closed = true;
+    conn->slots.clear();
+    connections.erase(conn->fd);
+  };
+
+  //writes all the ready responses at the front of the queue, bodies are sent straight from their HeapMemory
+  auto flushConnection = [&](SharedPtr<Connection> conn) 
+  {
+    while (!conn->slots.empty() && conn->slots.front()->ready)
+    {
+      struct iovec iov[64];
+      int niov = 0;
+      for (auto slot : conn->slots)
+      {
+        if (!slot->ready || niov + 2 > 64)
+          break;
+
+        Int64 offset = slot->offset;
+        Int64 headers_size = (Int64)slot->headers.size();
+        if (offset < headers_size)
+        {
+          iov[niov].iov_base = (void*)(slot->headers.c_str() + offset);
+          iov[niov].iov_len = (size_t)(headers_size - offset);
+          niov++;
+          offset = headers_size;
+        }
+
+        auto body = slot->response.body;
+        if (body && body->c_size() > offset - headers_size)
+        {
+          iov[niov].iov_base = body->c_ptr() + (offset - headers_size);
+          iov[niov].iov_len = (size_t)(body->c_size() - (offset - headers_size));
+          niov++;
+        }
+
+        //need to close after this one
+        if (!slot->keep_alive)
+          break;
+      }
+
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = niov;
+
+      auto n = niov ? ::sendmsg(conn->fd, &msg, MSG_NOSIGNAL) : 0;
+      if (n < 0)
+      {
+        if (errno == EINTR) 
+          continue;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          return true;
+
+        if (verbose)
+          PrintInfo("NetServer error writing to the client, maybe he just dropped the connection?", strerror(errno));
+
+        closeConnection(conn);
+        return false;
+      }
+
+      conn->last_activity = Time::now();
+      while (!conn->slots.empty() && conn->slots.front()->ready)
+      {
+        auto slot = conn->slots.front();
+        auto remaining = slot->getTotalSize() - slot->offset;
+        if (n < remaining)
+        {
+          slot->offset += n;
+          break;
+        }
+
+        n -= remaining;
+        conn->slots.pop_front();
+
+        if (!slot->keep_alive)
+        {
+          ::shutdown(conn->fd, SHUT_WR);
+          closeConnection(conn);
+          return false;
+        }
+      }
+    }
+
+    return true;
+  };
+
+  auto dispatchRequest = [&](SharedPtr<Connection> conn, SharedPtr<Slot> slot, NetRequest request) 
+  {
+    slot->aborted = request.aborted;
+
+    ThreadPool::push(thread_pool, [this, conn, slot, request, &completed_lock, &completed, wakeupfd]()
+    {
+      NetResponse response = 
+        bExitThread ? NetResponse(HttpStatus::STATUS_INTERNAL_SERVER_ERROR) : 
+        request.aborted() ? NetResponse(HttpStatus::STATUS_CANCELLED) : 
+        module->handleRequest(request);
+
+      if (verbose && !response.isSuccessful())
+        PrintInfo("!response.isSuccessful()", response.getErrorMessage());
+
+      prepareResponse(response, slot->keep_alive);
+      slot->headers = response.getHeadersAsString();
+      slot->response = response;
+      {
+        ScopedLock lock(completed_lock);
+        completed.push_back(std::make_pair(conn, slot));
+      }
+
+      Uint64 one = 1;
+      auto ret = ::write(wakeupfd, &one, sizeof(one));
+      (void)ret;
+    });
+  };
+
+  //splits the input buffer into (possibly pipelined) requests
+  auto parseRequests = [&](SharedPtr<Connection> conn) 
+  {
+    while (!conn->no_more_requests && (int)conn->slots.size() < max_pipelined_requests)
+    {
+      auto end_headers = conn->inbuf.find("\r\n\r\n", conn->inpos);
+      if (end_headers == String::npos)
+      {
+        if (conn->inbuf.size() - conn->inpos > max_headers_size)
+          conn->no_more_requests = true;
+        break;
+      }
+
+      end_headers += 4;
+      String headers = conn->inbuf.substr(conn->inpos, end_headers - conn->inpos);
+
+      NetRequest request;
+      bool bValid = false;
+      try 
+      {
+        bValid = request.setHeadersFromString(headers) && request.valid();
+      }
+      catch (...)
+      {
+        bValid = false;
+      }
+
+      Int64 content_length = bValid ? cint64(Connection::findHeader(request, "Content-Length")) : 0;
+      if (content_length < 0)
+      {
+        bValid = false;
+        content_length = 0;
+      }
+
+      if ((Int64)(conn->inbuf.size() - end_headers) < content_length)
+        break; //wait for the body
+
+      if (content_length)
+      {
+        request.body = std::make_shared<HeapMemory>();
+        if (!request.body->resize(content_length, __FILE__, __LINE__))
+          bValid = false;
+        else
+          memcpy(request.body->c_ptr(), conn->inbuf.c_str() + end_headers, (size_t)content_length);
+      }
+
+      conn->inpos = end_headers + (size_t)content_length;
+
+      //HTTP/1.1 default is keep-alive, HTTP/1.0 default is close
+      String first_line = headers.substr(0, headers.find("\r\n"));
+      String connection_header = StringUtils::toLower(Connection::findHeader(request, "Connection"));
+      bool bHttp10 = StringUtils::contains(first_line, "HTTP/1.0");
+
+      auto slot = std::make_shared<Slot>();
+      slot->keep_alive = bValid && (bHttp10 ? connection_header == "keep-alive" : connection_header != "close");
+      conn->slots.push_back(slot);
+
+      if (!slot->keep_alive)
+        conn->no_more_requests = true;
+
+      if (bValid)
+      {
+        dispatchRequest(conn, slot, request);
+      }
+      else
+      {
+        slot->response = NetResponse(HttpStatus::STATUS_BAD_REQUEST);
+        prepareResponse(slot->response, false);
+        slot->headers = slot->response.getHeadersAsString();
+        slot->ready = true;
+      }
+    }
+
+    //compact the input buffer
+    if (conn->inpos)
+    {
+      conn->inbuf.erase(0, conn->inpos);
+      conn->inpos = 0;
+    }
+  };
+
+  //keep epoll interest in sync with the connection state
+  auto updateConnection = [&](SharedPtr<Connection> conn) 
+  {
+    if (conn->closed)
+      return;
+
+    if ((conn->no_more_requests || conn->peer_closed) && conn->slots.empty())
+    {
+      closeConnection(conn);
+      return;
+    }
+
+    Uint32 events = 0;
+    if (!conn->no_more_requests && !conn->peer_closed && (int)conn->slots.size() < max_pipelined_requests)
+      events |= EPOLLIN;
+
+    if (!conn->slots.empty() && conn->slots.front()->ready)
+      events |= EPOLLOUT;
+
+    if (events != conn->events)
+    {
+      watch(EPOLL_CTL_MOD, conn->fd, events);
+      conn->events = events;
+    }
+  };
+
+  std::vector<char> readbuf(64 * 1024);
+  std::vector<struct epoll_event> events(256);
+  Time last_sweep = Time::now();
+
+  while (!bExitThread)
+  {
+    int nevents = epoll_wait(epollfd, &events[0], (int)events.size(), 1000);
+    if (nevents < 0 && errno != EINTR)
+    {
+      PrintError("NetServer epoll_wait failed", strerror(errno));
+      break;
+    }
+
+    for (int I = 0; I < nevents && !bExitThread; I++)
+    {
+      int fd = events[I].data.fd;
+
+      //new connections
+      if (fd == listenfd)
+      {
+        while (true)
+        {
+          int clientfd = accept4(listenfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+          if (clientfd < 0)
+            break;
+
+          if (NetSocket::Defaults::tcp_no_delay)
+          {
+            int flag = 1;
+            setsockopt(clientfd, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(flag));
+          }
+
+          auto conn = std::make_shared<Connection>(clientfd);
+          conn->events = EPOLLIN;
+          if (!watch(EPOLL_CTL_ADD, clientfd, conn->events))
+          {
+            ::close(clientfd);
+            continue;
+          }
+
+          connections[clientfd] = conn;
+
+          if (verbose)
+            PrintInfo("NetServer accepted new connection, num_connections", connections.size());
+        }
+        continue;
+      }
+
+      //responses ready from the workers
+      if (fd == wakeupfd)
+      {
+        Uint64 value;
+        auto ret = ::read(wakeupfd, &value, sizeof(value));
+        (void)ret;
+
+        std::vector< std::pair< SharedPtr<Connection>, SharedPtr<Slot> > > ready;
+        {
+          ScopedLock lock(completed_lock);
+          std::swap(ready, completed);
+        }
+
+        for (auto it : ready)
+        {
+          auto conn = it.first;
+          it.second->ready = true;
+          if (conn->closed) continue;
+          if (flushConnection(conn))
+          {
+            parseRequests(conn);
+            updateConnection(conn);
+          }
+        }
+        continue;
+      }
+
+      auto it = connections.find(fd);
+      if (it == connections.end())
+        continue;
+
+      auto conn = it->second;
+
+      if (events[I].events & (EPOLLERR | EPOLLHUP) && !(events[I].events & EPOLLIN))
+      {
+        closeConnection(conn);
+        continue;
+      }
+
+      if (events[I].events & EPOLLIN)
+      {
+        while (true)
+        {
+          auto n = ::recv(fd, &readbuf[0], readbuf.size(), 0);
+          if (n > 0)
+          {
+            conn->inbuf.append(&readbuf[0], (size_t)n);
+            conn->last_activity = Time::now();
+            if ((size_t)n < readbuf.size())
+              break;
+          }
+          else if (n == 0)
+          {
+            //HTTP/1.1 clients do not half-close in the middle of a request, nobody is waiting for the pending responses
+            conn->peer_closed = true;
+            if (cancel_on_disconnect)
+              abortRequests(conn);
+            break;
+          }
+          else if (errno == EINTR)
+          {
+            continue;
+          }
+          else if (errno == EAGAIN || errno == EWOULDBLOCK)
+          {
+            break;
+          }
+          else
+          {
+            closeConnection(conn);
+            break;
+          }
+        }
+
+        if (conn->closed)
+          continue;
+
+        parseRequests(conn);
+      }
+
+      if (events[I].events & EPOLLOUT)
+      {
+        if (!flushConnection(conn))
+          continue;
+        parseRequests(conn);
+      }
+
+      updateConnection(conn);
+    }
+
+    //close idle connections
+    if (keep_alive_timeout > 0 && last_sweep.elapsedMsec() > 1000)
+    {
+      std::vector< SharedPtr<Connection> > idle;
+      for (auto it : connections)
+      {
+        auto conn = it.second;
+        if (conn->slots.empty() && conn->last_activity.elapsedMsec() > keep_alive_timeout * 1000)
+          idle.push_back(conn);
+      }
+
+      for (auto conn : idle)
+        closeConnection(conn);
+
+      last_sweep = Time::now();
+    }
+  }
+
+  //workers are referencing the completed queue
+  thread_pool->waitAll();
+
+  std::vector< SharedPtr<Connection> > pending;
+  for (auto it : connections)
+    pending.push_back(it.second);
+
+  for (auto conn : pending)
+    closeConnection(conn);
+
+  ::close(epollfd);
+  ::close(wakeupfd);
+}
+
+#else
+
+///////////////////////////////////////////////////////////////
+void NetServer::runEventLoop(SharedPtr<NetSocket> server, SharedPtr<ThreadPool> thread_pool)
+{
+  ThrowException("event driven NetServer not supported on this platform");
+}
+
+#endif //__linux__
 
 } //namespace Visus
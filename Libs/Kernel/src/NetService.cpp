@@ -167,7 +167,7 @@ public:
   }
 
   //setNetRequest
-  void setNetRequest(NetRequest user_request, Promise<NetResponse> user_promise)
+  void setNetRequest(NetRequest user_request, Promise<NetResponse> user_promise, bool keep_alive = true, bool http2 = false)
   {
     if (this->request.valid())
     {
@@ -191,8 +191,24 @@ public:
 
     if (this->request.valid())
     {
-      curl_easy_setopt(this->handle, CURLOPT_FORBID_REUSE, 1L); //not sure if this is the best option (see http://www.perlmonks.org/?node_id=925760)
-      curl_easy_setopt(this->handle, CURLOPT_FRESH_CONNECT, 1L);
+      //connections are cached by the multi handle, so all the easy handles of this service share the same pool
+      if (keep_alive)
+      {
+        curl_easy_setopt(this->handle, CURLOPT_TCP_KEEPALIVE, 1L);
+      }
+      else
+      {
+        curl_easy_setopt(this->handle, CURLOPT_FORBID_REUSE, 1L); //not sure if this is the best option (see http://www.perlmonks.org/?node_id=925760)
+        curl_easy_setopt(this->handle, CURLOPT_FRESH_CONNECT, 1L);
+      }
+
+      //NOTE: silently falls back to HTTP/1.1 if libcurl or the server do not support HTTP/2
+      if (http2)
+      {
+        curl_easy_setopt(this->handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(this->handle, CURLOPT_PIPEWAIT, 1L);
+      }
+
       curl_easy_setopt(this->handle, CURLOPT_NOSIGNAL, 1L); //otherwise crash on linux
       curl_easy_setopt(this->handle, CURLOPT_TCP_NODELAY, 1L);
 
@@ -280,7 +296,7 @@ public:
       else if (request.method == "POST")
       {
         curl_easy_setopt(this->handle, CURLOPT_POST, 1L);
-        curl_easy_setopt(this->handle, CURLOPT_INFILESIZE, request.body ? request.body->c_size() : 0);
+        curl_easy_setopt(this->handle, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)(request.body ? request.body->c_size() : 0)); //the body is sent by ReadFunction
       }
       else if (request.method == "PUT")
       {
@@ -349,6 +365,15 @@ public:
     }
 
     memcpy(connection->response.body->c_ptr() + oldsize, chunk, N);
+
+    if (connection->request.partialResponse)
+    {
+      long response_code = 0;
+      curl_easy_getinfo(connection->handle, CURLINFO_RESPONSE_CODE, &response_code);
+      connection->response.status = (int)response_code;
+      connection->request.partialResponse(connection->request, connection->response);
+    }
+
     return (size_t)(TotIn);
   }
 
@@ -414,8 +439,19 @@ public:
 
     //important to create in this thread
     if (!multi_handle)
+    {
       multi_handle = curl_multi_init();
 
+      //keep at least one open connection for each easy handle
+      curl_multi_setopt(multi_handle, CURLMOPT_MAXCONNECTS, (long)std::max(owner->nconnections, 1));
+
+      if (owner->max_connections_per_host > 0)
+        curl_multi_setopt(multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS, (long)owner->max_connections_per_host);
+
+      if (owner->http2)
+        curl_multi_setopt(multi_handle, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+    }
+
     return std::make_shared<CurlConnection>(id, multi_handle);
   }
 
@@ -524,7 +560,7 @@ public:
 
           request->statistics.wait_msec = wait_msec;
           request->statistics.run_t1 = Time::now();
-          connection->setNetRequest(*request, promise);
+          connection->setNetRequest(*request, promise, owner->keep_alive, owner->http2);
         }
         owner->waiting = still_waiting;
       }
@@ -549,6 +585,16 @@ public:
               connection->done = true;
               curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &connection->response_code);
               connection->result = msg->data.result;
+
+              //pool statistics (0 new connects means the transfer reused a connection of the pool)
+              long num_connects = 0;
+              if (curl_easy_getinfo(msg->easy_handle, CURLINFO_NUM_CONNECTS, &num_connects) == CURLE_OK)
+              {
+                if (num_connects > 0)
+                  NetService::global_stats()->new_connections += num_connects;
+                else if (connection->response_code)
+                  ++NetService::global_stats()->reused_connections;
+              }
             }
           }
         }
@@ -622,10 +668,11 @@ public:
             if (owner->verbose)
               PrintInfo("still waiting for a 'response_code', retrying once more...", error_msg);
 
+            //do not retry on a pooled connection, it could be the one closed by the server
             auto request = connection->request;
             auto promise = connection->promise;
             connection->setNetRequest(NetRequest(), Promise<NetResponse>());
-            connection->setNetRequest(request, promise);
+            connection->setNetRequest(request, promise, /*keep_alive*/false, owner->http2);
           }
         }
       }
@@ -669,6 +716,20 @@ NetService::NetService(int nconnections_, bool bVerbose)
       verbose = cint(s_verbose);
   }
 
+  {
+    String s_keep_alive = Utils::getEnv("VISUS_NETSERVICE_KEEP_ALIVE");
+    if (!s_keep_alive.empty())
+      keep_alive = cbool(s_keep_alive);
+
+    String s_http2 = Utils::getEnv("VISUS_NETSERVICE_HTTP2");
+    if (!s_http2.empty())
+      http2 = cbool(s_http2);
+
+    String s_max_connections_per_host = Utils::getEnv("VISUS_NETSERVICE_MAX_CONNECTIONS_PER_HOST");
+    if (!s_max_connections_per_host.empty())
+      max_connections_per_host = cint(s_max_connections_per_host);
+  }
+
   this->pimpl = new Pimpl(this);
   this->pimpl->start();
 }
@@ -811,6 +872,9 @@ void NetService::testSpeed(int nconnections, int nrequests, std::vector<String>
     "Num request/sec", double(nrequests) / sec,
     "read",  StringUtils::getStringFromByteSize(NetService::global_stats()->rbytes), "bytes/sec", double(NetService::global_stats()->rbytes) / (sec),
     "write", StringUtils::getStringFromByteSize(NetService::global_stats()->wbytes), "bytes/sec", double(NetService::global_stats()->wbytes) / (sec));
+  PrintInfo(
+    "new connections", NetService::global_stats()->getNumNewConnections(),
+    "reused connections", NetService::global_stats()->getNumReusedConnections());
 
   NetService::global_stats()->resetStats();
 }
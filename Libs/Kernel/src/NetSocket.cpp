@@ -429,6 +429,10 @@ NetSocket::~NetSocket() {
   if (pimpl) delete pimpl;
 }
 
+int NetSocket::getDescriptor() const {
+  return pimpl->socketfd;
+}
+
 void NetSocket::shutdownSend() {
   return pimpl->shutdownSend();
 }
@@ -106,6 +106,7 @@ public:
   //setAccess
   void setAccess(SharedPtr<Access> value) {
     this->access=value;
+    this->prefetch_access.reset();
   }
 
   //getProgression
@@ -138,6 +139,17 @@ public:
     setProperty("SetAccuracy", this->accuracy, value);
   }
 
+  //getPrefetchBudget
+  Int64 getPrefetchBudget() const {
+    return prefetch_budget;
+  }
+
+  //setPrefetchBudget (bytes of blocks fetched ahead of the current level and around the view, 0 to disable)
+  void setPrefetchBudget(Int64 value) {
+    setProperty("SetPrefetchBudget", this->prefetch_budget, value);
+    this->access.reset();
+  }
+
   //getBounds
   virtual Position getBounds() override {
     return node_bounds;
@@ -218,11 +230,23 @@ private:
   int                quality = QueryDefaultQuality;
   Position           node_bounds = Position::invalid();
   double             accuracy = 0.0; //for idx2
+  Int64              prefetch_budget = 0;
 
   //run time derived properties
   Frustum            node_to_screen;
   Position           query_bounds;
 
+  //prefetching
+  SharedPtr<Access>  prefetch_access;
+  BoxNi              last_logic_box;
+
+  //the prefetch of the region the view is moving to outlives its job (see joinNeighborPrefetch)
+  SharedPtr<std::thread> neighbor_prefetch;
+  Aborted                neighbor_prefetch_aborted;
+
+  //joinNeighborPrefetch (aborts it, the next job or exitFromDataflow must not wait for a prefetch nobody needs)
+  void joinNeighborPrefetch();
+
   //modelChanged
   virtual void modelChanged() override {
     if (dataflow)
@@ -232,6 +256,9 @@ private:
   //publishDumbArray
   void publishDumbArray();
 
+  //createAccess
+  SharedPtr<Access> createAccess(SharedPtr<Dataset> dataset);
+
   
 }; 
 
@@ -41,6 +41,8 @@ For support : support@visus.net
 #include <Visus/StringTree.h>
 #include <Visus/GoogleMapsDataset.h>
 #include <Visus/IdxFilter.h>
+#include <Visus/RamAccess.h>
+#include <Visus/MultiplexAccess.h>
 
 namespace Visus {
 
@@ -68,6 +70,13 @@ public:
   SharedPtr<PointQuery>    point_query;
   SharedPtr<BoxQuery>      box_query;
 
+  //prefetching (runs in its own thread with its own access, they share a RAM cache)
+  SharedPtr<Access>        prefetch_access;
+  Int64                    prefetch_budget = 0;
+  Int64                    prefetched = 0;
+  BoxNi                    neighbor_box;
+  SharedPtr<std::thread>   prefetch_thread;
+
   //constructor
   MyJob(QueryNode* node_,SharedPtr<Dataset> dataset_,SharedPtr<Access> access_)
     : node(node_),dataset(dataset_),access(access_)
@@ -83,6 +92,8 @@ public:
     this->progression = node->getProgression();
     this->verbose = node->isVerbose();
     this->pdim = dataset->getPointDim();
+    this->prefetch_access = node->prefetch_access;
+    this->prefetch_budget = prefetch_access ? node->getPrefetchBudget() : 0;
 
     if (this->progression == QueryGuessProgression)
       this->progression = (pdim == 2) ? (pdim * 3) : (pdim * 4);
@@ -113,6 +124,23 @@ public:
       //remove transformation! (in doPublish I will add the physic clipping)
       BoxNi logic_box = this->logic_position.toDiscreteAxisAlignedBox();
 
+      //guess where the view is going from the last movement
+      auto last_logic_box = node->last_logic_box;
+      if (prefetch_budget > 0 && last_logic_box.isFullDim() && last_logic_box.getPointDim() == logic_box.getPointDim())
+      {
+        auto motion = (logic_box.p1 + logic_box.p2) - (last_logic_box.p1 + last_logic_box.p2);
+        bool bMoved = false;
+        for (int D = 0; D < motion.getPointDim(); D++)
+        {
+          motion[D] /= 2;
+          bMoved = bMoved || motion[D] != 0;
+        }
+
+        if (bMoved)
+          neighbor_box = logic_box.translate(motion).getIntersection(dataset->getLogicBox());
+      }
+      node->last_logic_box = logic_box;
+
       //don't want to produce something with too muchResolutionx
       if (QueryNode::willFitOnGpu)
       {
@@ -151,11 +179,74 @@ public:
   //destructor
   virtual ~MyJob()
   {
+    Thread::join(prefetch_thread);
+  }
+
+  //prefetch (the blocks are not merged, they end up in the RAM cache shared with the main access)
+  static Int64 prefetch(SharedPtr<Dataset> dataset, SharedPtr<Access> access, Field field, double time, Aborted aborted, 
+    BoxNi logic_box, int cur_resolution, int end_resolution, Int64 max_bytes, bool verbose)
+  {
+    auto query = dataset->createBoxQuery(logic_box, field, time, 'r', aborted);
+    query->end_resolutions = { end_resolution };
+    dataset->beginBoxQuery(query);
+    if (!query->isRunning())
+      return 0;
+
+    query->setCurrentResolution(cur_resolution);
+    auto nbytes = dataset->prefetchBoxQuery(access, query, max_bytes);
+
+    if (verbose)
+      PrintInfo("BoxQuery prefetched", logic_box, "resolution", cur_resolution, "/", end_resolution, "mem", StringUtils::getStringFromByteSize(nbytes));
+
+    return nbytes;
+  }
+
+  //startPrefetch (only one at a time, the previous one must be done since the next level will read its blocks)
+  void startPrefetch(BoxNi logic_box, int cur_resolution, int end_resolution)
+  {
+    Thread::join(prefetch_thread);
+    prefetch_thread.reset();
+
+    if (!prefetch_access || prefetched >= prefetch_budget || aborted() || !logic_box.isFullDim())
+      return;
+
+    prefetch_thread = Thread::start("QueryNode Prefetch", [this, logic_box, cur_resolution, end_resolution]() 
+    {
+      prefetched += prefetch(dataset, prefetch_access, field, time, this->aborted, logic_box, cur_resolution, end_resolution, prefetch_budget - prefetched, verbose);
+    });
+  }
+
+  //startNeighborPrefetch (the job is done once the last level is published, so the prefetch belongs to the node and the next job aborts it)
+  void startNeighborPrefetch(int end_resolution)
+  {
+    Thread::join(prefetch_thread);
+    prefetch_thread.reset();
+
+    if (!prefetch_access || prefetched >= prefetch_budget || aborted() || !neighbor_box.isFullDim())
+      return;
+
+    auto dataset = this->dataset;
+    auto access = this->prefetch_access;
+    auto field = this->field;
+    auto time = this->time;
+    auto logic_box = this->neighbor_box;
+    auto max_bytes = prefetch_budget - prefetched;
+    auto verbose = this->verbose;
+
+    Aborted neighbor_aborted;
+    node->neighbor_prefetch_aborted = neighbor_aborted;
+    node->neighbor_prefetch = Thread::start("QueryNode Neighbor Prefetch", [dataset, access, field, time, neighbor_aborted, logic_box, end_resolution, max_bytes, verbose]()
+    {
+      prefetch(dataset, access, field, time, neighbor_aborted, logic_box, -1, end_resolution, max_bytes, verbose);
+    });
   }
 
   //runJob
   virtual void runJob() override
   {
+    //jobs of the same node never run in parallel, and accesses are not thread safe
+    node->joinNeighborPrefetch();
+
     auto T1 = Time::now();
     if (auto query = point_query)
     {
@@ -204,6 +295,15 @@ public:
 
         PrintInfo("BoxQuery executeBoxQuery", I, "/", N, "/", EndH, "/", dataset->getMaxResolution(),"...");
 
+        //fetch the next level (or the region the view is moving to) while this one is fetched, merged and published
+        if (prefetch_budget > 0)
+        {
+          if (I + 1 < N)
+            startPrefetch(query->logic_box, EndH, query->end_resolutions[I + 1]);
+          else
+            startNeighborPrefetch(EndH);
+        }
+
         if (!dataset->executeBoxQuery(access, query))
           return;
 
@@ -271,6 +371,8 @@ std::function<bool(Int64)> QueryNode::willFitOnGpu;
 ///////////////////////////////////////////////////////////////////////////
 QueryNode::QueryNode() 
 {
+  this->prefetch_budget = StringUtils::getByteSizeFromString(Utils::getEnv("VISUS_QUERY_PREFETCH_BUDGET", "0"));
+
   addInputPort("dataset");
   addInputPort("fieldname");
   addInputPort("time");
@@ -280,6 +382,7 @@ QueryNode::QueryNode()
 
 ///////////////////////////////////////////////////////////////////////////
 QueryNode::~QueryNode(){
+  joinNeighborPrefetch();
 }
 
 
@@ -335,6 +438,14 @@ void QueryNode::execute(Archive& ar)
     return;
   }
 
+  if (ar.name == "SetPrefetchBudget")
+  {
+    Int64 value;
+    ar.read("value", value);
+    setPrefetchBudget(value);
+    return;
+  }
+
   if (ar.name == "SetBounds")
   {
     Matrix T; BoxNd box;
@@ -469,18 +580,55 @@ bool QueryNode::processInput()
   //create (and store in my class the access)
   if (!this->access)
   {
-    auto access_configs = dataset->getAccessConfigs();
+    setAccess(createAccess(dataset));
 
-    if (this->accessindex >= 0 && this->accessindex < (int)access_configs.size())
-      setAccess(dataset->createAccessForBlockQuery(*access_configs[this->accessindex]));
-    else
-      setAccess(dataset->createAccess());
+    //prefetching needs a second access (accesses are not thread safe), blocks go to a RAM cache in front of both
+    if (this->access && prefetch_budget > 0)
+    {
+      auto available = std::max(2 * prefetch_budget, StringUtils::getByteSizeFromString("128mb"));
+
+      auto ram_access = std::make_shared<RamAccess>(dataset->getDefaultBitsPerBlock());
+      ram_access->setAvailableMemory(available);
+
+      auto multiplex = std::make_shared<MultiplexAccess>(dataset.get());
+      multiplex->addChild(ram_access, StringTree("access"));
+      multiplex->addChild(this->access, StringTree("access"));
+
+      auto prefetch_ram_access = std::make_shared<RamAccess>(dataset->getDefaultBitsPerBlock());
+      prefetch_ram_access->shareMemoryWith(ram_access);
+
+      auto prefetch_multiplex = std::make_shared<MultiplexAccess>(dataset.get());
+      prefetch_multiplex->addChild(prefetch_ram_access, StringTree("access"));
+      prefetch_multiplex->addChild(createAccess(dataset), StringTree("access"));
+
+      setAccess(multiplex);
+      this->prefetch_access = prefetch_multiplex;
+    }
   }
  
   addNodeJob(std::make_shared<MyJob>(this, dataset, access));
   return true;
 }
 
+//////////////////////////////////////////////////////////////////
+void QueryNode::joinNeighborPrefetch()
+{
+  neighbor_prefetch_aborted.setTrue();
+  Thread::join(neighbor_prefetch);
+  neighbor_prefetch.reset();
+}
+
+//////////////////////////////////////////////////////////////////
+SharedPtr<Access> QueryNode::createAccess(SharedPtr<Dataset> dataset)
+{
+  auto access_configs = dataset->getAccessConfigs();
+
+  if (this->accessindex >= 0 && this->accessindex < (int)access_configs.size())
+    return dataset->createAccessForBlockQuery(*access_configs[this->accessindex]);
+  else
+    return dataset->createAccess();
+}
+
 //////////////////////////////////////////////////////////////////
 void QueryNode::publishDumbArray()
 {
@@ -497,7 +645,9 @@ void QueryNode::publishDumbArray()
 void QueryNode::exitFromDataflow() 
 {
   Node::exitFromDataflow();
+  joinNeighborPrefetch();
   this->access.reset();
+  this->prefetch_access.reset();
 }
 
 //////////////////////////////////////////////////////////////////
@@ -511,6 +661,7 @@ void QueryNode::write(Archive& ar) const
   ar.write("progression", progression);
   ar.write("quality", quality);
   ar.write("accuracy", accuracy);
+  ar.write("prefetch_budget", prefetch_budget);
 
   ar.writeObject("node_bounds", node_bounds);
 
@@ -528,6 +679,7 @@ void QueryNode::read(Archive& ar)
   ar.read("progression", progression);
   ar.read("quality", quality);
   ar.read("accuracy", accuracy);
+  ar.read("prefetch_budget", prefetch_budget, prefetch_budget);
 
   ar.readObject("node_bounds", node_bounds);
 
@@ -545,23 +545,24 @@ private:
         }
       }
     }
+    else if (QUERY)
+    {
+      //all the down datasets intersecting the query, executed in parallel
+      Array result;
+      {
+        ScopedReleaseGil release_gil;
+        result = DATASET->blendDownQueries(QUERY, this->ACCESS, type);
+      }
+      return newPyObject(result);
+    }
     else
     {
       ScopedReleaseGil release_gil;
 
       for (auto it : DATASET->down_datasets)
       {
-        auto dataset_name = it.first;
         auto field = it.second->getField();
-
-        Array buffer = QUERY?
-          DATASET->executeDownQuery(QUERY, this->ACCESS, dataset_name, field.name) :
-          Array(PointNi(DATASET->getPointDim()), field.dtype);
-
-        if (!buffer.valid() || (QUERY && QUERY->aborted()))
-          continue;
-
-        blend.addBlendArg(buffer);
+        blend.addBlendArg(Array(PointNi(DATASET->getPointDim()), field.dtype));
       }
     }
 
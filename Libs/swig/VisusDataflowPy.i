@@ -23,6 +23,7 @@ using namespace Visus;
     %feature("nodirector") Visus::Node::exitFromDataflow;
     %feature("nodirector") Visus::Node::abortProcessing;
     %feature("nodirector") Visus::Node::joinProcessing;
+    %feature("nodirector") Visus::Node::getNodeJobPriority;
     %feature("nodirector") Visus::Node::messageHasBeenPublished;
 
 %feature("director") Visus::NodeJob;
@@ -81,6 +81,20 @@ def LoadIdxDataset(url):
 %ignore Visus::DbModule::attach;
 
 %include <Visus/Db.h>
+
+//AccessStatistics counters are atomic, expose them as read-only attributes
+%extend Visus::AccessStatistics {
+	const Visus::Int64 rok;
+	const Visus::Int64 rfail;
+	const Visus::Int64 wok;
+	const Visus::Int64 wfail;
+}
+%{
+static Visus::Int64 Visus_AccessStatistics_rok_get  (Visus::AccessStatistics* self) {return self->rok  .load();}
+static Visus::Int64 Visus_AccessStatistics_rfail_get(Visus::AccessStatistics* self) {return self->rfail.load();}
+static Visus::Int64 Visus_AccessStatistics_wok_get  (Visus::AccessStatistics* self) {return self->wok  .load();}
+static Visus::Int64 Visus_AccessStatistics_wfail_get(Visus::AccessStatistics* self) {return self->wfail.load();}
+%}
 %include <Visus/Access.h>
 %include <Visus/LogicSamples.h>
 %include <Visus/Query.h>
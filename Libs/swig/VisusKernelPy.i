@@ -147,7 +147,7 @@ def __rmul__(self, v):
     return self.__mul__(v)
 
 # ////////////////////////////////////////////////////////
-def toNumPy(src, bShareMem=False, bSqueeze=False):
+def toNumPy(src, bShareMem=False, bSqueeze=False, bReadOnly=False):
 
 	import numpy
 
@@ -182,12 +182,14 @@ def toNumPy(src, bShareMem=False, bSqueeze=False):
 			pass
 
 		holder = MyNumPyHolder()
+		# the numpy array keeps the holder as its base, and the holder keeps the heap memory alive
+		holder.src = src
 		  
 		holder.__array_interface__ = {
 			'strides': None,
 			'shape': tuple(shape), 
 			'typestr': typestr, 
-			'data': (int(src.c_address()), False),  # The second entry in the tuple is a read-only flag (true means the data area is read-only).
+			'data': (int(src.c_address()), bReadOnly),  # The second entry in the tuple is a read-only flag (true means the data area is read-only).
 			'version': 3 
 		}
 
@@ -261,7 +261,7 @@ class PyDataset(object):
 		return self.db.createAccess(config)
 
 	# readBlock
-	def readBlock(self, block_id, time=None, field=None, access=None, aborted=Aborted()):
+	def readBlock(self, block_id, time=None, field=None, access=None, aborted=Aborted(), bShareMem=True):
 		Assert(access)
 		field=self.getField() if field is None else self.getField(field)	
 		time = self.getTime() if time is None else time
@@ -269,7 +269,7 @@ class PyDataset(object):
 		self.executeBlockQueryAndWait(access, read_block)
 		if not read_block.ok(): return None
 		self.db.convertBlockQueryToRowMajor(read_block) # default is to change the layout to rowmajor
-		return Array.toNumPy(read_block.buffer, bShareMem=False)
+		return Array.toNumPy(read_block.buffer, bShareMem=bShareMem, bReadOnly=bShareMem) # bShareMem=True avoids the copy (the numpy array keeps the buffer alive, it's read-only since a cache can share it), use bShareMem=False for a writable copy
 
 	# writeBlock
 	def writeBlock(self, block_id, time=None, field=None, access=None, data=None, aborted=Aborted()):
@@ -285,7 +285,7 @@ class PyDataset(object):
 
 
 	# read
-	def read(self, logic_box=None, x=None, y=None, z=None, u=None, v=None, time=None, field=None, field_name=None, num_refinements=1, quality=0, max_resolution=None, disable_filters=False, access=None):
+	def read(self, logic_box=None, x=None, y=None, z=None, u=None, v=None, time=None, field=None, field_name=None, num_refinements=1, quality=0, max_resolution=None, disable_filters=False, access=None, bShareMem=True):
 		"""
 		Reads a box in voxel or unit coordinates.
 
@@ -368,8 +368,8 @@ class PyDataset(object):
 		def NoGenerator():
 			if not self.db.executeBoxQuery(access, query):
 				raise Exception("query error {0}".format(query.errormsg))
-			# i cannot be sure how the numpy will be used outside or when the query will dealllocate the buffer
-			data=Array.toNumPy(query.buffer, bShareMem=False) 
+			# with bShareMem=True the numpy array keeps the query buffer alive instead of copying it (read-only, use bShareMem=False for a writable copy)
+			data=Array.toNumPy(query.buffer, bShareMem=bShareMem, bReadOnly=bShareMem) 
 			return data
 			
 		def WithGenerator():
@@ -384,6 +384,28 @@ class PyDataset(object):
 				self.db.nextBoxQuery(query)	
 
 		return NoGenerator() if query.end_resolutions.size()==1 else WithGenerator()
+
+	# readMany
+	def readMany(self, logic_boxes, time=None, field=None, max_resolution=None, num_threads=0, aborted=Aborted(), bShareMem=True):
+		"""
+		Reads many boxes concurrently on native threads (the GIL is released for the whole batch).
+		Returns a list of numpy arrays (None for failed boxes), by default they share (read-only) the query buffers, bShareMem=False returns writable copies.
+
+		Example:
+		crops=dataset.readMany([((x,y,z),(x+64,y+64,z+64)) for x,y,z in corners], num_threads=16)
+		"""
+		field=self.getField() if field is None else self.getField(field)
+		time = self.getTime() if time is None else time
+		end_resolution=-1 if max_resolution is None else max_resolution
+
+		boxes=VectorBoxNi()
+		for logic_box in logic_boxes:
+			if isinstance(logic_box,(tuple,list)):
+				logic_box=BoxNi(PointNi(logic_box[0]),PointNi(logic_box[1]))
+			boxes.push_back(BoxNi(logic_box))
+
+		buffers=self.db.readMany(boxes, field, time, end_resolution, num_threads, aborted)
+		return [Array.toNumPy(it, bShareMem=bShareMem, bReadOnly=bShareMem) if it.valid() else None for it in buffers]
 			
 
 
@@ -1,11 +1,26 @@
-
 import OpenVisus as ov
+import numpy as np
 import os,sys
 
+# ////////////////////////////////////////////////////////////////////////////////
+def TestRoundTrip(compression, data):
+	decoded=ov.Array.fromNumPy(data)
+	encoded = ov.Encode(compression,decoded.dims,decoded.dtype,decoded.heap)
+	assert(encoded)
+	decoded_check=ov.Decode(compression,decoded.dims,decoded.dtype,encoded)
+	assert(ov.HeapMemory.equals(decoded.heap,decoded_check))
+
 if __name__=="__main__":
 	decoded=ov.LoadBinaryDocument("README.md")
 	dims=ov.PointNi([decoded.c_size()])
 	dtype=ov.DType.fromString("uint8")
 	encoded = ov.Encode("zip",dims,dtype,decoded)
 	decoded_check=ov.Decode("zip",dims,dtype,encoded)
-	assert(ov.HeapMemory.equals(decoded,decoded_check))
\ No newline at end of file
+	assert(ov.HeapMemory.equals(decoded,decoded_check))
+
+	# number of samples not multiple of 8 too (bitshuffle leftovers)
+	for compression in ["zstd","shuffle+zstd","shuffle+lz4","bitshuffle+zstd","bitshuffle+lz4"]:
+		for dtype in [np.uint8,np.int16,np.float32,np.float64]:
+			for N in [1,7,8,1001,65536]:
+				data=(np.arange(N)//256 + np.random.randint(0,4,N)).astype(dtype)
+				TestRoundTrip(compression,data)
\ No newline at end of file